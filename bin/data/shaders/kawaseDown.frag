@@ -0,0 +1,15 @@
+// Dual Kawase downsample into a half size target: the 2x2 block under this pixel
+// plus its four diagonal neighbours, all linearly filtered
+
+uniform sampler2DRect blurTexture;
+uniform float offset;   // in source texels
+
+void main() {
+    vec2 texCoord = gl_TexCoord[0].xy;
+    vec4 sum = texture2DRect(blurTexture, texCoord) * 4.0;
+    sum += texture2DRect(blurTexture, texCoord + vec2(-offset, -offset));
+    sum += texture2DRect(blurTexture, texCoord + vec2( offset, -offset));
+    sum += texture2DRect(blurTexture, texCoord + vec2(-offset,  offset));
+    sum += texture2DRect(blurTexture, texCoord + vec2( offset,  offset));
+    gl_FragColor = sum / 8.0;
+}
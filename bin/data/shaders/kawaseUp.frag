@@ -0,0 +1,18 @@
+// Dual Kawase upsample into a double size target: a tent of eight linearly
+// filtered taps around this pixel
+
+uniform sampler2DRect blurTexture;
+uniform float offset;   // in source texels
+
+void main() {
+    vec2 texCoord = gl_TexCoord[0].xy;
+    vec4 sum = texture2DRect(blurTexture, texCoord + vec2(-2.0 * offset, 0.0));
+    sum += texture2DRect(blurTexture, texCoord + vec2( 2.0 * offset, 0.0));
+    sum += texture2DRect(blurTexture, texCoord + vec2(0.0, -2.0 * offset));
+    sum += texture2DRect(blurTexture, texCoord + vec2(0.0,  2.0 * offset));
+    sum += texture2DRect(blurTexture, texCoord + vec2(-offset, -offset)) * 2.0;
+    sum += texture2DRect(blurTexture, texCoord + vec2( offset, -offset)) * 2.0;
+    sum += texture2DRect(blurTexture, texCoord + vec2(-offset,  offset)) * 2.0;
+    sum += texture2DRect(blurTexture, texCoord + vec2( offset,  offset)) * 2.0;
+    gl_FragColor = sum / 12.0;
+}
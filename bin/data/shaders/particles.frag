@@ -0,0 +1,13 @@
+#version 120
+
+// soft round particle, fading out with age (gl_PointCoord needs 1.20)
+
+uniform vec4 color;
+
+varying float age;
+
+void main() {
+    vec2 d = gl_PointCoord * 2.0 - vec2(1.0);
+    float falloff = clamp(1.0 - dot(d, d), 0.0, 1.0);
+    gl_FragColor = vec4(color.rgb, color.a * falloff * (1.0 - age));
+}
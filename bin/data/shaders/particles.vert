@@ -0,0 +1,13 @@
+#version 120
+
+// particle point sprites: texcoord 0 is (size px, age 0..1)
+
+uniform float sizeScale;
+
+varying float age;
+
+void main() {
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    gl_PointSize = max(gl_MultiTexCoord0.x * sizeScale, 1.0);
+    age = gl_MultiTexCoord0.y;
+}
@@ -4,10 +4,26 @@ uniform float colorDecay;
 uniform float alphaDecay;
 uniform float alphaMin;
 
+// quantization step of the target's color and alpha, 0 for float targets
+uniform float colorStep;
+uniform float alphaStep;
+uniform float ditherSeed;   // different every frame
+
+float ditherNoise(vec2 position) {
+    return fract(sin(dot(position + ditherSeed, vec2(12.9898, 78.233)))*43758.5453) - 0.5;
+}
+
 void main() {
     vec4 color = texture2DRect(texSampler, gl_TexCoord[0].xy);
     color.rgb *= colorDecay;
     color.a *= alphaDecay;
+
+    // a slow fade loses less than half a step per frame, rounds back up and
+    // stalls in bands; noise of one step rounds it down at the right average rate
+    float noise = ditherNoise(gl_FragCoord.xy);
+    color.rgb += noise*colorStep;
+    color.a += noise*alphaStep;
+
     color.a = color.a < alphaMin ? 0.0 : color.a;
     gl_FragColor = color;
-}
\ No newline at end of file
+}
@@ -11,68 +11,166 @@
 
 
 ofxAudioAnalyzer::Settings::Settings(){
+    useInputStream = true;
     inputDeviceId = 0;
     stereo = false;
     sampleRate = 44100;
     bufferSize = 1024;
+    fftSize = 0;
+    hopSize = 0;
     windowType = OF_FFT_WINDOW_HAMMING;
     implementation = OF_FFT_FFTW;
+    useBuiltinFft = true;
+    numInputChannels = 0;
+    channelOffset = 0;
+    channelCount = 0;
+    frameHistorySize = 8;
+    threadedAnalysis = false;
+    analysisQueueBlocks = 16;
+    detectOnsets = true;
+    spectralFeatures = true;
+    numBands = 24;
+    bandScale = AA_FILTERBANK_MEL;
+    bandLowFreq = 40.0f;
+    bandHighFreq = 16000.0f;
+    bandAttackInMs = 1.0f;
+    bandReleaseInMs = 150.0f;
+    rolloffFraction = 0.85f;
 }
 
 ofxAudioAnalyzer::ofxAudioAnalyzer()
 {
+    fftEngine = NULL;
     fft = NULL;
+    nFftBins = 0;
+    analyzedFrameCount = 0;
+    sampleClock = 0;
+    previousSnapshotTime = 0;
+    windowWritePos = 0;
+    samplesSinceHop = 0;
+    hopOnset = false;
+    spectralCentroid = 0.0f;
+    spectralRolloff = 0.0f;
+    spectralFlatness = 0.0f;
+    spectralRMS = 0.0f;
+    memset(&parameters, 0, sizeof(parameters));
+    memset(regionGeneration, 0, sizeof(regionGeneration));
+    statMaxQueueDepth = 0;
+    statDroppedBlocks = 0;
+    statDroppedFrames = 0;
+    statWorstAnalysisMicros = 0;
+    analysisThread.analyzer = this;
 }
 
 void ofxAudioAnalyzer::setup(Settings settings)
 {
+    if (settings.fftSize == 0) settings.fftSize = settings.bufferSize;
+    if (settings.hopSize == 0 || settings.hopSize > settings.fftSize) settings.hopSize = settings.fftSize;
+    if (settings.numBands > AA_MAX_BANDS){
+        ofLog(OF_LOG_WARNING, "ofxAudioAnalyzer: only " + ofToString(AA_MAX_BANDS) + " filterbank bands are supported");
+        settings.numBands = AA_MAX_BANDS;
+    }
     _settings = settings;
     
     // setup FFT
-    fft = ofxFft::create(settings.bufferSize, settings.windowType, settings.implementation);
+    if (settings.useBuiltinFft){
+        fftEngine = ofxAudioFftEngine::create(settings.fftSize, settings.windowType);
+        if (!fftEngine){
+            ofLog(OF_LOG_NOTICE, "ofxAudioAnalyzer: no built-in FFT for size " + ofToString(settings.fftSize) + ", using ofxFft");
+        }
+    }
+    if (fftEngine){
+        nFftBins = fftEngine->getBinSize();
+        fftReal.allocate(nFftBins);
+        fftImag.allocate(nFftBins);
+    }
+    else{
+        fft = ofxFft::create(settings.fftSize, settings.windowType, settings.implementation);
+        nFftBins = fft->getBinSize();
+    }
     
     // vectors
 
-    pcmBuffer.resize(settings.bufferSize);
-    analyzedFFTData.resize(fft->getBinSize());
-    analyzedFFTData.assign(fft->getBinSize(), 0);
-    storedFFTData.resize(fft->getBinSize());
-    storedFFTData.assign(fft->getBinSize(), 0);
-    analyzedPSFData.resize(fft->getBinSize());
-    analyzedPSFData.assign(fft->getBinSize(), 0);
-    storedPSFData.resize(fft->getBinSize());
-    storedPSFData.assign(fft->getBinSize(), 0);
+    windowBuffer.assign(settings.fftSize, 0);
+    windowWritePos = 0;
+    samplesSinceHop = 0;
+    pcmBuffer.assign(settings.fftSize, 0);
+    analyzedFFTData.assign(nFftBins, 0);
+    previousFFTData.assign(nFftBins, 0);
+    analyzedPSFData.assign(nFftBins, 0);
+    energyPrefix.assign(nFftBins + 1, 0);
+    psfPrefix.assign(nFftBins + 1, 0);
+    analyzedFrameCount = 0;
     
-    memset(signalEnergy, 0, sizeof(float)*AA_NUM_FREQ_REGIONS);
-    memset(signalEnergySmoothed, 0, sizeof(float)*AA_NUM_FREQ_REGIONS);
-    memset(signalPSF, 0, sizeof(float)*AA_NUM_FREQ_REGIONS);
-    memset(signalPSFSmoothed, 0, sizeof(float)*AA_NUM_FREQ_REGIONS);
+    // all frame storage is allocated here so audioIn never allocates
+    AnalysisFrame prototype;
+    prototype.pcm.assign(settings.fftSize, 0);
+    prototype.fftBins.assign(nFftBins, 0);
+    prototype.psf.assign(nFftBins, 0);
+    frameRing.allocate(settings.frameHistorySize + 1, prototype);
+    snapshotBuffer.allocate(prototype);
+    sampleClock = 0;
+    previousSnapshotTime = 0;
     
-    // regions
-    _lowRegion.lowerFreq = 40.0f;
-    _lowRegion.upperFreq = 160.0f;
+    onsetDetector.setup(settings.onsetSettings, settings.sampleRate, settings.fftSize, settings.hopSize);
+    beatTracker.setup(settings.beatSettings, settings.sampleRate, settings.hopSize);
+    onsetQueue.allocate(AA_ONSET_QUEUE_SIZE, Onset());
+    hopOnset = false;
     
-    _midRegion.lowerFreq = 100.0f;
-    _midRegion.upperFreq = 3000.0f;
+    memset(signalEnergy, 0, sizeof(float)*AA_MAX_FREQ_REGIONS);
+    memset(signalEnergySmoothed, 0, sizeof(float)*AA_MAX_FREQ_REGIONS);
+    memset(signalPSF, 0, sizeof(float)*AA_MAX_FREQ_REGIONS);
+    memset(signalPSFSmoothed, 0, sizeof(float)*AA_MAX_FREQ_REGIONS);
+    memcpy(regionGeneration, parameters.regionGeneration, sizeof(regionGeneration));
+    
+    // filterbank weights are built once here, never per hop
+    filterbank.setup(settings.spectralFeatures ? settings.numBands : 0, settings.bandLowFreq, settings.bandHighFreq,
+                     nFftBins, settings.sampleRate, settings.bandScale);
+    memset(bandEnergy, 0, sizeof(float)*AA_MAX_BANDS);
+    memset(bandEnergySmoothed, 0, sizeof(float)*AA_MAX_BANDS);
+    for (unsigned int b=0; b<AA_MAX_BANDS; b++){
+        parameters.bandCoefAttack[b] = smoothingCoefficient(settings.bandAttackInMs);
+        parameters.bandCoefRelease[b] = smoothingCoefficient(settings.bandReleaseInMs);
+    }
+    parameterBuffer.allocate(parameters);
     
-    _highRegion.lowerFreq = 3000.0f;
-    _highRegion.upperFreq = 20000.0f;
+    // default regions
+    vector<FreqRegion> defaultRegions(AA_NUM_DEFAULT_FREQ_REGIONS);
+    defaultRegions[AA_FREQ_REGION_LOW] = FreqRegion(40.0f, 160.0f);
+    defaultRegions[AA_FREQ_REGION_MID] = FreqRegion(100.0f, 3000.0f);
+    defaultRegions[AA_FREQ_REGION_HIGH] = FreqRegion(3000.0f, 20000.0f);
+    defaultRegions[AA_FREQ_REGION_ALL] = FreqRegion(0.0f, settings.sampleRate/2.0f);
+    setRegions(defaultRegions);
     
-    // default attack release
-    for (ofxAudioAnalyzerRegion region = AA_FREQ_REGION_LOW; region < AA_NUM_FREQ_REGIONS; region++){
-        setAttackInRegion(1.0f, region);
-        setReleaseInRegion(150.0f, region);
+    // analysis thread must be running before audio starts arriving
+    resetAnalysisStats();
+    if (settings.threadedAnalysis){
+        PCMBlock blockPrototype;
+        blockPrototype.samples.assign(settings.bufferSize, 0);
+        blockQueue.allocate(settings.analysisQueueBlocks, blockPrototype);
+        analysisThread.startThread(true, false);
     }
     
     // setup audio input stream
-    inputStream.setDeviceID(settings.inputDeviceId);
-    inputStream.setInput(this);
-    inputStream.setup(0, settings.stereo ? 2 : 1, settings.sampleRate, settings.bufferSize, 4);
+    if (settings.useInputStream){
+        inputStream.setDeviceID(settings.inputDeviceId);
+        inputStream.setInput(this);
+        int nChannels = settings.numInputChannels > 0 ? settings.numInputChannels : (settings.stereo ? 2 : 1);
+        inputStream.setup(0, nChannels, settings.sampleRate, settings.bufferSize, 4);
+    }
 }
 
 ofxAudioAnalyzer::~ofxAudioAnalyzer()
 {
-    inputStream.stop();
+    if (_settings.useInputStream){
+        inputStream.stop();
+    }
+    if (analysisThread.isThreadRunning()){
+        analysisThread.quit();
+    }
+    if (fftEngine){
+        delete fftEngine;
+    }
     if (fft){
         delete fft;
     }
@@ -80,170 +178,626 @@ ofxAudioAnalyzer::~ofxAudioAnalyzer()
 
 void ofxAudioAnalyzer::audioIn(float *input, int bufferSize, int nChannels)
 {
-    if (!input) return;
+    process(input, bufferSize, nChannels);
+}
+
+void ofxAudioAnalyzer::process(const float *input, int nFrames, int nChannels)
+{
+    if (!input || !nFftBins) return;
     
-    pcmMutex.lock();
-    if (nChannels > 1){
-        for (int i=0; i<bufferSize; i++){
-            pcmBuffer[i] = input[i*2]*0.5f;
-            pcmBuffer[i] += input[i*2+1]*0.5f;
+    if (_settings.threadedAnalysis){
+        enqueueInput(input, nFrames, nChannels);
+    }
+    else{
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+        analyzeInput(input, nFrames, nChannels);
+        unsigned int elapsed = ofGetElapsedTimeMicros() - startTime;
+        if (elapsed > statWorstAnalysisMicros) statWorstAnalysisMicros = elapsed;
+    }
+}
+
+void ofxAudioAnalyzer::enqueueInput(const float *input, int nFrames, int nChannels)
+{
+    // real-time side of threaded analysis: downmix into preallocated blocks, never wait
+    int offset = 0;
+    while (offset < nFrames){
+        
+        PCMBlock *block = blockQueue.beginPush();
+        if (!block){
+            // the rest of the buffer is lost: count every block it would have taken
+            unsigned int nDropped = nFrames - offset;
+            unsigned int blockFrames = _settings.bufferSize;
+            ofxNDAtomicAdd(statDroppedBlocks, (nDropped + blockFrames - 1)/blockFrames);
+            ofxNDAtomicAdd(statDroppedFrames, nDropped);
+            break;
+        }
+        
+        int nBlockFrames = MIN(nFrames - offset, (int)block->samples.size());
+        downmix(input + offset*nChannels, &block->samples[0], nBlockFrames, nChannels);
+        block->nFrames = nBlockFrames;
+        blockQueue.endPush();
+        offset += nBlockFrames;
+    }
+    
+    unsigned int depth = blockQueue.size();
+    if (depth > statMaxQueueDepth) statMaxQueueDepth = depth;
+    
+    if (offset > 0) analysisThread.wake();
+}
+
+void ofxAudioAnalyzer::drainQueue()
+{
+    PCMBlock *block;
+    while ((block = blockQueue.front())){
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+        analyzeInput(&block->samples[0], block->nFrames, 1);
+        unsigned int elapsed = ofGetElapsedTimeMicros() - startTime;
+        if (elapsed > statWorstAnalysisMicros) statWorstAnalysisMicros = elapsed;
+        blockQueue.pop();
+    }
+}
+
+ofxAudioAnalyzer::AnalysisThread::AnalysisThread() :
+    analyzer(NULL),
+    _pending(0),
+    _quit(0)
+{
+}
+
+void ofxAudioAnalyzer::AnalysisThread::wake()
+{
+    // called from the audio callback, so no locks: only the first wakeup since the
+    // last drain posts, the callbacks until then just push
+    if (ofxNDAtomicCompareAndSwap(_pending, 0, 1)){
+        _wakeup.signal();
+    }
+}
+
+void ofxAudioAnalyzer::AnalysisThread::quit()
+{
+    ofxNDAtomicStore(_quit, 1);
+    _wakeup.signal();
+    waitForThread(true);
+}
+
+void ofxAudioAnalyzer::AnalysisThread::threadedFunction()
+{
+    while (!ofxNDAtomicLoad(_quit)){
+        // cleared before draining: a block queued from here on posts again, so none
+        // waits for the next callback (at worst one wakeup finds the queue empty)
+        ofxNDAtomicStore(_pending, 0);
+        analyzer->drainQueue();
+        _wakeup.wait();
+    }
+}
+
+void ofxAudioAnalyzer::analyzeInput(const float *input, int nFrames, int nChannels)
+{
+    // feed the sliding window one hop at a time, analyzing whenever a hop completes
+    int offset = 0;
+    while (offset < nFrames){
+        int nHopFrames = MIN(nFrames - offset, (int)(_settings.hopSize - samplesSinceHop));
+        pushSamples(input + offset*nChannels, nHopFrames, nChannels);
+        offset += nHopFrames;
+        samplesSinceHop += nHopFrames;
+        sampleClock += nHopFrames;
+        
+        if (samplesSinceHop >= _settings.hopSize){
+            samplesSinceHop = 0;
+            analyzeWindow();
+        }
+    }
+}
+
+void ofxAudioAnalyzer::pushSamples(const float *input, int nFrames, int nChannels)
+{
+    unsigned int windowSize = windowBuffer.size();
+    while (nFrames > 0){
+        int nSegment = MIN(nFrames, (int)(windowSize - windowWritePos));
+        downmix(input, &windowBuffer[windowWritePos], nSegment, nChannels);
+        input += nSegment*nChannels;
+        nFrames -= nSegment;
+        windowWritePos += nSegment;
+        if (windowWritePos == windowSize) windowWritePos = 0;
+    }
+}
+
+void ofxAudioAnalyzer::downmix(const float *input, float *output, int nFrames, int nChannels)
+{
+    // analyzed channel group, clamped to the channels actually present
+    int first = MIN((int)_settings.channelOffset, nChannels - 1);
+    int count = _settings.channelCount > 0 ? _settings.channelCount : 2;
+    count = MIN(count, nChannels - first);
+    const float *in = input + first;
+    
+    if (count == 1){
+        if (nChannels == 1){
+            memcpy(output, in, nFrames*sizeof(float));
+        }
+        else{
+            for (int i=0; i<nFrames; i++){
+                output[i] = in[i*nChannels];
+            }
+        }
+    }
+    else if (count == 2){
+        for (int i=0; i<nFrames; i++){
+            output[i] = (in[i*nChannels] + in[i*nChannels+1])*0.5f;
         }
     }
     else{
-        memcpy(&pcmBuffer[0], input, bufferSize*sizeof(float));
-    }
-    pcmMutex.unlock();
-    
-    int nBins = fft->getBinSize();
-    
-    fft->setSignal(pcmBuffer);
-    float *fftAmp = fft->getAmplitude();
-    memcpy(&analyzedFFTData[0], fftAmp, nBins*sizeof(float));
-    
-    // calculate psf & signal energy
-    float binFlux = 0;
-    float totalFlux = 0;
-    float energy = 0;
-    for (int i=0; i<nBins; i++){
-        binFlux = MAX(0,analyzedFFTData[i] - storedFFTData[i]);
-        analyzedPSFData[i] = binFlux;
-        totalFlux += binFlux;
-        energy += analyzedFFTData[i];
-    }
-    
-    signalEnergy[AA_FREQ_REGION_ALL] = energy;
-    signalPSF[AA_FREQ_REGION_ALL] = totalFlux;
-    
-    float coef = energy > signalEnergySmoothed[AA_FREQ_REGION_ALL] ? coefAttack[AA_FREQ_REGION_ALL] : coefRelease[AA_FREQ_REGION_ALL];
-    float smoothedEnergy = signalEnergySmoothed[AA_FREQ_REGION_ALL]*coef + signalEnergy[AA_FREQ_REGION_ALL]*(1.0f-coef);
-    signalEnergySmoothed[AA_FREQ_REGION_ALL] = smoothedEnergy;
-    
-    coef = totalFlux > signalPSFSmoothed[AA_FREQ_REGION_ALL] ? coefAttack[AA_FREQ_REGION_ALL] : coefRelease[AA_FREQ_REGION_ALL];
-    float smoothedFlux = signalPSFSmoothed[AA_FREQ_REGION_ALL]*coef + signalPSF[AA_FREQ_REGION_ALL]*(1.0f-coef);
-    signalPSFSmoothed[AA_FREQ_REGION_ALL] = smoothedFlux;
-    
-    // get region fft & PSF
-    FreqRegion fRegion;
-    for (unsigned int region = AA_FREQ_REGION_LOW; region <= AA_FREQ_REGION_HIGH; region++){
-        switch (region) {
-            case AA_FREQ_REGION_LOW:
-                fRegion = _lowRegion;
-                break;
-                
-            case AA_FREQ_REGION_MID:
-                fRegion = _midRegion;
-                break;
-                
-            case AA_FREQ_REGION_HIGH:
-                fRegion = _highRegion;
-                break;
-                
-            default:
-                continue;
+        float scale = 1.0f/count;
+        for (int i=0; i<nFrames; i++){
+            float sum = 0.0f;
+            for (int c=0; c<count; c++){
+                sum += in[i*nChannels + c];
+            }
+            output[i] = sum*scale;
         }
+    }
+}
+
+void ofxAudioAnalyzer::analyzeWindow()
+{
+    // unroll circular window, oldest sample first
+    unsigned int windowSize = windowBuffer.size();
+    unsigned int nTail = windowSize - windowWritePos;
+    memcpy(&pcmBuffer[0], &windowBuffer[windowWritePos], nTail*sizeof(float));
+    if (windowWritePos > 0){
+        memcpy(&pcmBuffer[nTail], &windowBuffer[0], windowWritePos*sizeof(float));
+    }
+    
+    int nBins = nFftBins;
+    
+    updateParameters();
+    const Parameters & params = parameterBuffer.front();
+    
+    const float *real;
+    const float *imag;
+    if (fftEngine){
+        fftEngine->process(&pcmBuffer[0], fftReal.data(), fftImag.data());
+        real = fftReal.data();
+        imag = fftImag.data();
+    }
+    else{
+        fft->setSignal(pcmBuffer);
+        real = fft->getReal();
+        imag = fft->getImaginary();
+    }
+    
+    // magnitudes, flux, prefix sums and moments in one pass; last hop's magnitudes become "previous"
+    ofxAudioSpectralMoments moments;
+    analyzedFFTData.swap(previousFFTData);
+    ofxAudioSpectralKernel(real, imag, &previousFFTData[0],
+                           &analyzedFFTData[0], &analyzedPSFData[0],
+                           &energyPrefix[0], &psfPrefix[0], nBins,
+                           _settings.spectralFeatures ? &moments : NULL);
+    
+    if (_settings.spectralFeatures){
+        analyzeSpectrum(moments, params, nBins);
+    }
+    
+    // region energy & PSF are O(1) lookups against cached bin bounds
+    for (unsigned int r = 0; r < params.numRegions; r++){
         
-        unsigned int lowerBin = binForFrequency(fRegion.lowerFreq);
-        unsigned int upperBin = binForFrequency(fRegion.upperFreq);
+        unsigned int lowerBin = params.regionLowerBin[r];
+        unsigned int upperBin = params.regionUpperBin[r];
         
         float trEnergy = 0.0f;
         float trPSF = 0.0f;
         if (upperBin >= lowerBin){
-            unsigned int b = lowerBin;
-            do {
-                trEnergy += analyzedFFTData[b];
-                trPSF += analyzedPSFData[b];
-            } while (++b <= upperBin);
+            trEnergy = energyPrefix[upperBin+1] - energyPrefix[lowerBin];
+            trPSF = psfPrefix[upperBin+1] - psfPrefix[lowerBin];
         }
         
-        signalPSF[region] = trPSF;
-        signalEnergy[region] = trEnergy;
+        signalPSF[r] = trPSF;
+        signalEnergy[r] = trEnergy;
         
-        float coef = trPSF >= signalPSFSmoothed[region] ? coefAttack[region] : coefRelease[region];
-        float psfSmoothed = signalPSFSmoothed[region]*coef + trPSF*(1.0f-coef);
-        signalPSFSmoothed[region] = psfSmoothed;
+        float coef = trPSF >= signalPSFSmoothed[r] ? params.coefAttack[r] : params.coefRelease[r];
+        signalPSFSmoothed[r] = signalPSFSmoothed[r]*coef + trPSF*(1.0f-coef);
+        
+        coef = trEnergy >= signalEnergySmoothed[r] ? params.coefAttack[r] : params.coefRelease[r];
+        signalEnergySmoothed[r] = signalEnergySmoothed[r]*coef + trEnergy*(1.0f-coef);
+    }
+    
+    // onsets & beat phase from the flux of the whole spectrum
+    if (_settings.detectOnsets){
+        Onset onset;
+        hopOnset = onsetDetector.process(psfPrefix[nBins], &pcmBuffer[0], sampleClock, onset);
+        beatTracker.process(onsetDetector.getNovelty(), hopOnset, onset.strength, onset.sampleTime, sampleClock);
         
-        coef = trEnergy >= signalEnergySmoothed[region] ? coefAttack[region] : coefRelease[region];
-        float enSmoothed = signalEnergySmoothed[region]*coef + trEnergy*(1.0f-coef);
-        signalEnergySmoothed[region] = enSmoothed;
+        // reader fell behind: drop the event, the frame still carries the onset flag
+        Onset *slot = hopOnset ? onsetQueue.beginPush() : NULL;
+        if (slot){
+            *slot = onset;
+            onsetQueue.endPush();
+        }
     }
+    
+    // publish frame - wait-free, frame storage is preallocated
+    unsigned long long hostTime = ofxNDClock::getMicros();
+    
+    AnalysisFrame & frame = frameRing.beginWrite();
+    fillFrame(frame, params, nBins, hostTime);
+    frameRing.endWrite();
+    
+    fillFrame(snapshotBuffer.back(), params, nBins, hostTime);
+    snapshotBuffer.publish();
+    
+    analyzedFrameCount++;
+}
 
+void ofxAudioAnalyzer::analyzeSpectrum(const ofxAudioSpectralMoments & moments, const Parameters & params, int nBins)
+{
+    float binHz = (_settings.sampleRate/2.0f)/(nBins - 1);
+    float total = energyPrefix[nBins];
     
-    // thread-safe assignments
-    fftMutex.lock();
-    storedFFTData = analyzedFFTData;
-    fftMutex.unlock();
+    spectralCentroid = total > 0.0f ? binHz*moments.weightedSum/total : 0.0f;
+    spectralRMS = sqrtf(moments.powerSum/nBins);
     
-    psfMutex.lock();
-    storedPSFData = analyzedFFTData;
-    psfMutex.unlock();
+    // rolloff is a binary search in the prefix sums the kernel already built
+    float target = total*_settings.rolloffFraction;
+    vector<float>::iterator prefixStart = energyPrefix.begin() + 1;
+    int rolloffBin = std::lower_bound(prefixStart, prefixStart + nBins, target) - prefixStart;
+    spectralRolloff = MIN(rolloffBin, nBins - 1)*binHz;
+    
+    // bands - sparse weights, same attack/release smoothing as the regions
+    unsigned int nBands = filterbank.getNumBands();
+    filterbank.process(&analyzedFFTData[0], bandEnergy);
+    
+    // flatness is taken over the bands: geometric over arithmetic mean. The product
+    // is in double so 64 small band values can't underflow; one pow instead of a log per bin
+    double product = 1.0;
+    double bandSum = 0.0;
+    for (unsigned int b=0; b<nBands; b++){
+        float coef = bandEnergy[b] >= bandEnergySmoothed[b] ? params.bandCoefAttack[b] : params.bandCoefRelease[b];
+        bandEnergySmoothed[b] = bandEnergySmoothed[b]*coef + bandEnergy[b]*(1.0f-coef);
+        
+        product *= bandEnergy[b] + 1e-4;
+        bandSum += bandEnergy[b] + 1e-4;
+    }
+    spectralFlatness = nBands > 0 ? MIN(pow(product, 1.0/nBands)/(bandSum/nBands), 1.0) : 0.0f;
+}
+
+void ofxAudioAnalyzer::fillFrame(AnalysisFrame & frame, const Parameters & params, int nBins, unsigned long long hostTime)
+{
+    memcpy(&frame.pcm[0], &pcmBuffer[0], pcmBuffer.size()*sizeof(float));
+    memcpy(&frame.fftBins[0], &analyzedFFTData[0], nBins*sizeof(float));
+    memcpy(&frame.psf[0], &analyzedPSFData[0], nBins*sizeof(float));
+    
+    unsigned int nRegions = params.numRegions;
+    frame.regions.numRegions = nRegions;
+    memcpy(frame.regions.energy, signalEnergy, nRegions*sizeof(float));
+    memcpy(frame.regions.energySmoothed, signalEnergySmoothed, nRegions*sizeof(float));
+    memcpy(frame.regions.psf, signalPSF, nRegions*sizeof(float));
+    memcpy(frame.regions.psfSmoothed, signalPSFSmoothed, nRegions*sizeof(float));
+    
+    unsigned int nBands = filterbank.getNumBands();
+    frame.spectral.centroid = spectralCentroid;
+    frame.spectral.rolloff = spectralRolloff;
+    frame.spectral.flatness = spectralFlatness;
+    frame.spectral.rms = spectralRMS;
+    frame.spectral.numBands = nBands;
+    memcpy(frame.spectral.bands, bandEnergy, nBands*sizeof(float));
+    memcpy(frame.spectral.bandsSmoothed, bandEnergySmoothed, nBands*sizeof(float));
+    
+    frame.novelty = onsetDetector.getNovelty();
+    frame.onset = hopOnset;
+    frame.beatPhase = beatTracker.getBeatPhase();
+    frame.tempoBpm = beatTracker.getTempoBpm();
+    frame.beatCount = beatTracker.getBeatCount();
+    
+    frame.frameIndex = analyzedFrameCount;
+    frame.sampleTime = sampleClock;
+    frame.hostTimeMicros = hostTime;
+}
+
+unsigned int ofxAudioAnalyzer::getAnalyzedFrameCount()
+{
+    return ofxNDAtomicLoad(analyzedFrameCount);
+}
+
+ofxAudioAnalyzer::AnalysisStats ofxAudioAnalyzer::getAnalysisStats()
+{
+    AnalysisStats stats;
+    stats.queueDepth = blockQueue.size();
+    stats.maxQueueDepth = statMaxQueueDepth;
+    stats.droppedBlocks = statDroppedBlocks;
+    stats.droppedFrames = statDroppedFrames;
+    stats.worstAnalysisMicros = statWorstAnalysisMicros;
+    return stats;
+}
+
+void ofxAudioAnalyzer::resetAnalysisStats()
+{
+    statMaxQueueDepth = 0;
+    statDroppedBlocks = 0;
+    statDroppedFrames = 0;
+    statWorstAnalysisMicros = 0;
+}
+
+vector<ofxAudioAnalyzer::FreqRegion> ofxAudioAnalyzer::FreqRegion::logSpaced(unsigned int nBands, float lowFreq, float highFreq)
+{
+    vector<FreqRegion> bands;
+    if (nBands == 0 || lowFreq <= 0.0f || highFreq <= lowFreq) return bands;
+    
+    float ratio = powf(highFreq/lowFreq, 1.0f/nBands);
+    float lower = lowFreq;
+    for (unsigned int b=0; b<nBands; b++){
+        float upper = lower*ratio;
+        bands.push_back(FreqRegion(lower, upper));
+        lower = upper;
+    }
+    return bands;
+}
+
+void ofxAudioAnalyzer::setRegions(const vector<FreqRegion> & newRegions)
+{
+    unsigned int nRegions = MIN(newRegions.size(), AA_MAX_FREQ_REGIONS);
+    if (newRegions.size() > AA_MAX_FREQ_REGIONS){
+        ofLog(OF_LOG_WARNING, "ofxAudioAnalyzer: only the first " + ofToString(AA_MAX_FREQ_REGIONS) + " regions will be used");
+    }
+    
+    for (unsigned int r=0; r<nRegions; r++){
+        if (r >= parameters.numRegions){
+            parameters.regionGeneration[r]++;
+        }
+        setRegion(r, newRegions[r]);
+    }
+    parameters.numRegions = nRegions;
+    publishParameters();
+}
+
+int ofxAudioAnalyzer::addRegion(FreqRegion region)
+{
+    if (parameters.numRegions >= AA_MAX_FREQ_REGIONS){
+        ofLog(OF_LOG_ERROR, "ofxAudioAnalyzer: can't add more than " + ofToString(AA_MAX_FREQ_REGIONS) + " regions");
+        return -1;
+    }
+    
+    unsigned int index = parameters.numRegions;
+    parameters.regionGeneration[index]++;
+    setRegion(index, region);
+    parameters.numRegions = index + 1;
+    publishParameters();
+    return index;
+}
+
+unsigned int ofxAudioAnalyzer::getNumRegions()
+{
+    return parameters.numRegions;
 }
 
 void ofxAudioAnalyzer::setLowMidHighRegions(FreqRegion lowRegion, FreqRegion midRegion, FreqRegion highRegion)
 {
-    _lowRegion = lowRegion;
-    _midRegion = midRegion;
-    _highRegion = highRegion;
+    setRegion(AA_FREQ_REGION_LOW, lowRegion);
+    setRegion(AA_FREQ_REGION_MID, midRegion);
+    setRegion(AA_FREQ_REGION_HIGH, highRegion);
+    publishParameters();
 }
 
-void ofxAudioAnalyzer::setAttackInRegion(int attackInMS, ofxAudioAnalyzerRegion region)
+void ofxAudioAnalyzer::setRegion(unsigned int index, const FreqRegion & region)
 {
-    if (region >= AA_NUM_FREQ_REGIONS || region < 0)
+    regions[index] = region;
+    
+    unsigned int nBins = nFftBins ? nFftBins : 1;
+    parameters.regionLowerBin[index] = MIN(binForFrequency(region.lowerFreq), nBins - 1);
+    parameters.regionUpperBin[index] = MIN(binForFrequency(region.upperFreq), nBins - 1);
+    parameters.coefAttack[index] = smoothingCoefficient(region.attackInMs);
+    parameters.coefRelease[index] = smoothingCoefficient(region.releaseInMs);
+}
+
+void ofxAudioAnalyzer::publishParameters()
+{
+    parameterBuffer.back() = parameters;
+    parameterBuffer.publish();
+}
+
+void ofxAudioAnalyzer::updateParameters()
+{
+    if (!parameterBuffer.update()) return;
+    
+    // regions added since the last hop start from silence
+    const Parameters & params = parameterBuffer.front();
+    for (unsigned int r=0; r<params.numRegions; r++){
+        if (regionGeneration[r] != params.regionGeneration[r]){
+            regionGeneration[r] = params.regionGeneration[r];
+            signalEnergy[r] = signalEnergySmoothed[r] = 0.0f;
+            signalPSF[r] = signalPSFSmoothed[r] = 0.0f;
+        }
+    }
+}
+
+void ofxAudioAnalyzer::setAttackInRegion(int attackInMS, unsigned int region)
+{
+    if (region >= AA_MAX_FREQ_REGIONS)
     {
         ofLog(OF_LOG_ERROR, "Invalid frequency region");
         return;
     }
     
-    float newCoef = 1.0f - (1.0f/(attackInMS*0.001f*_settings.sampleRate/_settings.bufferSize));
-    coefAttack[region] = CLAMP(newCoef, 0.0f, 0.99999999f);
+    regions[region].attackInMs = attackInMS;
+    parameters.coefAttack[region] = smoothingCoefficient(attackInMS);
+    publishParameters();
 }
 
-void ofxAudioAnalyzer::setReleaseInRegion(int releaseInMS, ofxAudioAnalyzerRegion region)
+void ofxAudioAnalyzer::setReleaseInRegion(int releaseInMS, unsigned int region)
 {
-    if (region >= AA_NUM_FREQ_REGIONS || region < 0)
+    if (region >= AA_MAX_FREQ_REGIONS)
     {
         ofLog(OF_LOG_ERROR, "Invalid frequency region");
         return;
     }
     
-    float newCoef = 1.0f - (1.0f/(releaseInMS*0.001f*_settings.sampleRate/_settings.bufferSize));
-    coefRelease[region] = CLAMP(newCoef, 0.0f, 0.99999999f);
+    regions[region].releaseInMs = releaseInMS;
+    parameters.coefRelease[region] = smoothingCoefficient(releaseInMS);
+    publishParameters();
+}
+
+void ofxAudioAnalyzer::setAttackInBand(int attackInMS, unsigned int band)
+{
+    if (band >= AA_MAX_BANDS)
+    {
+        ofLog(OF_LOG_ERROR, "Invalid filterbank band");
+        return;
+    }
+    parameters.bandCoefAttack[band] = smoothingCoefficient(attackInMS);
+    publishParameters();
+}
+
+void ofxAudioAnalyzer::setReleaseInBand(int releaseInMS, unsigned int band)
+{
+    if (band >= AA_MAX_BANDS)
+    {
+        ofLog(OF_LOG_ERROR, "Invalid filterbank band");
+        return;
+    }
+    parameters.bandCoefRelease[band] = smoothingCoefficient(releaseInMS);
+    publishParameters();
+}
+
+float ofxAudioAnalyzer::smoothingCoefficient(float timeInMs)
+{
+    // one-pole coefficient, applied once per hop
+    float newCoef = 1.0f - (1.0f/(timeInMs*0.001f*_settings.sampleRate/_settings.hopSize));
+    return CLAMP(newCoef, 0.0f, 0.99999999f);
+}
+
+bool ofxAudioAnalyzer::updateSnapshot()
+{
+    const AnalysisFrame & current = snapshotBuffer.front();
+    
+    // keep the outgoing snapshot's features for interpolation
+    RegionFeatures outgoing = current.regions;
+    unsigned long long outgoingTime = current.hostTimeMicros;
+    
+    if (!snapshotBuffer.update()) return false;
+    
+    previousSnapshotRegions = outgoing;
+    previousSnapshotTime = outgoingTime;
+    return true;
+}
+
+const ofxAudioAnalyzer::AnalysisFrame & ofxAudioAnalyzer::getSnapshot()
+{
+    return snapshotBuffer.front();
+}
+
+void ofxAudioAnalyzer::getInterpolatedFeatures(unsigned long long presentationTimeMicros, RegionFeatures & features)
+{
+    const AnalysisFrame & latest = snapshotBuffer.front();
+    const RegionFeatures & from = previousSnapshotRegions;
+    const RegionFeatures & to = latest.regions;
+    
+    features.numRegions = to.numRegions;
+    
+    float t = 1.0f;
+    if (latest.hostTimeMicros > previousSnapshotTime && previousSnapshotTime > 0 && from.numRegions == to.numRegions){
+        double interval = latest.hostTimeMicros - previousSnapshotTime;
+        double renderTime = (double)presentationTimeMicros - interval;
+        t = ofClamp((renderTime - previousSnapshotTime)/interval, 0.0, 1.0);
+    }
+    
+    for (unsigned int r=0; r<to.numRegions; r++){
+        if (t >= 1.0f){
+            features.energy[r] = to.energy[r];
+            features.energySmoothed[r] = to.energySmoothed[r];
+            features.psf[r] = to.psf[r];
+            features.psfSmoothed[r] = to.psfSmoothed[r];
+        }
+        else{
+            features.energy[r] = from.energy[r] + (to.energy[r] - from.energy[r])*t;
+            features.energySmoothed[r] = from.energySmoothed[r] + (to.energySmoothed[r] - from.energySmoothed[r])*t;
+            features.psf[r] = from.psf[r] + (to.psf[r] - from.psf[r])*t;
+            features.psfSmoothed[r] = from.psfSmoothed[r] + (to.psfSmoothed[r] - from.psfSmoothed[r])*t;
+        }
+    }
+}
+
+bool ofxAudioAnalyzer::getNextOnset(Onset & onset)
+{
+    Onset *next = onsetQueue.front();
+    if (!next) return false;
+    onset = *next;
+    onsetQueue.pop();
+    return true;
+}
+
+float ofxAudioAnalyzer::getBeatPhase(unsigned long long presentationTimeMicros)
+{
+    const AnalysisFrame & latest = snapshotBuffer.front();
+    
+    float phase = latest.beatPhase;
+    if (presentationTimeMicros > latest.hostTimeMicros){
+        phase += (presentationTimeMicros - latest.hostTimeMicros)*0.000001f*latest.tempoBpm/60.0f;
+    }
+    return phase - floorf(phase);
+}
+
+float ofxAudioAnalyzer::getTempoBpm()
+{
+    return snapshotBuffer.front().tempoBpm;
+}
+
+bool ofxAudioAnalyzer::getLatestFrame(AnalysisFrame & frame)
+{
+    return frameRing.read(frame);
+}
+
+unsigned int ofxAudioAnalyzer::getRecentFrames(vector<AnalysisFrame> & frames, unsigned int nFrames)
+{
+    return frameRing.readRecent(frames, nFrames);
+}
+
+unsigned int ofxAudioAnalyzer::getTornFrameReads()
+{
+    return frameRing.getTornReadCount();
 }
 
 vector<float> ofxAudioAnalyzer::getFFTBins()
 {
     vector<float> bins;
-    fftMutex.lock();
-    bins = storedFFTData;
-    fftMutex.unlock();
+    if (!getFFTBins(bins)) bins.clear();
     return bins;
 }
 
 vector<float> ofxAudioAnalyzer::getPSFData()
 {
-    vector<float> flux;
-    psfMutex.lock();
-    flux = storedPSFData;
-    psfMutex.unlock();
-    return flux;
+    vector<float> psf;
+    if (!getPSFData(psf)) psf.clear();
+    return psf;
 }
 
 vector<float> ofxAudioAnalyzer::getPCMData()
 {
     vector<float> pcm;
-    pcmMutex.lock();
-    pcm = pcmBuffer;
-    pcmMutex.unlock();
+    if (!getPCMData(pcm)) pcm.clear();
     return pcm;
 }
 
+bool ofxAudioAnalyzer::getFFTBins(vector<float> & bins)
+{
+    return frameRing.read(bins, &AnalysisFrame::fftBins);
+}
+
+bool ofxAudioAnalyzer::getPSFData(vector<float> & psf)
+{
+    return frameRing.read(psf, &AnalysisFrame::psf);
+}
+
+bool ofxAudioAnalyzer::getPCMData(vector<float> & pcm)
+{
+    return frameRing.read(pcm, &AnalysisFrame::pcm);
+}
+
 float ofxAudioAnalyzer::getSignalEnergy(bool smoothed)
 {
-    return smoothed ? signalEnergySmoothed[AA_FREQ_REGION_ALL] : signalEnergySmoothed[AA_FREQ_REGION_ALL];
+    return smoothed ? signalEnergySmoothed[AA_FREQ_REGION_ALL] : signalEnergy[AA_FREQ_REGION_ALL];
 }
 
-float ofxAudioAnalyzer::getSignalEnergyInRegion(ofxAudioAnalyzerRegion region, bool smoothed)
+float ofxAudioAnalyzer::getSignalEnergyInRegion(unsigned int region, bool smoothed)
 {
-    if (region < 0 || region > 3)
+    if (region >= parameters.numRegions)
         return 0.0f;
     
     return smoothed ? signalEnergySmoothed[region] : signalEnergy[region];
@@ -254,28 +808,68 @@ float ofxAudioAnalyzer::getTotalPSF(bool smoothed)
     return smoothed ? signalPSFSmoothed[AA_FREQ_REGION_ALL] : signalPSF[AA_FREQ_REGION_ALL];
 }
 
-float ofxAudioAnalyzer::getPSFinRegion(ofxAudioAnalyzerRegion region, bool smoothed)
+float ofxAudioAnalyzer::getPSFinRegion(unsigned int region, bool smoothed)
 {
-    
-    if (region < 0 || region >= AA_NUM_FREQ_REGIONS)
+    if (region >= parameters.numRegions)
         return 0.0f;
     
     return smoothed ? signalPSFSmoothed[region] : signalPSF[region];
 }
 
+unsigned int ofxAudioAnalyzer::getNumBands()
+{
+    return filterbank.getNumBands();
+}
+
+float ofxAudioAnalyzer::getBandEnergy(unsigned int band, bool smoothed)
+{
+    if (band >= filterbank.getNumBands())
+        return 0.0f;
+    
+    return smoothed ? bandEnergySmoothed[band] : bandEnergy[band];
+}
+
+float ofxAudioAnalyzer::getBandCenterFrequency(unsigned int band)
+{
+    if (band >= filterbank.getNumBands())
+        return 0.0f;
+    
+    return filterbank.getCenterFrequency(band);
+}
+
+float ofxAudioAnalyzer::getSpectralCentroid()
+{
+    return spectralCentroid;
+}
+
+float ofxAudioAnalyzer::getSpectralRolloff()
+{
+    return spectralRolloff;
+}
+
+float ofxAudioAnalyzer::getSpectralFlatness()
+{
+    return spectralFlatness;
+}
+
+float ofxAudioAnalyzer::getRMS()
+{
+    return spectralRMS;
+}
+
 unsigned int ofxAudioAnalyzer::binForFrequency(float freqInHz)
 {
     float nyquist = _settings.sampleRate/2;
 
-    if (freqInHz <= 0 || !fft)
+    if (freqInHz <= 0 || !nFftBins)
     {
         return 0;
     }
     else if (freqInHz >= nyquist)
     {
-        return fft->getBinSize();
+        return nFftBins;
     }
     else{
-        return MIN((unsigned int)roundf(freqInHz*fft->getBinSize()/nyquist), fft->getBinSize()-1);
+        return MIN((unsigned int)roundf(freqInHz*nFftBins/nyquist), nFftBins-1);
     }
 }
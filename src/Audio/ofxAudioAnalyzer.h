@@ -9,14 +9,31 @@
 #pragma once
 
 #include "ofBaseApp.h"
+#include "ofThread.h"
 #include "ofxFft.h"
+#include "ofxAudioRealFft.h"
+#include "ofxNDFrameRing.h"
+#include "ofxNDSpscQueue.h"
+#include "ofxNDTripleBuffer.h"
+#include "ofxNDSemaphore.h"
+#include "ofxNDClock.h"
+#include "ofxAudioSpectralKernel.h"
+#include "ofxAudioOnsetDetector.h"
+#include "ofxAudioBeatTracker.h"
+#include "ofxAudioFilterbank.h"
 
-#define AA_NUM_FREQ_REGIONS 4
+#define AA_MAX_FREQ_REGIONS 64
+#define AA_ONSET_QUEUE_SIZE 64
+#define AA_MAX_BANDS        64
+
+// Indices of the regions set up by default. Any number of regions
+// (up to AA_MAX_FREQ_REGIONS) can be configured with setRegions/addRegion.
 typedef enum {
     AA_FREQ_REGION_LOW = 0,
     AA_FREQ_REGION_MID,
     AA_FREQ_REGION_HIGH,
-    AA_FREQ_REGION_ALL
+    AA_FREQ_REGION_ALL,
+    AA_NUM_DEFAULT_FREQ_REGIONS
 } ofxAudioAnalyzerRegion;
 
 class ofxAudioAnalyzer : public ofBaseSoundInput{
@@ -25,36 +42,143 @@ public:
     
     struct Settings;
     struct FreqRegion;
+    struct AnalysisFrame;
+    struct AnalysisStats;
+    struct RegionFeatures;
+    struct SpectralFeatures;
+    typedef ofxAudioOnsetDetector::Onset Onset;
     
     ofxAudioAnalyzer();
     ~ofxAudioAnalyzer();
     void setup(Settings settings = Settings());
+    const Settings & getSettings() { return _settings; };
     
     void audioIn(float * input, int bufferSize, int nChannels);
     
+    // Input-agnostic entry point - audioIn forwards here. Use with
+    // settings.useInputStream = false to drive the analyzer from any source.
+    // With settings.threadedAnalysis this only downmixes into the analysis queue.
+    void process(const float * input, int nFrames, int nChannels);
+    unsigned int getAnalyzedFrameCount();   // analysis hops run so far
+    
+    AnalysisStats getAnalysisStats();
+    void resetAnalysisStats();
+    
+    // Regions are summed from prefix sums, so their count and width don't affect per-hop cost.
+    // The region and band setters can be called while audio is running, from the thread
+    // that called setup(); the analysis picks up each change whole at its next hop.
+    void setRegions(const vector<FreqRegion> & regions);
+    int  addRegion(FreqRegion region);      // returns the new region index, or -1 if full
+    unsigned int getNumRegions();
     void setLowMidHighRegions(FreqRegion lowRegion, FreqRegion midRegion, FreqRegion highRegion);
-    void setAttackInRegion(int attackInMS, ofxAudioAnalyzerRegion region);
-    void setReleaseInRegion(int releaseInMS, ofxAudioAnalyzerRegion region);
+    void setAttackInRegion(int attackInMS, unsigned int region);
+    void setReleaseInRegion(int releaseInMS, unsigned int region);
+    
+    // Consistent snapshot of the latest analysis frame for the render thread.
+    // updateSnapshot() swaps in the newest frame (returns false if none arrived);
+    // the reference from getSnapshot() stays valid and unchanged until the next
+    // updateSnapshot(). Neither call allocates. Call both from one thread only.
+    bool updateSnapshot();
+    const AnalysisFrame & getSnapshot();
+    
+    // Region features interpolated between the previous and current snapshot.
+    // Rendering runs one snapshot interval behind presentationTimeMicros
+    // (ofxNDClock) so values are interpolated, never extrapolated.
+    void getInterpolatedFeatures(unsigned long long presentationTimeMicros, RegionFeatures & features);
+    
+    // Onsets detected since the last call, oldest first, with sample clock timestamps.
+    // Returns false when none are waiting. Call from one reader thread only.
+    bool getNextOnset(Onset & onset);
+    
+    // Beat phase (0-1, 0 on the beat) of the current snapshot, advanced at the
+    // current tempo to presentationTimeMicros (ofxNDClock).
+    float getBeatPhase(unsigned long long presentationTimeMicros);
+    float getTempoBpm();
+    
+    // Lock-free frame access. Safe to call from any one reader thread while
+    // audio is running; never blocks the audio callback.
+    bool getLatestFrame(AnalysisFrame & frame);
+    unsigned int getRecentFrames(vector<AnalysisFrame> & frames, unsigned int nFrames);   // newest first
+    unsigned int getTornFrameReads();
     
     vector<float> getFFTBins();
-    vector<float> getPSFData();     // postive spectral flux can be thresholded to detect transients
+    vector<float> getPSFData();     // postive spectral flux, summed per hop for onset detection
     vector<float> getPCMData();
+    
+    // Same data copied into the caller's vector, which only allocates the first time
+    // (keep it around between calls). Only the one member is read out of the latest
+    // frame. Return false, contents unspecified, if no frame could be read intact.
+    bool getFFTBins(vector<float> & bins);
+    bool getPSFData(vector<float> & psf);
+    bool getPCMData(vector<float> & pcm);
+    
+    // Direct reads of the analysis state. These are not synchronized with the audio
+    // thread - values for different regions may come from different hops.
     float getSignalEnergy(bool smoothed = true);
-    float getSignalEnergyInRegion(ofxAudioAnalyzerRegion region, bool smoothed = true);
+    float getSignalEnergyInRegion(unsigned int region, bool smoothed = true);
     float getTotalPSF(bool smoothed = true);
-    float getPSFinRegion(ofxAudioAnalyzerRegion region, bool smoothed = true);
+    float getPSFinRegion(unsigned int region, bool smoothed = true);
+    
+    // Filterbank bands (settings.numBands, mel or log spaced) and whole-spectrum
+    // features. Computed in the same pass as energy/PSF unless settings.spectralFeatures is off.
+    unsigned int getNumBands();
+    float getBandEnergy(unsigned int band, bool smoothed = true);
+    float getBandCenterFrequency(unsigned int band);
+    void setAttackInBand(int attackInMS, unsigned int band);
+    void setReleaseInBand(int releaseInMS, unsigned int band);
+    float getSpectralCentroid();    // Hz
+    float getSpectralRolloff();     // Hz below which settings.rolloffFraction of the magnitude lies
+    float getSpectralFlatness();    // 0 (tonal) - 1 (noise), over the filterbank bands
+    float getRMS();                 // RMS of the magnitude spectrum
     
     struct Settings {
       
+        bool         useInputStream;    // false to feed process() manually (offline analysis)
         int          inputDeviceId;
         bool         stereo;
         unsigned int sampleRate;
         unsigned int bufferSize;
+        unsigned int numInputChannels;  // channels to open on the stream, 0 = 2 if stereo else 1
+        
+        // Group of interleaved input channels averaged into the analyzed signal.
+        // channelCount 0 = the first two channels (legacy stereo downmix).
+        unsigned int channelOffset;
+        unsigned int channelCount;
+        
+        // Analysis runs on a sliding window of the last fftSize samples,
+        // once every hopSize samples, independent of bufferSize.
+        // 0 means "same as bufferSize" for fftSize and "same as fftSize" (no overlap) for hopSize.
+        unsigned int        fftSize;
+        unsigned int        hopSize;
         
         fftWindowType       windowType;
-        fftImplementation   implementation;
+        fftImplementation   implementation;     // used only when the built-in FFT is off or unavailable
+        
+        // Built-in real FFT for power-of-two fftSize 256-8192, ofxFft otherwise
+        bool                useBuiltinFft;
         
-        // TODO: Overlap? FFT window size different from input buffer size?
+        unsigned int        frameHistorySize;   // number of analysis frames kept for readers
+        
+        // Run FFT & features on a dedicated thread instead of the audio callback.
+        // The callback then only downmixes into a queue of analysisQueueBlocks blocks
+        // (bufferSize frames each); blocks arriving while the queue is full are dropped.
+        bool                threadedAnalysis;
+        unsigned int        analysisQueueBlocks;
+        
+        // Onset detection and beat tracking on the total spectral flux, once per hop
+        bool                            detectOnsets;
+        ofxAudioOnsetDetector::Settings onsetSettings;
+        ofxAudioBeatTracker::Settings   beatSettings;
+        
+        // Filterbank & scalar spectral features
+        bool                    spectralFeatures;
+        unsigned int            numBands;           // up to AA_MAX_BANDS, 0 for none
+        ofxAudioFilterbankScale bandScale;
+        float                   bandLowFreq;
+        float                   bandHighFreq;
+        float                   bandAttackInMs;
+        float                   bandReleaseInMs;
+        float                   rolloffFraction;
         
         Settings();
     };
@@ -64,43 +188,220 @@ public:
         float lowerFreq;
         float upperFreq;
         
-        // TODO
-        //float attackInMs;
-        //float releaseInMs;
+        float attackInMs;
+        float releaseInMs;
         
-        FreqRegion() {
-            lowerFreq = 0.0f;
-            upperFreq = 0.0f;
+        FreqRegion(float lower = 0.0f, float upper = 0.0f, float attack = 1.0f, float release = 150.0f) {
+            lowerFreq = lower;
+            upperFreq = upper;
+            attackInMs = attack;
+            releaseInMs = release;
+        };
+        
+        // nBands contiguous log-spaced bands between lowFreq and highFreq
+        static vector<FreqRegion> logSpaced(unsigned int nBands, float lowFreq, float highFreq);
+    };
+    
+    struct AnalysisStats {
+        
+        unsigned int queueDepth;            // blocks waiting for the analysis thread
+        unsigned int maxQueueDepth;
+        unsigned int droppedBlocks;         // blocks lost because the queue was full
+        unsigned int droppedFrames;         // the samples in them, per channel
+        unsigned int worstAnalysisMicros;   // longest time spent analyzing one input block
+        
+        AnalysisStats() {
+            queueDepth = 0;
+            maxQueueDepth = 0;
+            droppedBlocks = 0;
+            droppedFrames = 0;
+            worstAnalysisMicros = 0;
+        };
+    };
+    
+    struct RegionFeatures {
+        
+        unsigned int    numRegions;
+        float           energy[AA_MAX_FREQ_REGIONS];
+        float           energySmoothed[AA_MAX_FREQ_REGIONS];
+        float           psf[AA_MAX_FREQ_REGIONS];
+        float           psfSmoothed[AA_MAX_FREQ_REGIONS];
+        
+        RegionFeatures() {
+            numRegions = 0;
+            memset(energy, 0, sizeof(energy));
+            memset(energySmoothed, 0, sizeof(energySmoothed));
+            memset(psf, 0, sizeof(psf));
+            memset(psfSmoothed, 0, sizeof(psfSmoothed));
+        };
+    };
+    
+    struct SpectralFeatures {
+        
+        float           centroid;
+        float           rolloff;
+        float           flatness;
+        float           rms;
+        unsigned int    numBands;
+        float           bands[AA_MAX_BANDS];
+        float           bandsSmoothed[AA_MAX_BANDS];
+        
+        SpectralFeatures() {
+            centroid = 0.0f;
+            rolloff = 0.0f;
+            flatness = 0.0f;
+            rms = 0.0f;
+            numBands = 0;
+            memset(bands, 0, sizeof(bands));
+            memset(bandsSmoothed, 0, sizeof(bandsSmoothed));
+        };
+    };
+    
+    struct AnalysisFrame {
+        
+        vector<float>       pcm;
+        vector<float>       fftBins;
+        vector<float>       psf;
+        RegionFeatures      regions;
+        SpectralFeatures    spectral;
+        float               novelty;            // normalized spectral flux fed to the onset detector
+        bool                onset;              // an onset was reported during this hop
+        float               beatPhase;          // at sampleTime
+        float               tempoBpm;
+        unsigned int        beatCount;
+        unsigned int        frameIndex;
+        unsigned long long  sampleTime;         // input sample clock at the end of the analysis window
+        unsigned long long  hostTimeMicros;     // ofxNDClock when the frame was published
+        
+        AnalysisFrame() {
+            novelty = 0.0f;
+            onset = false;
+            beatPhase = 0.0f;
+            tempoBpm = 0.0f;
+            beatCount = 0;
+            frameIndex = 0;
+            sampleTime = 0;
+            hostTimeMicros = 0;
         };
     };
 
 private:
     
+    struct PCMBlock {
+        vector<float>   samples;    // mono
+        int             nFrames;
+        PCMBlock() { nFrames = 0; };
+    };
+    
+    class AnalysisThread;
+    friend class AnalysisThread;
+    
+    // Drains the block queue, then sleeps until the audio callback queues more
+    class AnalysisThread : public ofThread {
+    public:
+        AnalysisThread();
+        ofxAudioAnalyzer *analyzer;
+        void wake();
+        void quit();
+    protected:
+        void threadedFunction();
+    private:
+        ofxNDSemaphore      _wakeup;
+        volatile int        _pending;       // a wakeup was signaled and not drained yet
+        volatile int        _quit;
+    };
+    
     Settings        _settings;
     
     ofSoundStream   inputStream;
-    ofxFft          *fft;
+    ofxAudioFftEngine   *fftEngine;         // built-in FFT, or NULL when falling back to ofxFft
+    ofxFft              *fft;
+    unsigned int        nFftBins;           // fftSize/2+1 once set up, 0 before
 
-    vector<float>   pcmBuffer;
+    // owned by the audio thread
+    vector<float>   windowBuffer;           // circular, fftSize samples
+    unsigned int    windowWritePos;
+    unsigned int    samplesSinceHop;
+    vector<float>   pcmBuffer;              // windowBuffer unrolled, oldest sample first
+    ofxNDAlignedArray<float>    fftReal;    // built-in FFT output, nFftBins each
+    ofxNDAlignedArray<float>    fftImag;
     vector<float>   analyzedFFTData;
-    vector<float>   storedFFTData;
+    vector<float>   previousFFTData;        // swapped with analyzedFFTData every hop
     vector<float>   analyzedPSFData;
-    vector<float>   storedPSFData;
-    
-    float           coefAttack[AA_NUM_FREQ_REGIONS];
-    float           coefRelease[AA_NUM_FREQ_REGIONS];
-    float           signalEnergy[AA_NUM_FREQ_REGIONS];
-    float           signalEnergySmoothed[AA_NUM_FREQ_REGIONS];
-    float           signalPSF[AA_NUM_FREQ_REGIONS];
-    float           signalPSFSmoothed[AA_NUM_FREQ_REGIONS];
-    FreqRegion      _lowRegion;
-    FreqRegion      _midRegion;
-    FreqRegion      _highRegion;
-    
-    ofMutex         pcmMutex;
-    ofMutex         fftMutex;
-    ofMutex         psfMutex;
+    vector<float>   energyPrefix;           // nBins+1 running sums for O(1) region queries
+    vector<float>   psfPrefix;
+    unsigned int    analyzedFrameCount;
+    unsigned long long  sampleClock;
+    
+    // published to readers
+    ofxNDFrameRing<AnalysisFrame>       frameRing;
+    ofxNDTripleBuffer<AnalysisFrame>    snapshotBuffer;
+    
+    // rhythm
+    ofxAudioOnsetDetector       onsetDetector;
+    ofxAudioBeatTracker         beatTracker;
+    ofxNDSpscQueue<Onset>       onsetQueue;
+    bool                        hopOnset;
+    
+    // render thread
+    RegionFeatures      previousSnapshotRegions;
+    unsigned long long  previousSnapshotTime;
+    
+    // threaded analysis
+    AnalysisThread                  analysisThread;
+    ofxNDSpscQueue<PCMBlock>        blockQueue;
+    volatile unsigned int           statMaxQueueDepth;
+    volatile unsigned int           statDroppedBlocks;
+    volatile unsigned int           statDroppedFrames;
+    volatile unsigned int           statWorstAnalysisMicros;
+    
+    // Region bounds and smoothing coefficients. The setters edit `parameters` and
+    // publish a copy; the audio thread swaps in the latest at the start of a hop.
+    struct Parameters {
+        unsigned int    numRegions;
+        unsigned int    regionLowerBin[AA_MAX_FREQ_REGIONS];    // cached inclusive bin bounds
+        unsigned int    regionUpperBin[AA_MAX_FREQ_REGIONS];
+        unsigned int    regionGeneration[AA_MAX_FREQ_REGIONS];  // bumped when a region is added
+        float           coefAttack[AA_MAX_FREQ_REGIONS];
+        float           coefRelease[AA_MAX_FREQ_REGIONS];
+        float           bandCoefAttack[AA_MAX_BANDS];
+        float           bandCoefRelease[AA_MAX_BANDS];
+    };
+    
+    // setter thread
+    Parameters      parameters;
+    FreqRegion      regions[AA_MAX_FREQ_REGIONS];
+    
+    ofxNDTripleBuffer<Parameters>   parameterBuffer;
+    
+    // audio thread: region state is reset when its generation changes
+    unsigned int    regionGeneration[AA_MAX_FREQ_REGIONS];
+    float           signalEnergy[AA_MAX_FREQ_REGIONS];
+    float           signalEnergySmoothed[AA_MAX_FREQ_REGIONS];
+    float           signalPSF[AA_MAX_FREQ_REGIONS];
+    float           signalPSFSmoothed[AA_MAX_FREQ_REGIONS];
+    
+    // filterbank & spectral features
+    ofxAudioFilterbank  filterbank;
+    float           bandEnergy[AA_MAX_BANDS];
+    float           bandEnergySmoothed[AA_MAX_BANDS];
+    float           spectralCentroid;
+    float           spectralRolloff;
+    float           spectralFlatness;
+    float           spectralRMS;
     
     // helpers
+    void analyzeInput(const float *input, int nFrames, int nChannels);
+    void enqueueInput(const float *input, int nFrames, int nChannels);
+    void drainQueue();
+    void pushSamples(const float *input, int nFrames, int nChannels);
+    void downmix(const float *input, float *output, int nFrames, int nChannels);
+    void analyzeWindow();
+    void analyzeSpectrum(const ofxAudioSpectralMoments & moments, const Parameters & params, int nBins);
+    void fillFrame(AnalysisFrame & frame, const Parameters & params, int nBins, unsigned long long hostTime);
+    void updateParameters();
+    void setRegion(unsigned int index, const FreqRegion & region);
+    void publishParameters();
     unsigned int binForFrequency(float freqInHz);
+    float smoothingCoefficient(float timeInMs);
 };
\ No newline at end of file
@@ -0,0 +1,715 @@
+//
+//  ofxAudioAnalyzerFileRunner.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/4/12.
+//
+//
+
+#include "ofxAudioAnalyzerFileRunner.h"
+#include <unistd.h>
+
+#define WAV_FORMAT_PCM          1
+#define WAV_FORMAT_IEEE_FLOAT   3
+#define WAV_FORMAT_EXTENSIBLE   0xFFFE
+
+#define FFT_BENCHMARK_PASSES    3
+
+static unsigned int readLE32(const unsigned char *b)
+{
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+}
+
+static unsigned short readLE16(const unsigned char *b)
+{
+    return b[0] | (b[1] << 8);
+}
+
+#pragma mark - WAV reader
+
+ofxWavFileReader::ofxWavFileReader()
+{
+    _numChannels = 0;
+    _sampleRate = 0;
+    _bitsPerSample = 0;
+    _isFloat = false;
+    _numFrames = 0;
+    _framesRead = 0;
+}
+
+ofxWavFileReader::~ofxWavFileReader()
+{
+    close();
+}
+
+bool ofxWavFileReader::open(const string &path)
+{
+    close();
+    
+    _file.open(ofToDataPath(path).c_str(), std::ios::in | std::ios::binary);
+    if (!_file.is_open()){
+        ofLog(OF_LOG_ERROR, "ofxWavFileReader: could not open " + path);
+        return false;
+    }
+    
+    unsigned char header[12];
+    _file.read((char*)header, 12);
+    if (!_file || memcmp(header, "RIFF", 4) != 0 || memcmp(header+8, "WAVE", 4) != 0){
+        ofLog(OF_LOG_ERROR, "ofxWavFileReader: not a RIFF/WAVE file " + path);
+        close();
+        return false;
+    }
+    
+    bool foundFormat = false;
+    unsigned char chunkHeader[8];
+    while (_file.read((char*)chunkHeader, 8)){
+        
+        unsigned int chunkSize = readLE32(chunkHeader+4);
+        
+        if (memcmp(chunkHeader, "fmt ", 4) == 0){
+            
+            unsigned char fmt[40];
+            memset(fmt, 0, sizeof(fmt));
+            _file.read((char*)fmt, MIN(chunkSize, sizeof(fmt)));
+            if (chunkSize > sizeof(fmt)) _file.seekg(chunkSize - sizeof(fmt), std::ios::cur);
+            
+            unsigned short format = readLE16(fmt);
+            _numChannels = readLE16(fmt+2);
+            _sampleRate = readLE32(fmt+4);
+            _bitsPerSample = readLE16(fmt+14);
+            if (format == WAV_FORMAT_EXTENSIBLE && chunkSize >= 26){
+                // first two bytes of the subformat GUID hold the actual format
+                format = readLE16(fmt+24);
+            }
+            _isFloat = (format == WAV_FORMAT_IEEE_FLOAT);
+            
+            if ((format != WAV_FORMAT_PCM && format != WAV_FORMAT_IEEE_FLOAT) ||
+                (_isFloat && _bitsPerSample != 32) ||
+                (!_isFloat && _bitsPerSample != 16 && _bitsPerSample != 24 && _bitsPerSample != 32) ||
+                _numChannels <= 0)
+            {
+                ofLog(OF_LOG_ERROR, "ofxWavFileReader: unsupported sample format in " + path);
+                close();
+                return false;
+            }
+            foundFormat = true;
+        }
+        else if (memcmp(chunkHeader, "data", 4) == 0){
+            
+            if (!foundFormat){
+                ofLog(OF_LOG_ERROR, "ofxWavFileReader: data chunk before fmt chunk in " + path);
+                close();
+                return false;
+            }
+            _numFrames = chunkSize/(_numChannels*_bitsPerSample/8);
+            _framesRead = 0;
+            return true;
+        }
+        else{
+            // chunks are padded to an even size
+            _file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+        }
+    }
+    
+    ofLog(OF_LOG_ERROR, "ofxWavFileReader: no data chunk in " + path);
+    close();
+    return false;
+}
+
+void ofxWavFileReader::close()
+{
+    if (_file.is_open()){
+        _file.close();
+    }
+    _file.clear();
+    _numFrames = 0;
+    _framesRead = 0;
+}
+
+int ofxWavFileReader::read(float *output, int nFrames)
+{
+    if (!_file.is_open()) return 0;
+    
+    nFrames = MIN((unsigned int)nFrames, _numFrames - _framesRead);
+    if (nFrames <= 0) return 0;
+    
+    int bytesPerSample = _bitsPerSample/8;
+    int nSamples = nFrames*_numChannels;
+    _readBuffer.resize(nSamples*bytesPerSample);
+    _file.read(&_readBuffer[0], _readBuffer.size());
+    nSamples = _file.gcount()/bytesPerSample;
+    nFrames = nSamples/_numChannels;
+    
+    const unsigned char *b = (const unsigned char*)&_readBuffer[0];
+    for (int i=0; i<nSamples; i++, b += bytesPerSample){
+        if (_isFloat){
+            unsigned int bits = readLE32(b);
+            memcpy(&output[i], &bits, sizeof(float));
+        }
+        else if (bytesPerSample == 2){
+            output[i] = (short)readLE16(b) / 32768.0f;
+        }
+        else if (bytesPerSample == 3){
+            int value = (b[0] << 8) | (b[1] << 16) | (b[2] << 24);
+            output[i] = (value >> 8) / 8388608.0f;
+        }
+        else{
+            output[i] = (int)readLE32(b) / 2147483648.0f;
+        }
+    }
+    
+    _framesRead += nFrames;
+    return nFrames;
+}
+
+#pragma mark - Runner
+
+ofxAudioAnalyzerFileRunner::Result::Result()
+{
+    success = false;
+    numHops = 0;
+    audioSeconds = 0;
+    analysisSeconds = 0;
+    totalSeconds = 0;
+    realtimeMultiple = 0;
+    numOnsets = 0;
+}
+
+ofxAudioAnalyzerFileRunner::OnsetLatencyResult::OnsetLatencyResult()
+{
+    numClicks = 0;
+    numDetected = 0;
+    numFalseOnsets = 0;
+    meanTimestampErrorMs = 0;
+    maxTimestampErrorMs = 0;
+    meanLatencyMs = 0;
+    maxLatencyMs = 0;
+    meanProcessMicros = 0;
+    tempoBpm = 0;
+}
+
+ofxAudioAnalyzerFileRunner::Result ofxAudioAnalyzerFileRunner::run(const string &wavPath, const string &csvPath, ofxAudioAnalyzer::Settings settings)
+{
+    Result result;
+    unsigned long long startTime = ofGetElapsedTimeMicros();
+    
+    ofxWavFileReader reader;
+    if (!reader.open(wavPath)){
+        return result;
+    }
+    
+    std::ofstream csv;
+    if (!csvPath.empty()){
+        csv.open(ofToDataPath(csvPath).c_str());
+        if (!csv.is_open()){
+            ofLog(OF_LOG_ERROR, "ofxAudioAnalyzerFileRunner: could not open " + csvPath);
+            return result;
+        }
+    }
+    
+    settings.useInputStream = false;
+    settings.threadedAnalysis = false;     // hops must finish inside process() to be logged
+    settings.sampleRate = reader.getSampleRate();
+    settings.stereo = reader.getNumChannels() > 1;
+    
+    ofxAudioAnalyzer analyzer;
+    analyzer.setup(settings);
+    settings = analyzer.getSettings();
+    
+    unsigned int nRegions = analyzer.getNumRegions();
+    if (csv.is_open()){
+        csv << "hop,time";
+        for (unsigned int r=0; r<nRegions; r++){
+            csv << ",energy" << r << ",psf" << r;
+        }
+        csv << ",centroid,rolloff,flatness,rms,onset\n";
+    }
+    
+    // feed one hop at a time so every analysis frame can be logged
+    int nChannels = reader.getNumChannels();
+    vector<float> block(settings.hopSize*nChannels);
+    unsigned long long analysisMicros = 0;
+    unsigned int totalFrames = 0;
+    
+    int nRead;
+    while ((nRead = reader.read(&block[0], settings.hopSize)) > 0){
+        
+        unsigned int hopsBefore = analyzer.getAnalyzedFrameCount();
+        
+        unsigned long long t0 = ofGetElapsedTimeMicros();
+        analyzer.process(&block[0], nRead, nChannels);
+        analysisMicros += ofGetElapsedTimeMicros() - t0;
+        
+        totalFrames += nRead;
+        
+        // onset time in seconds, empty if this hop reported none
+        double onsetTime = -1.0;
+        ofxAudioAnalyzer::Onset onset;
+        while (analyzer.getNextOnset(onset)){
+            onsetTime = (double)onset.sampleTime/settings.sampleRate;
+            result.numOnsets++;
+        }
+        
+        if (csv.is_open() && analyzer.getAnalyzedFrameCount() != hopsBefore){
+            csv << hopsBefore << "," << (double)totalFrames/settings.sampleRate;
+            for (unsigned int r=0; r<nRegions; r++){
+                csv << "," << analyzer.getSignalEnergyInRegion(r, false) << "," << analyzer.getPSFinRegion(r, false);
+            }
+            csv << "," << analyzer.getSpectralCentroid() << "," << analyzer.getSpectralRolloff()
+                << "," << analyzer.getSpectralFlatness() << "," << analyzer.getRMS() << ",";
+            if (onsetTime >= 0.0) csv << onsetTime;
+            csv << "\n";
+        }
+    }
+    
+    result.success = true;
+    result.numHops = analyzer.getAnalyzedFrameCount();
+    result.audioSeconds = (double)totalFrames/settings.sampleRate;
+    result.analysisSeconds = analysisMicros/1000000.0;
+    result.totalSeconds = (ofGetElapsedTimeMicros() - startTime)/1000000.0;
+    result.realtimeMultiple = result.analysisSeconds > 0 ? result.audioSeconds/result.analysisSeconds : 0;
+    return result;
+}
+
+void ofxAudioAnalyzerFileRunner::logResult(const Result &result)
+{
+    if (!result.success){
+        ofLog(OF_LOG_ERROR, "ofxAudioAnalyzerFileRunner: run failed");
+        return;
+    }
+    
+    stringstream ss;
+    ss << "ofxAudioAnalyzerFileRunner: " << result.numHops << " hops, "
+       << result.audioSeconds << "s audio analyzed in " << result.analysisSeconds << "s ("
+       << result.realtimeMultiple << "x realtime, " << result.totalSeconds << "s total with IO), "
+       << result.numOnsets << " onsets";
+    ofLog(OF_LOG_NOTICE, ss.str());
+}
+
+void ofxAudioAnalyzerFileRunner::benchmarkChannelScaling(unsigned int maxChannels, float seconds, ofxAudioAnalyzer::Settings settings)
+{
+    settings.useInputStream = false;
+    
+    // the multichannel analyzer only threads more than one group; the one channel
+    // baseline has to go through the same queue and thread to compare with
+    settings.threadedAnalysis = true;
+    if (settings.fftSize == 0) settings.fftSize = settings.bufferSize;
+    if (settings.hopSize == 0) settings.hopSize = settings.fftSize;
+    
+    unsigned int nBlocks = seconds*settings.sampleRate/settings.bufferSize;
+    if (nBlocks == 0) return;
+    
+    // queue must hold the whole run: the benchmark feeds faster than realtime
+    settings.analysisQueueBlocks = nBlocks + 1;
+    
+    double singleChannelSeconds = 0.0;
+    
+    for (unsigned int nChannels = 1; nChannels <= maxChannels; nChannels *= 2){
+        
+        vector<float> block(settings.bufferSize*nChannels);
+        for (unsigned int i=0; i<block.size(); i++){
+            block[i] = ofRandomf()*0.5f;
+        }
+        
+        ofxMultiChannelAudioAnalyzer::Settings multiSettings;
+        multiSettings.analyzerSettings = settings;
+        multiSettings.numInputChannels = nChannels;
+        
+        ofxMultiChannelAudioAnalyzer multiAnalyzer;
+        multiAnalyzer.setup(multiSettings);
+        
+        unsigned int expectedHops = (nBlocks*settings.bufferSize)/settings.hopSize;
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+        
+        for (unsigned int b=0; b<nBlocks; b++){
+            multiAnalyzer.process(&block[0], settings.bufferSize, nChannels);
+        }
+        
+        // wait for every analysis thread to catch up
+        bool done = false;
+        while (!done){
+            done = true;
+            for (unsigned int a=0; a<multiAnalyzer.getNumAnalyzers(); a++){
+                if (multiAnalyzer.getAnalyzer(a).getAnalyzedFrameCount() < expectedHops){
+                    done = false;
+                    break;
+                }
+            }
+            if (!done) ofSleepMillis(1);
+        }
+        
+        double elapsed = (ofGetElapsedTimeMicros() - startTime)/1000000.0;
+        if (nChannels == 1) singleChannelSeconds = elapsed;
+        
+        // speedup relative to analyzing the same channels one after another
+        double speedup = elapsed > 0 ? singleChannelSeconds*nChannels/elapsed : 0;
+        
+        stringstream ss;
+        ss << "ofxAudioAnalyzerFileRunner: " << nChannels << " channel(s): " << elapsed << "s for "
+           << seconds << "s audio (" << seconds/elapsed << "x realtime per channel, parallel speedup "
+           << speedup << "x)";
+        ofLog(OF_LOG_NOTICE, ss.str());
+    }
+}
+
+ofxAudioAnalyzerFileRunner::OnsetLatencyResult ofxAudioAnalyzerFileRunner::measureOnsetLatency(float bpm, float seconds, ofxAudioAnalyzer::Settings settings)
+{
+    OnsetLatencyResult result;
+    
+    settings.useInputStream = false;
+    settings.threadedAnalysis = false;
+    settings.detectOnsets = true;
+    settings.numInputChannels = 1;
+    settings.channelOffset = 0;
+    settings.channelCount = 1;
+    
+    ofxAudioAnalyzer analyzer;
+    analyzer.setup(settings);
+    settings = analyzer.getSettings();
+    
+    // click track: 5ms decaying noise bursts, offset so they don't line up with hops
+    unsigned int nFrames = seconds*settings.sampleRate;
+    unsigned int clickInterval = 60.0f*settings.sampleRate/bpm;
+    unsigned int clickLength = 0.005f*settings.sampleRate;
+    vector<float> signal(nFrames);
+    vector<unsigned int> clicks;
+    
+    ofSeedRandom(1);
+    for (unsigned int i=0; i<nFrames; i++){
+        signal[i] = ofRandomf()*0.001f;
+    }
+    for (unsigned int start = clickInterval/2 + 37; start + clickLength < nFrames; start += clickInterval){
+        clicks.push_back(start);
+        for (unsigned int i=0; i<clickLength; i++){
+            signal[start + i] += ofRandomf()*0.8f*expf(-5.0f*i/clickLength);
+        }
+    }
+    
+    vector<bool> clickMatched(clicks.size(), false);
+    double timestampErrorSum = 0.0;
+    double latencySum = 0.0;
+    double processMicrosSum = 0.0;
+    float msPerSample = 1000.0f/settings.sampleRate;
+    
+    for (unsigned int offset = 0; offset + settings.bufferSize <= nFrames; offset += settings.bufferSize){
+        
+        unsigned long long t0 = ofGetElapsedTimeMicros();
+        analyzer.process(&signal[offset], settings.bufferSize, 1);
+        unsigned long long elapsed = ofGetElapsedTimeMicros() - t0;
+        
+        ofxAudioAnalyzer::Onset onset;
+        while (analyzer.getNextOnset(onset)){
+            
+            // nearest click before or after the reported time
+            int nearest = -1;
+            double nearestError = 0.0;
+            for (unsigned int c=0; c<clicks.size(); c++){
+                double error = fabs((double)onset.sampleTime - clicks[c])*msPerSample;
+                if (nearest < 0 || error < nearestError){
+                    nearest = c;
+                    nearestError = error;
+                }
+            }
+            
+            if (nearest < 0 || nearestError > 50.0 || clickMatched[nearest]){
+                result.numFalseOnsets++;
+                continue;
+            }
+            
+            clickMatched[nearest] = true;
+            result.numDetected++;
+            
+            double latency = ((double)onset.detectedAt - clicks[nearest])*msPerSample;
+            timestampErrorSum += nearestError;
+            latencySum += latency;
+            processMicrosSum += elapsed;
+            result.maxTimestampErrorMs = MAX(result.maxTimestampErrorMs, nearestError);
+            result.maxLatencyMs = MAX(result.maxLatencyMs, latency);
+        }
+    }
+    
+    result.numClicks = clicks.size();
+    if (result.numDetected > 0){
+        result.meanTimestampErrorMs = timestampErrorSum/result.numDetected;
+        result.meanLatencyMs = latencySum/result.numDetected;
+        result.meanProcessMicros = processMicrosSum/result.numDetected;
+    }
+    analyzer.updateSnapshot();
+    result.tempoBpm = analyzer.getTempoBpm();
+    
+    return result;
+}
+
+void ofxAudioAnalyzerFileRunner::logOnsetLatency(const OnsetLatencyResult &result)
+{
+    stringstream ss;
+    ss << "ofxAudioAnalyzerFileRunner: onsets " << result.numDetected << "/" << result.numClicks
+       << " detected, " << result.numFalseOnsets << " false. Timestamp error mean "
+       << result.meanTimestampErrorMs << "ms max " << result.maxTimestampErrorMs
+       << "ms. Click to event latency mean " << result.meanLatencyMs << "ms max " << result.maxLatencyMs
+       << "ms (+" << result.meanProcessMicros << "us processing). Tempo " << result.tempoBpm << " bpm";
+    ofLog(OF_LOG_NOTICE, ss.str());
+}
+
+float ofxAudioAnalyzerFileRunner::benchmarkFeatureCost(float seconds, unsigned int passes, ofxAudioAnalyzer::Settings settings)
+{
+    settings.useInputStream = false;
+    settings.threadedAnalysis = false;
+    
+    unsigned int nFrames = seconds*settings.sampleRate;
+    vector<float> signal(nFrames);
+    ofSeedRandom(1);
+    for (unsigned int i=0; i<nFrames; i++){
+        signal[i] = ofRandomf()*0.5f;
+    }
+    
+    double bestMicros[2] = {0, 0};
+    unsigned int numHops = 0;
+    
+    for (unsigned int p=0; p<passes*2; p++){
+        
+        bool features = (p % 2) == 1;
+        settings.spectralFeatures = features;
+        
+        ofxAudioAnalyzer analyzer;
+        analyzer.setup(settings);
+        unsigned int bufferSize = analyzer.getSettings().bufferSize;
+        
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+        for (unsigned int offset = 0; offset + bufferSize <= nFrames; offset += bufferSize){
+            analyzer.process(&signal[offset], bufferSize, 1);
+        }
+        double elapsed = ofGetElapsedTimeMicros() - startTime;
+        
+        numHops = analyzer.getAnalyzedFrameCount();
+        if (bestMicros[features] == 0 || elapsed < bestMicros[features]){
+            bestMicros[features] = elapsed;
+        }
+    }
+    
+    if (numHops == 0 || bestMicros[0] <= 0) return 0.0f;
+    
+    double baseHop = bestMicros[0]/numHops;
+    double featureHop = bestMicros[1]/numHops;
+    float overhead = 100.0*(featureHop - baseHop)/baseHop;
+    
+    stringstream ss;
+    ss << "ofxAudioAnalyzerFileRunner: per hop " << baseHop << "us without spectral features, "
+       << featureHop << "us with " << settings.numBands << " bands (" << overhead << "% overhead)";
+    ofLog(overhead < 10.0f ? OF_LOG_NOTICE : OF_LOG_WARNING, ss.str());
+    
+    return overhead;
+}
+
+unsigned int ofxAudioAnalyzerFileRunner::benchmarkFft(unsigned int callsPerSize, fftWindowType windowType)
+{
+    const fftImplementation backends[2] = {OF_FFT_FFTW, OF_FFT_BASIC};
+    const char *backendNames[2] = {"ofxFft FFTW", "ofxFft basic"};
+    unsigned int numSlower = 0;
+    
+    ofSeedRandom(1);
+    
+    for (unsigned int l = AA_FFT_MIN_LOG2_SIZE; l <= AA_FFT_MAX_LOG2_SIZE; l++){
+        
+        unsigned int size = 1 << l;
+        vector<float> signal(size);
+        for (unsigned int i=0; i<size; i++){
+            signal[i] = ofRandomf()*0.5f;
+        }
+        
+        ofxAudioFftEngine *engine = ofxAudioFftEngine::create(size, windowType);
+        unsigned int nBins = engine->getBinSize();
+        ofxNDAlignedArray<float> real, imag;
+        real.allocate(nBins);
+        imag.allocate(nBins);
+        
+        // fastest of a few passes, against scheduling noise
+        double builtinMicros = 0;
+        for (unsigned int p=0; p<FFT_BENCHMARK_PASSES; p++){
+            unsigned long long startTime = ofGetElapsedTimeMicros();
+            for (unsigned int c=0; c<callsPerSize; c++){
+                engine->process(&signal[0], real.data(), imag.data());
+            }
+            double micros = (double)(ofGetElapsedTimeMicros() - startTime)/callsPerSize;
+            if (p == 0 || micros < builtinMicros) builtinMicros = micros;
+        }
+        
+        stringstream ss;
+        ss << "ofxAudioAnalyzerFileRunner: FFT " << size << ": built-in " << builtinMicros << "us";
+        
+        double fastestMicros = 0;
+        for (unsigned int b=0; b<2; b++){
+            ofxFft *fft = ofxFft::create(size, windowType, backends[b]);
+            
+            double micros = 0;
+            for (unsigned int p=0; p<FFT_BENCHMARK_PASSES; p++){
+                unsigned long long startTime = ofGetElapsedTimeMicros();
+                for (unsigned int c=0; c<callsPerSize; c++){
+                    fft->setSignal(&signal[0]);
+                }
+                double passMicros = (double)(ofGetElapsedTimeMicros() - startTime)/callsPerSize;
+                if (p == 0 || passMicros < micros) micros = passMicros;
+            }
+            if (fastestMicros == 0 || micros < fastestMicros) fastestMicros = micros;
+            
+            // magnitude error relative to the spectrum peak
+            const float *refReal = fft->getReal();
+            const float *refImag = fft->getImaginary();
+            float peak = 0.0f;
+            float maxError = 0.0f;
+            for (unsigned int k=0; k<nBins; k++){
+                float refMag = sqrtf(refReal[k]*refReal[k] + refImag[k]*refImag[k]);
+                float mag = sqrtf(real[k]*real[k] + imag[k]*imag[k]);
+                peak = MAX(peak, refMag);
+                maxError = MAX(maxError, fabsf(mag - refMag));
+            }
+            
+            ss << ", " << backendNames[b] << " " << micros << "us (max error " << (peak > 0 ? maxError/peak : 0) << ")";
+            delete fft;
+        }
+        
+        delete engine;
+        
+        bool slower = builtinMicros > fastestMicros;
+        if (slower) numSlower++;
+        ofLog(slower ? OF_LOG_WARNING : OF_LOG_NOTICE, ss.str());
+    }
+    
+    return numSlower;
+}
+
+namespace {
+    
+    // Stands in for the sound stream: blocks of a ramp (sample n is (n % 4096)/4096 - 0.5)
+    // through process() at the cadence a real stream would call audioIn
+    class PacedAudioThread : public ofThread {
+        
+    public:
+        
+        PacedAudioThread(ofxAudioAnalyzer & analyzer, unsigned int nBlocks) :
+            analyzer(analyzer), nBlocks(nBlocks), maxLateMicros(0), done(0) {};
+        
+        ofxAudioAnalyzer &  analyzer;
+        unsigned int        nBlocks;
+        unsigned int        maxLateMicros;      // worst block start behind its due time
+        volatile int        done;
+        
+        void threadedFunction()
+        {
+            const ofxAudioAnalyzer::Settings & settings = analyzer.getSettings();
+            vector<float> block(settings.bufferSize);
+            double blockMicros = 1000000.0*settings.bufferSize/settings.sampleRate;
+            unsigned long long startTime = ofGetElapsedTimeMicros();
+            unsigned int n = 0;
+            
+            for (unsigned int b=0; b<nBlocks && isThreadRunning(); b++){
+                unsigned long long due = startTime + (unsigned long long)(b*blockMicros);
+                unsigned long long now = ofGetElapsedTimeMicros();
+                if (now < due) usleep(due - now);
+                else maxLateMicros = MAX(maxLateMicros, (unsigned int)(now - due));
+                
+                for (unsigned int i=0; i<block.size(); i++, n++){
+                    block[i] = (n % 4096)/4096.0f - 0.5f;
+                }
+                analyzer.process(&block[0], block.size(), 1);
+            }
+            ofxNDAtomicStore(done, 1);
+        };
+    };
+}
+
+bool ofxAudioAnalyzerFileRunner::checkReaders(float seconds, ofxAudioAnalyzer::Settings settings)
+{
+    settings.useInputStream = false;
+    settings.bufferSize = 512;
+    settings.fftSize = 0;
+    settings.hopSize = 0;
+    
+    bool passed = true;
+    
+    for (unsigned int pass=0; pass<2; pass++){
+        
+        settings.threadedAnalysis = pass == 1;
+        ofxAudioAnalyzer analyzer;
+        analyzer.setup(settings);
+        
+        PacedAudioThread audio(analyzer, seconds*settings.sampleRate/settings.bufferSize);
+        audio.startThread(false, false);
+        
+        // the render thread's side: read as fast as possible, alternating the
+        // fill-in getters with the ones that return a new vector
+        vector<float> bins, psf, pcm;              // kept between reads, like a renderer would
+        vector<float> newBins, newPsf, newPcm;
+        const float *binsData = NULL, *psfData = NULL, *pcmData = NULL;
+        unsigned int numReads[2] = {0, 0};
+        unsigned long long readMicros[2] = {0, 0};
+        unsigned int numFailed = 0;
+        unsigned int numBroken = 0;
+        unsigned int numReallocated = 0;
+        
+        while (!ofxNDAtomicLoad(audio.done)){
+            
+            bool fill = (numReads[0] + numReads[1]) % 2 == 0;
+            unsigned long long startTime = ofGetElapsedTimeMicros();
+            bool ok = true;
+            if (fill){
+                ok = analyzer.getFFTBins(bins) && analyzer.getPSFData(psf) && analyzer.getPCMData(pcm);
+            }
+            else{
+                newBins = analyzer.getFFTBins();
+                newPsf = analyzer.getPSFData();
+                newPcm = analyzer.getPCMData();
+                ok = !newBins.empty() && !newPsf.empty() && !newPcm.empty();
+            }
+            readMicros[fill] += ofGetElapsedTimeMicros() - startTime;
+            numReads[fill]++;
+            
+            if (!ok){
+                // nothing published yet, or the writer lapped the reader
+                if (analyzer.getAnalyzedFrameCount() > 0) numFailed++;
+                continue;
+            }
+            
+            if (fill){
+                if (binsData && (binsData != &bins[0] || psfData != &psf[0] || pcmData != &pcm[0])) numReallocated++;
+                binsData = &bins[0];
+                psfData = &psf[0];
+                pcmData = &pcm[0];
+            }
+            
+            // an intact window is consecutive ramp samples; spectra are finite and non-negative
+            const vector<float> & readBins = fill ? bins : newBins;
+            const vector<float> & readPsf = fill ? psf : newPsf;
+            const vector<float> & readPcm = fill ? pcm : newPcm;
+            bool whole = readPcm.size() == analyzer.getSettings().fftSize && readBins.size() == readPsf.size();
+            for (unsigned int i=1; i<readPcm.size() && whole; i++){
+                int previous = roundf((readPcm[i-1] + 0.5f)*4096.0f);
+                int current = roundf((readPcm[i] + 0.5f)*4096.0f);
+                whole = current == (previous + 1) % 4096;
+            }
+            for (unsigned int k=0; k<readBins.size() && whole; k++){
+                whole = readBins[k] >= 0.0f && readBins[k] < 1e30f && readPsf[k] >= 0.0f && readPsf[k] < 1e30f;
+            }
+            if (!whole) numBroken++;
+            
+            // leave the audio thread some of the core on a single CPU machine
+            if ((numReads[0] + numReads[1]) % 64 == 0) ofSleepMillis(0);
+        }
+        audio.waitForThread(true);
+        
+        bool ok = numBroken == 0 && numReallocated == 0;
+        passed = passed && ok;
+        
+        stringstream ss;
+        ss << "ofxAudioAnalyzerFileRunner: readers, " << (settings.threadedAnalysis ? "threaded" : "in process()") << " analysis, "
+           << audio.nBlocks << " blocks of " << settings.bufferSize << " at " << settings.sampleRate << "Hz (worst "
+           << audio.maxLateMicros << "us late), " << analyzer.getAnalyzedFrameCount() << " hops: "
+           << numReads[1] << " fill-in reads " << (numReads[1] ? (double)readMicros[1]/numReads[1] : 0) << "us, "
+           << numReads[0] << " returning reads " << (numReads[0] ? (double)readMicros[0]/numReads[0] : 0) << "us, "
+           << numFailed << " failed, " << analyzer.getTornFrameReads() << " caught mid-write, "
+           << numBroken << " inconsistent, " << numReallocated << " reallocated";
+        ofLog(ok ? OF_LOG_NOTICE : OF_LOG_ERROR, ss.str());
+    }
+    
+    return passed;
+}
@@ -0,0 +1,122 @@
+//
+//  ofxAudioAnalyzerFileRunner.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/4/12.
+//
+//
+
+#pragma once
+
+#include "ofxAudioAnalyzer.h"
+#include "ofxMultiChannelAudioAnalyzer.h"
+#include <fstream>
+
+/// Streaming reader for PCM (16/24/32 bit integer) and 32-bit float WAV files
+class ofxWavFileReader {
+    
+public:
+    
+    ofxWavFileReader();
+    ~ofxWavFileReader();
+    
+    bool open(const string & path);
+    void close();
+    
+    // Reads up to nFrames interleaved frames as floats, returns number of frames read
+    int read(float * output, int nFrames);
+    
+    int getNumChannels() { return _numChannels; };
+    int getSampleRate() { return _sampleRate; };
+    unsigned int getNumFrames() { return _numFrames; };
+    
+private:
+    
+    std::ifstream   _file;
+    int             _numChannels;
+    int             _sampleRate;
+    int             _bitsPerSample;
+    bool            _isFloat;
+    unsigned int    _numFrames;
+    unsigned int    _framesRead;
+    
+    vector<char>    _readBuffer;
+};
+
+/// Runs an ofxAudioAnalyzer over a WAV file as fast as possible (no sound stream),
+/// writing per-hop energy/PSF for every region to CSV and measuring throughput.
+class ofxAudioAnalyzerFileRunner {
+    
+public:
+    
+    struct Result {
+        
+        bool            success;
+        unsigned int    numHops;
+        double          audioSeconds;
+        double          analysisSeconds;    // time spent inside ofxAudioAnalyzer::process
+        double          totalSeconds;       // including file IO and CSV output
+        double          realtimeMultiple;   // audioSeconds/analysisSeconds
+        unsigned int    numOnsets;
+        
+        Result();
+    };
+    
+    struct OnsetLatencyResult {
+        
+        unsigned int    numClicks;
+        unsigned int    numDetected;        // clicks with an onset within 50ms
+        unsigned int    numFalseOnsets;
+        double          meanTimestampErrorMs;   // |onset sampleTime - click|
+        double          maxTimestampErrorMs;
+        double          meanLatencyMs;          // click to event, in audio time
+        double          maxLatencyMs;
+        double          meanProcessMicros;      // wall clock per hop that reported an onset
+        float           tempoBpm;               // estimate at the end of the run
+        
+        OnsetLatencyResult();
+    };
+    
+    // sampleRate, useInputStream and stereo in settings are taken from the file.
+    // Pass an empty csvPath to skip CSV output (pure throughput measurement).
+    static Result run(const string & wavPath, const string & csvPath,
+                      ofxAudioAnalyzer::Settings settings = ofxAudioAnalyzer::Settings());
+    
+    static void logResult(const Result & result);
+    
+    // Feeds seconds of synthetic noise through an ofxMultiChannelAudioAnalyzer with
+    // 1, 2, 4 ... maxChannels single-channel groups and logs throughput and parallel
+    // scaling for each channel count. Every count, one channel included, is analyzed
+    // with threadedAnalysis.
+    static void benchmarkChannelScaling(unsigned int maxChannels = 16, float seconds = 10.0f,
+                                        ofxAudioAnalyzer::Settings settings = ofxAudioAnalyzer::Settings());
+    
+    // Runs a synthetic click track (decaying noise bursts at bpm over a quiet noise
+    // floor, clicks not aligned to hops) and measures how far and how late the
+    // reported onsets are from the true clicks, plus the tempo estimate.
+    static OnsetLatencyResult measureOnsetLatency(float bpm = 120.0f, float seconds = 20.0f,
+                                                  ofxAudioAnalyzer::Settings settings = ofxAudioAnalyzer::Settings());
+    static void logOnsetLatency(const OnsetLatencyResult & result);
+    
+    // Times per-hop analysis of synthetic noise with settings.spectralFeatures off and
+    // on (filterbank, centroid, rolloff, flatness, RMS) and logs the relative cost.
+    // Passes alternate and the fastest of each is kept to suppress scheduling noise.
+    // Returns the overhead in percent.
+    static float benchmarkFeatureCost(float seconds = 10.0f, unsigned int passes = 5,
+                                      ofxAudioAnalyzer::Settings settings = ofxAudioAnalyzer::Settings());
+    
+    // Times the built-in real FFT against ofxFft (FFTW and basic) for every supported
+    // size, windowing + transform per call (fastest of a few passes), and checks the
+    // built-in magnitudes against ofxFft's. Returns the number of sizes where the built-in FFT was slower than
+    // the fastest ofxFft backend.
+    static unsigned int benchmarkFft(unsigned int callsPerSize = 2000,
+                                     fftWindowType windowType = OF_FFT_WINDOW_HAMMING);
+    
+    // Feeds a ramp through process() in 512 frame blocks at the sample rate's cadence
+    // from a second thread, analysis inline and then threaded, while this thread reads
+    // getFFTBins/getPSFData/getPCMData as fast as it can. Every window read has to be
+    // consecutive ramp samples and the fill-in getters must never reallocate the
+    // caller's vectors. Logs read cost for both getter forms; returns false on a failure.
+    static bool checkReaders(float seconds = 10.0f,
+                             ofxAudioAnalyzer::Settings settings = ofxAudioAnalyzer::Settings());
+};
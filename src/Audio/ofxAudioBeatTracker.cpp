@@ -0,0 +1,158 @@
+//
+//  ofxAudioBeatTracker.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/9/12.
+//
+//
+
+#include "ofxAudioBeatTracker.h"
+#include <algorithm>
+#include <math.h>
+
+ofxAudioBeatTracker::Settings::Settings(){
+    minBpm = 70.0f;
+    maxBpm = 180.0f;
+    preferredBpm = 120.0f;
+    tempoMemorySeconds = 6.0f;
+    phaseCorrection = 0.25f;
+}
+
+ofxAudioBeatTracker::ofxAudioBeatTracker()
+{
+    _sampleRate = 44100;
+    _hopSize = 512;
+    _minLag = 0;
+    _maxLag = 0;
+    _acfDecay = 0.0f;
+    _writePos = 0;
+    _mean = 0.0f;
+    _periodHops = 0.0f;
+    _tempoBpm = 0.0f;
+    _phase = 0.0f;
+    _beatCount = 0;
+    _lastBeatSampleTime = 0;
+}
+
+void ofxAudioBeatTracker::setup(Settings settings, unsigned int sampleRate, unsigned int hopSize)
+{
+    _settings = settings;
+    _sampleRate = sampleRate;
+    _hopSize = hopSize;
+
+    float hopsPerMinute = 60.0f*sampleRate/hopSize;
+    _minLag = std::max(2, (int)floorf(hopsPerMinute/settings.maxBpm));
+    _maxLag = std::max(_minLag + 2, (unsigned int)ceilf(hopsPerMinute/settings.minBpm));
+    _acfDecay = expf(-(float)hopSize/(sampleRate*std::max(settings.tempoMemorySeconds, 0.1f)));
+
+    // lags up to twice the slowest period, for the second harmonic of each candidate
+    _novelty.assign(2*_maxLag + 2, 0);
+    _acf.assign(2*_maxLag + 2, 0);
+    _writePos = 0;
+    _mean = 0.0f;
+
+    // log-gaussian tempo prior, one octave wide, resolves double/half tempo ambiguity
+    _prior.assign(_maxLag + 2, 0);
+    for (unsigned int lag = _minLag; lag <= _maxLag + 1; lag++){
+        float octaves = log2f((hopsPerMinute/lag)/settings.preferredBpm);
+        _prior[lag] = expf(-0.5f*octaves*octaves);
+    }
+
+    _periodHops = hopsPerMinute/settings.preferredBpm;
+    _tempoBpm = settings.preferredBpm;
+    _phase = 0.0f;
+    _beatCount = 0;
+    _lastBeatSampleTime = 0;
+}
+
+float ofxAudioBeatTracker::spreadAcf(unsigned int lag)
+{
+    // a fractional period splits its correlation between neighbouring lags
+    return _acf[lag] + 0.5f*(_acf[lag-1] + _acf[lag+1]);
+}
+
+float ofxAudioBeatTracker::lagScore(unsigned int lag)
+{
+    return (spreadAcf(lag) + 0.5f*spreadAcf(2*lag))*_prior[lag];
+}
+
+void ofxAudioBeatTracker::process(float novelty, bool onset, float onsetStrength,
+                                  unsigned long long onsetSampleTime, unsigned long long windowEndSample)
+{
+    if (_novelty.empty()) return;
+
+    // leaky autocorrelation of the mean-removed novelty, one update per lag
+    _mean += (novelty - _mean)*(1.0f - _acfDecay);
+    float value = novelty - _mean;
+    unsigned int historySize = _novelty.size();
+    _novelty[_writePos] = value;
+
+    for (unsigned int lag = _minLag - 1; lag <= 2*_maxLag + 1; lag++){
+        float past = _novelty[(_writePos + historySize - lag) % historySize];
+        _acf[lag] = _acf[lag]*_acfDecay + value*past;
+    }
+    _writePos = (_writePos + 1) % historySize;
+
+    // a periodic onset train correlates at every multiple of its period, so
+    // adding the second harmonic keeps double-time from losing to half-time
+    unsigned int bestLag = 0;
+    float bestScore = 0.0f;
+    for (unsigned int lag = _minLag; lag <= _maxLag; lag++){
+        float score = lagScore(lag);
+        if (score > bestScore){
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    // a pulse at half the lag that correlates as strongly is the real beat level,
+    // otherwise every second beat would be lost to half-time
+    if (bestLag > 0){
+        unsigned int halfLag = 0;
+        float halfAcf = 0.0f;
+        for (unsigned int lag = bestLag/2; lag <= (bestLag + 1)/2; lag++){
+            if (lag >= _minLag && spreadAcf(lag) > halfAcf){
+                halfAcf = spreadAcf(lag);
+                halfLag = lag;
+            }
+        }
+        if (halfLag > 0 && halfAcf >= 0.8f*spreadAcf(bestLag)){
+            bestLag = halfLag;
+            bestScore = lagScore(halfLag);
+        }
+    }
+
+    // parabolic interpolation gives a fractional period
+    if (bestLag > 0){
+        float period = bestLag;
+        if (bestLag > _minLag && bestLag < _maxLag){
+            float a = lagScore(bestLag-1);
+            float c = lagScore(bestLag+1);
+            float denom = a - 2.0f*bestScore + c;
+            if (denom < 0.0f){
+                period += std::max(-0.5f, std::min(0.5f, 0.5f*(a - c)/denom));
+            }
+        }
+        _periodHops += (period - _periodHops)*0.1f;
+        _tempoBpm = 60.0f*_sampleRate/(_hopSize*_periodHops);
+    }
+
+    // advance the beat oscillator by one hop
+    float periodSamples = _periodHops*_hopSize;
+    _phase += 1.0f/_periodHops;
+    while (_phase >= 1.0f){
+        _phase -= 1.0f;
+        _beatCount++;
+        _lastBeatSampleTime = windowEndSample - (unsigned long long)(_phase*periodSamples);
+    }
+
+    // pull the phase toward the onset: an onset should land on a beat (phase 0)
+    if (onset && windowEndSample >= onsetSampleTime){
+        float onsetPhase = _phase - (windowEndSample - onsetSampleTime)/periodSamples;
+        float error = onsetPhase - floorf(onsetPhase + 0.5f);
+        float gain = _settings.phaseCorrection*std::min(1.0f, onsetStrength);
+        _phase -= error*gain;
+        if (_phase < 0.0f) _phase += 1.0f;
+        if (_phase >= 1.0f) _phase -= 1.0f;
+    }
+}
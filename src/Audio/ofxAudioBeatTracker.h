@@ -0,0 +1,75 @@
+//
+//  ofxAudioBeatTracker.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/9/12.
+//
+//
+
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+/// Incremental tempo and beat-phase estimator fed once per analysis hop.
+///
+/// Tempo comes from a leaky autocorrelation of the onset novelty over the lags
+/// between maxBpm and minBpm (plus their second harmonics), weighted toward
+/// preferredBpm. A phase oscillator runs at that tempo and is pulled toward
+/// each detected onset. Per-hop cost is
+/// linear in the number of lags; all memory is allocated in setup().
+class ofxAudioBeatTracker {
+
+public:
+
+    struct Settings {
+
+        float   minBpm;
+        float   maxBpm;
+        float   preferredBpm;           // center of the tempo prior
+        float   tempoMemorySeconds;     // time constant of the autocorrelation
+        float   phaseCorrection;        // 0-1, share of an onset's phase error removed
+
+        Settings();
+    };
+
+    ofxAudioBeatTracker();
+
+    void setup(Settings settings, unsigned int sampleRate, unsigned int hopSize);
+
+    // Call once per hop with the onset novelty. If an onset was detected at
+    // onsetSampleTime, pass onset = true. windowEndSample is the newest sample
+    // of the hop; the beat phase refers to that sample.
+    void process(float novelty, bool onset, float onsetStrength,
+                 unsigned long long onsetSampleTime, unsigned long long windowEndSample);
+
+    float getTempoBpm()             { return _tempoBpm; };
+    float getBeatPhase()            { return _phase; };         // 0-1, 0 on the beat
+    unsigned int getBeatCount()     { return _beatCount; };
+    unsigned long long getLastBeatSampleTime()  { return _lastBeatSampleTime; };
+
+private:
+
+    float spreadAcf(unsigned int lag);
+    float lagScore(unsigned int lag);
+
+    Settings        _settings;
+    unsigned int    _sampleRate;
+    unsigned int    _hopSize;
+    unsigned int    _minLag;            // in hops
+    unsigned int    _maxLag;
+    float           _acfDecay;
+
+    vector<float>   _novelty;           // circular, 2*maxLag+2 hops
+    vector<float>   _acf;               // indexed by lag
+    vector<float>   _prior;
+    unsigned int    _writePos;
+    float           _mean;
+
+    float           _periodHops;
+    float           _tempoBpm;
+    float           _phase;
+    unsigned int    _beatCount;
+    unsigned long long  _lastBeatSampleTime;
+};
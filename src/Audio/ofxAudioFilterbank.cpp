@@ -0,0 +1,142 @@
+//
+//  ofxAudioFilterbank.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/10/12.
+//
+//
+
+#include "ofxAudioFilterbank.h"
+#include <algorithm>
+#include <math.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define AA_FILTERBANK_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AA_FILTERBANK_NEON
+#endif
+
+static float toScale(float freq, ofxAudioFilterbankScale scale)
+{
+    return scale == AA_FILTERBANK_MEL ? 2595.0f*log10f(1.0f + freq/700.0f) : log2f(freq);
+}
+
+static float fromScale(float value, ofxAudioFilterbankScale scale)
+{
+    return scale == AA_FILTERBANK_MEL ? 700.0f*(powf(10.0f, value/2595.0f) - 1.0f) : powf(2.0f, value);
+}
+
+ofxAudioFilterbank::ofxAudioFilterbank()
+{
+}
+
+void ofxAudioFilterbank::setup(unsigned int nBands, float lowFreq, float highFreq,
+                               unsigned int nBins, float sampleRate, ofxAudioFilterbankScale scale)
+{
+    _firstBin.clear();
+    _numWeights.clear();
+    _weightOffset.clear();
+    _weights.clear();
+    _centerFreq.clear();
+
+    if (nBands == 0 || nBins < 2) return;
+
+    float nyquist = sampleRate/2.0f;
+    float binHz = nyquist/(nBins - 1);     // bins run from DC to nyquist inclusive
+    lowFreq = std::max(lowFreq, binHz*0.5f);
+    highFreq = std::min(highFreq, nyquist);
+    if (highFreq <= lowFreq) return;
+
+    // nBands+2 equally spaced edges on the chosen scale; band b spans edges b..b+2
+    float low = toScale(lowFreq, scale);
+    float high = toScale(highFreq, scale);
+    vector<float> edges(nBands + 2);
+    for (unsigned int e=0; e<edges.size(); e++){
+        edges[e] = fromScale(low + (high - low)*e/(nBands + 1), scale);
+    }
+
+    vector<float> bandWeights;
+    for (unsigned int b=0; b<nBands; b++){
+
+        float lower = edges[b];
+        float center = edges[b+1];
+        float upper = edges[b+2];
+
+        unsigned int first = std::min((unsigned int)ceilf(lower/binHz), nBins - 1);
+        unsigned int last = std::min((unsigned int)floorf(upper/binHz), nBins - 1);
+
+        bandWeights.clear();
+        for (unsigned int bin = first; bin <= last && last >= first; bin++){
+            float freq = bin*binHz;
+            float w = freq <= center ? (freq - lower)/(center - lower) : (upper - freq)/(upper - center);
+            bandWeights.push_back(std::max(w, 0.0f));
+        }
+
+        float sum = 0.0f;
+        for (unsigned int w=0; w<bandWeights.size(); w++) sum += bandWeights[w];
+
+        if (sum <= 0.0f){
+            // narrower than a bin: linear interpolation between the bins around the center
+            float position = std::min(center/binHz, (float)(nBins - 1));
+            first = std::min((unsigned int)floorf(position), nBins - 2);
+            float frac = position - first;
+            bandWeights.clear();
+            bandWeights.push_back(1.0f - frac);
+            bandWeights.push_back(frac);
+            sum = 1.0f;
+        }
+
+        // trim zero weights at either end to keep the run tight
+        unsigned int start = 0;
+        unsigned int end = bandWeights.size();
+        while (start < end && bandWeights[start] == 0.0f) start++;
+        while (end > start && bandWeights[end-1] == 0.0f) end--;
+
+        _firstBin.push_back(first + start);
+        _numWeights.push_back(end - start);
+        _weightOffset.push_back(_weights.size());
+        _centerFreq.push_back(center);
+        for (unsigned int w = start; w < end; w++){
+            _weights.push_back(bandWeights[w]/sum);
+        }
+    }
+}
+
+void ofxAudioFilterbank::process(const float *magnitude, float *bandOutput) const
+{
+    const float *weights = _weights.empty() ? NULL : &_weights[0];
+    unsigned int nBands = _firstBin.size();
+
+    for (unsigned int b=0; b<nBands; b++){
+        const float *mag = magnitude + _firstBin[b];
+        const float *w = weights + _weightOffset[b];
+        unsigned int n = _numWeights[b];
+
+        unsigned int i = 0;
+        float sum = 0.0f;
+        
+#if defined(AA_FILTERBANK_SSE)
+        __m128 acc = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4){
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(mag + i), _mm_loadu_ps(w + i)));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(AA_FILTERBANK_NEON)
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (; i + 4 <= n; i += 4){
+            acc = vmlaq_f32(acc, vld1q_f32(mag + i), vld1q_f32(w + i));
+        }
+        float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+        
+        for (; i < n; i++){
+            sum += mag[i]*w[i];
+        }
+        bandOutput[b] = sum;
+    }
+}
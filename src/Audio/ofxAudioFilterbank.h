@@ -0,0 +1,52 @@
+//
+//  ofxAudioFilterbank.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/10/12.
+//
+//
+
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+typedef enum {
+    AA_FILTERBANK_MEL = 0,
+    AA_FILTERBANK_LOG
+} ofxAudioFilterbankScale;
+
+/// Overlapping triangular bands on a mel or log frequency axis, applied to an
+/// FFT magnitude spectrum.
+///
+/// Weights are precomputed in setup() and stored sparsely: each band keeps only
+/// its first bin and the run of non-zero weights, packed into one array.
+/// Applying the bank costs one multiply-add per stored weight.
+/// Each band's weights sum to 1, so a band reads as the average magnitude under it.
+/// A band narrower than the bin spacing interpolates between the two nearest bins
+/// instead of reading zero.
+class ofxAudioFilterbank {
+
+public:
+
+    ofxAudioFilterbank();
+
+    void setup(unsigned int nBands, float lowFreq, float highFreq,
+               unsigned int nBins, float sampleRate, ofxAudioFilterbankScale scale = AA_FILTERBANK_MEL);
+
+    // bandOutput must hold getNumBands() values
+    void process(const float *magnitude, float *bandOutput) const;
+
+    unsigned int getNumBands() const    { return _firstBin.size(); };
+    unsigned int getNumWeights() const  { return _weights.size(); };
+    float getCenterFrequency(unsigned int band) const { return _centerFreq[band]; };
+
+private:
+
+    vector<unsigned int>    _firstBin;      // per band
+    vector<unsigned int>    _numWeights;
+    vector<unsigned int>    _weightOffset;  // into _weights
+    vector<float>           _weights;
+    vector<float>           _centerFreq;
+};
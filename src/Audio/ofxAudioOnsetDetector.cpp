@@ -0,0 +1,151 @@
+//
+//  ofxAudioOnsetDetector.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/9/12.
+//
+//
+
+#include "ofxAudioOnsetDetector.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#define OD_MAX_MEDIAN_HOPS  256
+
+ofxAudioOnsetDetector::Settings::Settings(){
+    medianWindowMs = 250.0f;
+    thresholdMultiplier = 1.5f;
+    thresholdDelta = 0.1f;
+    minIntervalMs = 60.0f;
+    peakReleaseSeconds = 5.0f;
+}
+
+ofxAudioOnsetDetector::ofxAudioOnsetDetector()
+{
+    _fftSize = 0;
+    _hopSize = 0;
+    _minIntervalHops = 0;
+    _peakDecay = 0.0f;
+    _historyPos = 0;
+    _historyCount = 0;
+    _peak = 0.0f;
+    _novelty = 0.0f;
+    _threshold = 0.0f;
+    _candidate = 0.0f;
+    _beforeCandidate = 0.0f;
+    _candidateWindowEnd = 0;
+    _hopsSinceOnset = 0;
+}
+
+void ofxAudioOnsetDetector::setup(Settings settings, unsigned int sampleRate, unsigned int fftSize, unsigned int hopSize)
+{
+    _settings = settings;
+    _fftSize = fftSize;
+    _hopSize = hopSize;
+    
+    float hopMs = 1000.0f*hopSize/sampleRate;
+    unsigned int medianHops = settings.medianWindowMs/hopMs + 0.5f;
+    medianHops = std::max(1u, std::min(medianHops, (unsigned int)OD_MAX_MEDIAN_HOPS));
+    _minIntervalHops = ceilf(settings.minIntervalMs/hopMs);
+    _peakDecay = expf(-hopMs*0.001f/std::max(settings.peakReleaseSeconds, 0.001f));
+    
+    _history.assign(medianHops, 0);
+    _scratch.assign(medianHops, 0);
+    _previousPcm.assign(fftSize, 0);
+    _historyPos = 0;
+    _historyCount = 0;
+    
+    _peak = 0.0f;
+    _novelty = 0.0f;
+    _threshold = 0.0f;
+    _candidate = 0.0f;
+    _beforeCandidate = 0.0f;
+    _candidateWindowEnd = 0;
+    _hopsSinceOnset = _minIntervalHops;
+}
+
+bool ofxAudioOnsetDetector::process(float flux, const float *pcm, unsigned long long windowEndSample, Onset & onset)
+{
+    if (_history.empty()) return false;
+    
+    // normalize against a slowly released peak so thresholds don't depend on input level
+    _peak = std::max(flux, _peak*_peakDecay);
+    _novelty = _peak > 1e-6f ? flux/_peak : 0.0f;
+    
+    // the previous hop is an onset if it beats the adaptive threshold and is a local maximum
+    _threshold = median()*_settings.thresholdMultiplier + _settings.thresholdDelta;
+    
+    bool found = false;
+    if (_candidate > _threshold && _candidate > _beforeCandidate && _candidate >= _novelty &&
+        _hopsSinceOnset >= _minIntervalHops)
+    {
+        // spectral flux rises while the onset moves toward the window center
+        unsigned int searchStart = _fftSize/2 > _hopSize/2 ? _fftSize/2 - _hopSize/2 : 0;
+        unsigned int onsetIndex = refineOnset(searchStart);
+        
+        onset.sampleTime = _candidateWindowEnd - _fftSize + onsetIndex;
+        onset.detectedAt = windowEndSample;
+        onset.strength = _candidate;
+        _hopsSinceOnset = 0;
+        found = true;
+    }
+    
+    // shift: the candidate joins the threshold history, this hop becomes the candidate
+    _history[_historyPos] = _candidate;
+    _historyPos = (_historyPos + 1) % _history.size();
+    if (_historyCount < _history.size()) _historyCount++;
+    
+    _beforeCandidate = _candidate;
+    _candidate = _novelty;
+    _candidateWindowEnd = windowEndSample;
+    if (pcm){
+        memcpy(&_previousPcm[0], pcm, _fftSize*sizeof(float));
+    }
+    _hopsSinceOnset++;
+    
+    return found;
+}
+
+float ofxAudioOnsetDetector::median()
+{
+    if (_historyCount == 0) return 0.0f;
+    
+    memcpy(&_scratch[0], &_history[0], _historyCount*sizeof(float));
+    unsigned int mid = _historyCount/2;
+    std::nth_element(_scratch.begin(), _scratch.begin() + mid, _scratch.begin() + _historyCount);
+    return _scratch[mid];
+}
+
+unsigned int ofxAudioOnsetDetector::refineOnset(unsigned int searchStart)
+{
+    // sample where short-term energy rises the most: energy of the block
+    // after i minus energy of the block before i, using running sums
+    const float *x = &_previousPcm[0];
+    int n = _fftSize;
+    int block = std::max(4, std::min(32, n/8));
+    int first = std::max((int)searchStart, block);
+    int last = n - block;
+    if (first > last) return searchStart;
+    
+    float before = 0.0f;
+    float after = 0.0f;
+    for (int i=0; i<block; i++){
+        before += x[first - block + i]*x[first - block + i];
+        after += x[first + i]*x[first + i];
+    }
+    
+    int best = first;
+    float bestRise = after - before;
+    for (int i = first + 1; i <= last; i++){
+        before += x[i-1]*x[i-1] - x[i-1-block]*x[i-1-block];
+        after += x[i+block-1]*x[i+block-1] - x[i-1]*x[i-1];
+        
+        // ties go to the later sample so an impulse maps to itself, not block-1 samples early
+        if (after - before >= bestRise){
+            bestRise = after - before;
+            best = i;
+        }
+    }
+    return best;
+}
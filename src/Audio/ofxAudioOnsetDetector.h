@@ -0,0 +1,85 @@
+//
+//  ofxAudioOnsetDetector.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/9/12.
+//
+//
+
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+/// Streaming onset detector driven by one spectral flux value per analysis hop.
+///
+/// Flux is normalized by a slowly decaying peak, compared against an adaptive
+/// threshold (median of the recent past * multiplier + delta) and peak-picked
+/// with one hop of lookahead, so an onset is reported one hop after its peak.
+/// The onset time is then refined to the sample from the PCM window.
+/// All memory is allocated in setup().
+class ofxAudioOnsetDetector {
+
+public:
+
+    struct Settings {
+
+        float           medianWindowMs;     // length of the threshold's median window
+        float           thresholdMultiplier;
+        float           thresholdDelta;     // in normalized flux units (0-1)
+        float           minIntervalMs;      // onsets closer than this are ignored
+        float           peakReleaseSeconds; // decay time of the normalization peak
+
+        Settings();
+    };
+
+    struct Onset {
+
+        unsigned long long  sampleTime;     // input sample clock at the onset
+        unsigned long long  detectedAt;     // sample clock when it was reported
+        float               strength;       // normalized flux at the peak, 0-1
+
+        Onset() {
+            sampleTime = 0;
+            detectedAt = 0;
+            strength = 0.0f;
+        };
+    };
+
+    ofxAudioOnsetDetector();
+
+    void setup(Settings settings, unsigned int sampleRate, unsigned int fftSize, unsigned int hopSize);
+
+    // Call once per hop. pcm is the analyzed window (fftSize samples, oldest first)
+    // ending at windowEndSample. Returns true and fills onset if an onset was found.
+    bool process(float flux, const float *pcm, unsigned long long windowEndSample, Onset & onset);
+
+    float getNovelty()      { return _novelty; };      // normalized flux of the last hop
+    float getThreshold()    { return _threshold; };
+
+private:
+
+    float median();
+    unsigned int refineOnset(unsigned int searchStart);
+
+    Settings        _settings;
+    unsigned int    _fftSize;
+    unsigned int    _hopSize;
+    unsigned int    _minIntervalHops;
+    float           _peakDecay;
+
+    vector<float>   _history;           // circular, normalized flux before the candidate
+    vector<float>   _scratch;           // median workspace
+    vector<float>   _previousPcm;       // window of the candidate hop
+    unsigned int    _historyPos;
+    unsigned int    _historyCount;
+
+    float           _peak;
+    float           _novelty;
+    float           _threshold;
+    float           _candidate;         // previous hop's novelty, tested once the next hop arrives
+    float           _beforeCandidate;
+    unsigned long long  _candidateWindowEnd;
+    unsigned int    _hopsSinceOnset;
+};
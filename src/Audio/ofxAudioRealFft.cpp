@@ -0,0 +1,30 @@
+//
+//  ofxAudioRealFft.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/11/12.
+//
+//
+
+#include "ofxAudioRealFft.h"
+
+bool ofxAudioFftEngine::isSupportedSize(unsigned int signalSize)
+{
+    for (unsigned int l = AA_FFT_MIN_LOG2_SIZE; l <= AA_FFT_MAX_LOG2_SIZE; l++){
+        if (signalSize == (1u << l)) return true;
+    }
+    return false;
+}
+
+ofxAudioFftEngine * ofxAudioFftEngine::create(unsigned int signalSize, fftWindowType windowType)
+{
+    switch (signalSize){
+        case 256:   return new ofxAudioRealFft<8>(windowType);
+        case 512:   return new ofxAudioRealFft<9>(windowType);
+        case 1024:  return new ofxAudioRealFft<10>(windowType);
+        case 2048:  return new ofxAudioRealFft<11>(windowType);
+        case 4096:  return new ofxAudioRealFft<12>(windowType);
+        case 8192:  return new ofxAudioRealFft<13>(windowType);
+        default:    return NULL;
+    }
+}
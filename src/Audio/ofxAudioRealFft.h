@@ -0,0 +1,287 @@
+//
+//  ofxAudioRealFft.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/11/12.
+//
+//
+
+#pragma once
+
+#include "ofxFft.h"
+#include "ofxNDAlignedArray.h"
+#include <math.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define AA_FFT_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AA_FFT_NEON
+#endif
+
+#define AA_FFT_MIN_LOG2_SIZE    8       // 256
+#define AA_FFT_MAX_LOG2_SIZE    13      // 8192
+
+/// Windowed real-input forward FFT used on the analysis hot path.
+///
+/// process() windows signalSize samples and writes bins 0..signalSize/2 of the
+/// spectrum into caller-owned real/imag arrays (16-byte aligned, getBinSize() floats).
+/// The window is normalized by its sum like ofxFft's, so results match ofxFft's
+/// getReal()/getImaginary() up to the sign of the imaginary part.
+/// Nothing is allocated after construction.
+class ofxAudioFftEngine {
+
+public:
+
+    virtual ~ofxAudioFftEngine() {};
+
+    virtual void process(const float *signal, float *real, float *imag) = 0;
+    virtual unsigned int getSignalSize() const = 0;
+    unsigned int getBinSize() const { return getSignalSize()/2 + 1; };
+
+    // Built-in engine for power-of-two sizes 256-8192, NULL for any other size
+    static ofxAudioFftEngine * create(unsigned int signalSize, fftWindowType windowType = OF_FFT_WINDOW_HAMMING);
+
+    static bool isSupportedSize(unsigned int signalSize);
+};
+
+/// Radix-2 engine specialized for N = 2^Log2N at compile time.
+///
+/// The N-point real transform runs as an N/2-point complex FFT on the even/odd
+/// samples (packed, windowed and bit-reversed in one pass), followed by the
+/// usual split into the N/2+1 real-spectrum bins. Butterflies work on separate
+/// real/imaginary arrays, four at a time with SSE or NEON. Window, bit-reversal
+/// and twiddle tables are built once in the constructor.
+template <unsigned int Log2N>
+class ofxAudioRealFft : public ofxAudioFftEngine {
+
+public:
+
+    enum {
+        N = 1 << Log2N,
+        M = N/2             // complex FFT size
+    };
+
+    ofxAudioRealFft(fftWindowType windowType = OF_FFT_WINDOW_HAMMING)
+    {
+        _window.allocate(N);
+        _bitReverse.allocate(M);
+        _twiddleRe.allocate(M);
+        _twiddleIm.allocate(M);
+        _splitRe.allocate(M);
+        _splitIm.allocate(M);
+        _zr.allocate(M);
+        _zi.allocate(M);
+
+        // window, normalized by its sum like ofxFft
+        double windowSum = 0.0;
+        for (unsigned int i=0; i<N; i++){
+            double w = 1.0;
+            switch (windowType){
+                case OF_FFT_WINDOW_BARTLETT:
+                    w = 1.0 - fabs(2.0*i/(N - 1) - 1.0);
+                    break;
+                case OF_FFT_WINDOW_HANN:
+                    w = 0.5 - 0.5*cos(2.0*M_PI*i/(N - 1));
+                    break;
+                case OF_FFT_WINDOW_HAMMING:
+                    w = 0.54 - 0.46*cos(2.0*M_PI*i/(N - 1));
+                    break;
+                case OF_FFT_WINDOW_SINE:
+                    w = sin(M_PI*i/(N - 1));
+                    break;
+                default:
+                    break;
+            }
+            _window[i] = w;
+            windowSum += w;
+        }
+        for (unsigned int i=0; i<N; i++){
+            _window[i] /= windowSum;
+        }
+
+        for (unsigned int i=0; i<M; i++){
+            unsigned int r = 0;
+            for (unsigned int b=0; b<Log2N-1; b++){
+                if (i & (1 << b)) r |= 1 << (Log2N - 2 - b);
+            }
+            _bitReverse[i] = r;
+        }
+
+        // stage with half-size h keeps its h twiddles at offset h, so SIMD loads stay aligned
+        for (unsigned int h=1; h<M; h <<= 1){
+            for (unsigned int j=0; j<h; j++){
+                _twiddleRe[h + j] = cos(-M_PI*j/h);
+                _twiddleIm[h + j] = sin(-M_PI*j/h);
+            }
+        }
+
+        for (unsigned int k=0; k<M; k++){
+            _splitRe[k] = cos(-2.0*M_PI*k/N);
+            _splitIm[k] = sin(-2.0*M_PI*k/N);
+        }
+    }
+
+    unsigned int getSignalSize() const { return N; };
+
+    void process(const float *signal, float *real, float *imag)
+    {
+        float *zr = _zr.data();
+        float *zi = _zi.data();
+
+        // window + pack even/odd samples as complex + bit-reverse, one pass
+        for (unsigned int i=0; i<M; i++){
+            unsigned int src = _bitReverse[i] << 1;
+            zr[i] = signal[src]*_window[src];
+            zi[i] = signal[src + 1]*_window[src + 1];
+        }
+
+        // first two stages have trivial twiddles (1 and -i): one radix-4 pass
+        for (unsigned int s=0; s<M; s+=4){
+            float ar = zr[s] + zr[s+1],   ai = zi[s] + zi[s+1];
+            float br = zr[s] - zr[s+1],   bi = zi[s] - zi[s+1];
+            float cr = zr[s+2] + zr[s+3], ci = zi[s+2] + zi[s+3];
+            float dr = zr[s+2] - zr[s+3], di = zi[s+2] - zi[s+3];
+            zr[s]   = ar + cr;  zi[s]   = ai + ci;
+            zr[s+2] = ar - cr;  zi[s+2] = ai - ci;
+            zr[s+1] = br + di;  zi[s+1] = bi - dr;     // d*(-i) = di - i*dr
+            zr[s+3] = br - di;  zi[s+3] = bi + dr;
+        }
+
+        for (unsigned int h=4; h<M; h <<= 1){
+            butterflyStage(zr, zi, h);
+        }
+
+        split(zr, zi, real, imag);
+    }
+
+private:
+
+    void butterflyStage(float *zr, float *zi, unsigned int h)
+    {
+        const float *wre = _twiddleRe.data() + h;
+        const float *wim = _twiddleIm.data() + h;
+
+        for (unsigned int s=0; s<M; s += 2*h){
+            float *ar = zr + s;
+            float *ai = zi + s;
+            float *br = zr + s + h;
+            float *bi = zi + s + h;
+
+#if defined(AA_FFT_SSE)
+            for (unsigned int j=0; j<h; j+=4){
+                __m128 wr = _mm_load_ps(wre + j);
+                __m128 wi = _mm_load_ps(wim + j);
+                __m128 xr = _mm_load_ps(br + j);
+                __m128 xi = _mm_load_ps(bi + j);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+                __m128 yr = _mm_load_ps(ar + j);
+                __m128 yi = _mm_load_ps(ai + j);
+                _mm_store_ps(ar + j, _mm_add_ps(yr, tr));
+                _mm_store_ps(ai + j, _mm_add_ps(yi, ti));
+                _mm_store_ps(br + j, _mm_sub_ps(yr, tr));
+                _mm_store_ps(bi + j, _mm_sub_ps(yi, ti));
+            }
+#elif defined(AA_FFT_NEON)
+            for (unsigned int j=0; j<h; j+=4){
+                float32x4_t wr = vld1q_f32(wre + j);
+                float32x4_t wi = vld1q_f32(wim + j);
+                float32x4_t xr = vld1q_f32(br + j);
+                float32x4_t xi = vld1q_f32(bi + j);
+                float32x4_t tr = vmlsq_f32(vmulq_f32(xr, wr), xi, wi);
+                float32x4_t ti = vmlaq_f32(vmulq_f32(xr, wi), xi, wr);
+                float32x4_t yr = vld1q_f32(ar + j);
+                float32x4_t yi = vld1q_f32(ai + j);
+                vst1q_f32(ar + j, vaddq_f32(yr, tr));
+                vst1q_f32(ai + j, vaddq_f32(yi, ti));
+                vst1q_f32(br + j, vsubq_f32(yr, tr));
+                vst1q_f32(bi + j, vsubq_f32(yi, ti));
+            }
+#else
+            for (unsigned int j=0; j<h; j++){
+                float tr = br[j]*wre[j] - bi[j]*wim[j];
+                float ti = br[j]*wim[j] + bi[j]*wre[j];
+                float yr = ar[j];
+                float yi = ai[j];
+                ar[j] = yr + tr;
+                ai[j] = yi + ti;
+                br[j] = yr - tr;
+                bi[j] = yi - ti;
+            }
+#endif
+        }
+    }
+
+    // N/2 complex bins of the packed signal -> N/2+1 bins of the real signal
+    void split(const float *zr, const float *zi, float *real, float *imag)
+    {
+        real[0] = zr[0] + zi[0];
+        imag[0] = 0.0f;
+        real[M] = zr[0] - zi[0];
+        imag[M] = 0.0f;
+
+        unsigned int k = 1;
+
+#if defined(AA_FFT_SSE)
+        // bins k..k+3 pair with M-k..M-k-3: load those four and reverse them
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; k + 4 <= M; k += 4){
+            __m128 pr = _mm_loadu_ps(zr + M - k - 3);
+            __m128 pi = _mm_loadu_ps(zi + M - k - 3);
+            pr = _mm_shuffle_ps(pr, pr, _MM_SHUFFLE(0,1,2,3));
+            pi = _mm_shuffle_ps(pi, pi, _MM_SHUFFLE(0,1,2,3));
+            __m128 qr = _mm_loadu_ps(zr + k);
+            __m128 qi = _mm_loadu_ps(zi + k);
+
+            __m128 er = _mm_mul_ps(half, _mm_add_ps(qr, pr));
+            __m128 ei = _mm_mul_ps(half, _mm_sub_ps(qi, pi));
+            __m128 dr = _mm_mul_ps(half, _mm_sub_ps(qr, pr));
+            __m128 di = _mm_mul_ps(half, _mm_add_ps(qi, pi));
+            __m128 wr = _mm_loadu_ps(_splitRe.data() + k);
+            __m128 wi = _mm_loadu_ps(_splitIm.data() + k);
+
+            _mm_storeu_ps(real + k, _mm_add_ps(er, _mm_add_ps(_mm_mul_ps(wr, di), _mm_mul_ps(wi, dr))));
+            _mm_storeu_ps(imag + k, _mm_add_ps(ei, _mm_sub_ps(_mm_mul_ps(wi, di), _mm_mul_ps(wr, dr))));
+        }
+#elif defined(AA_FFT_NEON)
+        for (; k + 4 <= M; k += 4){
+            float32x4_t pr = vld1q_f32(zr + M - k - 3);
+            float32x4_t pi = vld1q_f32(zi + M - k - 3);
+            pr = vrev64q_f32(vcombine_f32(vget_high_f32(pr), vget_low_f32(pr)));
+            pi = vrev64q_f32(vcombine_f32(vget_high_f32(pi), vget_low_f32(pi)));
+            float32x4_t qr = vld1q_f32(zr + k);
+            float32x4_t qi = vld1q_f32(zi + k);
+
+            float32x4_t er = vmulq_n_f32(vaddq_f32(qr, pr), 0.5f);
+            float32x4_t ei = vmulq_n_f32(vsubq_f32(qi, pi), 0.5f);
+            float32x4_t dr = vmulq_n_f32(vsubq_f32(qr, pr), 0.5f);
+            float32x4_t di = vmulq_n_f32(vaddq_f32(qi, pi), 0.5f);
+            float32x4_t wr = vld1q_f32(_splitRe.data() + k);
+            float32x4_t wi = vld1q_f32(_splitIm.data() + k);
+
+            vst1q_f32(real + k, vaddq_f32(er, vmlaq_f32(vmulq_f32(wr, di), wi, dr)));
+            vst1q_f32(imag + k, vaddq_f32(ei, vmlsq_f32(vmulq_f32(wi, di), wr, dr)));
+        }
+#endif
+
+        for (; k < M; k++){
+            float er = 0.5f*(zr[k] + zr[M-k]);
+            float ei = 0.5f*(zi[k] - zi[M-k]);
+            float dr = 0.5f*(zr[k] - zr[M-k]);
+            float di = 0.5f*(zi[k] + zi[M-k]);
+            real[k] = er + _splitRe[k]*di + _splitIm[k]*dr;
+            imag[k] = ei + _splitIm[k]*di - _splitRe[k]*dr;
+        }
+    }
+
+    ofxNDAlignedArray<float>        _window;
+    ofxNDAlignedArray<unsigned int> _bitReverse;
+    ofxNDAlignedArray<float>        _twiddleRe;     // per stage, at offset h
+    ofxNDAlignedArray<float>        _twiddleIm;
+    ofxNDAlignedArray<float>        _splitRe;       // exp(-2*pi*i*k/N)
+    ofxNDAlignedArray<float>        _splitIm;
+    ofxNDAlignedArray<float>        _zr;            // complex work buffer
+    ofxNDAlignedArray<float>        _zi;
+};
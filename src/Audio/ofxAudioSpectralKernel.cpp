@@ -0,0 +1,255 @@
+//
+//  ofxAudioSpectralKernel.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/5/12.
+//
+//
+
+#include "ofxAudioSpectralKernel.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define AA_KERNEL_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AA_KERNEL_NEON
+#endif
+
+// tail bins and the scalar reference share this loop
+static inline void scalarBins(const float *real, const float *imag,
+                              const float *prevMagnitude, float *magnitude, float *psf,
+                              float *energyPrefix, float *psfPrefix, int start, int nBins,
+                              ofxAudioSpectralMoments *moments)
+{
+    float energySum = energyPrefix[start];
+    float psfSum = psfPrefix[start];
+    float weightedSum = 0.0f;
+    float powerSum = 0.0f;
+
+    for (int i=start; i<nBins; i++){
+        float power = real[i]*real[i] + imag[i]*imag[i];
+        float mag = sqrtf(power);
+        float flux = mag - prevMagnitude[i];
+        flux = flux > 0.0f ? flux : 0.0f;
+        magnitude[i] = mag;
+        psf[i] = flux;
+        energySum += mag;
+        psfSum += flux;
+        energyPrefix[i+1] = energySum;
+        psfPrefix[i+1] = psfSum;
+
+        if (moments){
+            weightedSum += i*mag;
+            powerSum += power;
+        }
+    }
+
+    if (moments){
+        moments->weightedSum += weightedSum;
+        moments->powerSum += powerSum;
+    }
+}
+
+void ofxAudioSpectralKernelScalar(const float *real, const float *imag,
+                                  const float *prevMagnitude, float *magnitude, float *psf,
+                                  float *energyPrefix, float *psfPrefix, int nBins,
+                                  ofxAudioSpectralMoments *moments)
+{
+    energyPrefix[0] = 0.0f;
+    psfPrefix[0] = 0.0f;
+    if (moments) *moments = ofxAudioSpectralMoments();
+
+    scalarBins(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, 0, nBins, moments);
+}
+
+#if defined(AA_KERNEL_SSE)
+
+// inclusive prefix sum of the four lanes
+static inline __m128 prefixSum4(__m128 x)
+{
+    x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+    x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+    return x;
+}
+
+static inline float horizontalSum(__m128 x)
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, x);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// the moments branch is resolved at compile time, so the plain pass pays nothing for it
+template <bool computeMoments>
+static void spectralKernelSSE(const float *real, const float *imag,
+                              const float *prevMagnitude, float *magnitude, float *psf,
+                              float *energyPrefix, float *psfPrefix, int nBins,
+                              ofxAudioSpectralMoments *moments)
+{
+    energyPrefix[0] = 0.0f;
+    psfPrefix[0] = 0.0f;
+
+    const __m128 zero = _mm_setzero_ps();
+    __m128 energyCarry = zero;
+    __m128 psfCarry = zero;
+
+    __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 weightedAcc = zero;
+    __m128 powerAcc = zero;
+
+    int i = 0;
+    for (; i + 4 <= nBins; i += 4){
+        __m128 re = _mm_loadu_ps(real + i);
+        __m128 im = _mm_loadu_ps(imag + i);
+        __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        __m128 mag = _mm_sqrt_ps(power);
+        __m128 flux = _mm_max_ps(_mm_sub_ps(mag, _mm_loadu_ps(prevMagnitude + i)), zero);
+        _mm_storeu_ps(magnitude + i, mag);
+        _mm_storeu_ps(psf + i, flux);
+
+        __m128 energyScan = _mm_add_ps(prefixSum4(mag), energyCarry);
+        __m128 psfScan = _mm_add_ps(prefixSum4(flux), psfCarry);
+        _mm_storeu_ps(energyPrefix + i + 1, energyScan);
+        _mm_storeu_ps(psfPrefix + i + 1, psfScan);
+
+        // broadcast the last lane as the carry into the next block
+        energyCarry = _mm_shuffle_ps(energyScan, energyScan, _MM_SHUFFLE(3,3,3,3));
+        psfCarry = _mm_shuffle_ps(psfScan, psfScan, _MM_SHUFFLE(3,3,3,3));
+
+        if (computeMoments){
+            weightedAcc = _mm_add_ps(weightedAcc, _mm_mul_ps(mag, index));
+            powerAcc = _mm_add_ps(powerAcc, power);
+            index = _mm_add_ps(index, four);
+        }
+    }
+
+    if (computeMoments){
+        moments->weightedSum = horizontalSum(weightedAcc);
+        moments->powerSum = horizontalSum(powerAcc);
+    }
+
+    scalarBins(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, i, nBins,
+               computeMoments ? moments : NULL);
+}
+
+void ofxAudioSpectralKernel(const float *real, const float *imag,
+                            const float *prevMagnitude, float *magnitude, float *psf,
+                            float *energyPrefix, float *psfPrefix, int nBins,
+                            ofxAudioSpectralMoments *moments)
+{
+    if (moments){
+        spectralKernelSSE<true>(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, nBins, moments);
+    }
+    else{
+        spectralKernelSSE<false>(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, nBins, NULL);
+    }
+}
+
+#elif defined(AA_KERNEL_NEON)
+
+static inline float32x4_t prefixSum4(float32x4_t x)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    x = vaddq_f32(x, vextq_f32(zero, x, 3));
+    x = vaddq_f32(x, vextq_f32(zero, x, 2));
+    return x;
+}
+
+// ARMv7 NEON has no vector sqrt: use reciprocal sqrt estimate + two Newton steps
+static inline float32x4_t sqrt4(float32x4_t x)
+{
+    float32x4_t est = vrsqrteq_f32(x);
+    est = vmulq_f32(est, vrsqrtsq_f32(vmulq_f32(x, est), est));
+    est = vmulq_f32(est, vrsqrtsq_f32(vmulq_f32(x, est), est));
+    float32x4_t result = vmulq_f32(x, est);
+    // rsqrt(0) is inf, 0*inf is nan - force those lanes back to zero
+    uint32x4_t nonZero = vcgtq_f32(x, vdupq_n_f32(0.0f));
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(result), nonZero));
+}
+
+static inline float horizontalSum(float32x4_t x)
+{
+    float32x2_t pair = vadd_f32(vget_low_f32(x), vget_high_f32(x));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+}
+
+template <bool computeMoments>
+static void spectralKernelNEON(const float *real, const float *imag,
+                               const float *prevMagnitude, float *magnitude, float *psf,
+                               float *energyPrefix, float *psfPrefix, int nBins,
+                               ofxAudioSpectralMoments *moments)
+{
+    energyPrefix[0] = 0.0f;
+    psfPrefix[0] = 0.0f;
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t energyCarry = zero;
+    float32x4_t psfCarry = zero;
+
+    const float indexInit[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t index = vld1q_f32(indexInit);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    float32x4_t weightedAcc = zero;
+    float32x4_t powerAcc = zero;
+
+    int i = 0;
+    for (; i + 4 <= nBins; i += 4){
+        float32x4_t re = vld1q_f32(real + i);
+        float32x4_t im = vld1q_f32(imag + i);
+        float32x4_t power = vmlaq_f32(vmulq_f32(re, re), im, im);
+        float32x4_t mag = sqrt4(power);
+        float32x4_t flux = vmaxq_f32(vsubq_f32(mag, vld1q_f32(prevMagnitude + i)), zero);
+        vst1q_f32(magnitude + i, mag);
+        vst1q_f32(psf + i, flux);
+
+        float32x4_t energyScan = vaddq_f32(prefixSum4(mag), energyCarry);
+        float32x4_t psfScan = vaddq_f32(prefixSum4(flux), psfCarry);
+        vst1q_f32(energyPrefix + i + 1, energyScan);
+        vst1q_f32(psfPrefix + i + 1, psfScan);
+
+        energyCarry = vdupq_n_f32(vgetq_lane_f32(energyScan, 3));
+        psfCarry = vdupq_n_f32(vgetq_lane_f32(psfScan, 3));
+
+        if (computeMoments){
+            weightedAcc = vmlaq_f32(weightedAcc, mag, index);
+            powerAcc = vaddq_f32(powerAcc, power);
+            index = vaddq_f32(index, four);
+        }
+    }
+
+    if (computeMoments){
+        moments->weightedSum = horizontalSum(weightedAcc);
+        moments->powerSum = horizontalSum(powerAcc);
+    }
+
+    scalarBins(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, i, nBins,
+               computeMoments ? moments : NULL);
+}
+
+void ofxAudioSpectralKernel(const float *real, const float *imag,
+                            const float *prevMagnitude, float *magnitude, float *psf,
+                            float *energyPrefix, float *psfPrefix, int nBins,
+                            ofxAudioSpectralMoments *moments)
+{
+    if (moments){
+        spectralKernelNEON<true>(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, nBins, moments);
+    }
+    else{
+        spectralKernelNEON<false>(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, nBins, NULL);
+    }
+}
+
+#else
+
+void ofxAudioSpectralKernel(const float *real, const float *imag,
+                            const float *prevMagnitude, float *magnitude, float *psf,
+                            float *energyPrefix, float *psfPrefix, int nBins,
+                            ofxAudioSpectralMoments *moments)
+{
+    ofxAudioSpectralKernelScalar(real, imag, prevMagnitude, magnitude, psf, energyPrefix, psfPrefix, nBins, moments);
+}
+
+#endif
@@ -0,0 +1,45 @@
+//
+//  ofxAudioSpectralKernel.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/5/12.
+//
+//
+
+#pragma once
+
+#include <stddef.h>
+
+/// Whole-spectrum sums gathered by the kernel for the scalar spectral features
+struct ofxAudioSpectralMoments {
+    
+    float   weightedSum;    // sum of i*magnitude[i], for the centroid
+    float   powerSum;       // sum of magnitude[i]^2, for RMS
+    
+    ofxAudioSpectralMoments() {
+        weightedSum = 0.0f;
+        powerSum = 0.0f;
+    };
+};
+
+/// Fused per-hop spectral pass: one walk over the FFT output computes
+///
+///     magnitude[i]      = sqrt(real[i]^2 + imag[i]^2)
+///     psf[i]            = max(0, magnitude[i] - prevMagnitude[i])
+///     energyPrefix[i+1] = magnitude[0] + ... + magnitude[i]
+///     psfPrefix[i+1]    = psf[0] + ... + psf[i]
+///
+/// energyPrefix and psfPrefix must hold nBins+1 values; element 0 is set to zero.
+/// The energy/flux of any bin range [a,b] is then prefix[b+1] - prefix[a].
+/// If moments is not NULL the same pass also fills it.
+/// Uses SSE or NEON when available, scalar code otherwise. Buffers need no alignment.
+extern void ofxAudioSpectralKernel(const float *real, const float *imag,
+                                   const float *prevMagnitude, float *magnitude, float *psf,
+                                   float *energyPrefix, float *psfPrefix, int nBins,
+                                   ofxAudioSpectralMoments *moments = NULL);
+
+/// Plain scalar version, kept as the reference for the vectorized paths
+extern void ofxAudioSpectralKernelScalar(const float *real, const float *imag,
+                                         const float *prevMagnitude, float *magnitude, float *psf,
+                                         float *energyPrefix, float *psfPrefix, int nBins,
+                                         ofxAudioSpectralMoments *moments = NULL);
@@ -0,0 +1,101 @@
+//
+//  ofxMultiChannelAudioAnalyzer.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/8/12.
+//
+//
+
+#include "ofxMultiChannelAudioAnalyzer.h"
+
+ofxMultiChannelAudioAnalyzer::Settings::Settings()
+{
+    numInputChannels = 2;
+}
+
+ofxMultiChannelAudioAnalyzer::ofxMultiChannelAudioAnalyzer()
+{
+}
+
+ofxMultiChannelAudioAnalyzer::~ofxMultiChannelAudioAnalyzer()
+{
+    clear();
+}
+
+void ofxMultiChannelAudioAnalyzer::clear()
+{
+    if (_settings.analyzerSettings.useInputStream && !analyzers.empty()){
+        inputStream.stop();
+    }
+    for (unsigned int i=0; i<analyzers.size(); i++){
+        delete analyzers[i];
+    }
+    analyzers.clear();
+}
+
+void ofxMultiChannelAudioAnalyzer::setup(Settings settings)
+{
+    clear();
+    
+    if (settings.numInputChannels == 0) settings.numInputChannels = 1;
+    if (settings.groups.empty()){
+        for (unsigned int c=0; c<settings.numInputChannels; c++){
+            settings.groups.push_back(ChannelGroup(c, 1));
+        }
+    }
+    _settings = settings;
+    
+    // the analyzers never open their own stream - this class owns the only one
+    ofxAudioAnalyzer::Settings analyzerSettings = settings.analyzerSettings;
+    analyzerSettings.useInputStream = false;
+    analyzerSettings.numInputChannels = settings.numInputChannels;
+    if (settings.groups.size() > 1){
+        analyzerSettings.threadedAnalysis = true;
+    }
+    
+    for (unsigned int g=0; g<settings.groups.size(); g++){
+        const ChannelGroup & group = settings.groups[g];
+        if (group.channelOffset + group.channelCount > settings.numInputChannels){
+            ofLog(OF_LOG_WARNING, "ofxMultiChannelAudioAnalyzer: group " + ofToString(g) + " extends past the last input channel");
+        }
+        analyzerSettings.channelOffset = group.channelOffset;
+        analyzerSettings.channelCount = MAX(group.channelCount, 1);
+        
+        ofxAudioAnalyzer *analyzer = new ofxAudioAnalyzer();
+        analyzer->setup(analyzerSettings);
+        analyzers.push_back(analyzer);
+    }
+    
+    if (settings.analyzerSettings.useInputStream){
+        inputStream.setDeviceID(settings.analyzerSettings.inputDeviceId);
+        inputStream.setInput(this);
+        inputStream.setup(0, settings.numInputChannels, settings.analyzerSettings.sampleRate, settings.analyzerSettings.bufferSize, 4);
+    }
+}
+
+void ofxMultiChannelAudioAnalyzer::audioIn(float *input, int bufferSize, int nChannels)
+{
+    process(input, bufferSize, nChannels);
+}
+
+void ofxMultiChannelAudioAnalyzer::process(const float *input, int nFrames, int nChannels)
+{
+    // each analyzer picks out its own channel group
+    for (unsigned int g=0; g<analyzers.size(); g++){
+        analyzers[g]->process(input, nFrames, nChannels);
+    }
+}
+
+unsigned int ofxMultiChannelAudioAnalyzer::getNumAnalyzers()
+{
+    return analyzers.size();
+}
+
+ofxAudioAnalyzer & ofxMultiChannelAudioAnalyzer::getAnalyzer(unsigned int group)
+{
+    if (group >= analyzers.size()){
+        ofLog(OF_LOG_ERROR, "ofxMultiChannelAudioAnalyzer::getAnalyzer - group out of bounds");
+        group = 0;
+    }
+    return *analyzers[group];
+}
@@ -0,0 +1,62 @@
+//
+//  ofxMultiChannelAudioAnalyzer.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/8/12.
+//
+//
+
+#pragma once
+
+#include "ofxAudioAnalyzer.h"
+
+/// Runs one independent ofxAudioAnalyzer per input channel (or channel group)
+/// from a single multichannel sound stream.
+///
+/// With more than one group each analyzer uses threadedAnalysis, so the callback
+/// only deinterleaves and the groups are analyzed in parallel on their own threads.
+/// A single group is analyzed directly in the callback, exactly like a plain
+/// ofxAudioAnalyzer.
+class ofxMultiChannelAudioAnalyzer : public ofBaseSoundInput {
+    
+public:
+    
+    struct ChannelGroup {
+        
+        unsigned int channelOffset;
+        unsigned int channelCount;
+        
+        ChannelGroup(unsigned int offset = 0, unsigned int count = 1) {
+            channelOffset = offset;
+            channelCount = count;
+        };
+    };
+    
+    struct Settings {
+        
+        ofxAudioAnalyzer::Settings  analyzerSettings;   // shared by every group
+        unsigned int                numInputChannels;
+        vector<ChannelGroup>        groups;             // empty = one group per input channel
+        
+        Settings();
+    };
+    
+    ofxMultiChannelAudioAnalyzer();
+    ~ofxMultiChannelAudioAnalyzer();
+    
+    void setup(Settings settings = Settings());
+    
+    void audioIn(float * input, int bufferSize, int nChannels);
+    void process(const float * input, int nFrames, int nChannels);
+    
+    unsigned int        getNumAnalyzers();
+    ofxAudioAnalyzer &  getAnalyzer(unsigned int group);
+    
+private:
+    
+    void clear();
+    
+    Settings                    _settings;
+    ofSoundStream               inputStream;
+    vector<ofxAudioAnalyzer*>   analyzers;
+};
@@ -160,10 +160,12 @@
     NSDictionary *audioDevice = [self.audioDevices objectAtIndex:[self.audioInputBox indexOfSelectedItem]];
     NSString *audioDeviceName = [audioDevice objectForKey:kAudioDeviceName];
     int deviceIndex = [[audioDevice objectForKey:kAudioDeviceIndex] intValue];
+    int deviceChannels = [[audioDevice objectForKey:kAudioDeviceInputChannels] intValue];
     
     int oscListenPort = [[self.oscListenPortField stringValue] intValue];
     
     ofApplicationSetAudioInputDeviceId(deviceIndex);
+    ofApplicationSetAudioInputChannels(deviceChannels);
     ofApplicationSetMidiInputDeviceId(self.midiInputBox.indexOfSelectedItem);
     ofApplicationSetOSCListenPort(oscListenPort);
     
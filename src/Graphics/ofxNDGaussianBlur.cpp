@@ -0,0 +1,332 @@
+//
+//  ofxNDGaussianBlur.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#include "ofxNDGaussianBlur.h"
+#include "ofxNDGraphicsUtils.h"
+
+#define BLUR_MIN_LEVEL_SIZE     8
+
+// ------ CPU passes, sampling the way the shaders do ------
+
+// rectangle texture coordinates (texel centers at +0.5), linear filtering, clamp to edge
+static void sampleBilinear(const ofFloatPixels & pixels, float u, float v, float * out)
+{
+    int w = pixels.getWidth();
+    int h = pixels.getHeight();
+    int c = pixels.getNumChannels();
+    const float * data = pixels.getPixels();
+
+    float x = u - 0.5f;
+    float y = v - 0.5f;
+    int x0 = floorf(x);
+    int y0 = floorf(y);
+    float fx = x - x0;
+    float fy = y - y0;
+    int x1 = ofClamp(x0 + 1, 0, w - 1);
+    int y1 = ofClamp(y0 + 1, 0, h - 1);
+    x0 = ofClamp(x0, 0, w - 1);
+    y0 = ofClamp(y0, 0, h - 1);
+
+    const float * p00 = data + (y0*w + x0)*c;
+    const float * p10 = data + (y0*w + x1)*c;
+    const float * p01 = data + (y1*w + x0)*c;
+    const float * p11 = data + (y1*w + x1)*c;
+    for (int i=0; i<c; i++){
+        float top = p00[i] + (p10[i] - p00[i])*fx;
+        float bottom = p01[i] + (p11[i] - p01[i])*fx;
+        out[i] = top + (bottom - top)*fy;
+    }
+}
+
+enum BlurKernel {
+    BLUR_KERNEL_DOWN,
+    BLUR_KERNEL_UP
+};
+
+// kawaseDown.frag / kawaseUp.frag into a target of another size
+static void resampleReference(const ofFloatPixels & source, ofFloatPixels & target, int width, int height, BlurKernel kernel)
+{
+    int c = source.getNumChannels();
+    target.allocate(width, height, c);
+    float * out = target.getPixels();
+    float sx = source.getWidth()/(float)width;
+    float sy = source.getHeight()/(float)height;
+    float s[4];
+
+    for (int y=0; y<height; y++){
+        for (int x=0; x<width; x++){
+            float u = (x + 0.5f)*sx;
+            float v = (y + 0.5f)*sy;
+            float sum[4] = { 0, 0, 0, 0 };
+
+            if (kernel == BLUR_KERNEL_DOWN){
+                const float o = 1.0f;
+                const float taps[5][3] = { {0, 0, 4}, {-o, -o, 1}, {o, -o, 1}, {-o, o, 1}, {o, o, 1} };
+                for (int t=0; t<5; t++){
+                    sampleBilinear(source, u + taps[t][0], v + taps[t][1], s);
+                    for (int i=0; i<c; i++) sum[i] += s[i]*taps[t][2]/8.0f;
+                }
+            }
+            else{
+                const float o = 0.5f;
+                const float taps[8][3] = { {-2*o, 0, 1}, {2*o, 0, 1}, {0, -2*o, 1}, {0, 2*o, 1},
+                                           {-o, -o, 2}, {o, -o, 2}, {-o, o, 2}, {o, o, 2} };
+                for (int t=0; t<8; t++){
+                    sampleBilinear(source, u + taps[t][0], v + taps[t][1], s);
+                    for (int i=0; i<c; i++) sum[i] += s[i]*taps[t][2]/12.0f;
+                }
+            }
+
+            for (int i=0; i<c; i++) out[(y*width + x)*c + i] = sum[i];
+        }
+    }
+}
+
+// gaussian.frag, one direction
+static void blurPassReference(const ofFloatPixels & source, ofFloatPixels & target, bool vertical,
+                              const vector<float> & offsets, const vector<float> & weights)
+{
+    int w = source.getWidth();
+    int h = source.getHeight();
+    int c = source.getNumChannels();
+    target.allocate(w, h, c);
+    float * out = target.getPixels();
+    float dx = vertical ? 0.0f : 1.0f;
+    float dy = vertical ? 1.0f : 0.0f;
+    float a[4], b[4];
+
+    for (int y=0; y<h; y++){
+        for (int x=0; x<w; x++){
+            float u = x + 0.5f;
+            float v = y + 0.5f;
+            sampleBilinear(source, u, v, a);
+            float sum[4] = { 0, 0, 0, 0 };
+            for (int i=0; i<c; i++) sum[i] = a[i]*weights[0];
+
+            for (unsigned int t=1; t<offsets.size(); t++){
+                float o = offsets[t];
+                sampleBilinear(source, u + o*dx, v + o*dy, a);
+                sampleBilinear(source, u - o*dx, v - o*dy, b);
+                for (int i=0; i<c; i++) sum[i] += (a[i] + b[i])*weights[t];
+            }
+
+            for (int i=0; i<c; i++) out[(y*w + x)*c + i] = sum[i];
+        }
+    }
+}
+
+// ------ blur ------
+
+ofxNDGaussianBlur::ofxNDGaussianBlur() :
+    _sigma(4.0f),
+    _maxRadius(15),
+    _bUsePyramid(true),
+    _width(0),
+    _height(0),
+    _numLevels(0),
+    _radius(0)
+{
+    updateTaps();
+}
+
+void ofxNDGaussianBlur::setup(int width, int height, int internalFormat)
+{
+    _width = width;
+    _height = height;
+
+    _blurShader.load("shaders/vanilla.vert", "shaders/gaussian.frag");
+    _downShader.load("shaders/vanilla.vert", "shaders/kawaseDown.frag");
+    _upShader.load("shaders/vanilla.vert", "shaders/kawaseUp.frag");
+
+    // bilinear taps need linear filtering
+    ofFbo::Settings fboSettings;
+    fboSettings.useDepth = false;
+    fboSettings.useStencil = false;
+    fboSettings.depthStencilAsTexture = false;
+    fboSettings.textureTarget = GL_TEXTURE_RECTANGLE_ARB;
+    fboSettings.internalformat = internalFormat;
+    fboSettings.numColorbuffers = 1;
+
+    for (int l=0; l<=BLUR_MAX_LEVELS; l++){
+        fboSettings.width = MAX(width >> l, 1);
+        fboSettings.height = MAX(height >> l, 1);
+        if (l > 0){
+            _pyramid[l-1].allocate(fboSettings);
+            _pyramid[l-1].getTextureReference().setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+        }
+        _temp[l].allocate(fboSettings);
+        _temp[l].getTextureReference().setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+    }
+
+    updateTaps();
+}
+
+void ofxNDGaussianBlur::setSigma(float sigma)
+{
+    sigma = MAX(sigma, 0.0f);
+    if (sigma == _sigma) return;
+    _sigma = sigma;
+    updateTaps();
+}
+
+void ofxNDGaussianBlur::setMaxRadius(int radius)
+{
+    radius = ofClamp(radius, 0, 2*(BLUR_MAX_LINEAR_TAPS - 1));
+    if (radius == _maxRadius) return;
+    _maxRadius = radius;
+    updateTaps();
+}
+
+void ofxNDGaussianBlur::setUsePyramid(bool usePyramid)
+{
+    if (usePyramid == _bUsePyramid) return;
+    _bUsePyramid = usePyramid;
+    updateTaps();
+}
+
+// variance the down and up passes through this many levels add on their own, in
+// full size texels (measured from applyReference() on a single texel)
+static float resampleVariance(int numLevels)
+{
+    return ((1 << 2*numLevels) - 1)*17.0f/18.0f;
+}
+
+void ofxNDGaussianBlur::updateTaps()
+{
+    // halve until 3 sigma fits, as long as the resampling doesn't already blur more
+    // than asked for and the levels don't get too small to mean anything; the
+    // Gaussian at the bottom only makes up what the resampling doesn't
+    float variance = _sigma*_sigma;
+    float sigma = _sigma;
+    _numLevels = 0;
+    while (_bUsePyramid && _numLevels < BLUR_MAX_LEVELS && ceilf(3.0f*sigma) > _maxRadius &&
+           variance > resampleVariance(_numLevels + 1) &&
+           (_width >> (_numLevels + 1)) >= BLUR_MIN_LEVEL_SIZE && (_height >> (_numLevels + 1)) >= BLUR_MIN_LEVEL_SIZE){
+        _numLevels++;
+        sigma = sqrtf((variance - resampleVariance(_numLevels))/(1 << 2*_numLevels));
+    }
+
+    _radius = MIN((int)ceilf(3.0f*sigma), _maxRadius);
+    computeLinearTaps(sigma, _radius, _offsets, _weights);
+}
+
+void ofxNDGaussianBlur::computeLinearTaps(float sigma, int radius, vector<float> &offsets, vector<float> &weights)
+{
+    offsets.assign(1, 0.0f);
+    weights.assign(1, 1.0f);
+    if (radius <= 0 || sigma <= 0.0f) return;
+
+    vector<float> w(radius + 1);
+    float sum = 0.0f;
+    for (int k=0; k<=radius; k++){
+        w[k] = expf(-(k*k)/(2.0f*sigma*sigma));
+        sum += k == 0 ? w[k] : 2.0f*w[k];
+    }
+    for (int k=0; k<=radius; k++){
+        w[k] /= sum;
+    }
+
+    // taps k and k+1 with weights a and b are one fetch of a+b at (ka + (k+1)b)/(a+b),
+    // where linear filtering mixes the two texels b:a
+    weights[0] = w[0];
+    for (int k=1; k<=radius; k+=2){
+        float a = w[k];
+        float b = k + 1 <= radius ? w[k+1] : 0.0f;
+        if (a + b <= 0.0f) break;
+        weights.push_back(a + b);
+        offsets.push_back((k*a + (k + 1)*b)/(a + b));
+    }
+}
+
+void ofxNDGaussianBlur::apply(ofFbo &fbo)
+{
+    if (_width == 0){
+        ofLog(OF_LOG_ERROR, "ofxNDGaussianBlur: apply() before setup()");
+        return;
+    }
+
+    ofDisableBlendMode();
+
+    // ===== down =====
+    ofFbo * blurred = &fbo;
+    _downShader.begin();
+    _downShader.setUniform1f("offset", 1.0f);
+    for (int l=0; l<_numLevels; l++){
+        drawPass(_downShader, *blurred, _pyramid[l]);
+        blurred = &_pyramid[l];
+    }
+    _downShader.end();
+
+    // ===== blur =====
+    _blurShader.begin();
+    _blurShader.setUniform1i("numTaps", _offsets.size());
+    _blurShader.setUniform1fv("offsets", &_offsets[0], _offsets.size());
+    _blurShader.setUniform1fv("weights", &_weights[0], _weights.size());
+    _blurShader.setUniform2f("direction", 1.0f, 0.0f);
+    drawPass(_blurShader, *blurred, _temp[_numLevels]);
+    _blurShader.setUniform2f("direction", 0.0f, 1.0f);
+    drawPass(_blurShader, _temp[_numLevels], *blurred);
+    _blurShader.end();
+
+    // ===== up =====
+    _upShader.begin();
+    _upShader.setUniform1f("offset", 0.5f);
+    for (int l=_numLevels-1; l>=0; l--){
+        drawPass(_upShader, _pyramid[l], l > 0 ? _pyramid[l-1] : fbo);
+    }
+    _upShader.end();
+}
+
+void ofxNDGaussianBlur::drawPass(ofShader &shader, ofFbo &source, ofFbo &target)
+{
+    target.begin();
+    shader.setUniformTexture("blurTexture", source.getTextureReference(), 1);
+    ofxNDBillboardRect(0, 0, target.getWidth(), target.getHeight(), source.getWidth(), source.getHeight());
+    target.end();
+}
+
+void ofxNDGaussianBlur::applyReference(ofFloatPixels &pixels) const
+{
+    vector<ofFloatPixels> levels(_numLevels + 1);
+    levels[0] = pixels;
+    for (int l=1; l<=_numLevels; l++){
+        resampleReference(levels[l-1], levels[l], MAX(pixels.getWidth() >> l, 1), MAX(pixels.getHeight() >> l, 1), BLUR_KERNEL_DOWN);
+    }
+
+    ofFloatPixels temp;
+    blurPassReference(levels[_numLevels], temp, false, _offsets, _weights);
+    blurPassReference(temp, levels[_numLevels], true, _offsets, _weights);
+
+    for (int l=_numLevels; l>0; l--){
+        resampleReference(levels[l], levels[l-1], levels[l-1].getWidth(), levels[l-1].getHeight(), BLUR_KERNEL_UP);
+    }
+    pixels = levels[0];
+}
+
+void ofxNDGaussianBlur::gaussianReference(ofFloatPixels &pixels, float sigma)
+{
+    // every tap, out to where the weights stop mattering
+    int radius = ceilf(4.0f*sigma);
+    if (radius <= 0) return;
+
+    vector<float> offsets(radius + 1);
+    vector<float> weights(radius + 1);
+    float sum = 0.0f;
+    for (int k=0; k<=radius; k++){
+        offsets[k] = k;
+        weights[k] = expf(-(k*k)/(2.0f*sigma*sigma));
+        sum += k == 0 ? weights[k] : 2.0f*weights[k];
+    }
+    for (int k=0; k<=radius; k++){
+        weights[k] /= sum;
+    }
+
+    ofFloatPixels temp;
+    blurPassReference(pixels, temp, false, offsets, weights);
+    blurPassReference(temp, pixels, true, offsets, weights);
+}
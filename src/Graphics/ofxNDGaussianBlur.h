@@ -0,0 +1,94 @@
+//
+//  ofxNDGaussianBlur.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+#define BLUR_MAX_LINEAR_TAPS    9       // center + pairs, must match gaussian.frag
+#define BLUR_MAX_LEVELS         4       // halvings in the pyramid
+
+/// Separable Gaussian blur of an FBO, in place.
+///
+/// The horizontal pass reads the FBO into a target of its own and the vertical
+/// pass reads that back into the FBO, so no pass samples what it draws into.
+/// Weights are worked out here whenever sigma changes, and neighbouring taps are
+/// merged into one bilinear fetch between them: a radius of 15 is 1 + 2x8 fetches
+/// a pass instead of 1 + 2x15.
+///
+/// The radius is 3 sigma, capped at maxRadius. With the pyramid on, a blur wider
+/// than that is done smaller instead: the FBO is halved (dual Kawase downsample)
+/// until sigma fits, blurred there, and scaled back up with the Kawase upsample,
+/// so the cost stays about the same however large sigma gets. The resampling blurs
+/// too, and the Gaussian at the bottom only makes up the rest; the result is
+/// within about 1% of an exact Gaussian. With the pyramid off the kernel is cut
+/// off at maxRadius.
+///
+/// applyReference() does the same passes on the CPU, with the same bilinear and
+/// clamp-to-edge sampling, for checking the GPU output (see --blur-check in the
+/// headless build); gaussianReference() is the exact blur to compare both to.
+class ofxNDGaussianBlur {
+
+public:
+
+    ofxNDGaussianBlur();
+
+    // loads the shaders and allocates the intermediate targets for FBOs of this size
+    void setup(int width, int height, int internalFormat = GL_RGBA);
+
+    void setSigma(float sigma);
+    void setMaxRadius(int radius);
+    void setUsePyramid(bool usePyramid);
+
+    float   getSigma() const        { return _sigma; };
+    int     getMaxRadius() const    { return _maxRadius; };
+    bool    getUsePyramid() const   { return _bUsePyramid; };
+
+    // for the current settings: pyramid levels used, radius at the smallest level
+    // and bilinear fetches per pass
+    int     getNumLevels() const    { return _numLevels; };
+    int     getRadius() const       { return _radius; };
+    int     getNumTaps() const      { return _offsets.size(); };
+
+    // the intermediate targets setup() allocated, for memory accounting: the
+    // between-pass targets, full size first, then the pyramid levels
+    int     getNumTargets() const   { return 2*BLUR_MAX_LEVELS + 1; };
+    ofFbo & getTarget(int i)        { return i <= BLUR_MAX_LEVELS ? _temp[i] : _pyramid[i - BLUR_MAX_LEVELS - 1]; };
+
+    void apply(ofFbo & fbo);
+
+    void applyReference(ofFloatPixels & pixels) const;
+    static void gaussianReference(ofFloatPixels & pixels, float sigma);
+
+    // normalized weights for taps 0..radius, merged pairwise into bilinear taps;
+    // offsets[0] is the center, every other tap is used at +/- its offset
+    static void computeLinearTaps(float sigma, int radius, vector<float> & offsets, vector<float> & weights);
+
+private:
+
+    void updateTaps();
+    void drawPass(ofShader & shader, ofFbo & source, ofFbo & target);
+
+    float           _sigma;
+    int             _maxRadius;
+    bool            _bUsePyramid;
+
+    int             _width;
+    int             _height;
+    int             _numLevels;
+    int             _radius;
+    vector<float>   _offsets;
+    vector<float>   _weights;
+
+    ofShader        _blurShader;
+    ofShader        _downShader;
+    ofShader        _upShader;
+
+    ofFbo           _pyramid[BLUR_MAX_LEVELS];      // 1/2, 1/4, ... size
+    ofFbo           _temp[BLUR_MAX_LEVELS + 1];     // between the two passes, full size first
+};
@@ -7,6 +7,7 @@
 //
 
 #include "ofxNDGraphicsUtils.h"
+#include <algorithm>
 
 ofxNDHSBColor::ofxNDHSBColor(float _h, float _s, float _b, float _a)
 {
@@ -72,4 +73,52 @@ void ofxNDCircularGradient(float radius, const ofColor & start, const ofColor &
     }
     
     _nd_cg_mesh.draw();
-}
\ No newline at end of file
+}
+
+unsigned int ofxNDBytesPerPixel(int internalFormat)
+{
+    switch (internalFormat) {
+        case GL_RGBA32F_ARB:    return 16;
+        case GL_RGBA16F_ARB:    return 8;
+        case GL_RGB10_A2:
+        case GL_RGBA8:
+        case GL_RGBA:           return 4;
+        case GL_RGB:            return 3;
+        default:                return 4;
+    }
+}
+
+string ofxNDInternalFormatName(int internalFormat)
+{
+    switch (internalFormat) {
+        case GL_RGBA32F_ARB:    return "RGBA32F";
+        case GL_RGBA16F_ARB:    return "RGBA16F";
+        case GL_RGB10_A2:       return "RGB10_A2";
+        case GL_RGBA8:
+        case GL_RGBA:           return "RGBA8";
+        case GL_RGB:            return "RGB8";
+        default:                return ofToString(internalFormat);
+    }
+}
+
+int ofxNDInternalFormatForName(const string & name)
+{
+    string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "rgba32f")     return GL_RGBA32F_ARB;
+    if (lower == "rgba16f")     return GL_RGBA16F_ARB;
+    if (lower == "rgb10_a2" || lower == "rgb10a2") return GL_RGB10_A2;
+    if (lower == "rgba8")       return GL_RGBA8;
+    return 0;
+}
+
+float ofxNDQuantizationStep(int internalFormat, bool alpha)
+{
+    switch (internalFormat) {
+        case GL_RGB10_A2:       return alpha ? 1.0f/3.0f : 1.0f/1023.0f;
+        case GL_RGBA8:
+        case GL_RGBA:
+        case GL_RGB:            return 1.0f/255.0f;
+        default:                return 0.0f;
+    }
+}
@@ -30,4 +30,11 @@ extern void ofxNDBillboardRect(int x, int y, int w, int h, int tw, int th);
 
 
 // Circular gradient
-extern void ofxNDCircularGradient(float radius, const ofColor & start, const ofColor & end);
\ No newline at end of file
+extern void ofxNDCircularGradient(float radius, const ofColor & start, const ofColor & end);
+
+// Render target color formats: bytes per pixel, a short name ("RGBA16F") and back
+// (0 if unknown), and the quantization step of the color or alpha channels (0 for float)
+extern unsigned int ofxNDBytesPerPixel(int internalFormat);
+extern string ofxNDInternalFormatName(int internalFormat);
+extern int ofxNDInternalFormatForName(const string & name);
+extern float ofxNDQuantizationStep(int internalFormat, bool alpha);
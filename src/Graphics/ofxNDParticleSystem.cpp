@@ -0,0 +1,328 @@
+//
+//  ofxNDParticleSystem.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/16/12.
+//
+//
+
+#include "ofxNDParticleSystem.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define PARTICLES_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PARTICLES_NEON
+#endif
+
+// worker slices are whole cache lines of every array (8 particles of 2 floats),
+// so no two threads write the same line
+#define PARTICLE_SLICE_ALIGN    8
+
+// below this a worker costs more to wake than it saves
+#define MIN_PARTICLES_PER_THREAD    4096
+
+ofxNDParticleSystem::Parameters::Parameters() :
+    gravity(0.0f, 0.0f),
+    drag(0.3f)
+{
+}
+
+ofxNDParticleSystem::ofxNDParticleSystem() :
+    vectorized(true),
+    _maxParticles(0),
+    _numParticles(0),
+    _seed(0x2545F491)
+{
+}
+
+ofxNDParticleSystem::~ofxNDParticleSystem()
+{
+    stopThreads();
+}
+
+void ofxNDParticleSystem::setup(unsigned int maxParticles)
+{
+    _maxParticles = maxParticles;
+    _numParticles = 0;
+
+    // even, so the SIMD loops can always run on whole pairs of particles
+    unsigned int nFloats = ((maxParticles + 1) & ~1u)*2;
+    _position.allocate(nFloats);
+    _shape.allocate(nFloats);
+    _velocity.allocate(nFloats);
+    _rates.allocate(nFloats);
+}
+
+float ofxNDParticleSystem::random()
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return (_seed >> 8)*(1.0f/16777216.0f);
+}
+
+unsigned int ofxNDParticleSystem::emit(unsigned int count, const ofVec2f &position, const ofVec2f &velocity,
+                                       float spread, float speed, float size, float life)
+{
+    count = MIN(count, _maxParticles - _numParticles);
+    if (life <= 0.0f) return 0;
+
+    for (unsigned int n=0; n<count; n++){
+        unsigned int i = 2*_numParticles++;
+
+        // uniform in the disc: sqrt of the radius
+        float angle = TWO_PI*random();
+        float radius = spread*sqrtf(random());
+        _position[i] = position.x + cosf(angle)*radius;
+        _position[i+1] = position.y + sinf(angle)*radius;
+
+        angle = TWO_PI*random();
+        float particleSpeed = speed*random();
+        _velocity[i] = velocity.x + cosf(angle)*particleSpeed;
+        _velocity[i+1] = velocity.y + sinf(angle)*particleSpeed;
+
+        float particleSize = size*(0.5f + 0.5f*random());
+        float particleLife = life*(0.5f + 0.5f*random());
+        _shape[i] = particleSize;
+        _shape[i+1] = 0.0f;
+        _rates[i] = -particleSize/particleLife;
+        _rates[i+1] = 1.0f/particleLife;
+    }
+
+    return count;
+}
+
+void ofxNDParticleSystem::update(float dt, const Parameters &parameters)
+{
+    if (_numParticles == 0 || dt <= 0.0f) return;
+
+    // every worker gets an equal share of whole slices, the calling thread takes the rest
+    unsigned int nThreads = MIN(getNumThreads(), MAX(1u, _numParticles/MIN_PARTICLES_PER_THREAD));
+    unsigned int share = (_numParticles/nThreads) & ~(PARTICLE_SLICE_ALIGN - 1);
+
+    for (unsigned int t=0; t<nThreads-1; t++){
+        _workers[t]->start(t*share, (t+1)*share, dt, parameters);
+    }
+    integrate((nThreads-1)*share, _numParticles, dt, parameters);
+    for (unsigned int t=0; t<nThreads-1; t++){
+        _workers[t]->finish();
+    }
+
+    removeDead();
+}
+
+void ofxNDParticleSystem::integrate(unsigned int begin, unsigned int end, float dt, const Parameters &parameters)
+{
+    // p += v*dt, v = v*drag^dt + g*dt, (size, age) += (growth, 1/life)*dt.
+    // Position integrates the old velocity, matching the scalar loop below.
+    float damping = powf(parameters.drag, dt);
+    float gx = parameters.gravity.x*dt;
+    float gy = parameters.gravity.y*dt;
+
+    // whole pairs; the odd one out at the end is harmless padding
+    unsigned int first = 2*begin;
+    unsigned int last = 2*((end + 1) & ~1u);
+    float *p = _position.data(), *s = _shape.data(), *v = _velocity.data(), *r = _rates.data();
+
+#if defined(PARTICLES_SSE)
+    if (vectorized){
+        __m128 t = _mm_set1_ps(dt);
+        __m128 d = _mm_set1_ps(damping);
+        __m128 g = _mm_setr_ps(gx, gy, gx, gy);
+        __m128 zero = _mm_setzero_ps();
+        for (unsigned int i = first; i < last; i += 4){
+            __m128 vi = _mm_load_ps(v + i);
+            _mm_store_ps(p + i, _mm_add_ps(_mm_load_ps(p + i), _mm_mul_ps(vi, t)));
+            _mm_store_ps(v + i, _mm_add_ps(_mm_mul_ps(vi, d), g));
+            __m128 si = _mm_add_ps(_mm_load_ps(s + i), _mm_mul_ps(_mm_load_ps(r + i), t));
+            _mm_store_ps(s + i, _mm_max_ps(si, zero));
+        }
+        return;
+    }
+#elif defined(PARTICLES_NEON)
+    if (vectorized){
+        float32x4_t t = vdupq_n_f32(dt);
+        float32x4_t d = vdupq_n_f32(damping);
+        float gravity[4] = { gx, gy, gx, gy };
+        float32x4_t g = vld1q_f32(gravity);
+        float32x4_t zero = vdupq_n_f32(0.0f);
+        for (unsigned int i = first; i < last; i += 4){
+            float32x4_t vi = vld1q_f32(v + i);
+            vst1q_f32(p + i, vaddq_f32(vld1q_f32(p + i), vmulq_f32(vi, t)));
+            vst1q_f32(v + i, vaddq_f32(vmulq_f32(vi, d), g));
+            float32x4_t si = vaddq_f32(vld1q_f32(s + i), vmulq_f32(vld1q_f32(r + i), t));
+            vst1q_f32(s + i, vmaxq_f32(si, zero));
+        }
+        return;
+    }
+#endif
+
+    for (unsigned int i = first; i < last; i += 2){
+        float vx = v[i], vy = v[i+1];
+        p[i] += vx*dt;
+        p[i+1] += vy*dt;
+        v[i] = vx*damping + gx;
+        v[i+1] = vy*damping + gy;
+        s[i] = MAX(s[i] + r[i]*dt, 0.0f);
+        s[i+1] = MAX(s[i+1] + r[i+1]*dt, 0.0f);
+    }
+}
+
+void ofxNDParticleSystem::removeDead()
+{
+    const float *s = _shape.data();
+    unsigned int i = 0;
+    while (i < _numParticles){
+
+#if defined(PARTICLES_SSE)
+        // most particles are alive: skip them two at a time on the age lanes
+        if (vectorized && i + 2 <= _numParticles){
+            int dead = _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(s + 2*i), _mm_set1_ps(1.0f))) & 0xA;
+            if (!dead){
+                i += 2;
+                continue;
+            }
+        }
+#elif defined(PARTICLES_NEON)
+        if (vectorized && i + 2 <= _numParticles){
+            uint32x4_t dead = vcgeq_f32(vld1q_f32(s + 2*i), vdupq_n_f32(1.0f));
+            if (!(vgetq_lane_u32(dead, 1) | vgetq_lane_u32(dead, 3))){
+                i += 2;
+                continue;
+            }
+        }
+#endif
+
+        // the particle moved in from the end gets checked on the next pass
+        if (s[2*i+1] >= 1.0f){
+            moveParticle(--_numParticles, i);
+        }
+        else{
+            i++;
+        }
+    }
+}
+
+void ofxNDParticleSystem::moveParticle(unsigned int from, unsigned int to)
+{
+    if (from == to) return;
+    unsigned int f = 2*from, t = 2*to;
+    _position[t] = _position[f];  _position[t+1] = _position[f+1];
+    _shape[t] = _shape[f];        _shape[t+1] = _shape[f+1];
+    _velocity[t] = _velocity[f];  _velocity[t+1] = _velocity[f+1];
+    _rates[t] = _rates[f];        _rates[t+1] = _rates[f+1];
+}
+
+void ofxNDParticleSystem::draw()
+{
+    if (_numParticles == 0) return;
+
+    glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    glEnable(GL_POINT_SPRITE);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, _position.data());
+    glTexCoordPointer(2, GL_FLOAT, 0, _shape.data());
+
+    glDrawArrays(GL_POINTS, 0, _numParticles);
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisable(GL_POINT_SPRITE);
+    glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+}
+
+#pragma mark - Threads
+
+void ofxNDParticleSystem::setNumThreads(unsigned int n)
+{
+    n = CLAMP(n, 1u, (unsigned int)MAX_PARTICLE_THREADS);
+    if (n == getNumThreads()) return;
+
+    stopThreads();
+    for (unsigned int t=1; t<n; t++){
+        UpdateThread *worker = new UpdateThread(this);
+        worker->startThread(false, false);
+        _workers.push_back(worker);
+    }
+}
+
+void ofxNDParticleSystem::stopThreads()
+{
+    for (unsigned int t=0; t<_workers.size(); t++){
+        _workers[t]->quit();
+        delete _workers[t];
+    }
+    _workers.clear();
+}
+
+ofxNDParticleSystem::UpdateThread::UpdateThread(ofxNDParticleSystem *system) :
+    _system(system),
+    _pending(false),
+    _quit(false),
+    _begin(0),
+    _end(0),
+    _dt(0.0f)
+{
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_condition, NULL);
+}
+
+ofxNDParticleSystem::UpdateThread::~UpdateThread()
+{
+    pthread_cond_destroy(&_condition);
+    pthread_mutex_destroy(&_mutex);
+}
+
+void ofxNDParticleSystem::UpdateThread::start(unsigned int begin, unsigned int end, float dt, const Parameters &parameters)
+{
+    pthread_mutex_lock(&_mutex);
+    _begin = begin;
+    _end = end;
+    _dt = dt;
+    _parameters = parameters;
+    _pending = true;
+    pthread_cond_broadcast(&_condition);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ofxNDParticleSystem::UpdateThread::finish()
+{
+    pthread_mutex_lock(&_mutex);
+    while (_pending){
+        pthread_cond_wait(&_condition, &_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ofxNDParticleSystem::UpdateThread::quit()
+{
+    pthread_mutex_lock(&_mutex);
+    _quit = true;
+    pthread_cond_broadcast(&_condition);
+    pthread_mutex_unlock(&_mutex);
+    waitForThread(true);
+}
+
+void ofxNDParticleSystem::UpdateThread::threadedFunction()
+{
+    // polling like the audio analysis thread would cost up to a ms a frame here,
+    // so the worker sleeps on a condition until the next slice arrives
+    pthread_mutex_lock(&_mutex);
+    while (true){
+        while (!_pending && !_quit){
+            pthread_cond_wait(&_condition, &_mutex);
+        }
+        if (_quit) break;
+
+        pthread_mutex_unlock(&_mutex);
+        _system->integrate(_begin, _end, _dt, _parameters);
+        pthread_mutex_lock(&_mutex);
+
+        _pending = false;
+        pthread_cond_broadcast(&_condition);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
@@ -0,0 +1,127 @@
+//
+//  ofxNDParticleSystem.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/16/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxNDAlignedArray.h"
+#include <pthread.h>
+
+#define MAX_PARTICLE_THREADS    8
+
+/// Fixed-capacity particle pool, updated with SSE/NEON and drawn as point sprites.
+///
+/// Everything is allocated in setup(); emitting and dying only move data around
+/// inside the pool. Each field is its own array of (x, y) pairs:
+///
+///     position    x, y            px              - the vertex array
+///     shape       size, age       px, 0..1        - texcoord 0, for the shader
+///     velocity    x, y            px/s
+///     rates       growth, 1/life  px/s, 1/s
+///
+/// so one update is three element-wise multiply-adds over whole arrays, two
+/// particles per SIMD op. Live particles are 0..getNumParticles()-1; a particle
+/// dies when its age reaches 1 and the last one is moved into its place.
+///
+/// setNumThreads() splits the update over worker threads; emitting, compacting and
+/// drawing stay on the calling thread.
+class ofxNDParticleSystem {
+
+public:
+
+    struct Parameters {
+
+        ofVec2f     gravity;        // px/s^2
+        float       drag;           // fraction of velocity kept per second
+
+        Parameters();
+    };
+
+    ofxNDParticleSystem();
+    ~ofxNDParticleSystem();
+
+    // allocates the pool (and discards every particle); 0 releases it
+    void setup(unsigned int maxParticles);
+
+    unsigned int getMaxParticles() const    { return _maxParticles; };
+    unsigned int getNumParticles() const    { return _numParticles; };
+
+    // Up to count particles around position (uniformly within spread px), moving at
+    // velocity plus a random direction at up to speed px/s, starting at up to size px
+    // and shrinking to nothing over up to life seconds. Returns how many fit in the pool.
+    unsigned int emit(unsigned int count, const ofVec2f & position, const ofVec2f & velocity,
+                      float spread, float speed, float size, float life);
+
+    void clear()                            { _numParticles = 0; };
+
+    // ages and moves every particle by dt seconds, then removes the dead
+    void update(float dt, const Parameters & parameters);
+
+    // 1 updates on the calling thread; more starts n-1 workers (at most MAX_PARTICLE_THREADS)
+    void setNumThreads(unsigned int n);
+    unsigned int getNumThreads() const      { return _workers.size() + 1; };
+
+    // One GL_POINTS draw of every particle. Bind a shader that takes gl_PointSize from
+    // gl_MultiTexCoord0.x (shaders/particles.vert does) before calling.
+    void draw();
+
+    const float * getPositions() const      { return _position.data(); };
+    const float * getShapes() const         { return _shape.data(); };
+    const float * getVelocities() const     { return _velocity.data(); };
+    const float * getRates() const          { return _rates.data(); };
+
+    // false runs the plain scalar loops, for comparison
+    bool            vectorized;
+
+private:
+
+    class UpdateThread;
+    friend class UpdateThread;
+
+    // Waits for a slice of particles to update, updates it, signals it's done, repeat
+    class UpdateThread : public ofThread {
+    public:
+        UpdateThread(ofxNDParticleSystem *system);
+        ~UpdateThread();
+        void start(unsigned int begin, unsigned int end, float dt, const Parameters & parameters);
+        void finish();
+        void quit();
+    protected:
+        void threadedFunction();
+    private:
+        ofxNDParticleSystem *_system;
+        pthread_mutex_t     _mutex;
+        pthread_cond_t      _condition;
+        bool                _pending;
+        bool                _quit;
+        unsigned int        _begin;
+        unsigned int        _end;
+        float               _dt;
+        Parameters          _parameters;
+    };
+
+    // particles [begin, end), begin even
+    void integrate(unsigned int begin, unsigned int end, float dt, const Parameters & parameters);
+    void removeDead();
+    void moveParticle(unsigned int from, unsigned int to);
+    void stopThreads();
+
+    // xorshift, 0..1
+    float random();
+
+    unsigned int    _maxParticles;
+    unsigned int    _numParticles;
+    unsigned int    _seed;
+
+    ofxNDAlignedArray<float>    _position;
+    ofxNDAlignedArray<float>    _shape;
+    ofxNDAlignedArray<float>    _velocity;
+    ofxNDAlignedArray<float>    _rates;
+
+    vector<UpdateThread*>       _workers;
+};
@@ -0,0 +1,95 @@
+//
+//  ofxNDQualityGovernor.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#include "ofxNDQualityGovernor.h"
+
+ofxNDQualityGovernor::Settings::Settings() :
+    targetMs(1000.0f/60.0f),
+    overBudget(1.15f),
+    upHeadroom(0.6f),
+    downSeconds(0.5f),
+    upSeconds(3.0f),
+    maxUpSeconds(60.0f),
+    holdSeconds(1.0f),
+    smoothing(0.25f)
+{
+}
+
+ofxNDQualityGovernor::ofxNDQualityGovernor() :
+    _numLevels(1),
+    _level(0),
+    _intervalMs(0.0f),
+    _busyMs(0.0f),
+    _overTime(0.0f),
+    _underTime(0.0f),
+    _holdTime(0.0f),
+    _sinceRaise(0.0f)
+{
+}
+
+void ofxNDQualityGovernor::setup(unsigned int numLevels, unsigned int startLevel, const Settings &settings)
+{
+    _settings = settings;
+    _numLevels = MAX(numLevels, 1u);
+    _upSeconds.assign(_numLevels, settings.upSeconds);
+    _intervalMs = 0.0f;
+    _busyMs = 0.0f;
+    _sinceRaise = settings.maxUpSeconds;
+    setLevel(startLevel);
+}
+
+void ofxNDQualityGovernor::setLevel(unsigned int level)
+{
+    _level = MIN(level, _numLevels - 1);
+    _overTime = 0.0f;
+    _underTime = 0.0f;
+    _holdTime = _settings.holdSeconds;
+}
+
+bool ofxNDQualityGovernor::update(float intervalMs, float busyMs, float dt)
+{
+    if (dt <= 0.0f) return false;
+
+    // one pole, so a single slow frame (a GC, a texture upload) doesn't count for much
+    float k = 1.0f - expf(-dt/_settings.smoothing);
+    _intervalMs = _intervalMs == 0.0f ? intervalMs : _intervalMs + (intervalMs - _intervalMs)*k;
+    _busyMs = _busyMs == 0.0f ? busyMs : _busyMs + (busyMs - _busyMs)*k;
+    _sinceRaise += dt;
+
+    // held this level long enough: it gets the short wait again next time
+    if (_sinceRaise >= _settings.maxUpSeconds){
+        _upSeconds[_level] = _settings.upSeconds;
+    }
+
+    if (_holdTime > 0.0f){
+        _holdTime -= dt;
+        return false;
+    }
+
+    bool over = _intervalMs > _settings.targetMs*_settings.overBudget;
+    bool headroom = !over && _busyMs < _settings.targetMs*_settings.upHeadroom;
+    _overTime = over ? _overTime + dt : 0.0f;
+    _underTime = headroom ? _underTime + dt : 0.0f;
+
+    if (_overTime >= _settings.downSeconds && _level > 0){
+        // gave up on a level we only just reached: wait longer before trying it again
+        if (_sinceRaise < 2.0f*_upSeconds[_level]){
+            _upSeconds[_level] = MIN(_upSeconds[_level]*2.0f, _settings.maxUpSeconds);
+        }
+        setLevel(_level - 1);
+        return true;
+    }
+
+    if (_level + 1 < _numLevels && _underTime >= _upSeconds[_level + 1]){
+        setLevel(_level + 1);
+        _sinceRaise = 0.0f;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,73 @@
+//
+//  ofxNDQualityGovernor.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+/// Picks a quality level (0 = cheapest .. numLevels-1 = best) that holds frames
+/// within a time budget. What a level means is up to the caller.
+///
+/// Two measurements per frame: the frame interval, which shows frames that were
+/// missed (with vertical sync it never drops below the refresh), and the busy time
+/// spent making the frame, which shows how much headroom is left. Both are
+/// smoothed. The level drops when the interval has been over budget for
+/// downSeconds, and rises when there's been upHeadroom to spare for upSeconds;
+/// after any change neither happens again for holdSeconds. If a level turns out
+/// too expensive soon after rising to it, the wait before trying it again doubles,
+/// so a budget that sits between two levels settles on the lower one instead of
+/// flipping between them.
+class ofxNDQualityGovernor {
+
+public:
+
+    struct Settings {
+
+        float           targetMs;       // frame budget (16.6 for 60Hz)
+        float           overBudget;     // interval above targetMs x this counts as missing the budget
+        float           upHeadroom;     // busy time below targetMs x this leaves room for the next level
+        float           downSeconds;
+        float           upSeconds;      // first wait for a level, doubled up to maxUpSeconds on failures
+        float           maxUpSeconds;
+        float           holdSeconds;
+        float           smoothing;      // seconds, time constant of the smoothed times
+
+        Settings();
+    };
+
+    ofxNDQualityGovernor();
+
+    void setup(unsigned int numLevels, unsigned int startLevel, const Settings & settings = Settings());
+    Settings & getSettings()                { return _settings; };
+
+    // once a frame, dt in seconds; true when the level changed
+    bool update(float intervalMs, float busyMs, float dt);
+
+    // manual level, e.g. with the governor off; counts as a change for the hold
+    void setLevel(unsigned int level);
+
+    unsigned int getLevel() const           { return _level; };
+    unsigned int getNumLevels() const       { return _numLevels; };
+    float   getSmoothedIntervalMs() const   { return _intervalMs; };
+    float   getSmoothedBusyMs() const       { return _busyMs; };
+
+private:
+
+    Settings        _settings;
+    unsigned int    _numLevels;
+    unsigned int    _level;
+
+    float           _intervalMs;
+    float           _busyMs;
+    float           _overTime;          // seconds the interval has been over budget
+    float           _underTime;         // seconds there's been headroom
+    float           _holdTime;          // seconds left before another change
+    float           _sinceRaise;        // seconds since the last rise
+
+    vector<float>   _upSeconds;         // per level, the wait before rising to it
+};
@@ -0,0 +1,178 @@
+//
+//  benchMain.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//  Entry point for the benchmarks and checks that need no display, GL context or
+//  devices, built by "make bench" or the drawAndFadeBench target in Xcode:
+//
+//  drawAndFadeBench audio-run input.wav [output.csv]
+//  drawAndFadeBench audio-channels [maxChannels 16] [seconds 10]
+//  drawAndFadeBench audio-onset [bpm 120] [seconds 20]
+//  drawAndFadeBench audio-features [seconds 10] [passes 5]
+//  drawAndFadeBench audio-fft [callsPerSize 2000]
+//  drawAndFadeBench audio-readers [seconds 10]
+//  drawAndFadeBench frame-ring [seconds 5]
+//  drawAndFadeBench physics-replay [path.csv]
+//  drawAndFadeBench pipeline [users 6] [seconds 60]
+//  drawAndFadeBench filters [path.csv]
+//  drawAndFadeBench ropes
+//  drawAndFadeBench particles
+//  drawAndFadeBench joints
+//  drawAndFadeBench overlap
+//  drawAndFadeBench gestures [recording.ndht]
+//
+//  Results are logged. The exit status is 1 if a check failed or the mode or its
+//  arguments are wrong.
+//
+
+#include "ofMain.h"
+#include "ofxAudioAnalyzerFileRunner.h"
+#include "ofxNDFrameRing.h"
+#include "ofxHandPhysicsBenchmark.h"
+#include "ofxSyntheticTrackingSource.h"
+
+static float argument(const vector<string> & args, unsigned int index, float defaultValue)
+{
+    return index < args.size() ? ofToFloat(args[index]) : defaultValue;
+}
+
+// publishes frames whose every field holds the frame number, as fast as it can
+class FrameRingWriter : public ofThread {
+public:
+
+    struct Frame {
+        unsigned int values[256];
+    };
+
+    ofxNDFrameRing<Frame> ring;
+
+    void threadedFunction()
+    {
+        for (unsigned int n = 0; isThreadRunning(); n++){
+            Frame & frame = ring.beginWrite();
+            for (int i=0; i<256; i++){
+                frame.values[i] = n;
+            }
+            ring.endWrite();
+        }
+    };
+};
+
+// Reads a small ring while another thread overwrites it: every frame read() or
+// readRecent() returns has to be whole, and readRecent()'s have to be consecutive.
+static bool checkFrameRing(float seconds)
+{
+    FrameRingWriter writer;
+    FrameRingWriter::Frame prototype;
+    memset(&prototype, 0, sizeof(prototype));
+    writer.ring.allocate(4, prototype);
+    writer.startThread(false, false);
+
+    unsigned long long endTime = ofGetElapsedTimeMicros() + (unsigned long long)(seconds*1000000);
+    unsigned int numReads = 0;
+    unsigned int numMismatched = 0;
+    FrameRingWriter::Frame frame;
+    vector<FrameRingWriter::Frame> recent;
+
+    while (ofGetElapsedTimeMicros() < endTime){
+        unsigned int nRead = 0;
+        if (writer.ring.read(frame, numReads % 3)){
+            recent.resize(MAX(recent.size(), 1));
+            recent[0] = frame;
+            nRead = 1;
+        }
+        else{
+            nRead = writer.ring.readRecent(recent, 3);
+        }
+        for (unsigned int f=0; f<nRead; f++){
+            bool whole = recent[f].values[0] == recent[0].values[0] - f;
+            for (int i=1; i<256 && whole; i++){
+                whole = recent[f].values[i] == recent[f].values[0];
+            }
+            if (!whole) numMismatched++;
+        }
+        numReads += nRead;
+    }
+    writer.waitForThread(true);
+
+    ofLog(numMismatched > 0 ? OF_LOG_ERROR : OF_LOG_NOTICE, "ofxNDFrameRing: " + ofToString(writer.ring.getWriteCount()) + " frames written, " +
+          ofToString(numReads) + " read, " + ofToString(writer.ring.getTornReadCount()) + " reads caught mid-write and dropped, " +
+          ofToString(numMismatched) + " returned with mismatched fields");
+    return numMismatched == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    string mode = argc > 1 ? argv[1] : "";
+    vector<string> args;
+    for (int i=2; i<argc; i++){
+        args.push_back(argv[i]);
+    }
+
+    int result = 0;
+
+    if (mode == "audio-run" && !args.empty()){
+        ofxAudioAnalyzerFileRunner::Result run = ofxAudioAnalyzerFileRunner::run(args[0], args.size() > 1 ? args[1] : "");
+        ofxAudioAnalyzerFileRunner::logResult(run);
+        if (!run.success) result = 1;
+    }
+    else if (mode == "audio-channels"){
+        ofxAudioAnalyzerFileRunner::benchmarkChannelScaling(argument(args, 0, 16), argument(args, 1, 10.0f));
+    }
+    else if (mode == "audio-onset"){
+        ofxAudioAnalyzerFileRunner::logOnsetLatency(ofxAudioAnalyzerFileRunner::measureOnsetLatency(argument(args, 0, 120.0f), argument(args, 1, 20.0f)));
+    }
+    else if (mode == "audio-features"){
+        ofxAudioAnalyzerFileRunner::benchmarkFeatureCost(argument(args, 0, 10.0f), argument(args, 1, 5));
+    }
+    else if (mode == "audio-fft"){
+        // the analyzer prefers the built-in FFT, so it has to win at every size
+        if (ofxAudioAnalyzerFileRunner::benchmarkFft(argument(args, 0, 2000)) > 0) result = 1;
+    }
+    else if (mode == "audio-readers"){
+        if (!ofxAudioAnalyzerFileRunner::checkReaders(argument(args, 0, 10.0f))) result = 1;
+    }
+    else if (mode == "frame-ring"){
+        if (!checkFrameRing(argument(args, 0, 5.0f))) result = 1;
+    }
+    else if (mode == "physics-replay"){
+        vector<ofxHandPhysicsBenchmark::PathSample> path = args.empty() ? ofxHandPhysicsBenchmark::syntheticPath() : ofxHandPhysicsBenchmark::loadPath(args[0]);
+        if (path.empty() || !ofxHandPhysicsBenchmark::run(path)) result = 1;
+    }
+    else if (mode == "pipeline"){
+        // users come and go every few seconds, so departed hands' slots get reused
+        ofxSyntheticTrackingSource source(argument(args, 0, 6), 1, 5.0f);
+        ofxHandPhysicsBenchmark::PipelineResult run = ofxHandPhysicsBenchmark::runPipeline(source, argument(args, 1, 60.0f));
+        ofxHandPhysicsBenchmark::logPipelineResult(run);
+        if (run.badPositions > 0 || run.badHandles > 0 || (run.handsRemoved > 0 && run.staleHandles == 0)) result = 1;
+    }
+    else if (mode == "filters"){
+        vector<ofxHandPhysicsBenchmark::PathSample> path = args.empty() ? ofxHandPhysicsBenchmark::syntheticPath() : ofxHandPhysicsBenchmark::loadPath(args[0]);
+        if (path.empty()) result = 1;
+        else ofxHandPhysicsBenchmark::runFilters(path);
+    }
+    else if (mode == "ropes"){
+        if (!ofxHandPhysicsBenchmark::runRopes()) result = 1;
+    }
+    else if (mode == "particles"){
+        if (!ofxHandPhysicsBenchmark::checkParticles()) result = 1;
+        ofxHandPhysicsBenchmark::runParticles();
+    }
+    else if (mode == "joints"){
+        if (!ofxHandPhysicsBenchmark::runJoints()) result = 1;
+    }
+    else if (mode == "overlap"){
+        ofxHandPhysicsBenchmark::runOverlap();
+    }
+    else if (mode == "gestures"){
+        if (!(args.empty() ? ofxHandPhysicsBenchmark::runGestures() : ofxHandPhysicsBenchmark::runGestures(args[0]))) result = 1;
+    }
+    else{
+        ofLog(OF_LOG_ERROR, "Usage: drawAndFadeBench <mode> [arguments...], modes: audio-run audio-channels audio-onset audio-features audio-fft audio-readers frame-ring physics-replay pipeline filters ropes particles joints overlap gestures");
+        return 1;
+    }
+
+    return result;
+}
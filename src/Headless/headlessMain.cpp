@@ -0,0 +1,274 @@
+//
+//  headlessMain.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//  Entry point for builds without a display (Linux render boxes), in place of
+//  main.mm, glLaunch.mm and the Cocoa app. Renders a fixed number of frames with
+//  Mesa's software rasterizer on a simulated clock:
+//
+//  drawAndFadeHeadless [--frames 600] [--fps 60] [--size 1280x720] [--seed 1]
+//                      [--script input.txt] [--tracking synthetic|recording.ndht]
+//                      [--audio input.wav] [--dump frames/] [--timings frame_timings.csv]
+//                      [--golden frames/] [--tolerance 0]
+//                      [--trails-format rgba32f|rgba16f|rgb10_a2|rgba8] [--trails-scale 1.25]
+//                      [--quality 0-4] [--blur-check 4[,8,...]]
+//
+//  --dump writes every frame's mainFbo as frames/frame_00000.png and so on. The
+//  same arguments render the same frames, so --golden compares each frame to a
+//  dump made earlier: frames with any channel further off than --tolerance are
+//  logged, and the run exits with 1 if there were any.
+//
+//  --blur-check blurs a test pattern with ofxNDGaussianBlur at each sigma after
+//  the first frame, directly and through the pyramid, and compares the GPU result
+//  to the CPU reference (within --tolerance, at least 1). How far both are from an
+//  exact Gaussian is logged too, and the largest GPU difference at the end.
+//
+//  Built by "make headless" (see the Makefile) or the drawAndFadeHeadless target
+//  in Xcode.
+//
+
+#include "ofMain.h"
+#include "ofApplication.h"
+#include "ofxHeadlessWindow.h"
+#include "ofxNDGaussianBlur.h"
+
+// saves and compares each rendered frame, outside the window's timings
+class FrameChecker {
+public:
+
+    FrameChecker(ofApplication * app) : app(app), tolerance(0), numChecked(0), numDifferent(0), maxDifference(0) {};
+
+    void frameRendered(int & frame)
+    {
+        char name[32];
+        sprintf(name, "frame_%05d.png", frame);
+        app->readMainFbo(_pixels);
+
+        if (!dumpDirectory.empty()){
+            ofSaveImage(_pixels, dumpDirectory + "/" + name);
+        }
+        if (!goldenDirectory.empty()){
+            compare(goldenDirectory + "/" + name);
+        }
+    };
+
+    ofApplication * app;
+    string          dumpDirectory;
+    string          goldenDirectory;
+    int             tolerance;          // per channel, 0-255
+
+    unsigned int    numChecked;
+    unsigned int    numDifferent;
+    int             maxDifference;
+
+private:
+
+    void compare(const string & path)
+    {
+        numChecked++;
+        if (!ofLoadImage(_golden, path) || _golden.getWidth() != _pixels.getWidth() ||
+            _golden.getHeight() != _pixels.getHeight() || _golden.getNumChannels() != _pixels.getNumChannels()){
+            ofLog(OF_LOG_ERROR, "Golden " + path + " is missing or a different size");
+            numDifferent++;
+            return;
+        }
+
+        const unsigned char * a = _pixels.getPixels();
+        const unsigned char * b = _golden.getPixels();
+        unsigned int n = _pixels.getWidth()*_pixels.getHeight()*_pixels.getNumChannels();
+        int difference = 0;
+        unsigned int numOff = 0;
+        for (unsigned int i=0; i<n; i++){
+            int d = abs((int)a[i] - (int)b[i]);
+            difference = MAX(difference, d);
+            if (d > tolerance) numOff++;
+        }
+        maxDifference = MAX(maxDifference, difference);
+        if (numOff > 0){
+            ofLog(OF_LOG_WARNING, path + ": " + ofToString(numOff) + " channels off by up to " + ofToString(difference));
+            numDifferent++;
+        }
+    };
+
+    ofPixels        _pixels;
+    ofPixels        _golden;
+};
+
+// runs ofxNDGaussianBlur on the GPU and the CPU once there's a GL context
+class BlurChecker {
+public:
+
+    BlurChecker() : tolerance(1), numChecked(0), numFailed(0), maxDifference(0.0f) {};
+
+    void frameRendered(int & frame)
+    {
+        if (numChecked > 0) return;
+        for (unsigned int i=0; i<sigmas.size(); i++){
+            check(sigmas[i], false, ceilf(3.0f*sigmas[i]));
+            check(sigmas[i], true, 5);
+        }
+    };
+
+    vector<float>   sigmas;
+    int             tolerance;          // per channel, 0-255
+
+    unsigned int    numChecked;
+    unsigned int    numFailed;
+    float           maxDifference;      // GPU from the CPU reference, 0-255
+
+private:
+
+    void check(float sigma, bool usePyramid, int maxRadius)
+    {
+        const int width = 320;
+        const int height = 240;
+        numChecked++;
+
+        // float target, so the only differences are in the sampling
+        ofFbo fbo;
+        fbo.allocate(width, height, GL_RGBA32F_ARB);
+        fbo.getTextureReference().setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+        fbo.begin();
+        ofClear(0, 0, 0, 0);
+        ofFill();
+        ofSetColor(255, 255, 255);
+        ofCircle(ofPoint(width/2, height/2), 50);
+        ofSetColor(255, 0, 0);
+        ofRect(0, 0, 40, 30);
+        ofSetColor(0, 255, 0);
+        for (int i=0; i<8; i++){
+            ofRect(20 + i*37, height - 20 - i*9, 1, 1);
+        }
+        fbo.end();
+
+        ofFloatPixels source;
+        fbo.readToPixels(source);
+
+        ofxNDGaussianBlur blur;
+        blur.setup(width, height, GL_RGBA32F_ARB);
+        blur.setSigma(sigma);
+        blur.setMaxRadius(maxRadius);
+        blur.setUsePyramid(usePyramid);
+        blur.apply(fbo);
+
+        ofFloatPixels gpu;
+        fbo.readToPixels(gpu);
+        ofFloatPixels reference = source;
+        blur.applyReference(reference);
+        ofFloatPixels exact = source;
+        ofxNDGaussianBlur::gaussianReference(exact, sigma);
+
+        float gpuDifference = 0.0f;
+        float exactDifference = 0.0f;
+        unsigned int n = width*height*source.getNumChannels();
+        for (unsigned int i=0; i<n; i++){
+            gpuDifference = MAX(gpuDifference, fabsf(gpu.getPixels()[i] - reference.getPixels()[i]));
+            exactDifference = MAX(exactDifference, fabsf(reference.getPixels()[i] - exact.getPixels()[i]));
+        }
+
+        maxDifference = MAX(maxDifference, gpuDifference*255.0f);
+        bool failed = gpuDifference*255.0f > MAX(tolerance, 1);
+        if (failed) numFailed++;
+        ofLog(failed ? OF_LOG_ERROR : OF_LOG_NOTICE, "Blur sigma " + ofToString(sigma) + (usePyramid ? " pyramid" : " direct") +
+              " (" + ofToString(blur.getNumLevels()) + " levels, radius " + ofToString(blur.getRadius()) + ", " +
+              ofToString(blur.getNumTaps()) + " taps): GPU off the CPU reference by up to " + ofToString(gpuDifference*255.0f, 3) +
+              ", reference off an exact Gaussian by up to " + ofToString(exactDifference*255.0f, 2));
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    ofxHeadlessWindow::Settings settings;
+    int width = 1280;
+    int height = 720;
+    unsigned int seed = 1;
+    string tracking = "synthetic";
+    string dumpDirectory;
+    string goldenDirectory;
+    int tolerance = 0;
+    vector<float> blurCheckSigmas;
+
+    for (int i=1; i+1<argc; i+=2){
+        string option = argv[i];
+        string value = argv[i+1];
+        if (option == "--frames")           settings.numFrames = ofToInt(value);
+        else if (option == "--fps")         settings.frameRate = ofToFloat(value);
+        else if (option == "--seed")        seed = ofToInt(value);
+        else if (option == "--script")      ofApplicationSetInputScript(value);
+        else if (option == "--tracking")    tracking = value;
+        else if (option == "--audio")       ofApplicationSetAudioInputFile(value);
+        else if (option == "--dump")        dumpDirectory = value;
+        else if (option == "--golden")      goldenDirectory = value;
+        else if (option == "--tolerance")   tolerance = ofToInt(value);
+        else if (option == "--timings")     settings.timingsPath = value;
+        else if (option == "--trails-scale")    ofApplicationSetTrailsScale(ofToFloat(value));
+        else if (option == "--quality")     ofApplicationSetQualityLevel(ofToInt(value));
+        else if (option == "--blur-check"){
+            vector<string> sigmas = ofSplitString(value, ",");
+            for (unsigned int s=0; s<sigmas.size(); s++){
+                if (ofToFloat(sigmas[s]) > 0.0f) blurCheckSigmas.push_back(ofToFloat(sigmas[s]));
+            }
+        }
+        else if (option == "--trails-format" && ofxNDInternalFormatForName(value) != 0){
+            ofApplicationSetTrailsFormat(ofxNDInternalFormatForName(value));
+        }
+        else if (option == "--size"){
+            vector<string> size = ofSplitString(value, "x");
+            if (size.size() == 2){
+                width = ofToInt(size[0]);
+                height = ofToInt(size[1]);
+            }
+        }
+        else{
+            ofLog(OF_LOG_ERROR, "Unknown option " + option);
+            return 1;
+        }
+    }
+
+    ofApplicationSetRandomSeed(seed);
+    ofApplicationSetTrackingRecording(tracking);
+
+#ifdef TARGET_OSX
+    // a tool in bin/ next to data/, not inside an app bundle
+    ofSetDataPathRoot("data/");
+#endif
+
+    ofxHeadlessWindow window(settings);
+    ofSetupOpenGL(&window, width, height, OF_WINDOW);
+
+    ofApplication * app = new ofApplication();
+    FrameChecker checker(app);
+    checker.dumpDirectory = dumpDirectory;
+    checker.goldenDirectory = goldenDirectory;
+    checker.tolerance = tolerance;
+    if (!dumpDirectory.empty()){
+        ofDirectory::createDirectory(dumpDirectory, true, true);
+    }
+    if (!dumpDirectory.empty() || !goldenDirectory.empty()){
+        ofAddListener(window.frameRendered, &checker, &FrameChecker::frameRendered);
+    }
+
+    BlurChecker blurChecker;
+    blurChecker.sigmas = blurCheckSigmas;
+    blurChecker.tolerance = tolerance;
+    if (!blurCheckSigmas.empty()){
+        ofAddListener(window.frameRendered, &blurChecker, &BlurChecker::frameRendered);
+    }
+
+    ofRunApp(app);
+
+    int result = 0;
+    if (checker.numChecked > 0){
+        ofLog(OF_LOG_NOTICE, ofToString(checker.numDifferent) + " of " + ofToString(checker.numChecked) +
+              " frames differ from " + goldenDirectory + " (largest channel difference " + ofToString(checker.maxDifference) + ")");
+        if (checker.numDifferent > 0) result = 1;
+    }
+    if (blurChecker.numChecked > 0){
+        ofLog(OF_LOG_NOTICE, ofToString(blurChecker.numFailed) + " of " + ofToString(blurChecker.numChecked) +
+              " blurs off the CPU reference (largest difference " + ofToString(blurChecker.maxDifference, 3) + ")");
+        if (blurChecker.numFailed > 0) result = 1;
+    }
+    return result;
+}
@@ -0,0 +1,145 @@
+//
+//  ofxHeadlessWindow.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#include "ofxHeadlessWindow.h"
+#include "ofxNDClock.h"
+#include <algorithm>
+#include <fstream>
+
+ofxHeadlessWindow::Settings::Settings() :
+    numFrames(600),
+    frameRate(60.0f),
+    timingsPath("frame_timings.csv")
+{
+}
+
+ofxHeadlessWindow::ofxHeadlessWindow(const Settings &settings) :
+    _settings(settings),
+    _context(NULL),
+    _width(0),
+    _height(0),
+    _frameNum(0),
+    _setupScreen(true)
+{
+}
+
+ofxHeadlessWindow::~ofxHeadlessWindow()
+{
+    if (_context){
+        OSMesaDestroyContext(_context);
+    }
+}
+
+void ofxHeadlessWindow::setupOpenGL(int w, int h, int screenMode)
+{
+    _width = w;
+    _height = h;
+
+    // no depth: the app draws 2D into its own FBOs
+    _context = OSMesaCreateContextExt(OSMESA_RGBA, 0, 8, 0, NULL);
+    if (_context == NULL){
+        ofLog(OF_LOG_FATAL_ERROR, "ofxHeadlessWindow: can't create an OSMesa context");
+        std::exit(1);
+    }
+
+    _buffer.resize(w*h*4);
+    if (!OSMesaMakeCurrent(_context, &_buffer[0], GL_UNSIGNED_BYTE, w, h)){
+        ofLog(OF_LOG_FATAL_ERROR, "ofxHeadlessWindow: can't make the OSMesa context current");
+        std::exit(1);
+    }
+
+    ofLog(OF_LOG_NOTICE, "ofxHeadlessWindow: " + ofToString(w) + "x" + ofToString(h) + " on " +
+          string((const char*)glGetString(GL_RENDERER)) + ", OpenGL " + string((const char*)glGetString(GL_VERSION)));
+}
+
+void ofxHeadlessWindow::runAppViaInfiniteLoop(ofBaseApp *appPtr)
+{
+    ofxNDClock::setSimulated(true);
+    ofNotifySetup();
+
+    _timings.clear();
+    _timings.reserve(_settings.numFrames);
+
+    for (_frameNum = 0; _frameNum < (int)_settings.numFrames; _frameNum++){
+
+        ofxNDClock::setMicros((unsigned long long)(_frameNum*1000000.0/_settings.frameRate));
+
+        FrameTiming timing;
+        unsigned long long start = ofGetElapsedTimeMicros();
+        ofNotifyUpdate();
+        unsigned long long updated = ofGetElapsedTimeMicros();
+        display();
+        glFinish();
+        timing.updateMicros = updated - start;
+        timing.drawMicros = ofGetElapsedTimeMicros() - updated;
+        _timings.push_back(timing);
+
+        int frame = _frameNum;
+        ofNotifyEvent(frameRendered, frame);
+    }
+
+    // ofRunApp returns and the app exits as usual from here
+    reportTimings();
+}
+
+void ofxHeadlessWindow::display()
+{
+    // what ofAppGlutWindow does for a frame, minus the swap
+    ofViewport(0, 0, _width, _height);
+
+    float * bgPtr = ofBgColorPtr();
+    if (ofbClearBg() || _frameNum < 3){
+        glClearColor(bgPtr[0], bgPtr[1], bgPtr[2], bgPtr[3]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    if (_setupScreen) ofSetupScreen();
+
+    ofNotifyDraw();
+}
+
+#pragma mark - Timings
+
+static float percentile(vector<float> & values, float fraction)
+{
+    unsigned int index = MIN(values.size() - 1, (unsigned int)(fraction*values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void ofxHeadlessWindow::reportTimings()
+{
+    if (_timings.empty()) return;
+
+    vector<float> total;
+    double updateSum = 0.0, drawSum = 0.0;
+    for (unsigned int i=0; i<_timings.size(); i++){
+        total.push_back(_timings[i].updateMicros + _timings[i].drawMicros);
+        updateSum += _timings[i].updateMicros;
+        drawSum += _timings[i].drawMicros;
+    }
+
+    stringstream ss;
+    ss << "ofxHeadlessWindow: " << _timings.size() << " frames at " << _settings.frameRate << "fps simulated, "
+       << "update " << updateSum/_timings.size() << "us mean, draw " << drawSum/_timings.size() << "us mean, "
+       << "frame " << percentile(total, 0.5f) << "us median / " << percentile(total, 0.95f) << "us 95th / "
+       << percentile(total, 1.0f) << "us max";
+    ofLog(OF_LOG_NOTICE, ss.str());
+
+    if (_settings.timingsPath.empty()) return;
+
+    std::ofstream file(ofToDataPath(_settings.timingsPath).c_str());
+    if (!file.is_open()){
+        ofLog(OF_LOG_ERROR, "ofxHeadlessWindow: can't write " + _settings.timingsPath);
+        return;
+    }
+    file << "frame,update_us,draw_us\n";
+    for (unsigned int i=0; i<_timings.size(); i++){
+        file << i << "," << _timings[i].updateMicros << "," << _timings[i].drawMicros << "\n";
+    }
+}
@@ -0,0 +1,87 @@
+//
+//  ofxHeadlessWindow.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofAppBaseWindow.h"
+#include <GL/osmesa.h>
+
+/// Runs an app without a display: OpenGL renders offscreen through Mesa's software
+/// rasterizer (OSMesa), for a fixed number of frames on a simulated clock.
+///
+/// Frame n runs at exactly n/frameRate seconds on ofxNDClock, and ofGetFrameRate and
+/// ofGetLastFrameTime report the fixed rate, so a run with the same inputs renders
+/// the same frames however long each one actually takes. Each frame's update and
+/// draw (to glFinish) are timed on the wall clock, logged at the end and written
+/// to timingsPath as CSV.
+///
+/// Link libOSMesa in place of libGL, with GLEW built for OSMesa (GLEW_OSMESA) so
+/// extensions resolve through OSMesaGetProcAddress.
+class ofxHeadlessWindow : public ofAppBaseWindow {
+
+public:
+
+    struct Settings {
+
+        unsigned int    numFrames;
+        float           frameRate;
+        string          timingsPath;    // empty for no CSV
+
+        Settings();
+    };
+
+    struct FrameTiming {
+        float           updateMicros;
+        float           drawMicros;     // including glFinish
+    };
+
+    ofxHeadlessWindow(const Settings & settings = Settings());
+    ~ofxHeadlessWindow();
+
+    void    setupOpenGL(int w, int h, int screenMode);
+    void    initializeWindow() {};
+    void    runAppViaInfiniteLoop(ofBaseApp * appPtr);
+
+    int     getFrameNum()           { return _frameNum; };
+    float   getFrameRate()          { return _settings.frameRate; };
+    double  getLastFrameTime()      { return 1.0/_settings.frameRate; };
+
+    ofPoint getWindowPosition()     { return ofPoint(0, 0); };
+    ofPoint getWindowSize()         { return ofPoint(_width, _height); };
+    ofPoint getScreenSize()         { return ofPoint(_width, _height); };
+    int     getWidth()              { return _width; };
+    int     getHeight()             { return _height; };
+    int     getWindowMode()         { return OF_WINDOW; };
+
+    // the simulated rate is fixed by the settings
+    void    setFrameRate(float targetRate) {};
+
+    void    enableSetupScreen()     { _setupScreen = true; };
+    void    disableSetupScreen()    { _setupScreen = false; };
+
+    // after each frame has rendered, with its number, outside the timings
+    ofEvent<int>    frameRendered;
+
+    const vector<FrameTiming> & getTimings() const { return _timings; };
+
+private:
+
+    void    display();
+    void    reportTimings();
+
+    Settings                _settings;
+    OSMesaContext           _context;
+    vector<unsigned char>   _buffer;        // the default framebuffer, RGBA
+    int                     _width;
+    int                     _height;
+    int                     _frameNum;
+    bool                    _setupScreen;
+
+    vector<FrameTiming>     _timings;
+};
@@ -0,0 +1,115 @@
+//
+//  ofxHandFilter.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/14/12.
+//
+//
+
+#include "ofxHandFilter.h"
+
+const char * ofxHandFilterName(ofxHandFilterType type)
+{
+    switch (type){
+        case HAND_FILTER_ONE_POLE:  return "one-pole";
+        case HAND_FILTER_ONE_EURO:  return "One-Euro";
+        case HAND_FILTER_KALMAN:    return "Kalman";
+        default:                    return "unknown";
+    }
+}
+
+ofxHandFilterSettings::ofxHandFilterSettings() :
+    minCutoff(1.0f),
+    beta(0.02f),
+    derivativeCutoff(1.0f),
+    processNoise(3.0e4f),
+    measurementNoise(2.0f)
+{
+}
+
+// smoothing factor of a one-pole low pass with the given cutoff, sampled every dt
+static inline float lowPassAlpha(float cutoff, float dt)
+{
+    float tau = 1.0f/(TWO_PI*cutoff);
+    return 1.0f/(1.0f + tau/dt);
+}
+
+ofxHandFilter::ofxHandFilter()
+{
+    reset();
+}
+
+void ofxHandFilter::reset()
+{
+    _type = HAND_FILTER_ONE_EURO;
+    _initialized = false;
+    _sampleTime = 0.0f;
+    _position = ofPoint();
+    _velocity = ofVec3f();
+    _p00 = _p01 = _p11 = 0.0f;
+}
+
+void ofxHandFilter::addSample(ofxHandFilterType type, const ofPoint &measured, float sampleTime, const ofxHandFilterSettings &settings)
+{
+    if (!_initialized || type != _type){
+        _type = type;
+        _initialized = true;
+        _sampleTime = sampleTime;
+        _position = measured;
+        _velocity = ofVec3f();
+
+        // unknown velocity: allow for a fast hand
+        float r = settings.measurementNoise;
+        _p00 = r*r;
+        _p01 = 0.0f;
+        _p11 = 1000.0f*1000.0f;
+        return;
+    }
+
+    float dt = sampleTime - _sampleTime;
+    if (dt <= 0.0f) return;
+    _sampleTime = sampleTime;
+
+    if (_type == HAND_FILTER_KALMAN){
+        addKalmanSample(measured, dt, settings);
+    }
+    else{
+        addOneEuroSample(measured, dt, settings);
+    }
+}
+
+void ofxHandFilter::addOneEuroSample(const ofPoint &measured, float dt, const ofxHandFilterSettings &settings)
+{
+    // speed from the raw step, low passed at a fixed cutoff; the magnitude (not
+    // each axis) drives the position cutoff so diagonal moves aren't favoured
+    ofVec3f rawVelocity = (measured - _position)/dt;
+    _velocity += (rawVelocity - _velocity)*lowPassAlpha(settings.derivativeCutoff, dt);
+
+    float cutoff = settings.minCutoff + settings.beta*_velocity.length();
+    _position += (measured - _position)*lowPassAlpha(cutoff, dt);
+}
+
+void ofxHandFilter::addKalmanSample(const ofPoint &measured, float dt, const ofxHandFilterSettings &settings)
+{
+    // predict: x = F x, P = F P F' + Q with F = [1 dt; 0 1]
+    _position += _velocity*dt;
+
+    float q = settings.processNoise;
+    float dt2 = dt*dt;
+    _p00 += dt*(2.0f*_p01 + dt*_p11) + q*dt2*dt/3.0f;
+    _p01 += dt*_p11 + q*dt2*0.5f;
+    _p11 += q*dt;
+
+    // update with a position measurement, H = [1 0]
+    float s = _p00 + settings.measurementNoise*settings.measurementNoise;
+    float k0 = _p00/s;
+    float k1 = _p01/s;
+
+    ofVec3f innovation = measured - _position;
+    _position += innovation*k0;
+    _velocity += innovation*k1;
+
+    _p11 -= k1*_p01;
+    _p01 -= k0*_p01;
+    _p00 -= k0*_p00;
+}
@@ -0,0 +1,76 @@
+//
+//  ofxHandFilter.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/14/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+typedef enum {
+    HAND_FILTER_ONE_POLE = 0,       // fixed smoothCoef blend every frame, no velocity estimate
+    HAND_FILTER_ONE_EURO,           // speed-adaptive low pass: smooth when slow, little lag when fast
+    HAND_FILTER_KALMAN,             // constant-velocity Kalman
+    NUM_HAND_FILTER_TYPES
+} ofxHandFilterType;
+
+const char * ofxHandFilterName(ofxHandFilterType type);
+
+struct ofxHandFilterSettings {
+
+    // One-Euro (Casiez et al. 2012). Cutoff rises from minCutoff by beta per px/s of speed.
+    float   minCutoff;              // Hz
+    float   beta;
+    float   derivativeCutoff;       // Hz, for the speed estimate
+
+    // Kalman, per axis
+    float   processNoise;           // white acceleration spectral density, px^2/s^3
+    float   measurementNoise;       // std dev of a measurement, px
+
+    ofxHandFilterSettings();
+};
+
+/// Adaptive filter for one tracked joint, run once per new measurement.
+///
+/// Both filters keep a velocity estimate, so the filtered position can be
+/// extrapolated to when it will actually be seen (predict()). Measurements that
+/// aren't newer than the last one are ignored, so a 30Hz source can be fed at
+/// any frame rate. HAND_FILTER_ONE_POLE isn't handled here - it's frame based
+/// and lives in ofxHandPhysicsManager.
+class ofxHandFilter {
+
+public:
+
+    ofxHandFilter();
+
+    void reset();
+    bool isInitialized() const      { return _initialized; };
+
+    // a measurement taken (or received) at sampleTime, seconds
+    void addSample(ofxHandFilterType type, const ofPoint & measured, float sampleTime, const ofxHandFilterSettings & settings);
+
+    ofPoint getPosition() const     { return _position; };
+    ofVec3f getVelocity() const     { return _velocity; };      // px/s
+    float   getSampleTime() const   { return _sampleTime; };
+
+    // straight-line extrapolation from the last sample
+    ofPoint predict(float time) const { return _position + _velocity*(time - _sampleTime); };
+
+private:
+
+    void addOneEuroSample(const ofPoint & measured, float dt, const ofxHandFilterSettings & settings);
+    void addKalmanSample(const ofPoint & measured, float dt, const ofxHandFilterSettings & settings);
+
+    ofxHandFilterType   _type;
+    bool                _initialized;
+    float               _sampleTime;
+    ofPoint             _position;
+    ofVec3f             _velocity;
+
+    // Kalman covariance of [position, velocity]. Every axis gets the same
+    // noise model and the same updates, so one matrix serves all three.
+    float               _p00, _p01, _p11;
+};
@@ -0,0 +1,102 @@
+//
+//  ofxHandTrackingSource.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/13/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+typedef enum {
+    TRACKING_JOINT_HAND = 0,        // hands generator: one hand per id
+    TRACKING_JOINT_LEFT_HAND,       // user tracking: a whole skeleton per id
+    TRACKING_JOINT_RIGHT_HAND,
+    TRACKING_JOINT_HEAD,
+    TRACKING_JOINT_NECK,
+    TRACKING_JOINT_TORSO,
+    TRACKING_JOINT_LEFT_SHOULDER,
+    TRACKING_JOINT_LEFT_ELBOW,
+    TRACKING_JOINT_RIGHT_SHOULDER,
+    TRACKING_JOINT_RIGHT_ELBOW,
+    TRACKING_JOINT_LEFT_HIP,
+    TRACKING_JOINT_LEFT_KNEE,
+    TRACKING_JOINT_LEFT_FOOT,
+    TRACKING_JOINT_RIGHT_HIP,
+    TRACKING_JOINT_RIGHT_KNEE,
+    TRACKING_JOINT_RIGHT_FOOT,
+    NUM_TRACKING_JOINTS
+} ofxHandTrackingJoint;
+
+inline const char * ofxHandTrackingJointName(ofxHandTrackingJoint joint)
+{
+    static const char *names[NUM_TRACKING_JOINTS] = {
+        "hand", "left hand", "right hand", "head", "neck", "torso",
+        "left shoulder", "left elbow", "right shoulder", "right elbow",
+        "left hip", "left knee", "left foot", "right hip", "right knee", "right foot"
+    };
+    return joint < NUM_TRACKING_JOINTS ? names[joint] : "unknown";
+}
+
+// A set of user joints, one bit per ofxHandTrackingJoint
+typedef unsigned int ofxHandTrackingJointSet;
+
+#define TRACKING_JOINT_BIT(joint)       (1u << (joint))
+
+#define TRACKING_JOINTS_HANDS           (TRACKING_JOINT_BIT(TRACKING_JOINT_LEFT_HAND) | TRACKING_JOINT_BIT(TRACKING_JOINT_RIGHT_HAND))
+#define TRACKING_JOINTS_ARMS            (TRACKING_JOINTS_HANDS | \
+                                         TRACKING_JOINT_BIT(TRACKING_JOINT_LEFT_ELBOW) | TRACKING_JOINT_BIT(TRACKING_JOINT_RIGHT_ELBOW))
+#define TRACKING_JOINTS_USER            (((1u << NUM_TRACKING_JOINTS) - 1) & ~TRACKING_JOINT_BIT(TRACKING_JOINT_HAND))
+
+#define NUM_USER_JOINTS                 (NUM_TRACKING_JOINTS - 1)
+
+struct ofxHandTrackingEvent {
+    
+    enum Type {
+        ENTERED = 0,
+        LEFT
+    };
+    
+    Type            type;
+    unsigned int    id;
+    
+    ofxHandTrackingEvent(Type t = ENTERED, unsigned int i = 0) : type(t), id(i) {};
+};
+
+/// Where tracked hands come from: a live device, a recording, or a generator.
+///
+/// Consumers call update() once per frame, drain getNextEvent() to learn which
+/// ids entered or left, then read joint positions for the ids they track.
+/// Positions are projective, i.e. pixels in a getWidth() x getHeight() image
+/// with depth in z, like ofxOpenNI's.
+class ofxHandTrackingSource {
+    
+public:
+    
+    virtual ~ofxHandTrackingSource() {};
+    
+    // time in seconds on the consumer's clock; live sources ignore it
+    virtual void update(float /*time*/) {};
+    
+    // true: each id is a user with every joint but TRACKING_JOINT_HAND,
+    // false: each id is one TRACKING_JOINT_HAND
+    virtual bool tracksUsers() const = 0;
+    
+    // events in the order they happened, false when there are none left
+    virtual bool getNextEvent(ofxHandTrackingEvent & event) = 0;
+    
+    virtual unsigned int getNumTracked() = 0;
+    virtual unsigned int getTrackedID(unsigned int index) = 0;
+    
+    // false if the id isn't tracked (position untouched)
+    virtual bool getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint & position) = 0;
+    
+    // consumer-clock time the current positions arrived, or < 0 if the source
+    // can't tell (callers then treat every frame as a new measurement)
+    virtual float getSampleTime() { return -1.0f; };
+    
+    virtual float getWidth() { return 640.0f; };
+    virtual float getHeight() { return 480.0f; };
+};
@@ -0,0 +1,154 @@
+//
+//  ofxOpenNITrackingSource.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/13/12.
+//
+//
+
+#include "ofxOpenNITrackingSource.h"
+#include <algorithm>
+
+ofxOpenNITrackingSource::ofxOpenNITrackingSource(ofxOpenNI &openNIDevice, bool useUserGenerator) :
+    _openNIDevice(openNIDevice),
+    _usingUserGenerator(useUserGenerator),
+    _sampleTime(-1.0f),
+    _nextEvent(0)
+{
+    _deviceEvents.allocate(OPENNI_EVENT_QUEUE_SIZE, ofxHandTrackingEvent());
+    if (useUserGenerator){
+        ofAddListener(openNIDevice.userEvent, this, &ofxOpenNITrackingSource::userEvent);
+    }
+    else{
+        ofAddListener(openNIDevice.handEvent, this, &ofxOpenNITrackingSource::handEvent);
+    }
+}
+
+ofxOpenNITrackingSource::~ofxOpenNITrackingSource()
+{
+    if (_usingUserGenerator){
+        ofRemoveListener(_openNIDevice.userEvent, this, &ofxOpenNITrackingSource::userEvent);
+    }
+    else{
+        ofRemoveListener(_openNIDevice.handEvent, this, &ofxOpenNITrackingSource::handEvent);
+    }
+}
+
+void ofxOpenNITrackingSource::update(float time)
+{
+    // the device runs at 30Hz; only frames that brought new joints are new samples
+    if (_openNIDevice.isNewFrame()){
+        _sampleTime = time;
+    }
+    
+    // drop the events already read, keep any that weren't
+    _pendingEvents.erase(_pendingEvents.begin(), _pendingEvents.begin() + _nextEvent);
+    _nextEvent = 0;
+    
+    ofxHandTrackingEvent *event;
+    while ((event = _deviceEvents.front())){
+        applyEvent(*event);
+        _deviceEvents.pop();
+    }
+}
+
+static Joint openNIJoint(ofxHandTrackingJoint joint)
+{
+    switch (joint){
+        case TRACKING_JOINT_LEFT_HAND:      return JOINT_LEFT_HAND;
+        case TRACKING_JOINT_RIGHT_HAND:     return JOINT_RIGHT_HAND;
+        case TRACKING_JOINT_HEAD:           return JOINT_HEAD;
+        case TRACKING_JOINT_NECK:           return JOINT_NECK;
+        case TRACKING_JOINT_TORSO:          return JOINT_TORSO;
+        case TRACKING_JOINT_LEFT_SHOULDER:  return JOINT_LEFT_SHOULDER;
+        case TRACKING_JOINT_LEFT_ELBOW:     return JOINT_LEFT_ELBOW;
+        case TRACKING_JOINT_RIGHT_SHOULDER: return JOINT_RIGHT_SHOULDER;
+        case TRACKING_JOINT_RIGHT_ELBOW:    return JOINT_RIGHT_ELBOW;
+        case TRACKING_JOINT_LEFT_HIP:       return JOINT_LEFT_HIP;
+        case TRACKING_JOINT_LEFT_KNEE:      return JOINT_LEFT_KNEE;
+        case TRACKING_JOINT_LEFT_FOOT:      return JOINT_LEFT_FOOT;
+        case TRACKING_JOINT_RIGHT_HIP:      return JOINT_RIGHT_HIP;
+        case TRACKING_JOINT_RIGHT_KNEE:     return JOINT_RIGHT_KNEE;
+        case TRACKING_JOINT_RIGHT_FOOT:     return JOINT_RIGHT_FOOT;
+        default:                            return JOINT_LEFT_HAND;
+    }
+}
+
+bool ofxOpenNITrackingSource::getNextEvent(ofxHandTrackingEvent &event)
+{
+    if (_nextEvent >= _pendingEvents.size()) return false;
+    event = _pendingEvents[_nextEvent++];
+    return true;
+}
+
+bool ofxOpenNITrackingSource::getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint &position)
+{
+    if (_usingUserGenerator){
+        // the device indexes tracked users in the order they were found
+        for (unsigned int th = 0; th < _trackedIDs.size(); th++){
+            if (_trackedIDs[th] == id){
+                if (joint == TRACKING_JOINT_HAND) return false;
+                
+                // a joint the skeleton lost (or its profile doesn't have) keeps its last position
+                ofxOpenNIJoint & userJoint = _openNIDevice.getTrackedUser(th).getJoint(openNIJoint(joint));
+                if (userJoint.getPositionConfidence() <= 0.0f) return false;
+                position = userJoint.getProjectivePosition();
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    for (unsigned int th = 0; th < _trackedIDs.size(); th++){
+        if (_trackedIDs[th] == id){
+            position = _openNIDevice.getHand(id).getPosition();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ofxOpenNITrackingSource::userEvent(ofxOpenNIUserEvent &event)
+{
+    if (event.userStatus == USER_SKELETON_FOUND){
+        queueEvent(ofxHandTrackingEvent::ENTERED, event.id);
+    }
+    else if (event.userStatus == USER_SKELETON_LOST || event.userStatus == USER_TRACKING_STOPPED){
+        queueEvent(ofxHandTrackingEvent::LEFT, event.id);
+    }
+}
+
+void ofxOpenNITrackingSource::handEvent(ofxOpenNIHandEvent &event)
+{
+    if (event.handStatus == HAND_TRACKING_STARTED){
+        queueEvent(ofxHandTrackingEvent::ENTERED, event.id);
+    }
+    else if (event.handStatus == HAND_TRACKING_STOPPED){
+        queueEvent(ofxHandTrackingEvent::LEFT, event.id);
+    }
+}
+
+void ofxOpenNITrackingSource::queueEvent(ofxHandTrackingEvent::Type type, XnUserID id)
+{
+    ofxHandTrackingEvent *slot = _deviceEvents.beginPush();
+    if (!slot){
+        ofLog(OF_LOG_WARNING, "ofxOpenNITrackingSource: event queue full, dropping an event for id " + ofToString(id));
+        return;
+    }
+    *slot = ofxHandTrackingEvent(type, id);
+    _deviceEvents.endPush();
+}
+
+void ofxOpenNITrackingSource::applyEvent(const ofxHandTrackingEvent &event)
+{
+    vector<XnUserID>::iterator it = std::find(_trackedIDs.begin(), _trackedIDs.end(), (XnUserID)event.id);
+    if (event.type == ofxHandTrackingEvent::ENTERED){
+        if (it != _trackedIDs.end()) return;
+        _trackedIDs.push_back(event.id);
+    }
+    else{
+        if (it == _trackedIDs.end()) return;
+        _trackedIDs.erase(it);
+    }
+    _pendingEvents.push_back(event);
+}
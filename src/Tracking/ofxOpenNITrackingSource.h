@@ -0,0 +1,59 @@
+//
+//  ofxOpenNITrackingSource.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/13/12.
+//
+//
+
+#pragma once
+
+#include "ofxHandTrackingSource.h"
+#include "ofxOpenNI.h"
+#include "ofxNDSpscQueue.h"
+
+#define OPENNI_EVENT_QUEUE_SIZE 128
+
+/// Hands from a live ofxOpenNI device, either from its user generator
+/// (every skeleton joint) or its hands generator.
+/// The device itself is set up, started and updated by its owner. Its user and
+/// hand callbacks may come from another thread than the consumer's: they only
+/// queue the event, and update() applies it on the consumer's thread.
+class ofxOpenNITrackingSource : public ofxHandTrackingSource {
+    
+public:
+    
+    ofxOpenNITrackingSource(ofxOpenNI &openNIDevice, bool useUserGenerator = false);
+    ~ofxOpenNITrackingSource();
+    
+    void update(float time);
+    
+    bool tracksUsers() const { return _usingUserGenerator; };
+    bool getNextEvent(ofxHandTrackingEvent & event);
+    
+    unsigned int getNumTracked() { return _trackedIDs.size(); };
+    unsigned int getTrackedID(unsigned int index) { return _trackedIDs[index]; };
+    bool getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint & position);
+    
+    float getSampleTime() { return _sampleTime; };
+    float getWidth() { return _openNIDevice.getWidth(); };
+    float getHeight() { return _openNIDevice.getHeight(); };
+    
+private:
+    
+    void userEvent(ofxOpenNIUserEvent & event);
+    void handEvent(ofxOpenNIHandEvent & event);
+    void queueEvent(ofxHandTrackingEvent::Type type, XnUserID id);
+    void applyEvent(const ofxHandTrackingEvent & event);
+    
+    ofxOpenNI &     _openNIDevice;
+    bool            _usingUserGenerator;
+    float           _sampleTime;        // when the device last had a new frame
+    
+    ofxNDSpscQueue<ofxHandTrackingEvent>    _deviceEvents;      // device callback -> update()
+    
+    // consumer thread
+    vector<XnUserID>                _trackedIDs;        // same order as the device's tracked users
+    vector<ofxHandTrackingEvent>    _pendingEvents;     // applied by update(), read from _nextEvent
+    unsigned int                    _nextEvent;
+};
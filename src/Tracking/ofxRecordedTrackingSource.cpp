@@ -0,0 +1,358 @@
+//
+//  ofxRecordedTrackingSource.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/13/12.
+//
+//
+
+#include "ofxRecordedTrackingSource.h"
+
+#define TRACKING_FILE_VERSION   1
+#define TRACKING_HEADER_SIZE    16
+
+enum {
+    RECORD_FRAME = 0,
+    RECORD_ENTERED,
+    RECORD_LEFT
+};
+
+// every platform we build for is little endian, so values are copied as-is
+template <typename T>
+static inline void put(vector<unsigned char> & buffer, T value)
+{
+    const unsigned char *bytes = (const unsigned char *)&value;
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static inline T get(const vector<unsigned char> & buffer, unsigned int & cursor)
+{
+    T value;
+    memcpy(&value, &buffer[cursor], sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+static inline short toFixed(float v)
+{
+    return (short)ofClamp(roundf(v*16.0f), -32768.0f, 32767.0f);
+}
+
+// ---------------------------------------------------------------------
+//  Recorder
+// ---------------------------------------------------------------------
+
+ofxTrackingRecorder::ofxTrackingRecorder(ofxHandTrackingSource &source) :
+    _source(source),
+    _startTime(0.0f),
+    _lastTime(0.0f),
+    _lastSampleTime(-1.0f),
+    _started(false)
+{
+}
+
+ofxTrackingRecorder::~ofxTrackingRecorder()
+{
+    stop();
+}
+
+bool ofxTrackingRecorder::start(const string &path)
+{
+    stop();
+    _file.open(ofToDataPath(path).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_file.is_open()){
+        ofLog(OF_LOG_ERROR, "ofxTrackingRecorder: could not open " + path + " for writing");
+        return false;
+    }
+    
+    _record.clear();
+    _record.push_back('N'); _record.push_back('D'); _record.push_back('H'); _record.push_back('T');
+    put<unsigned short>(_record, TRACKING_FILE_VERSION);
+    put<unsigned char>(_record, _source.tracksUsers() ? 1 : 0);
+    put<unsigned char>(_record, 0);
+    put<float>(_record, _source.getWidth());
+    put<float>(_record, _source.getHeight());
+    _file.write((const char *)&_record[0], _record.size());
+    
+    _started = false;
+    _lastSampleTime = -1.0f;
+    _lastIDs.clear();
+    return true;
+}
+
+void ofxTrackingRecorder::stop()
+{
+    if (_file.is_open()){
+        _file.close();
+    }
+}
+
+void ofxTrackingRecorder::update(float time)
+{
+    _source.update(time);
+    if (!_file.is_open()) return;
+    
+    if (!_started){
+        _startTime = time;
+        _started = true;
+    }
+    _lastTime = time - _startTime;
+    
+    // a frame record per new sample, or when someone entered or left so their
+    // joints are known before their event plays back
+    float sampleTime = _source.getSampleTime();
+    bool newSample = sampleTime < 0.0f || sampleTime != _lastSampleTime;
+    _lastSampleTime = sampleTime;
+    
+    bool sameIDs = _lastIDs.size() == _source.getNumTracked();
+    for (unsigned int i=0; sameIDs && i<_lastIDs.size(); i++){
+        sameIDs = _lastIDs[i] == _source.getTrackedID(i);
+    }
+    if (!newSample && sameIDs) return;
+    
+    _lastIDs.resize(_source.getNumTracked());
+    for (unsigned int i=0; i<_lastIDs.size(); i++){
+        _lastIDs[i] = _source.getTrackedID(i);
+    }
+    
+    // one frame record with every joint of everyone currently tracked
+    _record.clear();
+    put<unsigned char>(_record, RECORD_FRAME);
+    put<float>(_record, _lastTime);
+    put<unsigned char>(_record, 0);
+    
+    unsigned int count = 0;
+    int firstJoint = _source.tracksUsers() ? TRACKING_JOINT_LEFT_HAND : TRACKING_JOINT_HAND;
+    int lastJoint = _source.tracksUsers() ? NUM_TRACKING_JOINTS - 1 : TRACKING_JOINT_HAND;
+    for (unsigned int i=0; i<_source.getNumTracked() && count < 255; i++){
+        unsigned int id = _source.getTrackedID(i);
+        for (int j = firstJoint; j <= lastJoint && count < 255; j++){
+            ofPoint p;
+            if (!_source.getJointPosition(id, (ofxHandTrackingJoint)j, p)) continue;
+            put<unsigned short>(_record, id);
+            put<unsigned char>(_record, j);
+            put<short>(_record, toFixed(p.x));
+            put<short>(_record, toFixed(p.y));
+            put<unsigned short>(_record, (unsigned short)ofClamp(roundf(p.z), 0.0f, 65535.0f));
+            count++;
+        }
+    }
+    _record[5] = count;
+    _file.write((const char *)&_record[0], _record.size());
+}
+
+bool ofxTrackingRecorder::getNextEvent(ofxHandTrackingEvent &event)
+{
+    if (!_source.getNextEvent(event)) return false;
+    
+    if (_file.is_open()){
+        _record.clear();
+        put<unsigned char>(_record, event.type == ofxHandTrackingEvent::ENTERED ? RECORD_ENTERED : RECORD_LEFT);
+        put<float>(_record, _lastTime);
+        put<unsigned short>(_record, event.id);
+        _file.write((const char *)&_record[0], _record.size());
+    }
+    return true;
+}
+
+bool ofxTrackingRecorder::getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint &position)
+{
+    return _source.getJointPosition(id, joint, position);
+}
+
+// ---------------------------------------------------------------------
+//  Playback
+// ---------------------------------------------------------------------
+
+ofxRecordedTrackingSource::ofxRecordedTrackingSource() :
+    _cursor(0),
+    _tracksUsers(false),
+    _width(640.0f),
+    _height(480.0f),
+    _duration(0.0f),
+    _loop(false),
+    _started(false),
+    _startTime(0.0f),
+    _sampleTime(-1.0f),
+    _nextEvent(0)
+{
+}
+
+bool ofxRecordedTrackingSource::load(const string &path)
+{
+    _data.clear();
+    _tracked.clear();
+    _pendingEvents.clear();
+    _nextEvent = 0;
+    _cursor = 0;
+    _duration = 0.0f;
+    _started = false;
+    _sampleTime = -1.0f;
+    
+    std::ifstream file(ofToDataPath(path).c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()){
+        ofLog(OF_LOG_ERROR, "ofxRecordedTrackingSource: could not open " + path);
+        return false;
+    }
+    
+    vector<unsigned char> header(TRACKING_HEADER_SIZE);
+    file.read((char *)&header[0], TRACKING_HEADER_SIZE);
+    unsigned int cursor = 4;
+    if (file.gcount() != TRACKING_HEADER_SIZE || memcmp(&header[0], "NDHT", 4) != 0
+        || get<unsigned short>(header, cursor) != TRACKING_FILE_VERSION){
+        ofLog(OF_LOG_ERROR, "ofxRecordedTrackingSource: " + path + " is not a version " + ofToString(TRACKING_FILE_VERSION) + " tracking recording");
+        return false;
+    }
+    _tracksUsers = get<unsigned char>(header, cursor) != 0;
+    get<unsigned char>(header, cursor);
+    _width = get<float>(header, cursor);
+    _height = get<float>(header, cursor);
+    
+    file.seekg(0, std::ios::end);
+    unsigned int size = (unsigned int)file.tellg() - TRACKING_HEADER_SIZE;
+    file.seekg(TRACKING_HEADER_SIZE, std::ios::beg);
+    _data.resize(size);
+    if (size > 0){
+        file.read((char *)&_data[0], size);
+    }
+    
+    // validate record framing once so playback never reads past the end; a
+    // truncated last record (recording interrupted) is dropped
+    cursor = 0;
+    unsigned int validEnd = 0;
+    while (cursor + 5 <= _data.size()){
+        unsigned char type = get<unsigned char>(_data, cursor);
+        float time = get<float>(_data, cursor);
+        unsigned int length = type == RECORD_FRAME ? (cursor < _data.size() ? 1 + 9*_data[cursor] : 1) : 2;
+        if (type > RECORD_LEFT || cursor + length > _data.size()) break;
+        cursor += length;
+        validEnd = cursor;
+        _duration = MAX(_duration, time);
+    }
+    _data.resize(validEnd);
+    
+    return true;
+}
+
+void ofxRecordedTrackingSource::restart()
+{
+    for (unsigned int t=0; t<_tracked.size(); t++){
+        if (_tracked[t].present){
+            _pendingEvents.push_back(ofxHandTrackingEvent(ofxHandTrackingEvent::LEFT, _tracked[t].id));
+        }
+    }
+    _tracked.clear();
+    _cursor = 0;
+}
+
+void ofxRecordedTrackingSource::update(float time)
+{
+    if (!_started){
+        _startTime = time;
+        _started = true;
+    }
+    float playTime = time - _startTime;
+    
+    while (true){
+        
+        if (_cursor >= _data.size()){
+            if (!_loop || _data.empty() || playTime <= _duration) break;
+            restart();
+            _startTime += _duration;
+            playTime -= _duration;
+        }
+        
+        unsigned int cursor = _cursor;
+        unsigned char type = get<unsigned char>(_data, cursor);
+        float recordTime = get<float>(_data, cursor);
+        if (recordTime > playTime) break;
+        
+        if (type == RECORD_FRAME){
+            _sampleTime = _startTime + recordTime;
+            unsigned int count = get<unsigned char>(_data, cursor);
+            for (unsigned int i=0; i<count; i++){
+                unsigned int id = get<unsigned short>(_data, cursor);
+                unsigned int joint = get<unsigned char>(_data, cursor);
+                float x = get<short>(_data, cursor)/16.0f;
+                float y = get<short>(_data, cursor)/16.0f;
+                float z = get<unsigned short>(_data, cursor);
+                if (joint < NUM_TRACKING_JOINTS){
+                    Tracked & tracked = trackedForID(id);
+                    tracked.joints[joint] = ofPoint(x, y, z);
+                    tracked.recorded |= TRACKING_JOINT_BIT(joint);
+                }
+            }
+        }
+        else{
+            unsigned int id = get<unsigned short>(_data, cursor);
+            bool entered = type == RECORD_ENTERED;
+            if (entered){
+                trackedForID(id).present = true;
+            }
+            else{
+                for (unsigned int t=0; t<_tracked.size(); t++){
+                    if (_tracked[t].id == id){
+                        _tracked.erase(_tracked.begin() + t);
+                        break;
+                    }
+                }
+            }
+            _pendingEvents.push_back(ofxHandTrackingEvent(entered ? ofxHandTrackingEvent::ENTERED : ofxHandTrackingEvent::LEFT, id));
+        }
+        _cursor = cursor;
+    }
+}
+
+ofxRecordedTrackingSource::Tracked & ofxRecordedTrackingSource::trackedForID(unsigned int id)
+{
+    for (unsigned int t=0; t<_tracked.size(); t++){
+        if (_tracked[t].id == id) return _tracked[t];
+    }
+    Tracked tracked;
+    tracked.id = id;
+    tracked.present = false;
+    tracked.recorded = 0;
+    _tracked.push_back(tracked);
+    return _tracked.back();
+}
+
+bool ofxRecordedTrackingSource::getNextEvent(ofxHandTrackingEvent &event)
+{
+    if (_nextEvent >= _pendingEvents.size()){
+        _pendingEvents.clear();
+        _nextEvent = 0;
+        return false;
+    }
+    event = _pendingEvents[_nextEvent++];
+    return true;
+}
+
+unsigned int ofxRecordedTrackingSource::getNumTracked()
+{
+    unsigned int n = 0;
+    for (unsigned int t=0; t<_tracked.size(); t++){
+        if (_tracked[t].present) n++;
+    }
+    return n;
+}
+
+unsigned int ofxRecordedTrackingSource::getTrackedID(unsigned int index)
+{
+    for (unsigned int t=0; t<_tracked.size(); t++){
+        if (_tracked[t].present && index-- == 0) return _tracked[t].id;
+    }
+    return 0;
+}
+
+bool ofxRecordedTrackingSource::getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint &position)
+{
+    for (unsigned int t=0; t<_tracked.size(); t++){
+        if (_tracked[t].id == id && _tracked[t].present){
+            if (!(_tracked[t].recorded & TRACKING_JOINT_BIT(joint))) return false;
+            position = _tracked[t].joints[joint];
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,109 @@
+//
+//  ofxRecordedTrackingSource.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/13/12.
+//
+//
+
+#pragma once
+
+#include "ofxHandTrackingSource.h"
+#include <fstream>
+
+// Recording file layout (little endian):
+//   header  "NDHT", uint16 version, uint8 tracksUsers, uint8 unused, float width, float height
+//   records uint8 type, float time (seconds since recording started), then
+//     FRAME   uint8 count, count x { uint16 id, uint8 joint, int16 x*16, int16 y*16, uint16 z (mm) }
+//     ENTERED uint16 id
+//     LEFT    uint16 id
+// Positions are stored at 1/16 pixel, 9 bytes per joint per frame. User recordings have
+// every joint the source reported (up to 255 per frame), hand recordings one per id.
+
+/// Records everything another source reports while passing it through unchanged.
+/// Put it between the live source and its consumer.
+class ofxTrackingRecorder : public ofxHandTrackingSource {
+    
+public:
+    
+    ofxTrackingRecorder(ofxHandTrackingSource & source);
+    ~ofxTrackingRecorder();
+    
+    bool start(const string & path);
+    void stop();
+    bool isRecording() const { return _file.is_open(); };
+    
+    void update(float time);
+    bool tracksUsers() const { return _source.tracksUsers(); };
+    bool getNextEvent(ofxHandTrackingEvent & event);
+    unsigned int getNumTracked() { return _source.getNumTracked(); };
+    unsigned int getTrackedID(unsigned int index) { return _source.getTrackedID(index); };
+    bool getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint & position);
+    float getSampleTime() { return _source.getSampleTime(); };
+    float getWidth() { return _source.getWidth(); };
+    float getHeight() { return _source.getHeight(); };
+    
+private:
+    
+    ofxHandTrackingSource & _source;
+    std::ofstream           _file;
+    float                   _startTime;
+    float                   _lastTime;
+    float                   _lastSampleTime;
+    vector<unsigned int>    _lastIDs;           // tracked when the last frame record was written
+    bool                    _started;
+    vector<unsigned char>   _record;
+};
+
+/// Plays back a recording made by ofxTrackingRecorder against the consumer's clock.
+/// Playback time starts at the first update() after load().
+class ofxRecordedTrackingSource : public ofxHandTrackingSource {
+    
+public:
+    
+    ofxRecordedTrackingSource();
+    
+    bool load(const string & path);
+    
+    // when looping, everyone leaves at the end and the recording restarts
+    void setLoop(bool loop) { _loop = loop; };
+    bool isFinished() const { return _cursor >= _data.size() && !_loop; };
+    float getDuration() const { return _duration; };
+    
+    void update(float time);
+    bool tracksUsers() const { return _tracksUsers; };
+    bool getNextEvent(ofxHandTrackingEvent & event);
+    unsigned int getNumTracked();
+    unsigned int getTrackedID(unsigned int index);
+    bool getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint & position);
+    float getSampleTime() { return _sampleTime; };
+    float getWidth() { return _width; };
+    float getHeight() { return _height; };
+    
+private:
+    
+    struct Tracked {
+        unsigned int    id;
+        bool            present;
+        ofPoint         joints[NUM_TRACKING_JOINTS];
+        ofxHandTrackingJointSet recorded;       // joints seen so far; older recordings only have hands
+    };
+    
+    Tracked & trackedForID(unsigned int id);
+    void restart();
+    
+    vector<unsigned char>           _data;      // records only, header stripped
+    unsigned int                    _cursor;
+    bool                            _tracksUsers;
+    float                           _width;
+    float                           _height;
+    float                           _duration;
+    bool                            _loop;
+    bool                            _started;
+    float                           _startTime;
+    float                           _sampleTime;        // of the last frame record played
+    
+    vector<Tracked>                 _tracked;
+    vector<ofxHandTrackingEvent>    _pendingEvents;
+    unsigned int                    _nextEvent;
+};
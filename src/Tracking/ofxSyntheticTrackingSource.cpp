@@ -0,0 +1,141 @@
+//
+//  ofxSyntheticTrackingSource.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/13/12.
+//
+//
+
+#include "ofxSyntheticTrackingSource.h"
+
+ofxSyntheticTrackingSource::ofxSyntheticTrackingSource(unsigned int numUsers, unsigned int seed, float churnSeconds) :
+    _churnSeconds(churnSeconds),
+    _sampleRate(0.0f),
+    _latency(0.0f),
+    _sampleTime(-1.0f),
+    _nextID(1),
+    _nextEvent(0)
+{
+    // a private generator, so ofRandom users elsewhere don't change the motion
+    unsigned int state = seed*2654435761u + 1;
+    
+    _users.resize(numUsers);
+    for (unsigned int u=0; u<numUsers; u++){
+        User & user = _users[u];
+        float r[5];
+        for (int i=0; i<5; i++){
+            state = state*1664525u + 1013904223u;
+            r[i] = (state >> 8)/16777216.0f;
+        }
+        user.id = 0;
+        user.phase = r[0]*TWO_PI;
+        user.speed = 0.6f + r[1]*1.2f;
+        user.center = ofPoint(640.0f*(u + 0.5f)/numUsers, 220.0f + r[2]*60.0f, 1500.0f + r[3]*1000.0f);
+        user.reach = 80.0f + r[4]*80.0f;
+        user.flickInterval = 1.5f + r[0]*2.0f;
+    }
+}
+
+void ofxSyntheticTrackingSource::setSampling(float sampleRate, float latency)
+{
+    _sampleRate = MAX(sampleRate, 0.0f);
+    _latency = MAX(latency, 0.0f);
+}
+
+void ofxSyntheticTrackingSource::update(float time)
+{
+    float captureTime = time - _latency;
+    if (_sampleRate > 0.0f){
+        captureTime = floorf(captureTime*_sampleRate)/_sampleRate;
+    }
+    _sampleTime = captureTime + _latency;
+    
+    for (unsigned int u=0; u<_users.size(); u++){
+        User & user = _users[u];
+        
+        // staggered presence: each user is away for the last fifth of every churn period
+        bool present = true;
+        if (_churnSeconds > 0.0f){
+            float cycle = fmodf(time + _churnSeconds*u/_users.size(), _churnSeconds);
+            present = cycle < _churnSeconds*0.8f;
+        }
+        
+        if (present && user.id == 0){
+            user.id = _nextID++;
+            _pendingEvents.push_back(ofxHandTrackingEvent(ofxHandTrackingEvent::ENTERED, user.id));
+        }
+        else if (!present && user.id != 0){
+            _pendingEvents.push_back(ofxHandTrackingEvent(ofxHandTrackingEvent::LEFT, user.id));
+            user.id = 0;
+        }
+        
+        float t = captureTime*user.speed + user.phase;
+        float flick = fmodf(MAX(captureTime, 0.0f) + user.phase, user.flickInterval);
+        float flickOffset = flick < 0.15f ? sinf(flick*PI/0.15f)*user.reach : 0.0f;
+        
+        ofPoint *joints = user.joints;
+        joints[TRACKING_JOINT_LEFT_HAND] = user.center + ofPoint(-user.reach*0.6f + cosf(t)*user.reach*0.5f,
+                                                                 sinf(t*2.0f)*user.reach*0.7f, -200.0f*sinf(t*0.5f));
+        joints[TRACKING_JOINT_RIGHT_HAND] = user.center + ofPoint(user.reach*0.6f + sinf(t*1.3f)*user.reach + flickOffset,
+                                                                  -cosf(t*0.9f)*user.reach, -200.0f*cosf(t*0.7f));
+        
+        // the body sways under the hands, elbows bend out between shoulder and hand,
+        // legs step in turn
+        float sway = sinf(t*0.8f)*15.0f;
+        float step = sinf(t*1.6f);
+        joints[TRACKING_JOINT_TORSO] = user.center + ofPoint(sway, 20.0f, 0.0f);
+        joints[TRACKING_JOINT_NECK] = joints[TRACKING_JOINT_TORSO] + ofPoint(sway*0.5f, -70.0f, 0.0f);
+        joints[TRACKING_JOINT_HEAD] = joints[TRACKING_JOINT_NECK] + ofPoint(sway*0.3f, -40.0f, 0.0f);
+        joints[TRACKING_JOINT_LEFT_SHOULDER] = joints[TRACKING_JOINT_NECK] + ofPoint(-45.0f, 10.0f, 0.0f);
+        joints[TRACKING_JOINT_RIGHT_SHOULDER] = joints[TRACKING_JOINT_NECK] + ofPoint(45.0f, 10.0f, 0.0f);
+        joints[TRACKING_JOINT_LEFT_ELBOW] = joints[TRACKING_JOINT_LEFT_SHOULDER].getInterpolated(joints[TRACKING_JOINT_LEFT_HAND], 0.5f) + ofPoint(-20.0f, 25.0f, 0.0f);
+        joints[TRACKING_JOINT_RIGHT_ELBOW] = joints[TRACKING_JOINT_RIGHT_SHOULDER].getInterpolated(joints[TRACKING_JOINT_RIGHT_HAND], 0.5f) + ofPoint(20.0f, 25.0f, 0.0f);
+        joints[TRACKING_JOINT_LEFT_HIP] = joints[TRACKING_JOINT_TORSO] + ofPoint(-30.0f, 60.0f, 0.0f);
+        joints[TRACKING_JOINT_RIGHT_HIP] = joints[TRACKING_JOINT_TORSO] + ofPoint(30.0f, 60.0f, 0.0f);
+        joints[TRACKING_JOINT_LEFT_KNEE] = joints[TRACKING_JOINT_LEFT_HIP] + ofPoint(-5.0f + step*12.0f, 70.0f - MAX(step, 0.0f)*15.0f, 0.0f);
+        joints[TRACKING_JOINT_RIGHT_KNEE] = joints[TRACKING_JOINT_RIGHT_HIP] + ofPoint(5.0f - step*12.0f, 70.0f - MAX(-step, 0.0f)*15.0f, 0.0f);
+        joints[TRACKING_JOINT_LEFT_FOOT] = joints[TRACKING_JOINT_LEFT_KNEE] + ofPoint(-step*6.0f, 70.0f, 0.0f);
+        joints[TRACKING_JOINT_RIGHT_FOOT] = joints[TRACKING_JOINT_RIGHT_KNEE] + ofPoint(step*6.0f, 70.0f, 0.0f);
+    }
+}
+
+bool ofxSyntheticTrackingSource::getNextEvent(ofxHandTrackingEvent &event)
+{
+    if (_nextEvent >= _pendingEvents.size()){
+        _pendingEvents.clear();
+        _nextEvent = 0;
+        return false;
+    }
+    event = _pendingEvents[_nextEvent++];
+    return true;
+}
+
+unsigned int ofxSyntheticTrackingSource::getNumTracked()
+{
+    unsigned int n = 0;
+    for (unsigned int u=0; u<_users.size(); u++){
+        if (_users[u].id != 0) n++;
+    }
+    return n;
+}
+
+unsigned int ofxSyntheticTrackingSource::getTrackedID(unsigned int index)
+{
+    for (unsigned int u=0; u<_users.size(); u++){
+        if (_users[u].id != 0 && index-- == 0) return _users[u].id;
+    }
+    return 0;
+}
+
+bool ofxSyntheticTrackingSource::getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint &position)
+{
+    if (id == 0 || joint == TRACKING_JOINT_HAND || joint >= NUM_TRACKING_JOINTS) return false;
+    
+    for (unsigned int u=0; u<_users.size(); u++){
+        if (_users[u].id == id){
+            position = _users[u].joints[joint];
+            return true;
+        }
+    }
+    return false;
+}
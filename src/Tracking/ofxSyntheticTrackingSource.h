@@ -0,0 +1,59 @@
+//
+//  ofxSyntheticTrackingSource.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/13/12.
+//
+//
+
+#pragma once
+
+#include "ofxHandTrackingSource.h"
+
+/// Procedurally animated users for running the hand pipeline without a camera.
+///
+/// Each user gets its own seeded mix of sweeping, circling and flicking motion
+/// for both hands, with the rest of a skeleton swaying and stepping along. With churnSeconds > 0 users also leave and come back
+/// (with new ids) on a staggered schedule, to exercise enter/leave handling.
+/// Entirely determined by the seed and the times passed to update().
+class ofxSyntheticTrackingSource : public ofxHandTrackingSource {
+    
+public:
+    
+    ofxSyntheticTrackingSource(unsigned int numUsers = 2, unsigned int seed = 1, float churnSeconds = 0.0f);
+    
+    // like a camera: positions captured sampleRate times a second (0 = every update)
+    // and seen latency seconds after capture. Defaults to 0, 0.
+    void setSampling(float sampleRate, float latency);
+    
+    void update(float time);
+    
+    bool tracksUsers() const { return true; };
+    bool getNextEvent(ofxHandTrackingEvent & event);
+    
+    unsigned int getNumTracked();
+    unsigned int getTrackedID(unsigned int index);
+    bool getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint & position);
+    float getSampleTime() { return _sampleTime; };
+    
+private:
+    
+    struct User {
+        unsigned int    id;             // 0 while away
+        float           phase;
+        float           speed;
+        ofPoint         center;
+        float           reach;
+        float           flickInterval;
+        ofPoint         joints[NUM_TRACKING_JOINTS];
+    };
+    
+    vector<User>                    _users;
+    float                           _churnSeconds;
+    float                           _sampleRate;
+    float                           _latency;
+    float                           _sampleTime;
+    unsigned int                    _nextID;
+    vector<ofxHandTrackingEvent>    _pendingEvents;
+    unsigned int                    _nextEvent;
+};
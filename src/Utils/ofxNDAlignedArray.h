@@ -0,0 +1,62 @@
+//
+//  ofxNDAlignedArray.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/11/12.
+//
+//
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+/// Fixed-size heap array aligned for SIMD loads/stores (16 bytes by default).
+///
+/// Allocation only happens in allocate(); the contents are zeroed there.
+/// Not copyable - hold it by value in the owning object and size it in setup().
+template <typename T, unsigned int Alignment = 16>
+class ofxNDAlignedArray {
+
+public:
+
+    ofxNDAlignedArray() : _data(NULL), _size(0) {};
+    ~ofxNDAlignedArray() { release(); };
+
+    void allocate(unsigned int size)
+    {
+        release();
+        if (size == 0) return;
+
+        void *memory = NULL;
+        if (posix_memalign(&memory, Alignment, size*sizeof(T)) != 0) return;
+        memset(memory, 0, size*sizeof(T));
+        _data = (T*)memory;
+        _size = size;
+    }
+
+    void release()
+    {
+        free(_data);
+        _data = NULL;
+        _size = 0;
+    }
+
+    unsigned int size() const   { return _size; };
+    bool empty() const          { return _size == 0; };
+
+    T * data()                  { return _data; };
+    const T * data() const      { return _data; };
+
+    T & operator[](unsigned int i)              { return _data[i]; };
+    const T & operator[](unsigned int i) const  { return _data[i]; };
+
+private:
+
+    // not copyable
+    ofxNDAlignedArray(const ofxNDAlignedArray &);
+    ofxNDAlignedArray & operator=(const ofxNDAlignedArray &);
+
+    T               *_data;
+    unsigned int    _size;
+};
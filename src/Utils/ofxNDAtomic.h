@@ -0,0 +1,62 @@
+//
+//  ofxNDAtomic.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/3/12.
+//
+//
+
+#pragma once
+
+// Minimal atomic helpers built on the GCC/clang __sync builtins, so they work
+// with the 10.6 SDK (no C++11 <atomic>) and on Linux alike.
+// Only use these on naturally aligned 32-bit values.
+
+inline void ofxNDMemoryBarrier()
+{
+    __sync_synchronize();
+}
+
+template <typename T>
+inline T ofxNDAtomicLoad(const volatile T & value)
+{
+    T result = value;
+    __sync_synchronize();
+    return result;
+}
+
+template <typename T>
+inline void ofxNDAtomicStore(volatile T & value, T newValue)
+{
+    __sync_synchronize();
+    value = newValue;
+    __sync_synchronize();
+}
+
+template <typename T>
+inline T ofxNDAtomicIncrement(volatile T & value)
+{
+    return __sync_add_and_fetch(&value, 1);
+}
+
+template <typename T>
+inline T ofxNDAtomicAdd(volatile T & value, T amount)
+{
+    return __sync_add_and_fetch(&value, amount);
+}
+
+template <typename T>
+inline bool ofxNDAtomicCompareAndSwap(volatile T & value, T oldValue, T newValue)
+{
+    return __sync_bool_compare_and_swap(&value, oldValue, newValue);
+}
+
+template <typename T>
+inline T ofxNDAtomicExchange(volatile T & value, T newValue)
+{
+    T oldValue = value;
+    while (!__sync_bool_compare_and_swap(&value, oldValue, newValue)){
+        oldValue = value;
+    }
+    return oldValue;
+}
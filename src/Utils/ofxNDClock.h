@@ -0,0 +1,54 @@
+//
+//  ofxNDClock.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+/// The clock animation and audio timestamps run on: ofGetElapsedTimeMicros, or for
+/// offline runs a simulated clock that starts at 0 and only moves when it's set, so
+/// every run sees the same times. Time how long something takes with
+/// ofGetElapsedTimeMicros, not this.
+///
+/// Switch and set it from the main thread between frames; other threads read it.
+class ofxNDClock {
+
+public:
+
+    static void setSimulated(bool simulated)
+    {
+        state().micros = 0;
+        state().simulated = simulated;
+    };
+    static bool isSimulated()                       { return state().simulated; };
+
+    // simulated only
+    static void setMicros(unsigned long long micros){ state().micros = micros; };
+
+    static unsigned long long getMicros()
+    {
+        return state().simulated ? state().micros : ofGetElapsedTimeMicros();
+    };
+
+    // like ofGetElapsedTimef
+    static float getSeconds()                       { return getMicros()/1000000.0f; };
+
+private:
+
+    struct State {
+        volatile bool               simulated;
+        volatile unsigned long long micros;
+    };
+
+    // one instance across translation units, no .cpp needed
+    static State & state()
+    {
+        static State s = { false, 0 };
+        return s;
+    };
+};
@@ -0,0 +1,167 @@
+//
+//  ofxNDFrameRing.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/3/12.
+//
+//
+
+#pragma once
+
+#include <vector>
+#include "ofxNDAtomic.h"
+
+/// Wait-free single-producer/single-consumer ring of frames.
+///
+/// The producer never blocks: it always overwrites the oldest slot. Each slot
+/// carries a sequence number (odd while being written) so readers can detect
+/// a slot that was overwritten mid-copy and retry with the next attempt.
+/// Frames must be fully sized in allocate() - copying frames of equal size
+/// does not allocate, so beginWrite()/endWrite() are safe on a real-time thread.
+template <typename T>
+class ofxNDFrameRing {
+    
+public:
+    
+    ofxNDFrameRing() : _writeCount(0), _tornReads(0) {};
+    
+    void allocate(unsigned int capacity, const T & prototype)
+    {
+        // need at least one slot beyond the one being written
+        _slots.assign(capacity < 2 ? 2 : capacity, Slot());
+        for (unsigned int i=0; i<_slots.size(); i++){
+            _slots[i].frame = prototype;
+            _slots[i].sequence = 0;
+        }
+        _writeCount = 0;
+        _tornReads = 0;
+    }
+    
+    unsigned int capacity() const { return _slots.size(); }
+    
+    // ---- producer ----
+    
+    T & beginWrite()
+    {
+        Slot & slot = _slots[_writeCount % _slots.size()];
+        ofxNDAtomicStore(slot.sequence, slot.sequence + 1);
+        return slot.frame;
+    }
+    
+    void endWrite()
+    {
+        Slot & slot = _slots[_writeCount % _slots.size()];
+        ofxNDAtomicStore(slot.sequence, slot.sequence + 1);
+        ofxNDAtomicStore(_writeCount, _writeCount + 1);
+    }
+    
+    // ---- consumer ----
+    
+    /// Number of frames ever published (wraps at 2^32)
+    unsigned int getWriteCount() const { return ofxNDAtomicLoad(_writeCount); }
+    
+    /// Number of reads that caught a slot mid-write and had to be retried
+    unsigned int getTornReadCount() const { return ofxNDAtomicLoad(_tornReads); }
+    
+    /// Copy the frame published "age" frames ago (0 = latest complete frame).
+    /// Returns false if no such frame exists or it could not be read intact.
+    bool read(T & frame, unsigned int age = 0)
+    {
+        for (int attempt = 0; attempt < 4; attempt++){
+            unsigned int count = ofxNDAtomicLoad(_writeCount);
+            if (count <= age) return false;
+            if (readFrameNumber(frame, count - 1 - age)) return true;
+        }
+        return false;
+    }
+    
+    /// Copy one member of the frame published "age" frames ago, e.g.
+    /// read(bins, &Frame::bins) - cheaper than the whole frame when that's all
+    /// a reader needs. Same checks and return value as read(frame, age).
+    template <typename M>
+    bool read(M & value, M T::*member, unsigned int age = 0)
+    {
+        for (int attempt = 0; attempt < 4; attempt++){
+            unsigned int count = ofxNDAtomicLoad(_writeCount);
+            if (count <= age) return false;
+            if (readFrameNumber(value, member, count - 1 - age)) return true;
+        }
+        return false;
+    }
+    
+    /// Copy up to nFrames of the most recent frames, newest first.
+    /// Returns the number of frames actually copied.
+    unsigned int readRecent(std::vector<T> & frames, unsigned int nFrames)
+    {
+        if (frames.size() < nFrames) frames.resize(nFrames);
+        
+        unsigned int count = ofxNDAtomicLoad(_writeCount);
+        unsigned int nRead = 0;
+        while (nRead < nFrames && nRead < count && readFrameNumber(frames[nRead], count - 1 - nRead)){
+            nRead++;
+        }
+        return nRead;
+    }
+    
+private:
+    
+    struct Slot {
+        T                       frame;
+        volatile unsigned int   sequence;
+        Slot() : sequence(0) {};
+    };
+    
+    // A slot holds frame number n once it has been written n/capacity + 1 times,
+    // i.e. when its sequence equals 2*(n/capacity + 1). Anything else means the
+    // frame was overwritten (or is being written) and the copy can't be trusted.
+    bool readFrameNumber(T & frame, unsigned int frameNumber)
+    {
+        unsigned int expectedSeq;
+        const Slot * slot = beginRead(frameNumber, expectedSeq);
+        if (!slot) return false;
+        
+        frame = slot->frame;
+        return endRead(*slot, expectedSeq);
+    }
+    
+    template <typename M>
+    bool readFrameNumber(M & value, M T::*member, unsigned int frameNumber)
+    {
+        unsigned int expectedSeq;
+        const Slot * slot = beginRead(frameNumber, expectedSeq);
+        if (!slot) return false;
+        
+        value = slot->frame.*member;
+        return endRead(*slot, expectedSeq);
+    }
+    
+    const Slot * beginRead(unsigned int frameNumber, unsigned int & expectedSeq)
+    {
+        if (_slots.empty()) return NULL;
+        
+        const Slot & slot = _slots[frameNumber % _slots.size()];
+        expectedSeq = 2*(frameNumber/_slots.size() + 1);
+        
+        if (ofxNDAtomicLoad(slot.sequence) != expectedSeq){
+            ofxNDAtomicIncrement(_tornReads);
+            return NULL;
+        }
+        return &slot;
+    }
+    
+    bool endRead(const Slot & slot, unsigned int expectedSeq)
+    {
+        // the atomic load only fences after itself: keep the copy's loads ahead of it
+        ofxNDMemoryBarrier();
+        
+        if (ofxNDAtomicLoad(slot.sequence) != expectedSeq){
+            ofxNDAtomicIncrement(_tornReads);
+            return false;
+        }
+        return true;
+    }
+    
+    std::vector<Slot>       _slots;
+    volatile unsigned int   _writeCount;
+    volatile unsigned int   _tornReads;
+};
@@ -0,0 +1,57 @@
+//
+//  ofxNDHistoryRing.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/12/12.
+//
+//
+
+#pragma once
+
+/// Fixed-capacity history of the last Capacity values, newest at index 0.
+///
+/// Storage is an inline array sized at compile time, so pushing never allocates
+/// or shifts - it just moves the head back one slot and overwrites the oldest value.
+/// Capacity must be a power of two (indices wrap with a mask).
+template <typename T, unsigned int Capacity>
+class ofxNDHistoryRing {
+
+    // compile-time check: array of negative size if Capacity is not a power of two
+    typedef char CapacityMustBePowerOfTwo[(Capacity > 0 && (Capacity & (Capacity - 1)) == 0) ? 1 : -1];
+
+public:
+
+    enum { kCapacity = Capacity };
+
+    ofxNDHistoryRing() : _head(0) {};
+
+    // every entry set to value, e.g. when tracking (re)starts
+    void fill(const T & value)
+    {
+        for (unsigned int i=0; i<Capacity; i++){
+            _items[i] = value;
+        }
+        _head = 0;
+    }
+
+    // value becomes index 0, everything else ages by one, the oldest is dropped
+    void push(const T & value)
+    {
+        _head = (_head + Capacity - 1) & (Capacity - 1);
+        _items[_head] = value;
+    }
+
+    // 0 = newest, size()-1 = oldest
+    const T & operator[](unsigned int age) const { return _items[(_head + age) & (Capacity - 1)]; };
+    T & operator[](unsigned int age) { return _items[(_head + age) & (Capacity - 1)]; };
+
+    const T & newest() const { return _items[_head]; };
+    const T & oldest() const { return (*this)[Capacity - 1]; };
+
+    unsigned int size() const { return Capacity; };
+
+private:
+
+    T               _items[Capacity];
+    unsigned int    _head;
+};
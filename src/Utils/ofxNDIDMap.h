@@ -0,0 +1,92 @@
+//
+//  ofxNDIDMap.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#pragma once
+
+/// Fixed-size map from an external ID (tracker user or hand ID) to a non-zero value,
+/// usually an ofxNDSlotIndex handle.
+///
+/// Open addressing with linear probing over Size entries (a power of two); keep it
+/// at least twice the number of IDs it holds so probes stay short. find() returns 0
+/// for a missing ID, so 0 can't be stored - slot index handles never are.
+/// No allocation - all storage is inline.
+template <unsigned int Size>
+class ofxNDIDMap {
+
+    typedef char SizeMustBePowerOfTwo[(Size > 0 && (Size & (Size - 1)) == 0) ? 1 : -1];
+
+public:
+
+    ofxNDIDMap() { clear(); };
+
+    void clear()
+    {
+        for (unsigned int e=0; e<Size; e++){
+            _value[e] = 0;
+        }
+        _size = 0;
+    }
+
+    unsigned int size() const { return _size; };
+
+    unsigned int find(unsigned int id) const
+    {
+        for (unsigned int e = home(id); _value[e] != 0; e = (e + 1) & (Size - 1)){
+            if (_id[e] == id) return _value[e];
+        }
+        return 0;
+    }
+
+    // false if the ID is already there (its value is kept) or the table is full
+    bool insert(unsigned int id, unsigned int value)
+    {
+        if (value == 0 || _size == Size - 1) return false;
+
+        unsigned int e = home(id);
+        for (; _value[e] != 0; e = (e + 1) & (Size - 1)){
+            if (_id[e] == id) return false;
+        }
+        _id[e] = id;
+        _value[e] = value;
+        _size++;
+        return true;
+    }
+
+    // false if the ID isn't there
+    bool remove(unsigned int id)
+    {
+        unsigned int e = home(id);
+        for (; _value[e] != 0 && _id[e] != id; e = (e + 1) & (Size - 1)){}
+        if (_value[e] == 0) return false;
+
+        // shift later entries of the probe run back into the hole so no lookup
+        // stops early on it - no tombstones to clean up
+        unsigned int hole = e;
+        for (unsigned int next = (e + 1) & (Size - 1); _value[next] != 0; next = (next + 1) & (Size - 1)){
+            unsigned int nextHome = home(_id[next]);
+            bool movable = hole <= next ? (nextHome <= hole || nextHome > next) : (nextHome <= hole && nextHome > next);
+            if (movable){
+                _id[hole] = _id[next];
+                _value[hole] = _value[next];
+                hole = next;
+            }
+        }
+        _value[hole] = 0;
+        _size--;
+        return true;
+    }
+
+private:
+
+    // Knuth's multiplicative hash; tracker IDs are small and sequential
+    static unsigned int home(unsigned int id) { return ((id * 2654435761u) >> 16) & (Size - 1); };
+
+    unsigned int    _id[Size];
+    unsigned int    _value[Size];      // 0 = empty
+    unsigned int    _size;
+};
@@ -0,0 +1,92 @@
+//
+//  ofxNDInputScript.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#include "ofxNDInputScript.h"
+#include <fstream>
+
+ofxNDInputScript::ofxNDInputScript() :
+    _due(0),
+    _next(0)
+{
+}
+
+bool ofxNDInputScript::load(const string &path)
+{
+    _events.clear();
+    _due = 0;
+    _next = 0;
+
+    std::ifstream file(ofToDataPath(path).c_str());
+    if (!file.is_open()){
+        ofLog(OF_LOG_ERROR, "ofxNDInputScript: can't open " + path);
+        return false;
+    }
+
+    string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(file, line)){
+        lineNumber++;
+
+        stringstream ss(line);
+        string timeString, type;
+        if (!(ss >> timeString) || timeString[0] == '#') continue;
+
+        Event event;
+        event.time = ofToFloat(timeString);
+        event.key = 0;
+        bool valid = !(ss >> type).fail();
+
+        if (valid && type == "key"){
+            event.type = INPUT_SCRIPT_KEY;
+            string key;
+            valid = !(ss >> key).fail();
+            if (valid) event.key = key.length() == 1 ? key[0] : ofToInt(key);
+        }
+        else if (valid && type == "osc"){
+            event.type = INPUT_SCRIPT_OSC;
+            valid = !(ss >> event.address).fail();
+            float arg;
+            while (valid && ss >> arg){
+                event.args.push_back(arg);
+            }
+        }
+        else if (valid && type == "midi"){
+            event.type = INPUT_SCRIPT_MIDI;
+            float control, value;
+            valid = !(ss >> control >> value).fail();
+            event.args.push_back(control);
+            event.args.push_back(value);
+        }
+        else{
+            valid = false;
+        }
+
+        if (!valid || (!_events.empty() && event.time < _events.back().time)){
+            ofLog(OF_LOG_ERROR, "ofxNDInputScript: " + path + " line " + ofToString(lineNumber) + " is out of order or can't be parsed");
+            _events.clear();
+            return false;
+        }
+        _events.push_back(event);
+    }
+
+    return true;
+}
+
+void ofxNDInputScript::update(float time)
+{
+    while (_due < _events.size() && _events[_due].time <= time){
+        _due++;
+    }
+}
+
+bool ofxNDInputScript::getNextEvent(Event &event)
+{
+    if (_next >= _due) return false;
+    event = _events[_next++];
+    return true;
+}
@@ -0,0 +1,57 @@
+//
+//  ofxNDInputScript.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+// Script file layout, one event per line, in time order:
+//   <seconds> key <character or key code>
+//   <seconds> osc <address> [float ...]
+//   <seconds> midi <control> <value>
+// Blank lines and lines starting with # are skipped.
+
+enum ofxNDInputScriptEventType {
+    INPUT_SCRIPT_KEY = 0,
+    INPUT_SCRIPT_OSC,
+    INPUT_SCRIPT_MIDI
+};
+
+/// Timed key presses, OSC and MIDI messages read from a text file, for feeding an
+/// app the same input on every run. Played against the caller's clock like the
+/// recorded tracking source.
+class ofxNDInputScript {
+
+public:
+
+    struct Event {
+        float                       time;
+        ofxNDInputScriptEventType   type;
+        int                         key;        // INPUT_SCRIPT_KEY
+        string                      address;    // INPUT_SCRIPT_OSC
+        vector<float>               args;       // OSC arguments, or MIDI control and value
+    };
+
+    ofxNDInputScript();
+
+    // false if the file can't be read or a line can't be parsed (logged with its number)
+    bool load(const string & path);
+    unsigned int getNumEvents() const { return _events.size(); };
+
+    // events due by time become available to getNextEvent
+    void update(float time);
+
+    // due events, oldest first; false when there are none left
+    bool getNextEvent(Event & event);
+
+private:
+
+    vector<Event>   _events;
+    unsigned int    _due;       // events before this are due
+    unsigned int    _next;      // next to hand out
+};
@@ -0,0 +1,74 @@
+//
+//  ofxNDSemaphore.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/18/12.
+//
+//
+
+#pragma once
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#include <errno.h>
+#endif
+
+/// Counting semaphore for waking a worker from a real-time thread.
+///
+/// signal() never blocks or takes a lock (dispatch_semaphore_signal on OS X, where
+/// unnamed POSIX semaphores aren't implemented; sem_post elsewhere), so the audio
+/// callback can call it. wait() blocks until the count is above 0 and takes one.
+class ofxNDSemaphore {
+
+public:
+
+    ofxNDSemaphore()
+    {
+#ifdef __APPLE__
+        _semaphore = dispatch_semaphore_create(0);
+#else
+        sem_init(&_semaphore, 0, 0);
+#endif
+    };
+
+    ~ofxNDSemaphore()
+    {
+#ifdef __APPLE__
+        dispatch_release(_semaphore);
+#else
+        sem_destroy(&_semaphore);
+#endif
+    };
+
+    void signal()
+    {
+#ifdef __APPLE__
+        dispatch_semaphore_signal(_semaphore);
+#else
+        sem_post(&_semaphore);
+#endif
+    };
+
+    void wait()
+    {
+#ifdef __APPLE__
+        dispatch_semaphore_wait(_semaphore, DISPATCH_TIME_FOREVER);
+#else
+        while (sem_wait(&_semaphore) != 0 && errno == EINTR){}
+#endif
+    };
+
+private:
+
+    // not copyable
+    ofxNDSemaphore(const ofxNDSemaphore &);
+    ofxNDSemaphore & operator=(const ofxNDSemaphore &);
+
+#ifdef __APPLE__
+    dispatch_semaphore_t    _semaphore;
+#else
+    sem_t                   _semaphore;
+#endif
+};
@@ -0,0 +1,102 @@
+//
+//  ofxNDSlotIndex.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/12/12.
+//
+//
+
+#pragma once
+
+/// Handle bookkeeping for a dense table of up to Capacity entries.
+///
+/// The owner keeps its data in plain arrays indexed 0..size()-1 (densely packed,
+/// ideally one array per field). insert() hands out a handle for the entry at
+/// index size(); remove() swap-removes, telling the owner which entry to move.
+/// Handles stay valid while their entry lives, even when it moves, and carry
+/// a generation so a handle to a removed entry never resolves to whatever
+/// reuses its slot. Handle 0 is never valid. No allocation - all storage is inline.
+template <unsigned int Capacity>
+class ofxNDSlotIndex {
+
+    typedef char CapacityMustFitInHandle[(Capacity > 0 && Capacity <= 256) ? 1 : -1];
+
+public:
+
+    typedef unsigned int Handle;
+    enum { kInvalidHandle = 0, kCapacity = Capacity };
+
+    ofxNDSlotIndex() { clear(); };
+
+    void clear()
+    {
+        _size = 0;
+        for (unsigned int s=0; s<Capacity; s++){
+            _generation[s] = 1;
+            _slotToDense[s] = Capacity;
+            _freeSlots[s] = Capacity - 1 - s;
+        }
+        _numFree = Capacity;
+    }
+
+    unsigned int size() const   { return _size; };
+    bool full() const           { return _size == Capacity; };
+
+    // returns kInvalidHandle when full; the new entry's dense index is size()-1
+    Handle insert()
+    {
+        if (_numFree == 0) return kInvalidHandle;
+        unsigned int slot = _freeSlots[--_numFree];
+        _slotToDense[slot] = _size;
+        _denseToSlot[_size] = slot;
+        _size++;
+        return makeHandle(slot);
+    }
+
+    // false for a stale handle. Otherwise the owner must move its entry at
+    // movedFrom to movedTo (both set, equal when the removed entry was last).
+    bool remove(Handle handle, unsigned int & movedFrom, unsigned int & movedTo)
+    {
+        int dense = indexOf(handle);
+        if (dense < 0) return false;
+
+        unsigned int slot = handle & 0xFF;
+        unsigned int last = _size - 1;
+        unsigned int lastSlot = _denseToSlot[last];
+
+        _denseToSlot[dense] = lastSlot;
+        _slotToDense[lastSlot] = dense;
+        _slotToDense[slot] = Capacity;
+        _size--;
+
+        // never hand out generation 0 so no handle can equal kInvalidHandle
+        unsigned int generation = (_generation[slot] + 1) & 0xFFFFFF;
+        _generation[slot] = generation == 0 ? 1 : generation;
+        _freeSlots[_numFree++] = slot;
+
+        movedFrom = last;
+        movedTo = dense;
+        return true;
+    }
+
+    // dense index of a live handle, -1 if stale or invalid
+    int indexOf(Handle handle) const
+    {
+        unsigned int slot = handle & 0xFF;
+        if (slot >= Capacity || (handle >> 8) != _generation[slot] || _slotToDense[slot] >= Capacity) return -1;
+        return _slotToDense[slot];
+    }
+
+    Handle handleAt(unsigned int denseIndex) const { return makeHandle(_denseToSlot[denseIndex]); };
+
+private:
+
+    Handle makeHandle(unsigned int slot) const { return (_generation[slot] << 8) | slot; };
+
+    unsigned int    _generation[Capacity];      // per slot, 24 bits used
+    unsigned int    _slotToDense[Capacity];     // Capacity = free
+    unsigned int    _denseToSlot[Capacity];
+    unsigned int    _freeSlots[Capacity];       // stack
+    unsigned int    _numFree;
+    unsigned int    _size;
+};
@@ -0,0 +1,78 @@
+//
+//  ofxNDSpscQueue.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/6/12.
+//
+//
+
+#pragma once
+
+#include <vector>
+#include "ofxNDAtomic.h"
+
+/// Bounded single-producer/single-consumer FIFO with preallocated elements.
+///
+/// Unlike ofxNDFrameRing nothing is ever overwritten: when the queue is full
+/// beginPush() returns NULL and the producer decides what to drop.
+/// Elements are written and read in place, so neither side copies or allocates.
+template <typename T>
+class ofxNDSpscQueue {
+    
+public:
+    
+    ofxNDSpscQueue() : _head(0), _tail(0) {};
+    
+    void allocate(unsigned int capacity, const T & prototype)
+    {
+        // one slot is always left empty to tell full from empty
+        _elements.assign(capacity + 1, prototype);
+        _head = 0;
+        _tail = 0;
+    }
+    
+    unsigned int capacity() const { return _elements.empty() ? 0 : _elements.size() - 1; }
+    
+    unsigned int size() const
+    {
+        unsigned int head = ofxNDAtomicLoad(_head);
+        unsigned int tail = ofxNDAtomicLoad(_tail);
+        return tail >= head ? tail - head : tail + _elements.size() - head;
+    }
+    
+    // ---- producer ----
+    
+    /// Slot to fill, or NULL if the queue is full
+    T * beginPush()
+    {
+        if (_elements.empty()) return NULL;
+        unsigned int next = (_tail + 1) % _elements.size();
+        if (next == ofxNDAtomicLoad(_head)) return NULL;
+        return &_elements[_tail];
+    }
+    
+    void endPush()
+    {
+        ofxNDAtomicStore(_tail, (_tail + 1) % (unsigned int)_elements.size());
+    }
+    
+    // ---- consumer ----
+    
+    /// Oldest element, or NULL if the queue is empty
+    T * front()
+    {
+        if (_head == ofxNDAtomicLoad(_tail)) return NULL;
+        return &_elements[_head];
+    }
+    
+    void pop()
+    {
+        ofxNDAtomicStore(_head, (_head + 1) % (unsigned int)_elements.size());
+    }
+    
+private:
+    
+    std::vector<T>          _elements;
+    volatile unsigned int   _head;
+    volatile unsigned int   _tail;
+};
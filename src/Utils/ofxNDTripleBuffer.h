@@ -0,0 +1,69 @@
+//
+//  ofxNDTripleBuffer.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/7/12.
+//
+//
+
+#pragma once
+
+#include "ofxNDAtomic.h"
+
+/// Lock-free triple buffer for handing the latest value from one producer
+/// thread to one consumer thread.
+///
+/// The producer fills back() and publish()es it; the consumer calls update()
+/// and then reads front() in place for as long as it likes - the producer
+/// never touches the front buffer, so no copy and no allocation is needed.
+/// Intermediate values published between two update() calls are skipped.
+template <typename T>
+class ofxNDTripleBuffer {
+    
+public:
+    
+    ofxNDTripleBuffer() : _backIndex(0), _middle(1), _frontIndex(2) {};
+    
+    void allocate(const T & prototype)
+    {
+        for (int i=0; i<3; i++) _buffers[i] = prototype;
+        _backIndex = 0;
+        _middle = 1;
+        _frontIndex = 2;
+    }
+    
+    // ---- producer ----
+    
+    T & back() { return _buffers[_backIndex]; }
+    
+    void publish()
+    {
+        unsigned int oldMiddle = ofxNDAtomicExchange(_middle, _backIndex | kFreshFlag);
+        _backIndex = oldMiddle & kIndexMask;
+    }
+    
+    // ---- consumer ----
+    
+    /// Swap in the most recently published value, if any. Returns true if front() changed.
+    bool update()
+    {
+        if (!(ofxNDAtomicLoad(_middle) & kFreshFlag)) return false;
+        unsigned int oldMiddle = ofxNDAtomicExchange(_middle, _frontIndex);
+        _frontIndex = oldMiddle & kIndexMask;
+        return true;
+    }
+    
+    const T & front() const { return _buffers[_frontIndex]; }
+    
+private:
+    
+    enum {
+        kIndexMask = 3,
+        kFreshFlag = 4
+    };
+    
+    T                       _buffers[3];
+    unsigned int            _backIndex;     // producer only
+    volatile unsigned int   _middle;        // index of the shared buffer | kFreshFlag
+    unsigned int            _frontIndex;    // consumer only
+};
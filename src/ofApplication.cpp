@@ -5,16 +5,53 @@
 
 #define HANDS_MAX_SCALE_FACTOR 0.4
 
-#define TRAIL_FBO_SCALE      1.25
+#define HAND_ROPE_LINKS     128
+
+#define MAX_TRACKED_USERS   2       // each drives a sprite per joint in the joint set
+
+#define MAX_PARTICLES               100000
+#define PARTICLE_UPDATE_THREADS     1       // more for bigger pools, see ofxNDParticleSystem
+#define PARTICLES_MAX_EMIT_RATE     6000.0f // per hand per second at PARTICLES_FULL_VELOCITY, split when more joints drive sprites
+#define PARTICLES_FULL_VELOCITY     2000.0f // sprite speed, px/s
+
+#define MAX_ANALYZED_CHANNELS   16
+
+// cheapest first; the governor moves between these to hold the frame budget
+struct QualityLevel {
+    float   trailsResolution;
+    int     blurRadius;
+    float   spriteBudget;
+};
+static const QualityLevel s_qualityLevels[] = {
+    { 0.5f,     3,  0.25f },
+    { 0.625f,   5,  0.4f },
+    { 0.75f,    8,  0.6f },
+    { 0.875f,   11, 0.8f },
+    { 1.0f,     15, 1.0f }
+};
+#define NUM_QUALITY_LEVELS  (sizeof(s_qualityLevels)/sizeof(s_qualityLevels[0]))
 
 static int s_inputAudioDeviceId = 0;
+static int s_inputAudioChannels = 2;
 static int s_inputMidiDeviceId = 0;
 static int s_oscListenPort = 9010;
+static unsigned int s_randomSeed = 0;
+static string s_inputScriptPath;
+static string s_trackingRecordingPath;
+static string s_audioInputFilePath;
+static int s_trailsFormat = GL_RGBA32F_ARB;
+static float s_trailsScale = 1.25f;
+static int s_qualityLevel = -1;
+static int s_oscReplyPort = 9000;
 
 void ofApplicationSetAudioInputDeviceId(int deviceId){
     s_inputAudioDeviceId = deviceId;
 }
 
+void ofApplicationSetAudioInputChannels(int nChannels){
+    s_inputAudioChannels = MIN(nChannels, MAX_ANALYZED_CHANNELS);
+}
+
 void ofApplicationSetMidiInputDeviceId(int deviceId){
     s_inputMidiDeviceId = deviceId;
 }
@@ -23,6 +60,38 @@ void ofApplicationSetOSCListenPort(int listenPort){
     s_oscListenPort = listenPort;
 }
 
+void ofApplicationSetTrailsFormat(int internalFormat){
+    s_trailsFormat = internalFormat;
+}
+
+void ofApplicationSetTrailsScale(float scale){
+    s_trailsScale = MAX(scale, 1.0f);
+}
+
+void ofApplicationSetQualityLevel(int level){
+    s_qualityLevel = MIN(level, (int)NUM_QUALITY_LEVELS - 1);
+}
+
+void ofApplicationSetOSCReplyPort(int replyPort){
+    s_oscReplyPort = replyPort;
+}
+
+void ofApplicationSetRandomSeed(unsigned int seed){
+    s_randomSeed = seed;
+}
+
+void ofApplicationSetInputScript(const string & path){
+    s_inputScriptPath = path;
+}
+
+void ofApplicationSetTrackingRecording(const string & path){
+    s_trackingRecordingPath = path;
+}
+
+void ofApplicationSetAudioInputFile(const string & path){
+    s_audioInputFilePath = path;
+}
+
 //--------------------------------------------------------------
 
 float toOnePoleTC(float value, float minMs, float maxMs)
@@ -34,22 +103,39 @@ float toOnePoleTC(float value, float minMs, float maxMs)
 
 ofApplication::ofApplication()
 {
+    mainAnalyzer = NULL;
 #ifdef USE_KINECT
+    trackingSource = NULL;
     handPhysics = NULL;
+    handPhysicsThread = NULL;
+    bKinectDevice = false;
 #endif
 }
 
 ofApplication::~ofApplication()
 {
 #ifdef USE_KINECT
+    // the worker steps handPhysics, so it goes first
+    if (handPhysicsThread){
+        delete handPhysicsThread;
+        handPhysicsThread = NULL;
+    }
+    
     if (handPhysics){
         delete handPhysics;
         handPhysics = NULL;
     }
     
+    if (trackingSource){
+        delete trackingSource;
+        trackingSource = NULL;
+    }
+    
     // prevents crashing on exit (sometimes)
-    kinectOpenNI.stop();
-    kinectOpenNI.waitForThread();
+    if (bKinectDevice){
+        kinectOpenNI.stop();
+        kinectOpenNI.waitForThread();
+    }
 #endif
 }
 
@@ -60,8 +146,15 @@ void ofApplication::setup(){
     ofEnableSmoothing();
     ofEnableArbTex();
     
+    // same seed, same sprite shapes every run
+    if (s_randomSeed) ofSeedRandom(s_randomSeed);
+    bool offline = ofxNDClock::isSimulated();
+    
     // setup animation parameters
     debugMode = false;
+    frameStartMicros = 0;
+    frameMicros = 0.0f;
+    lastFrameMicros = 0.0f;
     
     // FLAGS
     bDrawUserOutline = true;
@@ -70,6 +163,11 @@ void ofApplication::setup(){
     bTrailHands = false;
     bDrawPoi = false;
     bTrailPoi = false;
+    bDrawRopes = false;
+    bTrailRopes = true;
+    bDrawParticles = false;
+    bTrailParticles = true;
+    bGestures = false;
 
     // CIRCULAR GRADIENT + BACKGROUND
     bgBrightnessFade = 0.0f;
@@ -87,6 +185,8 @@ void ofApplication::setup(){
     userShapeScaleFactor = 1.1f;
     strobeLastDrawTime = 0;
     strobeIntervalMs = 0;
+    bSyncToBeat = false;
+    strobeLastBeatSlot = -1;
     
     // POI
     poiMaxScaleFactor = 0.1f;
@@ -95,6 +195,16 @@ void ofApplication::setup(){
     // HANDS    
     handsColorHSB = ofxNDHSBColor(0,0,200);
     
+    // PARTICLES
+    particleColorHSB = ofxNDHSBColor(0,0,255,160);
+    particleParameters.gravity = ofVec2f(0, 150.0f);
+    particleParameters.drag = 0.2f;
+    for (int i=0; i<MAX_TRACKED_JOINTS; i++){
+        particleEmitAccumulator[i] = 0.0f;
+    }
+    handParticles.setup(MAX_PARTICLES);
+    handParticles.setNumThreads(PARTICLE_UPDATE_THREADS);
+    
     ofFbo::Settings fboSettings;
     fboSettings.width = ofGetWidth();
     fboSettings.height = ofGetHeight();
@@ -110,21 +220,24 @@ void ofApplication::setup(){
     ofClear(0,0,0,0);
     mainFbo.end();
     
-    fboSettings.numColorbuffers = 2;
-    fboSettings.width = ofGetWidth()*TRAIL_FBO_SCALE;
-    fboSettings.height = ofGetHeight()*TRAIL_FBO_SCALE;
-    fboSettings.internalformat = GL_RGBA32F_ARB;
-    trailsFbo.allocate(fboSettings);
-    trailsFbo.begin();
-    trailsFbo.activateAllDrawBuffers();
-    ofClear(0, 0, 0, 0);
-    trailsFbo.end();
+    // quality: governed live, fixed offline so every run renders the same
+    bGovernQuality = s_qualityLevel < 0 && !offline;
+    int startLevel = s_qualityLevel >= 0 ? s_qualityLevel : NUM_QUALITY_LEVELS - 1;
+    qualityGovernor.setup(NUM_QUALITY_LEVELS, startLevel);
+    trailsResolution = s_qualityLevels[startLevel].trailsResolution;
+    pixelScale = 1.0f;
+    spriteBudget = s_qualityLevels[startLevel].spriteBudget;
+    
+    trailsFormat = s_trailsFormat;
+    trailsScale = s_trailsScale;
+    allocateTrails();
     
     fboSettings.numColorbuffers = 1;
     fboSettings.width = 640;
     fboSettings.height = 480;
     fboSettings.internalformat = GL_RGBA;
     userFbo.allocate(fboSettings);
+    userFbo.getTextureReference().setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
     userFbo.begin();
     userFbo.activateAllDrawBuffers();
     ofClear(0,0,0,0);
@@ -132,80 +245,156 @@ void ofApplication::setup(){
     
     trailsShader.load("shaders/vanilla.vert", "shaders/trails.frag");
     userMaskShader.load("shaders/vanilla.vert", "shaders/userDepthMask.frag");
-    gaussianBlurShader.load("shaders/vanilla.vert", "shaders/gaussian.frag");
+    userBlur.setup(userFbo.getWidth(), userFbo.getHeight());
+    userBlur.setSigma(4.0f);
+    userBlur.setMaxRadius(s_qualityLevels[startLevel].blurRadius);
+    particleShader.load("shaders/particles.vert", "shaders/particles.frag");
+    
+    logRenderTargets();
     
     // midi setup
     midiIn.setVerbose(false);
-    midiIn.openPort(s_inputMidiDeviceId);
+    if (!offline) midiIn.openPort(s_inputMidiDeviceId);
     midiIn.addListener(this);
     
     // osc setup
-    oscIn.setup(s_oscListenPort);
+    if (!offline) oscIn.setup(s_oscListenPort);
+    
+    if (!s_inputScriptPath.empty() && inputScript.load(s_inputScriptPath)){
+        ofLog(OF_LOG_NOTICE, "Input script: " + ofToString(inputScript.getNumEvents()) + " events from " + s_inputScriptPath);
+    }
     
     // audio setup
     audioSensitivity = 1.0f;
+    audioOnsetPulse = 0.0f;
+    audioBeatPhase = 0.0f;
     
     ofxAudioAnalyzer::Settings audioSettings;
     audioSettings.stereo = true;
     audioSettings.inputDeviceId = s_inputAudioDeviceId;
     audioSettings.bufferSize = 512;
-    audioAnalyzer.setup(audioSettings);
     
-    audioAnalyzer.setAttackInRegion(10, AA_FREQ_REGION_LOW);
-    audioAnalyzer.setReleaseInRegion(250, AA_FREQ_REGION_LOW);
-    audioAnalyzer.setAttackInRegion(5, AA_FREQ_REGION_MID);
-    audioAnalyzer.setReleaseInRegion(120, AA_FREQ_REGION_MID);
-    audioAnalyzer.setAttackInRegion(1, AA_FREQ_REGION_HIGH);
-    audioAnalyzer.setReleaseInRegion(80, AA_FREQ_REGION_HIGH);
+    vector<ofxAudioAnalyzer*> analyzers;
     
-    // kinect setup
-#ifdef USE_KINECT    
+    // offline: analyzed in update as the clock reaches it, same hops every run
+    bOfflineAudio = offline;
+    audioFramesFed = 0;
+    if (bOfflineAudio){
+        audioSettings.useInputStream = false;
+        audioSettings.threadedAnalysis = false;
+        if (!s_audioInputFilePath.empty() && audioFile.open(ofToDataPath(s_audioInputFilePath))){
+            audioSettings.sampleRate = audioFile.getSampleRate();
+            audioSettings.stereo = audioFile.getNumChannels() > 1;
+        }
+    }
     
-    kinectDriver.setup();
-    kinectAngle = 0;
+    if (s_inputAudioChannels > 2 && !bOfflineAudio){
+        
+        // multichannel interface: ch 1+2 mix drives the visuals as before,
+        // plus one analyzer per input channel, each on its own thread
+        ofxMultiChannelAudioAnalyzer::Settings channelSettings;
+        channelSettings.analyzerSettings = audioSettings;
+        channelSettings.numInputChannels = s_inputAudioChannels;
+        channelSettings.groups.push_back(ofxMultiChannelAudioAnalyzer::ChannelGroup(0, 2));
+        for (int c=0; c<s_inputAudioChannels; c++){
+            channelSettings.groups.push_back(ofxMultiChannelAudioAnalyzer::ChannelGroup(c, 1));
+        }
+        channelAnalyzer.setup(channelSettings);
+        
+        for (unsigned int a=0; a<channelAnalyzer.getNumAnalyzers(); a++){
+            analyzers.push_back(&channelAnalyzer.getAnalyzer(a));
+        }
+        channelFeatures.resize(s_inputAudioChannels);
+    }
+    else{
+        audioAnalyzer.setup(audioSettings);
+        analyzers.push_back(&audioAnalyzer);
+    }
     
-    kinectOpenNI.setup();
-    kinectOpenNI.addImageGenerator();
-    kinectOpenNI.addDepthGenerator();
-    kinectOpenNI.setDepthColoring(COLORING_GREY);
+    mainAnalyzer = analyzers[0];
     
-    kinectOpenNI.setThreadSleep(15000);
-    kinectOpenNI.setSafeThreading(false);
-    kinectOpenNI.setRegister(true);
-    kinectOpenNI.setMirror(true);
+    for (unsigned int a=0; a<analyzers.size(); a++){
+        analyzers[a]->setAttackInRegion(10, AA_FREQ_REGION_LOW);
+        analyzers[a]->setReleaseInRegion(250, AA_FREQ_REGION_LOW);
+        analyzers[a]->setAttackInRegion(5, AA_FREQ_REGION_MID);
+        analyzers[a]->setReleaseInRegion(120, AA_FREQ_REGION_MID);
+        analyzers[a]->setAttackInRegion(1, AA_FREQ_REGION_HIGH);
+        analyzers[a]->setReleaseInRegion(80, AA_FREQ_REGION_HIGH);
+    }
     
+    // kinect setup
+#ifdef USE_KINECT    
+    
+    kinectAngle = 0;
+    bKinectDevice = s_trackingRecordingPath.empty() && !offline;
+    if (bKinectDevice){
+        
+        kinectDriver.setup();
+        
+        kinectOpenNI.setup();
+        kinectOpenNI.addImageGenerator();
+        kinectOpenNI.addDepthGenerator();
+        kinectOpenNI.setDepthColoring(COLORING_GREY);
+        
+        kinectOpenNI.setThreadSleep(15000);
+        kinectOpenNI.setSafeThreading(false);
+        kinectOpenNI.setRegister(true);
+        kinectOpenNI.setMirror(true);
+        
 #ifdef USE_USER_TRACKING
-    // setup user generator
-    kinectOpenNI.addUserGenerator();
-    kinectOpenNI.setMaxNumUsers(2);
-    kinectOpenNI.setUseMaskPixelsAllUsers(true);
-    kinectOpenNI.setUseMaskTextureAllUsers(true);
-    kinectOpenNI.setUsePointCloudsAllUsers(false);
-    kinectOpenNI.setSkeletonProfile(XN_SKEL_PROFILE_UPPER);
-    kinectOpenNI.setUserSmoothing(0.4);
+        // setup user generator
+        kinectOpenNI.addUserGenerator();
+        kinectOpenNI.setMaxNumUsers(MAX_TRACKED_USERS);
+        kinectOpenNI.setUseMaskPixelsAllUsers(true);
+        kinectOpenNI.setUseMaskTextureAllUsers(true);
+        kinectOpenNI.setUsePointCloudsAllUsers(false);
+        kinectOpenNI.setSkeletonProfile(XN_SKEL_PROFILE_ALL);
+        kinectOpenNI.setUserSmoothing(0.4);
 #else
-    // hands generator
-    kinectOpenNI.addHandsGenerator();
-    kinectOpenNI.addAllHandFocusGestures();
-    kinectOpenNI.setMaxNumHands(2);
-    kinectOpenNI.setMinTimeBetweenHands(50);
+        // hands generator
+        kinectOpenNI.addHandsGenerator();
+        kinectOpenNI.addAllHandFocusGestures();
+        kinectOpenNI.setMaxNumHands(2);
+        kinectOpenNI.setMinTimeBetweenHands(50);
 #endif
 
-    
-    kinectOpenNI.start();
-    
+        
+        kinectOpenNI.start();
+        
 #ifdef USE_USER_TRACKING
-    handPhysics = new ofxHandPhysicsManager(kinectOpenNI, true);
+        trackingSource = new ofxOpenNITrackingSource(kinectOpenNI, true);
 #else
-    handPhysics = new ofxHandPhysicsManager(kinectOpenNI, false);
+        trackingSource = new ofxOpenNITrackingSource(kinectOpenNI, false);
 #endif
+    }
+    else if (s_trackingRecordingPath.empty() || s_trackingRecordingPath == "synthetic"){
+        // seeded on its own, so the motion doesn't depend on ofRandom
+        trackingSource = new ofxSyntheticTrackingSource(MAX_TRACKED_USERS, MAX(s_randomSeed, 1u));
+    }
+    else{
+        ofxRecordedTrackingSource * recording = new ofxRecordedTrackingSource();
+        if (!recording->load(s_trackingRecordingPath)){
+            ofLog(OF_LOG_ERROR, "Can't load tracking recording " + s_trackingRecordingPath);
+        }
+        recording->setLoop(true);
+        trackingSource = recording;
+    }
+    handPhysics = new ofxHandPhysicsManager(*trackingSource);
     
     handPhysics->restDistance = 0.0f;
     handPhysics->springCoef = 100.0f;
     handPhysics->smoothCoef = 0.5f;
+    handPhysics->filterType = HAND_FILTER_ONE_EURO;
     handPhysics->friction = 0.08f;
     handPhysics->gravity = ofVec2f(0,7000.0f);
     handPhysics->physicsEnabled = true;
+    
+    handPhysicsThread = new ofxHandPhysicsThread(*handPhysics);
+    handPhysicsThread->setThreaded(true);
+    
+    handGestures.addDefaultTemplates();
+    gestureMicros = 0.0f;
+    deviceMicros = 0.0f;
 #endif
     
 }
@@ -213,26 +402,70 @@ void ofApplication::setup(){
 //--------------------------------------------------------------
 void ofApplication::update(){
     
-    float elapsedTime = ofGetElapsedTimef();
+    frameStartMicros = ofGetElapsedTimeMicros();
+    float elapsedTime = ofxNDClock::getSeconds();
 
-    audioLowEnergy = ofMap(audioAnalyzer.getSignalEnergyInRegion(AA_FREQ_REGION_LOW)*audioSensitivity, 0.25f, 3.0f, 0.0f, 1.0f, true);
-    audioMidEnergy = audioAnalyzer.getSignalEnergyInRegion(AA_FREQ_REGION_MID)*audioSensitivity;
-    audioHiPSF = ofMap(audioAnalyzer.getPSFinRegion(AA_FREQ_REGION_HIGH)*audioSensitivity, 0.3f, 4.0f, 0.0f, 1.0f, true);
+    // all audio values for this frame come from one consistent analysis snapshot
+    unsigned long long nowMicros = ofxNDClock::getMicros();
+    if (bOfflineAudio) feedAudioFile(nowMicros);
+    mainAnalyzer->updateSnapshot();
+    mainAnalyzer->getInterpolatedFeatures(nowMicros, audioFeatures);
+    for (unsigned int c=0; c<channelFeatures.size(); c++){
+        ofxAudioAnalyzer & analyzer = channelAnalyzer.getAnalyzer(c+1);
+        analyzer.updateSnapshot();
+        analyzer.getInterpolatedFeatures(nowMicros, channelFeatures[c]);
+    }
+    audioLowEnergy = ofMap(audioFeatures.energySmoothed[AA_FREQ_REGION_LOW]*audioSensitivity, 0.25f, 3.0f, 0.0f, 1.0f, true);
+    audioMidEnergy = audioFeatures.energySmoothed[AA_FREQ_REGION_MID]*audioSensitivity;
+    audioHiPSF = ofMap(audioFeatures.psfSmoothed[AA_FREQ_REGION_HIGH]*audioSensitivity, 0.3f, 4.0f, 0.0f, 1.0f, true);
+    
+    audioOnsetPulse *= powf(0.05f, ofGetLastFrameTime()/0.15f);
+    ofxAudioAnalyzer::Onset onset;
+    while (mainAnalyzer->getNextOnset(onset)){
+        audioOnsetPulse = MAX(audioOnsetPulse, onset.strength);
+    }
+    audioBeatPhase = mainAnalyzer->getBeatPhase(nowMicros);
     elapsedPhase = 2.0*M_PI*elapsedTime;
     
     processOscMessages();
+    processInputScript(elapsedTime);
 
 #ifdef USE_KINECT
-    kinectOpenNI.update();
-    handPhysics->update();    
-    if(bDrawUserOutline) updateUserOutline();
+    // the step started last frame has had the whole draw to run; until the next
+    // one starts, the device and handPhysics are ours. The tracking source updates
+    // inside the step, but the device update stays here: it uploads the depth and
+    // image textures, which needs the GL context.
+    handPhysicsThread->finish();
+    if (bKinectDevice){
+        unsigned long long deviceStart = ofGetElapsedTimeMicros();
+        kinectOpenNI.update();
+        deviceMicros = ofGetElapsedTimeMicros() - deviceStart;
+    }
+    // the outline reads the device too, so it goes before the step takes it back
+    if(bDrawUserOutline && bKinectDevice) updateUserOutline();
+    handPhysics->setRopeLinks(bDrawRopes ? HAND_ROPE_LINKS : 0);
+    handPhysicsThread->start(elapsedTime);
+    updateGestures();
  #endif
     
+    updateQuality();
+    updateParticles();
+    
     // don't draw if frame freeze is turned on
     bool shouldDrawNew = true;
     if (strobeIntervalMs > 1000.0f/60.0f){
         
-        shouldDrawNew = (elapsedTime - strobeLastDrawTime >= strobeIntervalMs/1000.0f);
+        if (bSyncToBeat && mainAnalyzer->getTempoBpm() > 0.0f){
+            // nearest whole subdivision of the beat to the strobe interval
+            float beatMs = 60000.0f/mainAnalyzer->getTempoBpm();
+            int subdivisions = MAX(1, (int)roundf(beatMs/strobeIntervalMs));
+            int slot = (int)(audioBeatPhase*subdivisions);
+            shouldDrawNew = (slot != strobeLastBeatSlot);
+            strobeLastBeatSlot = slot;
+        }
+        else{
+            shouldDrawNew = (elapsedTime - strobeLastDrawTime >= strobeIntervalMs/1000.0f);
+        }
         if (shouldDrawNew){
             strobeLastDrawTime = elapsedTime;
         }
@@ -246,6 +479,8 @@ void ofApplication::update(){
         if (bDrawUserOutline && bTrailUserOutline) drawUserOutline();
         if (bDrawHands && bTrailHands) drawHandSprites();
         if (bDrawPoi && bTrailPoi) drawPoiSprites();
+        if (bDrawRopes && bTrailRopes) drawHandRopes();
+        if (bDrawParticles && bTrailParticles) drawParticles();
         drawTouches();
     }
     endTrails();
@@ -259,6 +494,8 @@ void ofApplication::update(){
     if (shouldDrawNew){
         if (bDrawHands && !bTrailHands) drawHandSprites();
         if (bDrawPoi && !bTrailPoi) drawPoiSprites();
+        if (bDrawRopes && !bTrailRopes) drawHandRopes();
+        if (bDrawParticles && !bTrailParticles) drawParticles();
     }
 
     mainFbo.end();
@@ -287,30 +524,104 @@ void ofApplication::draw(){
     if (debugMode){
         
 #ifdef USE_KINECT
-        kinectOpenNI.drawSkeletons(0, 0, ofGetWidth(), ofGetHeight());
+        if (bKinectDevice) kinectOpenNI.drawSkeletons(0, 0, ofGetWidth(), ofGetHeight());
 #endif
         
         ofSetColor(255, 255, 255);
         stringstream ss;
         ss << setprecision(2);
-        ss << "Audio Signal Energy: " << audioAnalyzer.getSignalEnergy();
+        ss << "Audio Signal Energy: " << audioFeatures.energySmoothed[AA_FREQ_REGION_ALL];
         ofDrawBitmapString(ss.str(), 20,30);
         ss.str(std::string());
-        ss << "Audio Signal PSF: " << audioAnalyzer.getTotalPSF();
+        ss << "Audio Signal PSF: " << audioFeatures.psfSmoothed[AA_FREQ_REGION_ALL];
         ofDrawBitmapString(ss.str(), 20,45);
         ss.str(std::string());
-        ss << "Region Energy -- Low: " << audioAnalyzer.getSignalEnergyInRegion(AA_FREQ_REGION_LOW) <<
-        " Mid: " << audioAnalyzer.getSignalEnergyInRegion(AA_FREQ_REGION_MID) << " High: " << audioAnalyzer.getSignalEnergyInRegion(AA_FREQ_REGION_HIGH);
+        ss << "Region Energy -- Low: " << audioFeatures.energySmoothed[AA_FREQ_REGION_LOW] <<
+        " Mid: " << audioFeatures.energySmoothed[AA_FREQ_REGION_MID] << " High: " << audioFeatures.energySmoothed[AA_FREQ_REGION_HIGH];
         ofDrawBitmapString(ss.str(), 20, 60);
         ss.str(std::string());
-        ss << "Region PSF -- Low: " << audioAnalyzer.getPSFinRegion(AA_FREQ_REGION_LOW) <<
-        " Mid: " << audioAnalyzer.getPSFinRegion(AA_FREQ_REGION_MID) << " High: " << audioAnalyzer.getPSFinRegion(AA_FREQ_REGION_HIGH);
+        ss << "Region PSF -- Low: " << audioFeatures.psfSmoothed[AA_FREQ_REGION_LOW] <<
+        " Mid: " << audioFeatures.psfSmoothed[AA_FREQ_REGION_MID] << " High: " << audioFeatures.psfSmoothed[AA_FREQ_REGION_HIGH];
         ofDrawBitmapString(ss.str(), 20, 75);
+        ss.str(std::string());
+        ofxAudioAnalyzer::AnalysisStats audioStats = mainAnalyzer->getAnalysisStats();
+        ss << "Audio Analysis -- Queue: " << audioStats.queueDepth << " (max " << audioStats.maxQueueDepth <<
+        ") Dropped: " << audioStats.droppedBlocks << " Worst: " << audioStats.worstAnalysisMicros << "us";
+        ofDrawBitmapString(ss.str(), 20, 90);
+        
+        ss.str(std::string());
+        ss << "Beat -- Tempo: " << (int)roundf(mainAnalyzer->getTempoBpm()) << " Phase: " << audioBeatPhase <<
+        " Onset: " << audioOnsetPulse << (bSyncToBeat ? " (synced)" : "");
+        ofDrawBitmapString(ss.str(), 20, 105);
+        ss.str(std::string());
+        const ofxAudioAnalyzer::SpectralFeatures & spectral = mainAnalyzer->getSnapshot().spectral;
+        ss << "Spectrum -- Centroid: " << (int)spectral.centroid << "Hz Rolloff: " << (int)spectral.rolloff <<
+        "Hz Flatness: " << spectral.flatness << " RMS: " << spectral.rms;
+        ofDrawBitmapString(ss.str(), 20, 120);
         
-        ofDrawBitmapString("Frame Rate: " + ofToString(ofGetFrameRate()), 20, 100);
+        int hudY = 135;
+        for (unsigned int c=0; c<channelFeatures.size(); c++){
+            ss.str(std::string());
+            ss << "Ch " << c+1 << " Energy -- Low: " << channelFeatures[c].energySmoothed[AA_FREQ_REGION_LOW] <<
+            " Mid: " << channelFeatures[c].energySmoothed[AA_FREQ_REGION_MID] << " High: " << channelFeatures[c].energySmoothed[AA_FREQ_REGION_HIGH] <<
+            " PSF: " << channelFeatures[c].psfSmoothed[AA_FREQ_REGION_ALL];
+            ofDrawBitmapString(ss.str(), 20, hudY);
+            hudY += 15;
+        }
+        
+#ifdef USE_KINECT
+        ss.str(std::string());
+        const ofxHandPhysicsFrame & hands = handPhysicsThread->front();
+        ss << "Hands -- Filter: " << ofxHandFilterName(handPhysics->filterType) << " Display latency: " <<
+        (int)roundf(hands.displayLatency*1000.0f) << "ms Sprites: " << hands.numHands;
+        ofDrawBitmapString(ss.str(), 20, hudY);
+        hudY += 15;
+        
+        ss.str(std::string());
+        ss << "Physics -- " << (handPhysicsThread->isThreaded() ? "Overlapped" : "Serial") << " Step: " <<
+        (int)handPhysicsThread->getStepMicros() << "us On frame: " << (int)handPhysicsThread->getWaitMicros() << "us Device: " <<
+        (int)deviceMicros << "us";
+        ofDrawBitmapString(ss.str(), 20, hudY);
+        hudY += 15;
+        
+        ss.str(std::string());
+        ss << "Gestures -- " << (bGestures ? "On" : "Off") << " Tracks: " << handGestures.getNumTracks() <<
+        " Match: " << (int)gestureMicros << "us Last: " << (lastGesture.empty() ? "none" : lastGesture);
+        ofDrawBitmapString(ss.str(), 20, hudY);
+        hudY += 15;
+#endif
+        
+        ss.str(std::string());
+        ss << "Quality -- Level " << qualityGovernor.getLevel() << "/" << NUM_QUALITY_LEVELS - 1 <<
+        (bGovernQuality ? " (governed)" : " (fixed)") << " Interval: " << ofToString(qualityGovernor.getSmoothedIntervalMs(), 1) <<
+        "ms Busy: " << ofToString(qualityGovernor.getSmoothedBusyMs(), 1) << "ms Blur: r" << userBlur.getRadius() << "/" << (1 << userBlur.getNumLevels()) << " Sprites: " <<
+        (int)(spriteBudget*100.0f) << "%";
+        ofDrawBitmapString(ss.str(), 20, hudY);
+        hudY += 15;
+        
+        ss.str(std::string());
+        ss << "Trails -- " << ofxNDInternalFormatName(trailsFormat) << " x" << trailsScale*trailsResolution << " " <<
+        (int)trailsFbo.getWidth() << "x" << (int)trailsFbo.getHeight();
+        ofDrawBitmapString(ss.str(), 20, hudY);
+        hudY += 15;
+        
+        ss.str(std::string());
+        ss << "Particles: " << handParticles.getNumParticles() << " / " << handParticles.getMaxParticles() <<
+        " (" << handParticles.getNumThreads() << (handParticles.getNumThreads() > 1 ? " threads)" : " thread)");
+        ofDrawBitmapString(ss.str(), 20, hudY);
+        hudY += 15;
+        
+        ofDrawBitmapString("Frame Rate: " + ofToString(ofGetFrameRate()) + " CPU: " + ofToString(frameMicros/1000.0f) + "ms", 20, hudY + 10);
         
     }
 
+#ifdef USE_KINECT
+    // as close to the swap as we get; the hands are predicted ahead by this much
+    handPhysicsThread->frameDisplayed(ofxNDClock::getSeconds());
+#endif
+    
+    lastFrameMicros = ofGetElapsedTimeMicros() - frameStartMicros;
+    frameMicros = frameMicros == 0.0f ? lastFrameMicros : frameMicros + (lastFrameMicros - frameMicros)*0.05f;
 }
 
 void ofApplication::beginTrails()
@@ -319,13 +630,15 @@ void ofApplication::beginTrails()
     ofSetColor(255,255,255);
     ofFill();
     
+    // the attachments swap roles each frame: fade last frame's trails into the other one
+    trailsWriteBuffer = 1 - trailsWriteBuffer;
     trailsFbo.begin();
-    trailsFbo.setActiveDrawBuffer(0);
+    trailsFbo.setActiveDrawBuffer(trailsWriteBuffer);
     ofClear(0,0,0,0);
 
-    ofTexture & fadingTex = trailsFbo.getTextureReference(1);
+    ofTexture & fadingTex = trailsFbo.getTextureReference(1 - trailsWriteBuffer);
     
-    ofPoint trailOffset = trailVelocity*ofGetLastFrameTime();
+    ofPoint trailOffset = trailVelocity*ofGetLastFrameTime()*trailsResolution;
     
     ofPushMatrix();        
 
@@ -341,6 +654,9 @@ void ofApplication::beginTrails()
     trailsShader.setUniform1f("alphaDecay", trailAlphaDecay);
     trailsShader.setUniform1f("colorDecay", trailColorDecay);
     trailsShader.setUniform1f("alphaMin", trailMinAlpha);
+    trailsShader.setUniform1f("colorStep", ofxNDQuantizationStep(trailsFormat, false));
+    trailsShader.setUniform1f("alphaStep", ofxNDQuantizationStep(trailsFormat, true));
+    trailsShader.setUniform1f("ditherSeed", ofGetFrameNum() % 256);
     int w = trailsFbo.getWidth();
     int h = trailsFbo.getHeight();
     ofxNDBillboardRect(0, 0, w, h, w, h);
@@ -350,30 +666,82 @@ void ofApplication::beginTrails()
     
     // for other drawing methods to be scaled properly
     ofPushMatrix();
-    ofPoint trailTrans = ofPoint(ofGetWidth(), ofGetHeight())*(TRAIL_FBO_SCALE - 1.0f)/2.0f;
+    ofPoint trailTrans = ofPoint(ofGetWidth(), ofGetHeight())*(trailsScale - 1.0f)/2.0f;
+    ofScale(trailsResolution, trailsResolution);
     ofTranslate(trailTrans);
+    pixelScale = trailsResolution;
 }
 
 void ofApplication::endTrails()
 {
     ofDisableBlendMode();
     ofPopMatrix();
+    pixelScale = 1.0f;
     ofSetColor(255,255,255);
-    trailsFbo.setActiveDrawBuffer(1);
-    ofClear(0,0,0,0);
-    trailsFbo.getTextureReference(0).draw(0,0);
     trailsFbo.end();
 }
 
+void ofApplication::allocateTrails()
+{
+    ofFbo::Settings fboSettings;
+    fboSettings.width = ofGetWidth()*trailsScale*trailsResolution;
+    fboSettings.height = ofGetHeight()*trailsScale*trailsResolution;
+    fboSettings.useDepth = false;
+    fboSettings.useStencil = false;
+    fboSettings.depthStencilAsTexture = false;
+    fboSettings.numColorbuffers = 2;
+    fboSettings.internalformat = trailsFormat;
+    trailsFbo.allocate(fboSettings);
+    trailsFbo.begin();
+    trailsFbo.activateAllDrawBuffers();
+    ofClear(0, 0, 0, 0);
+    trailsFbo.end();
+    trailsWriteBuffer = 0;
+}
+
+void ofApplication::logRenderTargets()
+{
+    // sizes and formats as allocated, read back from the FBOs' textures
+    ofFbo * targets[] = { &mainFbo, &trailsFbo, &userFbo };
+    const char * names[] = { "main", "trails", "user" };
+    
+    stringstream ss;
+    ss << "Render targets --";
+    float totalMB = 0.0f;
+    for (unsigned int i=0; i<sizeof(targets)/sizeof(targets[0]); i++){
+        ofFbo & fbo = *targets[i];
+        int format = fbo.getTextureReference(0).texData.glTypeInternal;
+        float mb = fbo.getWidth()*fbo.getHeight()*ofxNDBytesPerPixel(format)*fbo.getNumTextures()/(1024.0f*1024.0f);
+        ss << " " << names[i] << ": " << (int)fbo.getWidth() << "x" << (int)fbo.getHeight() << " " <<
+        ofxNDInternalFormatName(format) << " x" << fbo.getNumTextures() << " " << ofToString(mb, 1) << "MB";
+        totalMB += mb;
+    }
+    
+    // the user blur's pyramid and between-pass targets, together
+    float blurMB = 0.0f;
+    int blurFormat = GL_RGBA;
+    for (int i=0; i<userBlur.getNumTargets(); i++){
+        ofFbo & fbo = userBlur.getTarget(i);
+        blurFormat = fbo.getTextureReference(0).texData.glTypeInternal;
+        blurMB += fbo.getWidth()*fbo.getHeight()*ofxNDBytesPerPixel(blurFormat)*fbo.getNumTextures()/(1024.0f*1024.0f);
+    }
+    ss << " user blur: " << userBlur.getNumTargets() << " targets " << ofxNDInternalFormatName(blurFormat) << " " <<
+    ofToString(blurMB, 1) << "MB";
+    totalMB += blurMB;
+    
+    ss << " total: " << ofToString(totalMB, 1) << "MB";
+    ofLog(OF_LOG_NOTICE, ss.str());
+}
+
 void ofApplication::drawTrails()
 {
     ofEnableBlendMode(OF_BLENDMODE_ALPHA);
     ofSetColor(255, 255, 255);
     ofPushMatrix();
-    ofPoint trailTrans = -ofPoint(ofGetWidth(), ofGetHeight())*(TRAIL_FBO_SCALE - 1.0f)/2.0f;
+    ofPoint trailTrans = -ofPoint(ofGetWidth(), ofGetHeight())*(trailsScale - 1.0f)/2.0f;
     ofTranslate(trailTrans);
-    ofTexture & trailTex = trailsFbo.getTextureReference(0);
-    trailTex.draw(0,0);
+    ofTexture & trailTex = trailsFbo.getTextureReference(trailsWriteBuffer);
+    trailTex.draw(0, 0, trailsFbo.getWidth()/trailsResolution, trailsFbo.getHeight()/trailsResolution);
     ofPopMatrix();
 }
 
@@ -402,44 +770,30 @@ void ofApplication::updateUserOutline()
     ofxNDBillboardRect(0, 0, userFbo.getWidth(), userFbo.getHeight(), depthTex.getWidth(), depthTex.getHeight());
     userMaskShader.end();
     
-    // ===== blur =====
-    gaussianBlurShader.begin();
-    
-    float blurAmt = 4.0f; //ofMap(audioLowEnergy, 0.0f, 1.0f, 0.01f, 15.0f, true);
-    
-    gaussianBlurShader.setUniform1f("sigma", blurAmt);
-    gaussianBlurShader.setUniform1f("nBlurPixels", 15.0f);
-    gaussianBlurShader.setUniform1i("isVertical", 0);
-    gaussianBlurShader.setUniformTexture("blurTexture",  userFbo.getTextureReference(), 1);
-    
-    ofxNDBillboardRect(0, 0, userFbo.getWidth(), userFbo.getHeight(), depthTex.getWidth(), depthTex.getHeight());
-    
-    gaussianBlurShader.setUniform1i("isVertical", 1);
-    gaussianBlurShader.setUniformTexture("blurTexture", userFbo.getTextureReference(), 1);
-    
-    ofxNDBillboardRect(0, 0, userFbo.getWidth(), userFbo.getHeight(), depthTex.getWidth(), depthTex.getHeight());
-    
-    gaussianBlurShader.end();
-    
     userFbo.end();
+    
+    // ===== blur =====
+    userBlur.apply(userFbo);
 #endif
 }
 
 void ofApplication::drawPoiSprites()
 {
-    float shapeRadius = ofMap(audioHiPSF, 0.0, 1.0, POI_MIN_SCALE_FACTOR*ofGetWidth(), poiMaxScaleFactor*ofGetWidth(), true);
+    float poiLevel = bSyncToBeat ? MAX(audioHiPSF, audioOnsetPulse) : audioHiPSF;
+    float shapeRadius = ofMap(poiLevel, 0.0, 1.0, POI_MIN_SCALE_FACTOR*ofGetWidth(), poiMaxScaleFactor*ofGetWidth(), true);
     
 #ifdef USE_KINECT
-    for (int i=0; i<handPhysics->getNumTrackedHands(); i++)
+    const ofxHandPhysicsFrame & hands = handPhysicsThread->front();
+    for (int i=0; i<hands.numHands; i++)
     {
+        if (!shouldDrawSprite(i, hands.numHands)) continue;
 
-        ofPoint hp = handPhysics->getNormalizedSpritePositionForHand(i);
-        ofPoint hp1 = handPhysics->getNormalizedSpritePositionForHand(i, 1);
+        ofPoint hp = hands.sprites[i].position;
+        ofPoint hp1 = hands.previousPositions[i];
         hp *= ofGetWindowSize();
         hp1 *= ofGetWindowSize();
         
-        ofxHandPhysicsManager::ofxHandPhysicsState physState = handPhysics->getPhysicsStateForHand(i);
-        float spriteVel = physState.spriteVelocity.length();
+        float spriteVel = hands.sprites[i].velocity.length();
         //float drawAlpha = ofMap(spriteVel, 0, 500, 180, 255);
         //ofSetColor(poiSpriteColor.r, poiSpriteColor.g, poiSpriteColor.b, drawAlpha);
 
@@ -478,7 +832,7 @@ void ofApplication::drawPoiSprites()
         
         float dirAngle = ofVec2f(1.0f,0.0f).angle(pDiff);
         
-        ofSetLineWidth(4.0f);
+        ofSetLineWidth(4.0f*pixelScale);
         ofPushMatrix();
         ofTranslate(hp1);
         ofRotate(dirAngle, 0, 0, 1);
@@ -494,17 +848,19 @@ void ofApplication::drawHandSprites()
     float radius = ofMap(audioMidEnergy, 0.1f, 4.0f, 2.0f, HANDS_MAX_SCALE_FACTOR*ofGetWidth(), false);
     
 #ifdef USE_KINECT
-    for (int i=0; i<handPhysics->getNumTrackedHands(); i++)
+    const ofxHandPhysicsFrame & hands = handPhysicsThread->front();
+    for (int i=0; i<hands.numHands; i++)
     {
+        if (!shouldDrawSprite(i, hands.numHands)) continue;
         
-        ofPoint handPos = handPhysics->getPhysicsStateForHand(i).handPositions[0];
+        ofPoint handPos = hands.handPositions[i];
         handPos *= ofGetWindowSize()/ofPoint(640,480);
 #else
     {
         ofPoint handPos = ofGetWindowSize()/2.0f;
 #endif
         if (radius > 4.0f){
-            ofSetLineWidth(3.0f);
+            ofSetLineWidth(3.0f*pixelScale);
             ofPolyline randomShape;
             randomShape.addVertex(ofPoint(0,0));
             for (int s=0; s<4; s++){
@@ -524,6 +880,163 @@ void ofApplication::drawHandSprites()
     }
 }
     
+void ofApplication::drawHandRopes()
+{
+#ifdef USE_KINECT
+    const ofxHandPhysicsFrame & hands = handPhysicsThread->front();
+    unsigned int nVerts = hands.ropeLinks + 1;
+    if (nVerts < 2 || hands.numHands == 0) return;
+    
+    ofSetColor(poiSpriteColorHSB.getOfColor());
+    ofSetLineWidth(2.0f*pixelScale);
+    ofPushMatrix();
+    ofScale(ofGetWidth()/640.0f, ofGetHeight()/480.0f);
+    
+    // straight from the physics' vertex stream, one strip per hand
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, &hands.ropeVertices[0]);
+    for (unsigned int i=0; i<hands.numHands; i++){
+        glDrawArrays(GL_LINE_STRIP, i*nVerts, nVerts);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    
+    ofPopMatrix();
+#endif
+}
+    
+void ofApplication::updateParticles()
+{
+    float dt = ofGetLastFrameTime();
+    
+    // keep the pool running after the flag goes off so the last particles can fade
+    if (bDrawParticles){
+        
+        // louder mids make bigger particles, hi-hat-like transients puff them up further
+        float size = ofMap(audioMidEnergy, 0.1f, 4.0f, 3.0f, 24.0f, true)*(1.0f + audioHiPSF);
+        
+#ifdef USE_KINECT
+        const ofxHandPhysicsManager::SpriteSample * sprites = handPhysicsThread->front().sprites;
+        unsigned int nSprites = handPhysicsThread->front().numHands;
+        
+        // a pair of hands' worth of particles, shared out over however many joints drive sprites,
+        // and none while the pool is over the quality level's share
+        float budget = 2.0f/MAX(nSprites, 2u)*spriteBudget;
+        if (handParticles.getNumParticles() > MAX_PARTICLES*spriteBudget) budget = 0.0f;
+        for (unsigned int i=0; i<nSprites; i++)
+        {
+            ofVec2f position = sprites[i].position*ofGetWindowSize();
+            ofVec2f velocity = sprites[i].velocity*ofVec2f(ofGetWidth()/640.0f, ofGetHeight()/480.0f);
+#else
+        {
+            int i = 0;
+            float budget = spriteBudget;
+            ofVec2f position = (ofGetWindowSize()/2.0f) + ofPoint(cosf(elapsedPhase/2.0f), sinf(elapsedPhase/2.0f))*100.0f;
+            ofVec2f velocity = ofVec2f(-sinf(elapsedPhase/2.0f), cosf(elapsedPhase/2.0f))*100.0f*M_PI;
+#endif
+            // spawn rate follows the sprite's speed; whole particles only, the rest carries over
+            float rate = ofMap(velocity.length(), 0.0f, PARTICLES_FULL_VELOCITY, 0.0f, PARTICLES_MAX_EMIT_RATE, true)*budget;
+            particleEmitAccumulator[i] += rate*dt;
+            unsigned int count = (unsigned int)particleEmitAccumulator[i];
+            particleEmitAccumulator[i] -= count;
+            
+            handParticles.emit(count, position, velocity*0.3f, 4.0f, 120.0f, size, 1.5f);
+        }
+    }
+    
+    handParticles.update(dt, particleParameters);
+}
+
+void ofApplication::updateQuality()
+{
+    // the interval shows missed frames, the busy time how much room is left
+    if (!bGovernQuality) return;
+    if (qualityGovernor.update(ofGetLastFrameTime()*1000.0f, lastFrameMicros/1000.0f, ofGetLastFrameTime())){
+        applyQualityLevel();
+    }
+}
+
+void ofApplication::applyQualityLevel()
+{
+    const QualityLevel & level = s_qualityLevels[qualityGovernor.getLevel()];
+    userBlur.setMaxRadius(level.blurRadius);
+    spriteBudget = level.spriteBudget;
+    
+    // the trails start over at a new resolution, so only reallocate when it changes
+    if (level.trailsResolution != trailsResolution){
+        trailsResolution = level.trailsResolution;
+        allocateTrails();
+        logRenderTargets();
+    }
+    
+    if (!oscOutHost.empty()){
+        ofxOscMessage m;
+        m.setAddress("/oF/quality");
+        m.addFloatArg(qualityGovernor.getLevel()/(float)(NUM_QUALITY_LEVELS - 1));
+        oscOut.sendMessage(m);
+    }
+}
+
+bool ofApplication::shouldDrawSprite(unsigned int index, unsigned int numSprites)
+{
+    // an even spread of the budgeted count, so every user keeps some
+    unsigned int budgeted = MAX(2u, (unsigned int)ceilf(numSprites*spriteBudget));
+    if (budgeted >= numSprites) return true;
+    return (index + 1)*budgeted/numSprites > index*budgeted/numSprites;
+}
+
+void ofApplication::updateGestures()
+{
+#ifdef USE_KINECT
+    // hand joints only; elbows and knees trace swipes all night
+    const ofxHandPhysicsFrame & hands = handPhysicsThread->front();
+    unsigned long long matchStart = ofGetElapsedTimeMicros();
+    handGestures.beginFrame(hands.time);
+    for (unsigned int i=0; i<hands.numHands; i++){
+        ofxHandTrackingJoint joint = hands.sprites[i].joint;
+        if (joint != TRACKING_JOINT_HAND && joint != TRACKING_JOINT_LEFT_HAND && joint != TRACKING_JOINT_RIGHT_HAND) continue;
+        handGestures.addPosition(hands.sprites[i].id*NUM_TRACKING_JOINTS + joint, hands.handPositions[i]);
+    }
+    handGestures.endFrame();
+    gestureMicros = ofGetElapsedTimeMicros() - matchStart;
+    
+    ofxHandGestureRecognizer::Gesture gesture;
+    while (handGestures.getNextGesture(gesture)){
+        lastGesture = gesture.name;
+        ofLog(OF_LOG_VERBOSE, "Gesture: " + gesture.name + " (" + ofToString(gesture.score, 2) + ")");
+        if (!bGestures) continue;
+        
+        if (gesture.name == "circle cw")
+            bDrawParticles = !bDrawParticles;
+        else if (gesture.name == "circle ccw")
+            bDrawRopes = !bDrawRopes;
+        else if (gesture.name == "swipe left" || gesture.name == "swipe right")
+            bDrawPoi = !bDrawPoi;
+        else if (gesture.name == "swipe up")
+            bDrawHands = !bDrawHands;
+        else if (gesture.name == "swipe down")
+            bDrawUserOutline = !bDrawUserOutline;
+        else if (gesture.name == "zigzag")
+            strobeIntervalMs = strobeIntervalMs > 0.0f ? 0.0f : 100.0f;
+        else if (gesture.name == "v")
+            bSyncToBeat = !bSyncToBeat;
+    }
+#endif
+}
+    
+void ofApplication::drawParticles()
+{
+    ofEnableBlendMode(OF_BLENDMODE_ADD);
+    ofColor color = particleColorHSB.getOfColor();
+    
+    particleShader.begin();
+    particleShader.setUniform1f("sizeScale", pixelScale);
+    particleShader.setUniform4f("color", color.r/255.0f, color.g/255.0f, color.b/255.0f, color.a/255.0f);
+    handParticles.draw();
+    particleShader.end();
+    
+    ofDisableBlendMode();
+}
+    
 void ofApplication::drawUserOutline()
 {
 #ifdef USE_KINECT
@@ -558,7 +1071,7 @@ void ofApplication::drawTouches()
             }
         }
         
-        ofSetLineWidth(3.0f);
+        ofSetLineWidth(3.0f*pixelScale);
         ofSetColor(ofFloatColor(1.0f - bgBrightnessFade));
         touchLine.draw();
     }
@@ -573,92 +1086,141 @@ void ofApplication::processOscMessages()
         ofxOscMessage m;
         oscIn.getNextMessage(&m);
         
-        string a = m.getAddress();
-        
-        // ------ FLAGS/SWITCHES -------
-        if (a == "/oF/drawUser/")
-        {
-            bDrawUserOutline = m.getArgAsFloat(0) != 0.0f;
-        }
-        else if (a == "/of/drawUserTrails")
-        {
-            bTrailUserOutline = m.getArgAsFloat(0) != 0.0f;
-        }
-        else if (a == "/oF/drawPoi")
-        {
-            bDrawPoi = m.getArgAsFloat(0) != 0.0f;
-        }
-        else if (a == "/oF/drawPoiTrails")
-        {
-            bTrailPoi = m.getArgAsFloat(0) != 0.0f;
-        }
-        
-        // ------- BACKGROUND ---------
-        else if (a == "/oF/bgBrightFade")
-        {
-            bgBrightnessFade = m.getArgAsFloat(0);
-        }
-        else if (a == "/oF/bgSpotSize")
-        {
-            bgSpotRadius = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 1.0f, ofGetHeight(), true);
-        }
-        
-        // ------- USER OUTLINE -------
-        else if (a == "/oF/drawUser")
-        {
-            bDrawUserOutline = m.getArgAsFloat(0) != 0.0f;
-        }
-        else if (a == "/oF/drawUserTrails")
-        {
-            bTrailUserOutline = m.getArgAsFloat(0) != 0.0f;
-        }
-        
-        // -------- POI --------
-        else if (a == "/oF/poiHue")
-        {
-            poiSpriteColorHSB.h = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 0.0f, 254.0f, true);
-        }
-        
-        // ------- TOUCH PAD ------
-        else if (a.find("/oF/multiPad/") != string::npos)
-        {
-            handleTouchPadMessage(m);
-        }
-        
-        // ------- EFFECTS ------
-        
-        else if (a == "/oF/strobeRate")
-        {
-            strobeIntervalMs = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 10.0f, 250.0f, true);
-        }
-        else if (a == "/oF/trailVelocity")
-        {
-            // swap X and Y from touchOSC in landscape
-            trailVelocity.set(ofVec3f(m.getArgAsFloat(1),m.getArgAsFloat(0))*300.0f);
-        }
-        else if (a == "/oF/trailZoom")
-        {
-            float oscv = m.getArgAsFloat(0);
-            trailZoom = powf(fabs(oscv), 3.0f) * (oscv >= 0.0f ? 1.0f : -1.0f) * 10.0f;
-        }
-        else if (a == "/oF/trailAlphaFade")
-        {
-            trailAlphaDecay = toOnePoleTC(m.getArgAsFloat(0), 10, 10000);
-        }
-        else if (a == "/oF/trailColorFade")
-        {
-            trailColorDecay = toOnePoleTC(m.getArgAsFloat(0), 10, 10000);
-        }
-        else if (a == "/oF/trailMinAlpha")
-        {
-            trailMinAlpha = ofMap((float)m.getArgAsFloat(0), 0.0f, 1.0f, 0.02f, 0.15f);
-        }
-        
-        // ------- AUDIO SENSITIVITY ------
-        else if (a == "/oF/audioSensitivity")
-        {
-            audioSensitivity = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 0.5f, 2.0f, true);
+        // new controller: tell it where quality is
+        if (m.getRemoteIp() != oscOutHost){
+            oscOutHost = m.getRemoteIp();
+            oscOut.setup(oscOutHost, s_oscReplyPort);
+            applyQualityLevel();
         }
+        handleOscMessage(m);
+    }
+}
+
+void ofApplication::handleOscMessage(ofxOscMessage &m)
+{
+    string a = m.getAddress();
+    
+    // ------ FLAGS/SWITCHES -------
+    if (a == "/oF/drawUser/")
+    {
+        bDrawUserOutline = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/of/drawUserTrails")
+    {
+        bTrailUserOutline = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/drawPoi")
+    {
+        bDrawPoi = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/drawPoiTrails")
+    {
+        bTrailPoi = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/drawParticles")
+    {
+        bDrawParticles = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/drawParticleTrails")
+    {
+        bTrailParticles = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/gestures")
+    {
+        bGestures = m.getArgAsFloat(0) != 0.0f;
+    }
+    
+    // ------- QUALITY ------
+    else if (a == "/oF/governor")
+    {
+        bGovernQuality = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/quality")
+    {
+        // 0-1 over the levels; picking one turns the governor off
+        bGovernQuality = false;
+        qualityGovernor.setLevel(roundf(ofClamp(m.getArgAsFloat(0), 0.0f, 1.0f)*(NUM_QUALITY_LEVELS - 1)));
+        applyQualityLevel();
+    }
+    
+    // ------- BACKGROUND ---------
+    else if (a == "/oF/bgBrightFade")
+    {
+        bgBrightnessFade = m.getArgAsFloat(0);
+    }
+    else if (a == "/oF/bgSpotSize")
+    {
+        bgSpotRadius = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 1.0f, ofGetHeight(), true);
+    }
+    
+    // ------- USER OUTLINE -------
+    else if (a == "/oF/drawUser")
+    {
+        bDrawUserOutline = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/drawUserTrails")
+    {
+        bTrailUserOutline = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/userBlur")
+    {
+        // the pyramid keeps wide blurs about as cheap as narrow ones
+        userBlur.setSigma(ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 0.0f, 24.0f, true));
+    }
+    else if (a == "/oF/userBlurPyramid")
+    {
+        userBlur.setUsePyramid(m.getArgAsFloat(0) != 0.0f);
+    }
+    
+    // -------- POI --------
+    else if (a == "/oF/poiHue")
+    {
+        poiSpriteColorHSB.h = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 0.0f, 254.0f, true);
+    }
+    
+    // ------- TOUCH PAD ------
+    else if (a.find("/oF/multiPad/") != string::npos)
+    {
+        handleTouchPadMessage(m);
+    }
+    
+    // ------- EFFECTS ------
+    
+    else if (a == "/oF/strobeRate")
+    {
+        strobeIntervalMs = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 10.0f, 250.0f, true);
+    }
+    else if (a == "/oF/beatSync")
+    {
+        bSyncToBeat = m.getArgAsFloat(0) != 0.0f;
+    }
+    else if (a == "/oF/trailVelocity")
+    {
+        // swap X and Y from touchOSC in landscape
+        trailVelocity.set(ofVec3f(m.getArgAsFloat(1),m.getArgAsFloat(0))*300.0f);
+    }
+    else if (a == "/oF/trailZoom")
+    {
+        float oscv = m.getArgAsFloat(0);
+        trailZoom = powf(fabs(oscv), 3.0f) * (oscv >= 0.0f ? 1.0f : -1.0f) * 10.0f;
+    }
+    else if (a == "/oF/trailAlphaFade")
+    {
+        trailAlphaDecay = toOnePoleTC(m.getArgAsFloat(0), 10, 10000);
+    }
+    else if (a == "/oF/trailColorFade")
+    {
+        trailColorDecay = toOnePoleTC(m.getArgAsFloat(0), 10, 10000);
+    }
+    else if (a == "/oF/trailMinAlpha")
+    {
+        trailMinAlpha = ofMap((float)m.getArgAsFloat(0), 0.0f, 1.0f, 0.02f, 0.15f);
+    }
+    
+    // ------- AUDIO SENSITIVITY ------
+    else if (a == "/oF/audioSensitivity")
+    {
+        audioSensitivity = ofMap(m.getArgAsFloat(0), 0.0f, 1.0f, 0.5f, 2.0f, true);
     }
 }
 
@@ -691,6 +1253,53 @@ void ofApplication::handleTouchPadMessage(ofxOscMessage &m)
         }
     }
 }
+
+void ofApplication::processInputScript(float time)
+{
+    // scripted input goes through the same handlers as the real thing
+    inputScript.update(time);
+    ofxNDInputScript::Event event;
+    while (inputScript.getNextEvent(event)){
+        if (event.type == INPUT_SCRIPT_KEY){
+            keyPressed(event.key);
+        }
+        else if (event.type == INPUT_SCRIPT_OSC){
+            ofxOscMessage m;
+            m.setAddress(event.address);
+            for (unsigned int i=0; i<event.args.size(); i++){
+                m.addFloatArg(event.args[i]);
+            }
+            handleOscMessage(m);
+        }
+        else if (event.type == INPUT_SCRIPT_MIDI){
+            ofxMidiMessage msg;
+            msg.status = MIDI_CONTROL_CHANGE;
+            msg.control = (int)event.args[0];
+            msg.value = (int)event.args[1];
+            newMidiMessage(msg);
+        }
+    }
+}
+
+void ofApplication::feedAudioFile(unsigned long long nowMicros)
+{
+    // whole buffers up to now, as a sound stream would have delivered them; silence without a file or past its end
+    const ofxAudioAnalyzer::Settings & settings = mainAnalyzer->getSettings();
+    unsigned int nChannels = audioFile.getNumChannels() > 0 ? audioFile.getNumChannels() : 2;
+    unsigned long long dueFrames = nowMicros*settings.sampleRate/1000000;
+    
+    while (audioFramesFed + settings.bufferSize <= dueFrames){
+        audioBlock.assign(settings.bufferSize*nChannels, 0.0f);
+        if (audioFile.getNumChannels() > 0) audioFile.read(&audioBlock[0], settings.bufferSize);
+        mainAnalyzer->process(&audioBlock[0], settings.bufferSize, nChannels);
+        audioFramesFed += settings.bufferSize;
+    }
+}
+
+void ofApplication::readMainFbo(ofPixels & pixels)
+{
+    mainFbo.readToPixels(pixels);
+}
     
 //--------------------------------------------------------------
 void ofApplication::keyPressed(int key){
@@ -700,13 +1309,43 @@ void ofApplication::keyPressed(int key){
 #ifdef USE_KINECT
         case OF_KEY_UP:
             kinectAngle = CLAMP(kinectAngle + 1, -30, 30);
-            kinectDriver.setTiltAngle(kinectAngle);
+            if (bKinectDevice) kinectDriver.setTiltAngle(kinectAngle);
             break;
             
         case OF_KEY_DOWN:
             kinectAngle = CLAMP(kinectAngle - 1, -30, 30);
-            kinectDriver.setTiltAngle(kinectAngle);
+            if (bKinectDevice) kinectDriver.setTiltAngle(kinectAngle);
+            break;
+            
+        case 'r':
+            bDrawRopes = !bDrawRopes;
+            break;
+            
+        case 't':
+            handPhysicsThread->setThreaded(!handPhysicsThread->isThreaded());
             break;
+            
+        case 'g':
+            bGestures = !bGestures;
+            break;
+            
+        case 'f':
+            handPhysicsThread->finish();
+            handPhysics->filterType = (ofxHandFilterType)((handPhysics->filterType + 1) % NUM_HAND_FILTER_TYPES);
+            break;
+            
+#ifdef USE_USER_TRACKING
+        case 'j':
+            // hands -> arms -> whole skeleton
+            handPhysicsThread->finish();
+            if (handPhysics->getJointSet() == TRACKING_JOINTS_HANDS)
+                handPhysics->setJointSet(TRACKING_JOINTS_ARMS);
+            else if (handPhysics->getJointSet() == TRACKING_JOINTS_ARMS)
+                handPhysics->setJointSet(TRACKING_JOINTS_USER);
+            else
+                handPhysics->setJointSet(TRACKING_JOINTS_HANDS);
+            break;
+#endif
 #endif
             
         case '=':
@@ -717,6 +1356,28 @@ void ofApplication::keyPressed(int key){
             audioSensitivity = CLAMP(audioSensitivity*0.9f, 0.5f, 4.0f);
             break;
             
+        case 'p':
+            bDrawParticles = !bDrawParticles;
+            break;
+            
+        case 'q':
+            bGovernQuality = !bGovernQuality;
+            break;
+            
+        case 'b':
+        {
+            // trails precision, high to low; the trails start over
+            static const int formats[] = { GL_RGBA32F_ARB, GL_RGBA16F_ARB, GL_RGB10_A2, GL_RGBA8 };
+            int next = 0;
+            for (int i=0; i<4; i++){
+                if (formats[i] == trailsFormat) next = (i + 1) % 4;
+            }
+            trailsFormat = formats[next];
+            allocateTrails();
+            logRenderTargets();
+            break;
+        }
+            
         case 'd':
             debugMode = !debugMode;
             midiIn.setVerbose(debugMode);
@@ -808,6 +1469,14 @@ void ofApplication::newMidiMessage(ofxMidiMessage& msg)
             bTrailPoi = msg.value >= 64;
             break;
             
+        case 7:
+            bDrawParticles = msg.value >= 64;
+            break;
+            
+        case 8:
+            bTrailParticles = msg.value >= 64;
+            break;
+            
             
         // ----- BG + GRADIENT -----
         // Colors done this way because ofColor inherently resets Hue/Sat when reaching full black/white
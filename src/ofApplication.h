@@ -7,8 +7,20 @@
 #include "ofxHardwareDriver.h"
 #include "ofxOpenCv.h"
 #include "ofxAudioAnalyzer.h"
+#include "ofxMultiChannelAudioAnalyzer.h"
 #include "ofxHandPhysics.h"
+#include "ofxHandPhysicsThread.h"
+#include "ofxHandGestureRecognizer.h"
+#include "ofxOpenNITrackingSource.h"
+#include "ofxRecordedTrackingSource.h"
+#include "ofxSyntheticTrackingSource.h"
 #include "ofxNDGraphicsUtils.h"
+#include "ofxNDParticleSystem.h"
+#include "ofxNDGaussianBlur.h"
+#include "ofxNDQualityGovernor.h"
+#include "ofxNDInputScript.h"
+#include "ofxNDClock.h"
+#include "ofxAudioAnalyzerFileRunner.h"
 #include <map>
 
 // ================================
@@ -20,9 +32,28 @@
 #define USE_USER_TRACKING
 
 extern void ofApplicationSetAudioInputDeviceId(int deviceId);
+extern void ofApplicationSetAudioInputChannels(int nChannels);
 extern void ofApplicationSetMidiInputDeviceId(int deviceId);
 extern void ofApplicationSetOSCListenPort(int listenPort);
 
+// Trails buffer color format (GL_RGBA32F_ARB, GL_RGBA16F_ARB, GL_RGB10_A2 or GL_RGBA8;
+// fixed point formats are dithered) and size relative to the window (overscan, >= 1)
+extern void ofApplicationSetTrailsFormat(int internalFormat);
+extern void ofApplicationSetTrailsScale(float scale);
+
+// Quality level 0 (cheapest) - 4, or -1 to let the governor hold the frame rate (the
+// default, except offline where it's 4). Levels are sent to OSC clients on replyPort.
+extern void ofApplicationSetQualityLevel(int level);
+extern void ofApplicationSetOSCReplyPort(int replyPort);
+
+// Offline runs (ofxNDClock simulated, e.g. under ofxHeadlessWindow) open no devices:
+// audio comes from the input file (silence without one), hands from the tracking
+// recording ("synthetic" for generated users), and control only from the script.
+extern void ofApplicationSetRandomSeed(unsigned int seed);
+extern void ofApplicationSetInputScript(const string & path);
+extern void ofApplicationSetTrackingRecording(const string & path);
+extern void ofApplicationSetAudioInputFile(const string & path);
+
 class ofApplication : public ofBaseApp, public ofxMidiListener {
 	public:
     
@@ -47,61 +78,115 @@ class ofApplication : public ofBaseApp, public ofxMidiListener {
         // midi events
         void newMidiMessage(ofxMidiMessage& msg);
     
+        // the last frame's scene, before the background and HUD
+        void readMainFbo(ofPixels & pixels);
+    
     
     private:
 
         // osc events
         void processOscMessages();
+        void handleOscMessage(ofxOscMessage &m);
         void handleTouchPadMessage(ofxOscMessage &m);
     
+        // scripted input, offline audio
+        void processInputScript(float time);
+        void feedAudioFile(unsigned long long nowMicros);
+    
         // drawing
         void beginTrails();
         void endTrails();
+        void allocateTrails();
+        void logRenderTargets();
+    
+        // quality
+        void updateQuality();
+        void applyQualityLevel();
+        bool shouldDrawSprite(unsigned int index, unsigned int numSprites);
         
         void updateUserOutline();
+        void updateParticles();
+        void updateGestures();
         
         void drawTrails();
         void drawPoiSprites();
         void drawHandSprites();
+        void drawHandRopes();
+        void drawParticles();
         void drawUserOutline();
         void drawTouches();
     
         // openGL
         ofFbo           mainFbo;
-        ofFbo           trailsFbo;
+        ofFbo           trailsFbo;          // two attachments, ping-ponged
+        int             trailsWriteBuffer;  // this frame's trails; the other holds last frame's
+        int             trailsFormat;
+        float           trailsScale;
+        float           trailsResolution;   // of the overscanned window size, from the quality level
+        float           pixelScale;         // for point sizes and line widths, which the matrix doesn't scale:
+                                            // trailsResolution while drawing into the trails, else 1
         ofFbo           userFbo;
     
         ofShader        trailsShader;
-        ofShader        gaussianBlurShader;
+        ofxNDGaussianBlur   userBlur;
         ofShader        userMaskShader;
+        ofShader        particleShader;
     
         ofPolyline          touchLine;
         map<int,ofVec2f>    touchMap;
     
         // midi
         ofxMidiIn       midiIn;
+        ofxNDInputScript    inputScript;
     
         // osc
         ofxOscReceiver  oscIn;
+        ofxOscSender    oscOut;         // back to whoever last sent us a message
+        string          oscOutHost;
     
         // audio
         ofxAudioAnalyzer            audioAnalyzer;
+        ofxMultiChannelAudioAnalyzer    channelAnalyzer;    // only used with more than 2 input channels
+        ofxAudioAnalyzer *          mainAnalyzer;           // ch 1+2 mix, drives the visuals
+        ofxAudioAnalyzer::RegionFeatures    audioFeatures;
+        vector<ofxAudioAnalyzer::RegionFeatures>    channelFeatures;    // one per input channel
         float                       audioSensitivity;
         float                       audioLowEnergy;
         float                       audioMidEnergy;
         float                       audioHiEnergy;
         float                       audioHiPSF;
+        float                       audioOnsetPulse;    // jumps to onset strength, decays per frame
+        float                       audioBeatPhase;
+        bool                        bOfflineAudio;      // fed from audioFile by the clock, no stream
+        ofxWavFileReader            audioFile;
+        unsigned long long          audioFramesFed;
+        vector<float>               audioBlock;
     
         // kinect
 #ifdef USE_KINECT
         ofxOpenNI                   kinectOpenNI;
         ofxHardwareDriver           kinectDriver;
+        ofxHandTrackingSource *     trackingSource;
         ofxHandPhysicsManager *     handPhysics;
+        ofxHandPhysicsThread *      handPhysicsThread;  // steps handPhysics, draw from its front()
+        bool                        bKinectDevice;      // false when tracking comes from a recording
+        ofxHandGestureRecognizer    handGestures;       // hand joints' trajectories, switch the scene when on
+        string                      lastGesture;
+        float                       gestureMicros;
+        float                       deviceMicros;       // kinectOpenNI.update(), left on the render thread
         int                         kinectAngle;
 #endif
         // renderer state
         float       elapsedPhase;
         bool        debugMode;
+        unsigned long long  frameStartMicros;
+        float       frameMicros;        // update() + draw() on this thread, smoothed
+        float       lastFrameMicros;    // same, last frame only
+    
+        // QUALITY
+        ofxNDQualityGovernor    qualityGovernor;
+        bool        bGovernQuality;
+        float       spriteBudget;       // share of sprites and particles drawn, 0-1
     
     
     
@@ -114,10 +199,17 @@ class ofApplication : public ofBaseApp, public ofxMidiListener {
         bool        bTrailHands;
         bool        bDrawPoi;
         bool        bTrailPoi;
+        bool        bDrawRopes;
+        bool        bTrailRopes;
+        bool        bDrawParticles;
+        bool        bTrailParticles;
+        bool        bGestures;
     
         // FREEZE FRAME
         float       strobeIntervalMs;
         float       strobeLastDrawTime;
+        bool        bSyncToBeat;        // strobe on beat subdivisions, poi pulse on onsets
+        int         strobeLastBeatSlot;
     
         // CIRCULAR GRADIENT + BACKGROUND
         float       bgBrightnessFade;
@@ -141,6 +233,12 @@ class ofApplication : public ofBaseApp, public ofxMidiListener {
     
         // HANDS
         ofxNDHSBColor   handsColorHSB;
+    
+        // PARTICLES
+        ofxNDParticleSystem     handParticles;
+        ofxNDParticleSystem::Parameters particleParameters;
+        float                   particleEmitAccumulator[MAX_TRACKED_JOINTS];     // fractional particles owed, per hand
+        ofxNDHSBColor           particleColorHSB;
 
     
 };
@@ -0,0 +1,463 @@
+//
+//  ofxHandGestureRecognizer.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/17/12.
+//
+//
+
+#include "ofxHandGestureRecognizer.h"
+#include <algorithm>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define GESTURES_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GESTURES_NEON
+#endif
+
+// A window whose rms radius is under this fraction of its path length is the hand
+// going back and forth over the same spot (jitter, sway), not a shape
+#define GESTURE_MIN_SPREAD      0.1f
+
+ofxHandGestureRecognizer::ofxHandGestureRecognizer() :
+    minScore(0.92f),
+    maxDuration(1.5f),
+    pauseTime(0.1f),
+    vectorized(true),
+    _numScales(0),
+    _time(0.0f),
+    _numTracks(0),
+    _cursor(0),
+    _nextGesture(0)
+{
+    _tracks.resize(MAX_GESTURE_TRACKS);
+    _templateX.allocate(MAX_GESTURE_TEMPLATES*GESTURE_WINDOW_POINTS);
+    _templateY.allocate(MAX_GESTURE_TEMPLATES*GESTURE_WINDOW_POINTS);
+
+    float spacings[] = { 6.0f, 12.0f, 24.0f };
+    setScales(spacings, 3);
+}
+
+#pragma mark - Templates
+
+void ofxHandGestureRecognizer::resample(const vector<ofPoint> &path, unsigned int n, vector<ofVec2f> &points)
+{
+    points.clear();
+    float length = 0.0f;
+    for (unsigned int i=1; i<path.size(); i++){
+        length += ofVec2f(path[i] - path[i-1]).length();
+    }
+    if (path.size() < 2 || length <= 0.0f) return;
+
+    // $1's resampling: walk the path dropping a point every interval
+    float interval = length/(n - 1);
+    float travelled = 0.0f;
+    ofVec2f from = path[0];
+    points.push_back(from);
+    for (unsigned int i=1; i<path.size() && points.size() < n; i++){
+        ofVec2f to = path[i];
+        float segment = (to - from).length();
+        while (travelled + segment >= interval && points.size() < n){
+            from += (to - from)*((interval - travelled)/segment);
+            points.push_back(from);
+            segment = (to - from).length();
+            travelled = 0.0f;
+        }
+        travelled += segment;
+        from = to;
+    }
+
+    // rounding can leave the last point short
+    while (points.size() < n){
+        points.push_back(path.back());
+    }
+}
+
+bool ofxHandGestureRecognizer::addTemplate(const string &name, const vector<ofPoint> &path, float maxRotation)
+{
+    if (_names.size() >= MAX_GESTURE_TEMPLATES) return false;
+
+    vector<ofVec2f> points;
+    resample(path, GESTURE_WINDOW_POINTS, points);
+    if (points.empty()) return false;
+
+    ofVec2f center;
+    for (unsigned int i=0; i<points.size(); i++){
+        center += points[i];
+    }
+    center /= (float)points.size();
+
+    float squares = 0.0f;
+    for (unsigned int i=0; i<points.size(); i++){
+        points[i] -= center;
+        squares += points[i].lengthSquared();
+    }
+    if (squares <= 0.0f) return false;
+
+    float scale = 1.0f/sqrtf(squares);
+    unsigned int offset = _names.size()*GESTURE_WINDOW_POINTS;
+    for (unsigned int i=0; i<points.size(); i++){
+        _templateX[offset + i] = points[i].x*scale;
+        _templateY[offset + i] = points[i].y*scale;
+    }
+    _names.push_back(name);
+    _maxRotation.push_back(maxRotation);
+    return true;
+}
+
+void ofxHandGestureRecognizer::clearTemplates()
+{
+    _names.clear();
+    _maxRotation.clear();
+}
+
+void ofxHandGestureRecognizer::addDefaultTemplates()
+{
+    // y is down: increasing angles turn clockwise on screen
+    vector<ofPoint> clockwise, counterClockwise;
+    for (int i=0; i<=64; i++){
+        float angle = TWO_PI*i/64.0f;
+        clockwise.push_back(ofPoint(cosf(angle), sinf(angle)));
+        counterClockwise.push_back(ofPoint(cosf(angle), -sinf(angle)));
+    }
+    addTemplate("circle cw", clockwise);
+    addTemplate("circle ccw", counterClockwise);
+
+    // the rest mean something only the right way up
+    vector<ofPoint> path;
+    path.push_back(ofPoint(0, 0));
+    path.push_back(ofPoint(1, 0));
+    addTemplate("swipe right", path, PI/6.0f);
+
+    path[0] = ofPoint(1, 0);
+    path[1] = ofPoint(0, 0);
+    addTemplate("swipe left", path, PI/6.0f);
+
+    path[0] = ofPoint(0, 1);
+    path[1] = ofPoint(0, 0);
+    addTemplate("swipe up", path, PI/6.0f);
+
+    path[0] = ofPoint(0, 0);
+    path[1] = ofPoint(0, 1);
+    addTemplate("swipe down", path, PI/6.0f);
+
+    path.clear();
+    for (int i=0; i<5; i++){
+        path.push_back(ofPoint(i, i % 2));
+    }
+    addTemplate("zigzag", path, PI/6.0f);
+
+    path.clear();
+    path.push_back(ofPoint(0, 0));
+    path.push_back(ofPoint(1, 2));
+    path.push_back(ofPoint(2, 0));
+    addTemplate("v", path, PI/6.0f);
+}
+
+void ofxHandGestureRecognizer::setScales(const float *spacings, unsigned int numScales)
+{
+    _numScales = MIN(numScales, (unsigned int)MAX_GESTURE_SCALES);
+    for (unsigned int s=0; s<_numScales; s++){
+        _spacing[s] = MAX(spacings[s], 0.1f);
+    }
+
+    // smallest first: a held match only gives way to a larger scale
+    std::sort(_spacing, _spacing + _numScales);
+    _numTracks = 0;
+}
+
+#pragma mark - Trajectories
+
+void ofxHandGestureRecognizer::beginFrame(float time)
+{
+    _time = time;
+    _cursor = 0;
+}
+
+void ofxHandGestureRecognizer::addPosition(unsigned int key, const ofPoint &position)
+{
+    // callers usually give the same keys in the same order every frame
+    unsigned int index = _cursor;
+    if (index >= _numTracks || _tracks[index].key != key){
+        for (index = 0; index < _numTracks; index++){
+            if (_tracks[index].key == key) break;
+        }
+    }
+
+    if (index == _numTracks){
+        if (_numTracks == MAX_GESTURE_TRACKS) return;
+        _numTracks++;
+        _tracks[index].key = key;
+        _tracks[index].started = false;
+    }
+
+    Track & track = _tracks[index];
+    track.seen = true;
+    _cursor = index + 1;
+
+    if (!track.started){
+        resetTrack(track, position);
+        track.candidate.held = false;
+        track.usedUntil = -1.0f;
+        track.started = true;
+        return;
+    }
+
+    track.travelled = (ofVec2f(position) - track.position).length();
+    track.position = position;
+    for (unsigned int s=0; s<_numScales; s++){
+        unsigned int added = advance(track.scales[s], _spacing[s], position);
+        if (s == 0 && added > 0) track.lastMoveTime = _time;
+    }
+}
+
+void ofxHandGestureRecognizer::endFrame()
+{
+    unsigned int t = 0;
+    while (t < _numTracks){
+        if (!_tracks[t].seen){
+            _tracks[t] = _tracks[--_numTracks];
+            continue;
+        }
+        _tracks[t].seen = false;
+        match(_tracks[t]);
+        _tracks[t].travelled = 0.0f;
+        t++;
+    }
+}
+
+bool ofxHandGestureRecognizer::getNextGesture(Gesture &gesture)
+{
+    if (_nextGesture >= _gestures.size()){
+        _gestures.clear();
+        _nextGesture = 0;
+        return false;
+    }
+    gesture = _gestures[_nextGesture++];
+    return true;
+}
+
+void ofxHandGestureRecognizer::resetTrack(Track &track, const ofVec2f &position)
+{
+    track.position = position;
+    track.travelled = 0.0f;
+    track.lastMoveTime = _time;
+    for (unsigned int s=0; s<_numScales; s++){
+        resetScale(track.scales[s], position);
+    }
+}
+
+void ofxHandGestureRecognizer::resetScale(Scale &scale, const ofVec2f &position)
+{
+    scale.head = 0;
+    scale.count = 0;
+    scale.sumX = scale.sumY = scale.sumSquares = 0.0;
+    scale.last = position;
+    scale.travelled = 0.0f;
+    pushPoint(scale, position.x, position.y);
+    scale.changed = false;
+}
+
+unsigned int ofxHandGestureRecognizer::advance(Scale &scale, float spacing, const ofVec2f &position)
+{
+    ofVec2f from = scale.last;
+    float segment = (position - from).length();
+
+    // a jump past the whole window (lost and found again) starts over
+    if (scale.travelled + segment > spacing*GESTURE_WINDOW_POINTS){
+        resetScale(scale, position);
+        return 0;
+    }
+
+    unsigned int added = 0;
+    while (scale.travelled + segment >= spacing){
+        from += (position - from)*((spacing - scale.travelled)/segment);
+        pushPoint(scale, from.x, from.y);
+        segment = (position - from).length();
+        scale.travelled = 0.0f;
+        added++;
+    }
+    scale.travelled += segment;
+    scale.last = position;
+    return added;
+}
+
+void ofxHandGestureRecognizer::pushPoint(Scale &scale, float x, float y)
+{
+    unsigned int slot;
+    if (scale.count < GESTURE_WINDOW_POINTS){
+        slot = scale.count++;
+    }
+    else{
+        // the oldest point leaves the window and its sums
+        slot = scale.head;
+        float oldX = scale.x[slot], oldY = scale.y[slot];
+        scale.sumX -= oldX;
+        scale.sumY -= oldY;
+        scale.sumSquares -= (double)oldX*oldX + (double)oldY*oldY;
+        scale.head = (scale.head + 1) % GESTURE_WINDOW_POINTS;
+    }
+
+    scale.x[slot] = scale.x[slot + GESTURE_WINDOW_POINTS] = x;
+    scale.y[slot] = scale.y[slot + GESTURE_WINDOW_POINTS] = y;
+    scale.time[slot] = _time;
+    scale.sumX += x;
+    scale.sumY += y;
+    scale.sumSquares += (double)x*x + (double)y*y;
+    scale.changed = true;
+}
+
+void ofxHandGestureRecognizer::match(Track &track)
+{
+    Candidate & candidate = track.candidate;
+    if (candidate.held){
+        candidate.pathLeft -= track.travelled;
+    }
+
+    for (unsigned int s=0; s<_numScales; s++){
+        Scale & scale = track.scales[s];
+        if (!scale.changed || scale.count < GESTURE_WINDOW_POINTS) continue;
+        scale.changed = false;
+
+        // the newest point is just before head
+        float duration = scale.time[(scale.head + GESTURE_WINDOW_POINTS - 1) % GESTURE_WINDOW_POINTS] - scale.time[scale.head];
+        if (duration > maxDuration || scale.time[scale.head] <= track.usedUntil) continue;
+
+        int t;
+        float windowScore, angle;
+        if (!score(scale, _spacing[s], t, windowScore, angle) || windowScore < minScore) continue;
+
+        // a larger scale takes over (and waits in turn), the same scale only improves
+        if (candidate.held && (s < candidate.scale || (s == candidate.scale && windowScore <= candidate.score))) continue;
+        if (!candidate.held || s > candidate.scale){
+            candidate.pathLeft = _spacing[s]*(GESTURE_WINDOW_POINTS - 1);
+        }
+        candidate.held = true;
+        candidate.templateIndex = t;
+        candidate.scale = s;
+        candidate.score = windowScore;
+        candidate.angle = angle;
+        candidate.center = ofPoint(scale.sumX/GESTURE_WINDOW_POINTS, scale.sumY/GESTURE_WINDOW_POINTS);
+        candidate.size = sqrtf(MAX(scale.sumSquares/GESTURE_WINDOW_POINTS - candidate.center.x*candidate.center.x -
+                                   candidate.center.y*candidate.center.y, 0.0));
+        candidate.time = _time;
+    }
+
+    // nothing bigger can still contain it once the hand has stopped or moved a window on
+    if (candidate.held && (candidate.scale == _numScales - 1 || candidate.pathLeft <= 0.0f ||
+                           _time - track.lastMoveTime >= pauseTime)){
+        commit(track);
+    }
+}
+
+void ofxHandGestureRecognizer::commit(Track &track)
+{
+    const Candidate & candidate = track.candidate;
+
+    Gesture gesture;
+    gesture.name = _names[candidate.templateIndex];
+    gesture.key = track.key;
+    gesture.score = candidate.score;
+    gesture.angle = candidate.angle;
+    gesture.center = candidate.center;
+    gesture.size = candidate.size;
+    gesture.time = candidate.time;
+    _gestures.push_back(gesture);
+
+    // later windows start after this one, but whatever came since can still be the next gesture
+    track.candidate.held = false;
+    track.usedUntil = candidate.time;
+}
+
+bool ofxHandGestureRecognizer::score(const Scale &scale, float spacing, int &bestTemplate, float &bestScore, float &bestAngle)
+{
+    const unsigned int n = GESTURE_WINDOW_POINTS;
+    double cx = scale.sumX/n, cy = scale.sumY/n;
+    float squares = scale.sumSquares - n*(cx*cx + cy*cy);
+
+    float spread = GESTURE_MIN_SPREAD*spacing*(n - 1);
+    if (squares < n*spread*spread) return false;
+    float inverseNorm = 1.0f/sqrtf(squares);
+
+    const float *wx = scale.x + scale.head;
+    const float *wy = scale.y + scale.head;
+    bestTemplate = -1;
+    bestScore = -1.0f;
+
+    for (unsigned int t=0; t<_names.size(); t++){
+        const float *tx = _templateX.data() + t*n;
+        const float *ty = _templateY.data() + t*n;
+
+        // a = sum(template . window), b = sum(template x window), both centered
+        float a = 0.0f, b = 0.0f;
+        bool done = false;
+
+#if defined(GESTURES_SSE)
+        if (vectorized){
+            __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+            __m128 va = _mm_setzero_ps(), vb = _mm_setzero_ps();
+            for (unsigned int i=0; i<n; i+=4){
+                __m128 px = _mm_sub_ps(_mm_loadu_ps(wx + i), vcx);
+                __m128 py = _mm_sub_ps(_mm_loadu_ps(wy + i), vcy);
+                __m128 qx = _mm_load_ps(tx + i);
+                __m128 qy = _mm_load_ps(ty + i);
+                va = _mm_add_ps(va, _mm_add_ps(_mm_mul_ps(qx, px), _mm_mul_ps(qy, py)));
+                vb = _mm_add_ps(vb, _mm_sub_ps(_mm_mul_ps(qx, py), _mm_mul_ps(qy, px)));
+            }
+            float sa[4], sb[4];
+            _mm_storeu_ps(sa, va);
+            _mm_storeu_ps(sb, vb);
+            a = (sa[0] + sa[1]) + (sa[2] + sa[3]);
+            b = (sb[0] + sb[1]) + (sb[2] + sb[3]);
+            done = true;
+        }
+#elif defined(GESTURES_NEON)
+        if (vectorized){
+            float32x4_t vcx = vdupq_n_f32(cx), vcy = vdupq_n_f32(cy);
+            float32x4_t va = vdupq_n_f32(0.0f), vb = vdupq_n_f32(0.0f);
+            for (unsigned int i=0; i<n; i+=4){
+                float32x4_t px = vsubq_f32(vld1q_f32(wx + i), vcx);
+                float32x4_t py = vsubq_f32(vld1q_f32(wy + i), vcy);
+                float32x4_t qx = vld1q_f32(tx + i);
+                float32x4_t qy = vld1q_f32(ty + i);
+                va = vmlaq_f32(vmlaq_f32(va, qx, px), qy, py);
+                vb = vmlsq_f32(vmlaq_f32(vb, qx, py), qy, px);
+            }
+            a = (vgetq_lane_f32(va, 0) + vgetq_lane_f32(va, 1)) + (vgetq_lane_f32(va, 2) + vgetq_lane_f32(va, 3));
+            b = (vgetq_lane_f32(vb, 0) + vgetq_lane_f32(vb, 1)) + (vgetq_lane_f32(vb, 2) + vgetq_lane_f32(vb, 3));
+            done = true;
+        }
+#endif
+
+        if (!done){
+            for (unsigned int i=0; i<n; i++){
+                float px = wx[i] - cx, py = wy[i] - cy;
+                a += tx[i]*px + ty[i]*py;
+                b += tx[i]*py - ty[i]*px;
+            }
+        }
+        a *= inverseNorm;
+        b *= inverseNorm;
+
+        // Protractor: the best rotation is atan(b/a), scoring sqrt(a^2 + b^2);
+        // past the template's limit the limit is the best there is
+        float angle = atan2f(b, a);
+        float similarity;
+        if (fabsf(angle) <= _maxRotation[t]){
+            similarity = sqrtf(a*a + b*b);
+        }
+        else{
+            angle = CLAMP(angle, -_maxRotation[t], _maxRotation[t]);
+            similarity = a*cosf(angle) + b*sinf(angle);
+        }
+
+        if (similarity > bestScore){
+            bestTemplate = t;
+            bestScore = similarity;
+            bestAngle = angle;
+        }
+    }
+    return bestTemplate >= 0;
+}
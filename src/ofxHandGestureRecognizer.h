@@ -0,0 +1,162 @@
+//
+//  ofxHandGestureRecognizer.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/17/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxNDAlignedArray.h"
+
+#define GESTURE_WINDOW_POINTS   32      // resampled points per trajectory window and per template
+#define MAX_GESTURE_TEMPLATES   32
+#define MAX_GESTURE_TRACKS      96      // trajectories followed at once (one per tracked joint)
+#define MAX_GESTURE_SCALES      4
+
+/// Streaming $1-style template matcher on hand trajectories.
+///
+/// Every trajectory is resampled as it arrives into points a fixed path length
+/// apart, once per scale, and the last GESTURE_WINDOW_POINTS of them are matched
+/// against every template once per frame. Matching is Protractor's: the window
+/// and the template are compared as centered, unit-length vectors, with the best
+/// rotation between them in closed form, so a score is two dot products per
+/// template. The window's centroid and length come from running sums, and a
+/// still hand adds no points, so a frame costs at most
+/// trajectories x scales x templates x GESTURE_WINDOW_POINTS, whatever the history.
+///
+/// A gesture is recognized when it fills a window: about GESTURE_WINDOW_POINTS
+/// x spacing of path at one of the scales, traced within maxDuration. A match is
+/// held until the hand pauses or has moved a window further, and a match at a
+/// larger scale replaces it meanwhile - half a zigzag is a swipe until the rest
+/// arrives. Windows reaching back into a recognized one don't count, so one
+/// gesture fires once.
+class ofxHandGestureRecognizer {
+
+public:
+
+    struct Gesture {
+
+        string          name;
+        unsigned int    key;        // the trajectory, as given to addPosition
+        float           score;      // cosine similarity to the template, minScore..1
+        float           angle;      // radians the trajectory is rotated from the template
+        ofPoint         center;     // of the window, in the positions' coordinates
+        float           size;       // rms distance of the window from center
+        float           time;       // of the frame its window completed in (it's reported a little later)
+    };
+
+    ofxHandGestureRecognizer();
+
+    // path in any coordinates (y down like the screen, for the direction of turns), resampled
+    // to GESTURE_WINDOW_POINTS. maxRotation in radians; PI matches any orientation.
+    // false if it's a point or there are MAX_GESTURE_TEMPLATES already.
+    bool addTemplate(const string & name, const vector<ofPoint> & path, float maxRotation = PI);
+    void clearTemplates();
+    unsigned int getNumTemplates() const { return _names.size(); };
+
+    // circles both ways, swipes in four directions, zigzag, "v"
+    void addDefaultTemplates();
+
+    // one scale per resampling spacing (in the positions' units, at most MAX_GESTURE_SCALES);
+    // forgets every trajectory. Default: 6, 12 and 24 (640x480 projective pixels).
+    void setScales(const float * spacings, unsigned int numScales);
+    unsigned int getNumScales() const   { return _numScales; };
+
+    // 0..1, a window must match at least this well (default 0.92)
+    float           minScore;
+
+    // seconds; slower windows are the hand wandering, not a gesture (default 1.5)
+    float           maxDuration;
+
+    // seconds without new points at the smallest scale that end a held match (default 0.1)
+    float           pauseTime;
+
+    // Each frame: beginFrame, one addPosition per trajectory, endFrame. Keys are the
+    // caller's (e.g. id and joint); trajectories not given a position are forgotten.
+    void beginFrame(float time);
+    void addPosition(unsigned int key, const ofPoint & position);
+    void endFrame();
+
+    // recognized gestures in the order they were committed, false when there are none left
+    bool getNextGesture(Gesture & gesture);
+
+    unsigned int getNumTracks() const   { return _numTracks; };
+
+    // false runs the plain scalar loops, for comparison
+    bool            vectorized;
+
+private:
+
+    // Last window of one trajectory at one spacing. Points are mirrored (point i is
+    // stored at i and i+N), so the window is always N contiguous floats from head.
+    struct Scale {
+        float           x[2*GESTURE_WINDOW_POINTS];
+        float           y[2*GESTURE_WINDOW_POINTS];
+        float           time[GESTURE_WINDOW_POINTS];    // when each point was added, not mirrored
+        unsigned int    head;
+        unsigned int    count;
+        double          sumX;
+        double          sumY;
+        double          sumSquares;         // of x*x + y*y
+        ofVec2f         last;               // resampling cursor: last point on the path
+        float           travelled;          // path since the last resampled point
+        bool            changed;            // points added since the last match
+    };
+
+    // best match so far, waiting to see if it's part of something bigger
+    struct Candidate {
+        bool            held;
+        int             templateIndex;
+        unsigned int    scale;
+        float           score;
+        float           angle;
+        ofPoint         center;
+        float           size;
+        float           time;
+        float           pathLeft;           // commit once the hand has moved this much further
+    };
+
+    struct Track {
+        unsigned int    key;
+        bool            seen;
+        bool            started;
+        ofVec2f         position;           // last given
+        float           travelled;          // this frame
+        float           lastMoveTime;       // last point at the smallest scale
+        float           usedUntil;          // points up to here belong to a recognized gesture
+        Candidate       candidate;
+        Scale           scales[MAX_GESTURE_SCALES];
+    };
+
+    void resetTrack(Track & track, const ofVec2f & position);
+    void resetScale(Scale & scale, const ofVec2f & position);
+    unsigned int advance(Scale & scale, float spacing, const ofVec2f & position);
+    void pushPoint(Scale & scale, float x, float y);
+    void match(Track & track);
+    void commit(Track & track);
+
+    // best template for one full window; false if the window is too small to say
+    bool score(const Scale & scale, float spacing, int & bestTemplate, float & bestScore, float & bestAngle);
+
+    static void resample(const vector<ofPoint> & path, unsigned int n, vector<ofVec2f> & points);
+
+    float           _spacing[MAX_GESTURE_SCALES];
+    unsigned int    _numScales;
+    float           _time;
+
+    vector<Track>   _tracks;
+    unsigned int    _numTracks;
+    unsigned int    _cursor;        // where the next key usually is
+
+    // templates, each GESTURE_WINDOW_POINTS floats of x and of y, centered and unit length
+    ofxNDAlignedArray<float>    _templateX;
+    ofxNDAlignedArray<float>    _templateY;
+    vector<string>              _names;
+    vector<float>               _maxRotation;
+
+    vector<Gesture>             _gestures;
+    unsigned int                _nextGesture;
+};
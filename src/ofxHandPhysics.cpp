@@ -9,80 +9,386 @@
 #include "ofxHandPhysics.h"
 #include <algorithm>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define HAND_PHYSICS_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAND_PHYSICS_NEON
+#endif
+
 ofxHandPhysicsManager::ofxHandPhysicsState::ofxHandPhysicsState()
 {
-    handPositions.assign(MAX_POINT_HISTORY, ofPoint());
-    spritePositions.assign(MAX_POINT_HISTORY, ofPoint());
+    handPositions.fill(ofPoint());
+    spritePositions.fill(ofPoint());
     handVelocity = 0.0f;
     spriteVelocity = 0.0f;
+    timeAccumulator = 0.0f;
+    lastUpdateTime = 0.0f;
     isNew = true;
 }
 
-ofxHandPhysicsManager::ofxHandPhysicsManager(ofxOpenNI &openNIDevice, bool useUserGenerator) :
-    _openNIDevice(openNIDevice),
-    _usingUserGenerator(useUserGenerator),
-    _width(0.0f),
-    _height(0.0f),
+ofxHandPhysicsManager::ofxHandPhysicsManager(ofxHandTrackingSource &source) :
+    filterType(HAND_FILTER_ONE_POLE),
+    smoothCoef(0.66f),
+    predictionScale(1.0f),
+    sensorLatency(0.0f),
+    maxPrediction(0.1f),
     physicsEnabled(false),
     spriteMass(1.0f),
     springCoef(100.0f),
-    friction(0.05f),
     restDistance(10.0f),
+    friction(0.05f),
     gravity(ofPoint(0, 1000.0f)),
-    smoothCoef(0.66f)
+    fixedTimeStep(1.0f/240.0f),
+    maxSubSteps(16),
+    ropeIterations(4),
+    _width(0.0f),
+    _height(0.0f),
+    _lastUpdateTime(0.0f),
+    _displayLatency(0.0f),
+    _source(source),
+    _jointSet(TRACKING_JOINTS_HANDS),
+    _stepAccumulator(0.0f),
+    _lastStepTime(-1.0f)
 {
-    if (useUserGenerator){
-        ofAddListener(openNIDevice.userEvent, this, &ofxHandPhysicsManager::userEvent);
+    for (unsigned int h=0; h<MAX_TRACKED_JOINTS; h++){
+        _ropeIsNew[h] = true;
     }
-    else{
-        ofAddListener(openNIDevice.handEvent, this, &ofxHandPhysicsManager::handEvent);
+    
+    ofxNDAlignedArray<float> * arrays[] = {
+        &_handFromX, &_handFromY, &_handToX, &_handToY, &_simX, &_simY,
+        &_previousSimX, &_previousSimY, &_velocityX, &_velocityY, &_accelerationX, &_accelerationY
+    };
+    for (unsigned int a=0; a<sizeof(arrays)/sizeof(arrays[0]); a++){
+        arrays[a]->allocate(MAX_TRACKED_JOINTS);
     }
 }
 
 ofxHandPhysicsManager::~ofxHandPhysicsManager()
 {
-    if (_usingUserGenerator){
-        ofRemoveListener(_openNIDevice.userEvent, this, &ofxHandPhysicsManager::userEvent);
+}
+
+void ofxHandPhysicsManager::update()
+{
+    update(ofGetElapsedTimef());
+}
+
+void ofxHandPhysicsManager::update(float time)
+{
+    _lastUpdateTime = time;
+    _source.update(time);
+    
+    // add/remove hands first so positions below are only read for tracked ids
+    ofxHandTrackingEvent event;
+    while (_source.getNextEvent(event)){
+        trackingEvent(event);
     }
-    else{
-        ofRemoveListener(_openNIDevice.handEvent, this, &ofxHandPhysicsManager::handEvent);
+    
+    // one clock for every sprite (and rope), so they can all step together
+    float dTime = _lastStepTime < 0.0f ? 0.0f : MAX(time - _lastStepTime, 0.0f);
+    _lastStepTime = time;
+    
+    unsigned int nSteps = 1;
+    float dt = dTime;
+    float alpha = 1.0f;
+    if (fixedTimeStep > 0.0f){
+        dt = fixedTimeStep;
+        _stepAccumulator += dTime;
+        nSteps = _stepAccumulator/fixedTimeStep;
+        if (nSteps > maxSubSteps){
+            // long stall: drop the time we can't catch up on rather than spiralling
+            nSteps = maxSubSteps;
+            _stepAccumulator = nSteps*fixedTimeStep;
+        }
+        _stepAccumulator -= nSteps*fixedTimeStep;
+        alpha = _stepAccumulator/fixedTimeStep;
+    }
+    
+    float sampleTime = _source.getSampleTime();
+    if (sampleTime < 0.0f){
+        sampleTime = time;
     }
+    
+    // hands: each joint's new position through its own smoothing/filter. A joint the
+    // source can't see this frame holds where it was.
+    unsigned int nHands = _handSlots.size();
+    bool fresh[MAX_TRACKED_JOINTS];         // (re)started this frame: placed, not stepped
+    for (unsigned int h = 0; h < nHands; h++)
+    {
+        ofxHandPhysicsState & physState = _handState[h];
+        ofPoint rawPosition;
+        bool found = _source.getJointPosition(_handID[h], _handJoint[h], rawPosition);
+        
+        fresh[h] = physState.isNew;
+        if (physState.isNew){
+            if (found){
+                resetPhysState(physState, rawPosition, time, sampleTime);
+            }
+            _simX[h] = _previousSimX[h] = _handFromX[h] = _handToX[h] = physState.simPosition.x;
+            _simY[h] = _previousSimY[h] = _handFromY[h] = _handToY[h] = physState.simPosition.y;
+            _velocityX[h] = _velocityY[h] = 0.0f;
+            _accelerationX[h] = _accelerationY[h] = 0.0f;
+        }
+        else{
+            _handFromX[h] = physState.handPositions[0].x;
+            _handFromY[h] = physState.handPositions[0].y;
+            if (found){
+                updateHandPosition(physState, rawPosition, time, sampleTime);
+            }
+            else{
+                physState.handVelocity = 0.0f;
+                physState.handPositions.push(physState.handPositions[0]);
+                physState.lastUpdateTime = time;
+            }
+            _handToX[h] = physState.handPositions[0].x;
+            _handToY[h] = physState.handPositions[0].y;
+        }
+        _handPosition[h] = physState.handPositions[0];
+    }
+    
+    // sprites: every step is one pass over all of them
+    if (physicsEnabled){
+        float damping = powf(1.0f - friction, dt*60.0f);
+        for (unsigned int s=0; s<nSteps; s++){
+            stepSprites(nHands, stepFraction(s, nSteps, dTime, _stepAccumulator), dt, damping);
+        }
+    }
+    
+    for (unsigned int h = 0; h < nHands; h++)
+    {
+        ofxHandPhysicsState & physState = _handState[h];
+        
+        if (!physicsEnabled || fresh[h]){
+            // the sprite is the hand (and a new one starts there at rest)
+            ofVec2f velocity = fresh[h] ? ofVec2f() : physState.handVelocity;
+            _simX[h] = _previousSimX[h] = _handToX[h];
+            _simY[h] = _previousSimY[h] = _handToY[h];
+            _velocityX[h] = velocity.x;
+            _velocityY[h] = velocity.y;
+            _accelerationX[h] = _accelerationY[h] = 0.0f;
+            if (physState.isNew) continue;
+        }
+        
+        physState.previousSimPosition.set(_previousSimX[h], _previousSimY[h], physState.previousSimPosition.z);
+        physState.simPosition.set(_simX[h], _simY[h], physState.simPosition.z);
+        physState.spriteVelocity.set(_velocityX[h], _velocityY[h]);
+        physState.spriteAcceleration.set(_accelerationX[h], _accelerationY[h]);
+        physState.timeAccumulator = _stepAccumulator;
+        
+        if (!fresh[h]){
+            // drawn where it is at render time, between the last two steps
+            ofPoint sprite = physicsEnabled ? physState.previousSimPosition.getInterpolated(physState.simPosition, alpha) : physState.handPositions[0];
+            physState.spritePositions.push(sprite);
+        }
+        _spritePosition[h] = physState.spritePositions[0];
+        _spriteSpeed[h] = physState.spriteVelocity.length();
+    }
+    
+    updateRopes(nSteps, dTime, dt, alpha);
 }
 
-void ofxHandPhysicsManager::update()
+float ofxHandPhysicsManager::stepFraction(unsigned int step, unsigned int nSteps, float dTime, float accumulator)
+{
+    // How far through the frame's hand movement a step lands. The simulation trails the
+    // frame by what's left in the accumulator, so the last step falls short of the new
+    // hand position - aiming every frame's steps at it would make the path depend on
+    // the frame rate. An early step can land before the last frame (a negative fraction).
+    if (fixedTimeStep <= 0.0f || dTime <= 0.0f) return 1.0f;
+    return 1.0f - (accumulator + (nSteps - 1 - step)*fixedTimeStep)/dTime;
+}
+
+void ofxHandPhysicsManager::stepSprites(unsigned int numHands, float fraction, float dt, float damping)
 {
-    // update physics settings, inserting new ones as necessary
-    if (_usingUserGenerator){
-        for (int th = 0; th < _trackedUserOrHandIDs.size(); th++)
-        {
-            XnUserID userID = _trackedUserOrHandIDs[th];
-            ofPoint handPositionL = _openNIDevice.getTrackedUser(th).getJoint(JOINT_LEFT_HAND).getProjectivePosition();
-            ofxHandPhysicsState & physStateL = _trackedUserHandPhysicsL[userID];
-            updatePhysState(physStateL, handPositionL);
-            
-            ofPoint handPositionR = _openNIDevice.getTrackedUser(th).getJoint(JOINT_RIGHT_HAND).getProjectivePosition();
-            ofxHandPhysicsState & physStateR = _trackedUserHandPhysicsR[userID];
-            updatePhysState(physStateR, handPositionR);
+    // stepSprite() on every hand at once, same operations in the same order:
+    //   target = from*(1 - f) + to*f
+    //   stretch = sim - target, less restDistance along itself
+    //   acceleration = (-stretch*springCoef + gravity*spriteMass)/spriteMass
+    //   velocity = (velocity + acceleration*dt)*damping, sim += velocity*dt
+    // Lanes past numHands (up to the next multiple of four) are stale and never read.
+    float *fromX = _handFromX.data(), *fromY = _handFromY.data(), *toX = _handToX.data(), *toY = _handToY.data();
+    float *x = _simX.data(), *y = _simY.data(), *px = _previousSimX.data(), *py = _previousSimY.data();
+    float *vx = _velocityX.data(), *vy = _velocityY.data(), *ax = _accelerationX.data(), *ay = _accelerationY.data();
+    float keep = 1.0f - fraction;
+    float gx = gravity.x*spriteMass;
+    float gy = gravity.y*spriteMass;
+    
+#if defined(HAND_PHYSICS_SSE)
+    __m128 f = _mm_set1_ps(fraction), k = _mm_set1_ps(keep);
+    __m128 rest = _mm_set1_ps(restDistance), spring = _mm_set1_ps(springCoef), mass = _mm_set1_ps(spriteMass);
+    __m128 fgx = _mm_set1_ps(gx), fgy = _mm_set1_ps(gy);
+    __m128 t = _mm_set1_ps(dt), d = _mm_set1_ps(damping), zero = _mm_setzero_ps();
+    for (unsigned int h = 0; h < numHands; h += 4){
+        __m128 tx = _mm_add_ps(_mm_mul_ps(_mm_load_ps(fromX + h), k), _mm_mul_ps(_mm_load_ps(toX + h), f));
+        __m128 ty = _mm_add_ps(_mm_mul_ps(_mm_load_ps(fromY + h), k), _mm_mul_ps(_mm_load_ps(toY + h), f));
+        __m128 cx = _mm_load_ps(x + h);
+        __m128 cy = _mm_load_ps(y + h);
+        _mm_store_ps(px + h, cx);
+        _mm_store_ps(py + h, cy);
+        
+        __m128 sx = _mm_sub_ps(cx, tx);
+        __m128 sy = _mm_sub_ps(cy, ty);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(sx, sx), _mm_mul_ps(sy, sy)));
+        __m128 nonZero = _mm_cmpgt_ps(length, zero);
+        sx = _mm_sub_ps(sx, _mm_mul_ps(_mm_and_ps(_mm_div_ps(sx, length), nonZero), rest));
+        sy = _mm_sub_ps(sy, _mm_mul_ps(_mm_and_ps(_mm_div_ps(sy, length), nonZero), rest));
+        
+        __m128 accX = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(zero, sx), spring), fgx), mass);
+        __m128 accY = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(zero, sy), spring), fgy), mass);
+        __m128 velX = _mm_mul_ps(_mm_add_ps(_mm_load_ps(vx + h), _mm_mul_ps(accX, t)), d);
+        __m128 velY = _mm_mul_ps(_mm_add_ps(_mm_load_ps(vy + h), _mm_mul_ps(accY, t)), d);
+        _mm_store_ps(ax + h, accX);
+        _mm_store_ps(ay + h, accY);
+        _mm_store_ps(vx + h, velX);
+        _mm_store_ps(vy + h, velY);
+        _mm_store_ps(x + h, _mm_add_ps(cx, _mm_mul_ps(velX, t)));
+        _mm_store_ps(y + h, _mm_add_ps(cy, _mm_mul_ps(velY, t)));
+    }
+#elif defined(HAND_PHYSICS_NEON)
+    float32x4_t f = vdupq_n_f32(fraction), k = vdupq_n_f32(keep);
+    float32x4_t rest = vdupq_n_f32(restDistance), spring = vdupq_n_f32(springCoef);
+    float32x4_t fgx = vdupq_n_f32(gx), fgy = vdupq_n_f32(gy), invMass = vdupq_n_f32(1.0f/spriteMass);
+    float32x4_t t = vdupq_n_f32(dt), d = vdupq_n_f32(damping), zero = vdupq_n_f32(0.0f);
+    for (unsigned int h = 0; h < numHands; h += 4){
+        float32x4_t tx = vaddq_f32(vmulq_f32(vld1q_f32(fromX + h), k), vmulq_f32(vld1q_f32(toX + h), f));
+        float32x4_t ty = vaddq_f32(vmulq_f32(vld1q_f32(fromY + h), k), vmulq_f32(vld1q_f32(toY + h), f));
+        float32x4_t cx = vld1q_f32(x + h);
+        float32x4_t cy = vld1q_f32(y + h);
+        vst1q_f32(px + h, cx);
+        vst1q_f32(py + h, cy);
+        
+        // no vector divide on ARMv7: refined reciprocal square root, close to but not
+        // bit-identical with the scalar path
+        float32x4_t sx = vsubq_f32(cx, tx);
+        float32x4_t sy = vsubq_f32(cy, ty);
+        float32x4_t lengthSquared = vaddq_f32(vmulq_f32(sx, sx), vmulq_f32(sy, sy));
+        float32x4_t inverse = vrsqrteq_f32(lengthSquared);
+        inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(lengthSquared, inverse), inverse));
+        inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(lengthSquared, inverse), inverse));
+        uint32x4_t nonZero = vcgtq_f32(lengthSquared, zero);
+        float32x4_t scale = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(inverse, rest)), nonZero));
+        sx = vsubq_f32(sx, vmulq_f32(sx, scale));
+        sy = vsubq_f32(sy, vmulq_f32(sy, scale));
+        
+        float32x4_t accX = vmulq_f32(vaddq_f32(vmulq_f32(vnegq_f32(sx), spring), fgx), invMass);
+        float32x4_t accY = vmulq_f32(vaddq_f32(vmulq_f32(vnegq_f32(sy), spring), fgy), invMass);
+        float32x4_t velX = vmulq_f32(vaddq_f32(vld1q_f32(vx + h), vmulq_f32(accX, t)), d);
+        float32x4_t velY = vmulq_f32(vaddq_f32(vld1q_f32(vy + h), vmulq_f32(accY, t)), d);
+        vst1q_f32(ax + h, accX);
+        vst1q_f32(ay + h, accY);
+        vst1q_f32(vx + h, velX);
+        vst1q_f32(vy + h, velY);
+        vst1q_f32(x + h, vaddq_f32(cx, vmulq_f32(velX, t)));
+        vst1q_f32(y + h, vaddq_f32(cy, vmulq_f32(velY, t)));
+    }
+#else
+    for (unsigned int h = 0; h < numHands; h++){
+        float tx = fromX[h]*keep + toX[h]*fraction;
+        float ty = fromY[h]*keep + toY[h]*fraction;
+        px[h] = x[h];
+        py[h] = y[h];
+        
+        float sx = x[h] - tx;
+        float sy = y[h] - ty;
+        float length = sqrtf(sx*sx + sy*sy);
+        if (length > 0.0f){
+            sx -= (sx/length)*restDistance;
+            sy -= (sy/length)*restDistance;
         }
+        
+        ax[h] = (-sx*springCoef + gx)/spriteMass;
+        ay[h] = (-sy*springCoef + gy)/spriteMass;
+        vx[h] = (vx[h] + ax[h]*dt)*damping;
+        vy[h] = (vy[h] + ay[h]*dt)*damping;
+        x[h] += vx[h]*dt;
+        y[h] += vy[h]*dt;
+    }
+#endif
+}
 
+void ofxHandPhysicsManager::setJointSet(ofxHandTrackingJointSet joints)
+{
+    joints &= TRACKING_JOINTS_USER;
+    if (joints == _jointSet) return;
+    _jointSet = joints;
+    if (!_source.tracksUsers()) return;
+    
+    // re-add everyone with the new set, in the order they're tracked now
+    vector<unsigned int> ids;
+    for (unsigned int h=0; h<_handSlots.size(); h++){
+        if (std::find(ids.begin(), ids.end(), _handID[h]) == ids.end()){
+            ids.push_back(_handID[h]);
+        }
     }
-    else{
-        for (int th = 0; th < _trackedUserOrHandIDs.size(); th++)
-        {
-            XnUserID handId = _trackedUserOrHandIDs[th];
-            ofPoint & handPosition = _openNIDevice.getHand(handId).getPosition();
-            ofxHandPhysicsState & physState = _trackedHandPhysics[handId];
-            updatePhysState(physState, handPosition);
+    for (unsigned int i=0; i<ids.size(); i++){
+        removeID(ids[i]);
+    }
+    for (unsigned int i=0; i<ids.size(); i++){
+        trackingEvent(ofxHandTrackingEvent(ofxHandTrackingEvent::ENTERED, ids[i]));
+    }
+}
+
+void ofxHandPhysicsManager::setRopeLinks(unsigned int links)
+{
+    if (links == _ropes.getNumLinks()) return;
+    _ropes.setup(MAX_TRACKED_JOINTS, links);
+    for (unsigned int h=0; h<MAX_TRACKED_JOINTS; h++){
+        _ropeIsNew[h] = true;
+    }
+}
+
+void ofxHandPhysicsManager::updateRopes(unsigned int nSteps, float dTime, float dt, float alpha)
+{
+    unsigned int nRopes = _handSlots.size();
+    if (_ropes.getNumLinks() == 0 || nRopes == 0) return;
+    
+    for (unsigned int h=0; h<nRopes; h++){
+        if (_ropeIsNew[h]){
+            _ropeAnchor[h] = _handPosition[h];
+            _ropes.resetRope(h, _ropeAnchor[h]);
+            _ropeIsNew[h] = false;
+        }
+    }
+    
+    ofxHandRopes::Parameters parameters;
+    parameters.stiffness = springCoef;
+    parameters.restLength = restDistance;
+    parameters.mass = spriteMass;
+    parameters.gravity = physicsEnabled ? gravity : ofVec2f();
+    parameters.iterations = ropeIterations;
+    parameters.damping = powf(1.0f - friction, dt*60.0f);
+    
+    // anchors move linearly from the last step's hand to this frame's, like the sprite targets
+    ofVec2f anchors[MAX_TRACKED_JOINTS];
+    for (unsigned int s=0; s<nSteps; s++){
+        float f = stepFraction(s, nSteps, dTime, _stepAccumulator);
+        for (unsigned int h=0; h<nRopes; h++){
+            anchors[h] = _ropeAnchor[h].getInterpolated(_handPosition[h], f);
         }
+        _ropes.step(nRopes, anchors, dt, parameters);
     }
+    if (nSteps > 0){
+        for (unsigned int h=0; h<nRopes; h++){
+            _ropeAnchor[h] = _handPosition[h];
+        }
+    }
+    
+    _ropes.updateVertices(nRopes, alpha);
+}
+
+void ofxHandPhysicsManager::frameDisplayed(float time)
+{
+    // smoothed over ~30 frames, swap timing wobbles
+    float latency = MAX(time - _lastUpdateTime, 0.0f);
+    _displayLatency = _displayLatency == 0.0f ? latency : _displayLatency + (latency - _displayLatency)*0.03f;
 }
 
 unsigned int ofxHandPhysicsManager::getNumTrackedHands()
 {
-    return _usingUserGenerator ? _trackedUserOrHandIDs.size()*2 : _trackedUserOrHandIDs.size();
+    return _handSlots.size();
 }
 
-ofxHandPhysicsManager::ofxHandPhysicsState ofxHandPhysicsManager::getPhysicsStateForHand(unsigned int i)
+const ofxHandPhysicsManager::ofxHandPhysicsState & ofxHandPhysicsManager::getPhysicsStateForHand(unsigned int i)
 {
     return handPhysicsForIndex(i);
 }
@@ -91,153 +397,299 @@ ofPoint ofxHandPhysicsManager::getNormalizedSpritePositionForHand(unsigned int i
 {
     if (_width == 0.0f || _height == 0.0f)
     {
-        _width = _openNIDevice.getWidth();
-        _height = _openNIDevice.getHeight();
+        _width = _source.getWidth();
+        _height = _source.getHeight();
     }
     
     // don't divide by zero
-    if (_width == 0.0f || _height == 0.0f)
+    if (_width == 0.0f || _height == 0.0f || i >= _handSlots.size())
     {
         return ofPoint(0,0);
     }
     
-    stepIndex = CLAMP(stepIndex, 0, MAX_POINT_HISTORY);
+    stepIndex = CLAMP(stepIndex, 0, MAX_POINT_HISTORY - 1);
     
-    ofPoint returnPoint = handPhysicsForIndex(i).spritePositions[stepIndex];
+    ofPoint returnPoint = stepIndex == 0 ? _spritePosition[i] : _handState[i].spritePositions[stepIndex];
     return returnPoint * ofPoint(1.0f/_width, 1.0f/_height);
 }
 
 float ofxHandPhysicsManager::getAbsSpriteVelocityForHand(unsigned int i)
 {
-    return handPhysicsForIndex(i).spriteVelocity.length();
+    return i < _handSlots.size() ? _spriteSpeed[i] : 0.0f;
 }
 
-void ofxHandPhysicsManager::updatePhysState(ofxHandPhysicsManager::ofxHandPhysicsState &physState, ofPoint &handPosition)
+ofPoint ofxHandPhysicsManager::getHandPositionForHand(unsigned int i)
 {
-    float currentTime = ofGetElapsedTimef();
-    
-    if (physState.isNew){
-        physState.spritePositions.assign(MAX_POINT_HISTORY, handPosition);
-        physState.handPositions.assign(MAX_POINT_HISTORY, handPosition);
-        physState.isNew = false;
-    }
-    else{
-        
-        // update hand position
-        handPosition *= 1.0f - smoothCoef;
-        handPosition += physState.handPositions[0]*smoothCoef;
-        
-        physState.handPositions.pop_back();
-        physState.handPositions.insert(physState.handPositions.begin(), handPosition);
-        
-        double dTime = currentTime - physState.lastUpdateTime;
-        physState.handVelocity = (handPosition - physState.handPositions[0])/dTime;
-        
-        if (physicsEnabled){
-            
-            ofVec2f dStretch = physState.spritePositions[0] - physState.handPositions[0];
-            dStretch -= restDistance*dStretch.getNormalized();
-            
-            ofVec2f force = -dStretch*springCoef;
-            force += gravity*spriteMass;
-            physState.spriteAcceleration = force/spriteMass;
-            physState.spriteVelocity += physState.spriteAcceleration * dTime;
-            physState.spriteVelocity *= 1.0f - friction;
-            
-            ofVec3f newPosition = physState.spritePositions[0] + (physState.spriteVelocity*dTime);
-            physState.spritePositions.pop_back();
-            physState.spritePositions.insert(physState.spritePositions.begin(), newPosition);
-        }
-        else{
-            physState.spritePositions.pop_back();
-            physState.spritePositions.insert(physState.spritePositions.begin(),  handPosition);
-            physState.spriteVelocity = physState.handVelocity;
-        }
-        
+    return i < _handSlots.size() ? _handPosition[i] : ofPoint();
+}
+
+ofxHandTrackingJoint ofxHandPhysicsManager::getJointForHand(unsigned int i)
+{
+    return i < _handSlots.size() ? _handJoint[i] : TRACKING_JOINT_HAND;
+}
+
+unsigned int ofxHandPhysicsManager::getIDForHand(unsigned int i)
+{
+    return i < _handSlots.size() ? _handID[i] : 0;
+}
+
+unsigned int ofxHandPhysicsManager::getSprites(SpriteSample *sprites, unsigned int maxSprites)
+{
+    if (_width == 0.0f || _height == 0.0f)
+    {
+        _width = _source.getWidth();
+        _height = _source.getHeight();
     }
+    if (_width == 0.0f || _height == 0.0f) return 0;
     
-    physState.lastUpdateTime = currentTime;
+    unsigned int n = MIN(maxSprites, _handSlots.size());
+    float sx = 1.0f/_width, sy = 1.0f/_height;
+    for (unsigned int h=0; h<n; h++){
+        sprites[h].position.set(_spritePosition[h].x*sx, _spritePosition[h].y*sy);
+        sprites[h].velocity.set(_velocityX[h], _velocityY[h]);
+        sprites[h].id = _handID[h];
+        sprites[h].joint = _handJoint[h];
+    }
+    return n;
+}
 
+ofxHandPhysicsManager::HandHandle ofxHandPhysicsManager::getHandleForHand(unsigned int i)
+{
+    return i < _handSlots.size() ? _handSlots.handleAt(i) : (HandHandle)ofxNDSlotIndex<MAX_TRACKED_JOINTS>::kInvalidHandle;
 }
 
+bool ofxHandPhysicsManager::isHandleValid(HandHandle handle)
+{
+    return _handSlots.indexOf(handle) >= 0;
+}
 
-void ofxHandPhysicsManager::userEvent(ofxOpenNIUserEvent &event)
+const ofxHandPhysicsManager::ofxHandPhysicsState & ofxHandPhysicsManager::getPhysicsStateForHandle(HandHandle handle)
 {
-    if (event.userStatus == USER_SKELETON_FOUND){
-        _trackedUserOrHandIDs.push_back(event.id);
-        ofLog(OF_LOG_NOTICE, "HandPhysics: Added user " + ofToString(event.id));
-    }
-    else if (event.userStatus == USER_SKELETON_LOST || event.userStatus == USER_TRACKING_STOPPED){
-        
-        ofLog(OF_LOG_NOTICE, "HandPhysics: Removing user " + ofToString(event.id));
+    int index = _handSlots.indexOf(handle);
+    return index >= 0 ? _handState[index] : defaultPhysState;
+}
 
-        _trackedUserHandPhysicsL.erase(event.id);
-        _trackedUserHandPhysicsR.erase(event.id);
-        
-        vector<XnUserID>::iterator it = _trackedUserOrHandIDs.begin();
-        while (it != _trackedUserOrHandIDs.end()){
-            if (*it == event.id){
-                ofLog(OF_LOG_NOTICE, "HandPhysics: Removing user " + ofToString(event.id) + " from tracked list");
-                _trackedUserOrHandIDs.erase(it);
-                break;
-            }
-            it++;
-        }
-        
+void ofxHandPhysicsManager::updatePhysState(ofxHandPhysicsManager::ofxHandPhysicsState &physState, const ofPoint &rawHandPosition, float time, float sampleTime)
+{
+    if (sampleTime < 0.0f){
+        sampleTime = time;
+    }
+    
+    if (physState.isNew){
+        resetPhysState(physState, rawHandPosition, time, sampleTime);
+        return;
+    }
+    
+    ofPoint previousHand = physState.handPositions[0];
+    float dTime = updateHandPosition(physState, rawHandPosition, time, sampleTime);
+    ofPoint handPosition = physState.handPositions[0];
+    
+    if (!physicsEnabled){
+        physState.simPosition = handPosition;
+        physState.previousSimPosition = handPosition;
+        physState.timeAccumulator = 0.0f;
+        physState.spritePositions.push(handPosition);
+        physState.spriteVelocity = physState.handVelocity;
+        return;
+    }
+    
+    if (fixedTimeStep <= 0.0f){
+        // legacy variable step
+        physState.previousSimPosition = physState.simPosition;
+        stepSprite(physState, handPosition, dTime, powf(1.0f - friction, dTime*60.0f));
+        physState.spritePositions.push(physState.simPosition);
+        return;
     }
+    
+    physState.timeAccumulator += dTime;
+    unsigned int nSteps = physState.timeAccumulator/fixedTimeStep;
+    if (nSteps > maxSubSteps){
+        // long stall: drop the time we can't catch up on rather than spiralling
+        nSteps = maxSubSteps;
+        physState.timeAccumulator = nSteps*fixedTimeStep;
+    }
+    
+    // the hand target moves linearly from last frame's position to this one's, each
+    // sub-step aimed at where it was at that step's time
+    physState.timeAccumulator -= nSteps*fixedTimeStep;
+    float damping = powf(1.0f - friction, fixedTimeStep*60.0f);
+    for (unsigned int s=0; s<nSteps; s++){
+        ofPoint target = previousHand.getInterpolated(handPosition, stepFraction(s, nSteps, dTime, physState.timeAccumulator));
+        physState.previousSimPosition = physState.simPosition;
+        stepSprite(physState, target, fixedTimeStep, damping);
+    }
+    
+    // draw the sprite where it is at render time, between the last two steps
+    float alpha = physState.timeAccumulator/fixedTimeStep;
+    physState.spritePositions.push(physState.previousSimPosition.getInterpolated(physState.simPosition, alpha));
+}
+
+void ofxHandPhysicsManager::resetPhysState(ofxHandPhysicsState &physState, const ofPoint &rawHandPosition, float time, float sampleTime)
+{
+    physState.filter.reset();
+    physState.filter.addSample(filterType, rawHandPosition, sampleTime, filterSettings);
+    physState.spritePositions.fill(rawHandPosition);
+    physState.handPositions.fill(rawHandPosition);
+    physState.simPosition = rawHandPosition;
+    physState.previousSimPosition = rawHandPosition;
+    physState.handVelocity = 0.0f;
+    physState.spriteVelocity = 0.0f;
+    physState.spriteAcceleration = 0.0f;
+    physState.timeAccumulator = 0.0f;
+    physState.lastUpdateTime = time;
+    physState.isNew = false;
 }
 
-void ofxHandPhysicsManager::handEvent(ofxOpenNIHandEvent & event)
+float ofxHandPhysicsManager::updateHandPosition(ofxHandPhysicsState &physState, const ofPoint &rawHandPosition, float time, float sampleTime)
 {
-    if (event.handStatus == HAND_TRACKING_STARTED){
-        _trackedUserOrHandIDs.push_back(event.id);
+    float dTime = MAX(time - physState.lastUpdateTime, 0.0f);
+    physState.lastUpdateTime = time;
+    
+    // smoothing and friction are tuned per 60Hz frame - scale them to the actual frame time
+    float frames = dTime*60.0f;
+    float smooth = powf(smoothCoef, frames);
+    
+    // update hand position
+    ofPoint previousHand = physState.handPositions[0];
+    ofPoint handPosition;
+    if (filterType == HAND_FILTER_ONE_POLE){
+        handPosition = rawHandPosition*(1.0f - smooth) + previousHand*smooth;
     }
-    else if (event.handStatus == HAND_TRACKING_STOPPED){
-        
-        _trackedHandPhysics.erase(event.id);
-        
-        vector<XnUserID>::iterator it = _trackedUserOrHandIDs.begin();
-        while (it != _trackedUserOrHandIDs.end()){
-            if (*it == event.id){
-                _trackedUserOrHandIDs.erase(it);
-                break;
-            }
-            it++;
-        }
+    else{
+        physState.filter.addSample(filterType, rawHandPosition, sampleTime, filterSettings);
         
+        // lead the hand by how old it will be when this frame is seen
+        float sampleAge = MAX(time - physState.filter.getSampleTime(), 0.0f);
+        float horizon = (sampleAge + sensorLatency + _displayLatency)*predictionScale;
+        horizon = ofClamp(horizon, 0.0f, maxPrediction);
+        handPosition = physState.filter.predict(physState.filter.getSampleTime() + horizon);
+    }
+    if (dTime > 0.0f){
+        physState.handVelocity = (handPosition - previousHand)/dTime;
     }
+    physState.handPositions.push(handPosition);
+    return dTime;
+}
+
+void ofxHandPhysicsManager::stepSprite(ofxHandPhysicsManager::ofxHandPhysicsState &physState, const ofPoint &target, float dt, float damping)
+{
+    ofVec2f dStretch = physState.simPosition - target;
+    dStretch -= restDistance*dStretch.getNormalized();
+    
+    ofVec2f force = -dStretch*springCoef;
+    force += gravity*spriteMass;
+    physState.spriteAcceleration = force/spriteMass;
+    
+    // semi-implicit Euler: velocity first, then position with the new velocity
+    physState.spriteVelocity += physState.spriteAcceleration*dt;
+    physState.spriteVelocity *= damping;
+    physState.simPosition += physState.spriteVelocity*dt;
 }
 
 
-ofxHandPhysicsManager::ofxHandPhysicsState & ofxHandPhysicsManager::handPhysicsForIndex(int index){
-    if (_usingUserGenerator){
-        
-        if (index/2 >= _trackedUserOrHandIDs.size())
-        {
-            ofLog(OF_LOG_ERROR, "ofxHandPhysicsManager::handPhysicsForIndex - index out of bounds");
-            return defaultPhysState;
-        }
+void ofxHandPhysicsManager::trackingEvent(const ofxHandTrackingEvent &event)
+{
+    bool users = _source.tracksUsers();
+    ofxHandTrackingJointSet joints = users ? _jointSet : TRACKING_JOINT_BIT(TRACKING_JOINT_HAND);
+    
+    if (event.type == ofxHandTrackingEvent::ENTERED){
         
+        if (findID(event.id) >= 0) return;
         
-        int uIndex = index/2;
-        int hIndex = index % 2;
+        // all of a user's joints or none, so a user never ends up half tracked
+        unsigned int nJoints = 0;
+        for (unsigned int j=0; j<NUM_TRACKING_JOINTS; j++){
+            if (joints & TRACKING_JOINT_BIT(j)) nJoints++;
+        }
+        if (_handSlots.size() + nJoints > MAX_TRACKED_JOINTS){
+            ofLog(OF_LOG_WARNING, "HandPhysics: Ignoring " + string(users ? "user " : "hand ") + ofToString(event.id) + ", already tracking " + ofToString(_handSlots.size()) + " of " + ofToString(MAX_TRACKED_JOINTS) + " joints");
+            return;
+        }
         
-        if (hIndex == 0){
-            return _trackedUserHandPhysicsL[_trackedUserOrHandIDs[uIndex]];
+        for (unsigned int j=0; j<NUM_TRACKING_JOINTS; j++){
+            if (joints & TRACKING_JOINT_BIT(j)){
+                addHand(event.id, (ofxHandTrackingJoint)j);
+            }
         }
-        else{
-            return _trackedUserHandPhysicsR[_trackedUserOrHandIDs[uIndex]];
+        if (users){
+            ofLog(OF_LOG_NOTICE, "HandPhysics: Added user " + ofToString(event.id) + " (" + ofToString(nJoints) + " joints)");
         }
     }
     else{
+        if (users){
+            ofLog(OF_LOG_NOTICE, "HandPhysics: Removing user " + ofToString(event.id));
+        }
+        removeID(event.id);
+    }
+}
+
+bool ofxHandPhysicsManager::addHand(unsigned int id, ofxHandTrackingJoint joint)
+{
+    if (_handSlots.insert() == ofxNDSlotIndex<MAX_TRACKED_JOINTS>::kInvalidHandle){
+        ofLog(OF_LOG_WARNING, "HandPhysics: Ignoring hand " + ofToString(id) + ", already tracking " + ofToString(MAX_TRACKED_JOINTS) + " joints");
+        return false;
+    }
+    
+    unsigned int index = _handSlots.size() - 1;
+    _handIDs.insert(id, _handSlots.handleAt(index));
+    _handID[index] = id;
+    _handJoint[index] = joint;
+    _handPosition[index] = ofPoint();
+    _spritePosition[index] = ofPoint();
+    _spriteSpeed[index] = 0.0f;
+    _handState[index] = ofxHandPhysicsState();
+    _ropeIsNew[index] = true;
+    return true;
+}
+
+void ofxHandPhysicsManager::removeHand(unsigned int index)
+{
+    unsigned int from, to;
+    if (_handSlots.remove(_handSlots.handleAt(index), from, to) && from != to){
+        _handID[to] = _handID[from];
+        _handJoint[to] = _handJoint[from];
+        _handPosition[to] = _handPosition[from];
+        _spritePosition[to] = _spritePosition[from];
+        _spriteSpeed[to] = _spriteSpeed[from];
+        _handState[to] = _handState[from];
         
-        if (index >= _trackedUserOrHandIDs.size())
-        {
-            ofLog(OF_LOG_ERROR, "ofxHandPhysicsManager::handPhysicsForIndex - index out of bounds");
-            return defaultPhysState;
+        ofxNDAlignedArray<float> * arrays[] = {
+            &_handFromX, &_handFromY, &_handToX, &_handToY, &_simX, &_simY,
+            &_previousSimX, &_previousSimY, &_velocityX, &_velocityY, &_accelerationX, &_accelerationY
+        };
+        for (unsigned int a=0; a<sizeof(arrays)/sizeof(arrays[0]); a++){
+            (*arrays[a])[to] = (*arrays[a])[from];
         }
         
-        return _trackedHandPhysics[_trackedUserOrHandIDs[index]];
+        _ropes.moveRope(from, to);
+        _ropeAnchor[to] = _ropeAnchor[from];
+        _ropeIsNew[to] = _ropeIsNew[from];
+    }
+}
+
+void ofxHandPhysicsManager::removeID(unsigned int id)
+{
+    if (!_handIDs.remove(id)) return;
+    
+    // backwards, so whatever gets moved into a removed entry has already been checked
+    for (int h = (int)_handSlots.size() - 1; h >= 0; h--){
+        if (_handID[h] == id) removeHand(h);
+    }
+}
+
+int ofxHandPhysicsManager::findID(unsigned int id)
+{
+    // a stale or missing handle is -1
+    return _handSlots.indexOf(_handIDs.find(id));
+}
+
+ofxHandPhysicsManager::ofxHandPhysicsState & ofxHandPhysicsManager::handPhysicsForIndex(unsigned int index)
+{
+    if (index >= _handSlots.size())
+    {
+        ofLog(OF_LOG_ERROR, "ofxHandPhysicsManager::handPhysicsForIndex - index out of bounds");
+        return defaultPhysState;
     }
     
+    return _handState[index];
 }
@@ -9,33 +9,86 @@
 #pragma once
 
 #include "ofMain.h"
-#include "ofxOpenNI.h"
-#include <map>
+#include "ofxHandTrackingSource.h"
+#include "ofxHandFilter.h"
+#include "ofxHandRopes.h"
+#include "ofxNDHistoryRing.h"
+#include "ofxNDSlotIndex.h"
+#include "ofxNDIDMap.h"
+#include "ofxNDAlignedArray.h"
 
-#define MAX_POINT_HISTORY   10
-
-using std::map;
+#define MAX_POINT_HISTORY   256     // power of two, frames of hand/sprite history kept per hand
+#define MAX_TRACKED_JOINTS  96      // sprites (6 users x 15 joints, or one per tracked hand); more are ignored
 
+/// Drives a sprite from every tracked joint: a spring pulls each sprite towards
+/// its (smoothed, filtered) joint. A "hand" in the getters below is any tracked
+/// joint - user sources give one per joint in the joint set, hand sources one per id.
 class ofxHandPhysicsManager {
     
 public:
     
     struct ofxHandPhysicsState;
     
-    ofxHandPhysicsManager(ofxOpenNI &openNIDevice, bool useUserGenerator = false);
+    // stays valid while the hand is tracked, even as other hands come and go
+    typedef ofxNDSlotIndex<MAX_TRACKED_JOINTS>::Handle HandHandle;
+    
+    // the source must outlive the manager
+    ofxHandPhysicsManager(ofxHandTrackingSource &source);
     ~ofxHandPhysicsManager();
     
     void update();
+    void update(float time);        // time in seconds, e.g. a fixed clock for replays
     
     // state getters
     unsigned int getNumTrackedHands();
     
-    ofxHandPhysicsState getPhysicsStateForHand(unsigned int i);
+    // i is 0..getNumTrackedHands()-1; the order changes when a hand is lost.
+    // State references are valid until the next tracking event.
+    const ofxHandPhysicsState & getPhysicsStateForHand(unsigned int i);
     ofPoint getNormalizedSpritePositionForHand(unsigned int i, unsigned int stepIndex = 0);
     float   getAbsSpriteVelocityForHand(unsigned int i);
+    ofPoint getHandPositionForHand(unsigned int i);
+    
+    ofxHandTrackingJoint    getJointForHand(unsigned int i);
+    unsigned int            getIDForHand(unsigned int i);
+    
+    struct SpriteSample {
+        ofVec2f                 position;   // normalized, like getNormalizedSpritePositionForHand
+        ofVec2f                 velocity;   // px/s in the source's projective coordinates
+        unsigned int            id;
+        ofxHandTrackingJoint    joint;
+    };
+    
+    // Every hand's sprite in one call, in hand order; returns how many were written
+    unsigned int getSprites(SpriteSample * sprites, unsigned int maxSprites);
     
-    // input smoothing
-    float       smoothCoef;
+    HandHandle  getHandleForHand(unsigned int i);
+    bool        isHandleValid(HandHandle handle);
+    const ofxHandPhysicsState & getPhysicsStateForHandle(HandHandle handle);
+    
+    // Which joints of each tracked user drive a sprite (TRACKING_JOINTS_HANDS by default).
+    // Sources that track hands always give one sprite per hand. Users already tracked are
+    // re-added with the new set; a user only gets sprites if all of them fit.
+    void                    setJointSet(ofxHandTrackingJointSet joints);
+    ofxHandTrackingJointSet getJointSet() const { return _jointSet; };
+    
+    // input smoothing. HAND_FILTER_ONE_POLE (the default) blends with smoothCoef every
+    // frame; the adaptive filters run once per new sample from the source and use filterSettings.
+    ofxHandFilterType       filterType;
+    ofxHandFilterSettings   filterSettings;
+    float                   smoothCoef;
+    
+    // latency compensation for the adaptive filters: hands are extrapolated to when the
+    // frame will be seen, i.e. by the sample's age + sensorLatency + the measured update to
+    // display time, times predictionScale (0 = off, 1 = fully), at most maxPrediction seconds.
+    float       predictionScale;
+    float       sensorLatency;          // capture to the source's sample time, not measurable here
+    float       maxPrediction;
+    
+    // call once the frame drawn from the last update() is on screen (or about to be),
+    // time on the same clock as update(time)
+    void        frameDisplayed(float time);
+    float       getDisplayLatency() const { return _displayLatency; };
     
     // physics parameters
     bool        physicsEnabled;
@@ -44,15 +97,42 @@ public:
     float       restDistance;
     float       friction;
     ofVec2f     gravity;
+    
+    // integration: semi-implicit Euler at fixedTimeStep, run as many times per frame as
+    // the elapsed time needs (at most maxSubSteps, the rest is dropped after a long stall).
+    // Every sprite steps together, four at a time with SSE/NEON, on one shared clock.
+    // Sprites are drawn interpolated between the last two steps.
+    // fixedTimeStep <= 0 integrates once per frame with the frame's time delta instead.
+    float           fixedTimeStep;
+    unsigned int    maxSubSteps;
 
+    // ropes: each hand drags a chain of ropeLinks masses (0 = no ropes). A rope is the
+    // sprite's spring with its mass spread along it - springCoef, restDistance, spriteMass,
+    // friction and gravity apply to the rope as a whole. Stepped at fixedTimeStep.
+    void            setRopeLinks(unsigned int links);
+    unsigned int    getRopeLinks() const { return _ropes.getNumLinks(); };
+    unsigned int    ropeIterations;
+    
+    // Vertex stream for every hand's rope, getRopeLinks()+1 (x, y) vertices per hand in
+    // hand order, hand end first; projective coordinates like getHandPositionForHand.
+    const float *   getRopeVertices() const { return _ropes.getVertices(); };
+    
+    typedef ofxNDHistoryRing<ofPoint, MAX_POINT_HISTORY> PointHistory;
+    
     struct ofxHandPhysicsState {
         
-        vector<ofPoint> handPositions;
-        vector<ofPoint> spritePositions;
+        PointHistory    handPositions;      // [0] = current frame
+        PointHistory    spritePositions;
+        ofxHandFilter   filter;
         ofVec2f handVelocity;
         ofVec2f spriteVelocity;
         ofVec2f spriteAcceleration;
         
+        // simulated sprite at the last two fixed steps; spritePositions[0] is drawn between them
+        ofPoint simPosition;
+        ofPoint previousSimPosition;
+        float   timeAccumulator;
+        
         float  lastUpdateTime;
         
         bool    isNew;
@@ -61,27 +141,69 @@ public:
         
     };
     
+    // Advances one hand to time on its own clock, one sprite at a time - the reference
+    // for update()'s batched pass. Public so recorded paths can be replayed without a device.
+    // sampleTime is when rawHandPosition arrived (< 0: now, i.e. a new sample every call).
+    void updatePhysState(ofxHandPhysicsState &physState, const ofPoint &rawHandPosition, float time, float sampleTime = -1.0f);
+    
 private:
 
-    void updatePhysState(ofxHandPhysicsState &physState, ofPoint &handPosition);
+    void resetPhysState(ofxHandPhysicsState &physState, const ofPoint &rawHandPosition, float time, float sampleTime);
+    float updateHandPosition(ofxHandPhysicsState &physState, const ofPoint &rawHandPosition, float time, float sampleTime);
+    void stepSprite(ofxHandPhysicsState &physState, const ofPoint &target, float dt, float damping);
+    
+    // all sprites 0..numHands-1 one step towards their hand, which moves from _handFrom
+    // to _handTo over the frame and is fraction of the way there at this step's time
+    void stepSprites(unsigned int numHands, float fraction, float dt, float damping);
 
-    void userEvent(ofxOpenNIUserEvent & event);
-    void handEvent(ofxOpenNIHandEvent & event);
+    void trackingEvent(const ofxHandTrackingEvent & event);
+    
+    bool addHand(unsigned int id, ofxHandTrackingJoint joint);
+    void removeHand(unsigned int index);
+    void removeID(unsigned int id);
+    int  findID(unsigned int id);
+    void updateRopes(unsigned int nSteps, float dTime, float dt, float alpha);
+    float stepFraction(unsigned int step, unsigned int nSteps, float dTime, float accumulator);
     
-    ofxHandPhysicsState & handPhysicsForIndex(int index);
+    ofxHandPhysicsState & handPhysicsForIndex(unsigned int index);
     ofxHandPhysicsState defaultPhysState;
     
     float   _width;
     float   _height;
     
-    ofxOpenNI &_openNIDevice;
-    bool    _usingUserGenerator;
+    float   _lastUpdateTime;
+    float   _displayLatency;
     
-    vector<XnUserID>                            _trackedUserOrHandIDs;
-    map<XnUserID, ofxHandPhysicsState>          _trackedHandPhysics;
-    map<XnUserID, ofxHandPhysicsState>          _trackedUserHandPhysicsL;
-    map<XnUserID, ofxHandPhysicsState>          _trackedUserHandPhysicsR;
-
+    ofxHandTrackingSource & _source;
+    
+    ofxHandTrackingJointSet _jointSet;
+    
+    // shared fixed-step clock
+    float   _stepAccumulator;
+    float   _lastStepTime;
+    
+    // dense slot table: entries 0.._handSlots.size()-1 are live, one array per field.
+    // The hot per-frame fields are kept apart from the full state (which carries the history).
+    ofxNDSlotIndex<MAX_TRACKED_JOINTS>  _handSlots;
+    unsigned int            _handID[MAX_TRACKED_JOINTS];
+    ofxNDIDMap<256>         _handIDs;           // tracker ID -> handle of its first joint, so ENTERED doesn't scan
+    ofxHandTrackingJoint    _handJoint[MAX_TRACKED_JOINTS];
+    ofPoint                 _handPosition[MAX_TRACKED_JOINTS];
+    ofPoint                 _spritePosition[MAX_TRACKED_JOINTS];
+    float                   _spriteSpeed[MAX_TRACKED_JOINTS];
+    ofxHandPhysicsState     _handState[MAX_TRACKED_JOINTS];
+    
+    // the sprite integrator's working set, one float per hand per array, MAX_TRACKED_JOINTS long
+    ofxNDAlignedArray<float>    _handFromX, _handFromY;     // hand at the last frame
+    ofxNDAlignedArray<float>    _handToX, _handToY;         // hand at this frame
+    ofxNDAlignedArray<float>    _simX, _simY;
+    ofxNDAlignedArray<float>    _previousSimX, _previousSimY;
+    ofxNDAlignedArray<float>    _velocityX, _velocityY;
+    ofxNDAlignedArray<float>    _accelerationX, _accelerationY;
+    
+    ofxHandRopes            _ropes;                             // rope r belongs to hand r
+    ofVec2f                 _ropeAnchor[MAX_TRACKED_JOINTS];    // hand at the last rope step
+    bool                    _ropeIsNew[MAX_TRACKED_JOINTS];
 
 };
 
@@ -0,0 +1,1376 @@
+//
+//  ofxHandPhysicsBenchmark.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/12/12.
+//
+//
+
+#include "ofxHandPhysicsBenchmark.h"
+#include "ofxSyntheticTrackingSource.h"
+#include "ofxRecordedTrackingSource.h"
+#include <fstream>
+#include <algorithm>
+
+static const char * patternNames[ofxHandPhysicsBenchmark::NUM_FRAME_PATTERNS] = {
+    "steady 60Hz", "steady 30Hz", "steady 144Hz", "jitter 8-33ms", "60Hz + 250ms stalls"
+};
+
+namespace {
+
+// One hand following a path as a camera would see it: sampled, noisy and late
+class PathTrackingSource : public ofxHandTrackingSource {
+
+public:
+
+    PathTrackingSource(const vector<ofxHandPhysicsBenchmark::PathSample> & path,
+                       const ofxHandPhysicsBenchmark::FilterConditions & conditions,
+                       ofPoint (*pathPosition)(const vector<ofxHandPhysicsBenchmark::PathSample> &, float)) :
+        _path(path),
+        _conditions(conditions),
+        _pathPosition(pathPosition),
+        _random(conditions.seed*2654435761u + 1),
+        _sample(-1),
+        _sampleTime(-1.0f),
+        _entered(false)
+    {
+    };
+
+    void update(float time)
+    {
+        float interval = 1.0f/_conditions.sampleRate;
+        int sample = floorf((time - _conditions.sensorLatency - _path.front().time)/interval);
+        if (sample == _sample || sample < 0) return;
+
+        _sample = sample;
+        float captureTime = _path.front().time + sample*interval;
+        _position = _pathPosition(_path, captureTime) + ofPoint(gaussian(), gaussian())*_conditions.noise;
+        _sampleTime = captureTime + _conditions.sensorLatency;
+    };
+
+    bool tracksUsers() const { return false; };
+
+    bool getNextEvent(ofxHandTrackingEvent & event)
+    {
+        if (_entered || _sample < 0) return false;
+        _entered = true;
+        event = ofxHandTrackingEvent(ofxHandTrackingEvent::ENTERED, 1);
+        return true;
+    };
+
+    unsigned int getNumTracked() { return _entered ? 1 : 0; };
+    unsigned int getTrackedID(unsigned int /*index*/) { return 1; };
+
+    bool getJointPosition(unsigned int id, ofxHandTrackingJoint /*joint*/, ofPoint & position)
+    {
+        if (!_entered || id != 1) return false;
+        position = _position;
+        return true;
+    };
+
+    float getSampleTime() { return _sampleTime; };
+
+private:
+
+    float uniform()
+    {
+        _random = _random*1664525u + 1013904223u;
+        return ((_random >> 8) + 0.5f)/16777216.0f;
+    };
+
+    float gaussian()
+    {
+        return sqrtf(-2.0f*logf(uniform()))*cosf(TWO_PI*uniform());
+    };
+
+    const vector<ofxHandPhysicsBenchmark::PathSample> &    _path;
+    ofxHandPhysicsBenchmark::FilterConditions               _conditions;
+    ofPoint (*_pathPosition)(const vector<ofxHandPhysicsBenchmark::PathSample> &, float);
+    unsigned int    _random;
+    int             _sample;
+    float           _sampleTime;
+    ofPoint         _position;
+    bool            _entered;
+};
+
+// Synthetic users whose right hands break off from their usual wandering to trace a
+// scripted shape, then carry on from wherever the shape ended
+class GesturePerformanceSource : public ofxHandTrackingSource {
+
+public:
+
+    struct Cue {
+        unsigned int    user;
+        float           start;
+        float           duration;
+        vector<ofxHandPhysicsBenchmark::PathSample> shape;     // time is the fraction of the stroke, starts at 0, 0
+    };
+
+    GesturePerformanceSource(unsigned int numUsers, unsigned int seed, const vector<Cue> & cues,
+                             ofPoint (*pathPosition)(const vector<ofxHandPhysicsBenchmark::PathSample> &, float)) :
+        _synthetic(numUsers, seed),
+        _cues(cues),
+        _pathPosition(pathPosition),
+        _random(seed*2654435761u + 7),
+        _users(numUsers)
+    {
+        _synthetic.setSampling(30.0f, 0.0f);
+    };
+
+    void update(float time)
+    {
+        _synthetic.update(time);
+        float sampleTime = _synthetic.getSampleTime();
+
+        for (unsigned int u=0; u<_users.size() && u<_synthetic.getNumTracked(); u++){
+            User & user = _users[u];
+            ofPoint hand;
+            _synthetic.getJointPosition(_synthetic.getTrackedID(u), TRACKING_JOINT_RIGHT_HAND, hand);
+
+            // this user's next cue
+            while (user.cue < _cues.size() && _cues[user.cue].user != u) user.cue++;
+            if (user.cue >= _cues.size()){
+                user.right = hand + user.offset;
+                continue;
+            }
+
+            const Cue & cue = _cues[user.cue];
+            if (sampleTime >= cue.start + cue.duration && user.performing){
+                // carry on wandering from the end of the shape
+                user.offset = user.anchor + _pathPosition(cue.shape, 1.0f) - hand;
+                user.performing = false;
+                user.cue++;
+                user.right = hand + user.offset;
+            }
+            else if (sampleTime >= cue.start){
+                if (!user.performing){
+                    user.anchor = hand + user.offset;
+                    user.performing = true;
+                }
+                ofPoint noise(gaussian(), gaussian());
+                user.right = user.anchor + _pathPosition(cue.shape, (sampleTime - cue.start)/cue.duration) + noise*1.5f;
+            }
+            else{
+                user.right = hand + user.offset;
+            }
+        }
+    };
+
+    bool tracksUsers() const { return true; };
+    bool getNextEvent(ofxHandTrackingEvent & event) { return _synthetic.getNextEvent(event); };
+    unsigned int getNumTracked() { return _synthetic.getNumTracked(); };
+    unsigned int getTrackedID(unsigned int index) { return _synthetic.getTrackedID(index); };
+
+    bool getJointPosition(unsigned int id, ofxHandTrackingJoint joint, ofPoint & position)
+    {
+        if (joint == TRACKING_JOINT_RIGHT_HAND){
+            for (unsigned int u=0; u<_users.size() && u<_synthetic.getNumTracked(); u++){
+                if (_synthetic.getTrackedID(u) != id) continue;
+                position = _users[u].right;
+                return true;
+            }
+        }
+        return _synthetic.getJointPosition(id, joint, position);
+    };
+
+    float getSampleTime() { return _synthetic.getSampleTime(); };
+
+private:
+
+    struct User {
+        unsigned int    cue;
+        bool            performing;
+        ofPoint         anchor;         // where the current shape started
+        ofPoint         offset;         // from the synthetic hand, after the shapes so far
+        ofPoint         right;
+        User() : cue(0), performing(false) {};
+    };
+
+    float gaussian()
+    {
+        _random = _random*1664525u + 1013904223u;
+        float u1 = ((_random >> 8) + 0.5f)/16777216.0f;
+        _random = _random*1664525u + 1013904223u;
+        float u2 = ((_random >> 8) + 0.5f)/16777216.0f;
+        return sqrtf(-2.0f*logf(u1))*cosf(TWO_PI*u2);
+    };
+
+    ofxSyntheticTrackingSource  _synthetic;
+    const vector<Cue> &         _cues;
+    ofPoint (*_pathPosition)(const vector<ofxHandPhysicsBenchmark::PathSample> &, float);
+    unsigned int                _random;
+    vector<User>                _users;
+};
+
+// One 60Hz frame of four emitters circling at different rates; owed carries each
+// emitter's fraction of a particle over to the next frame
+void emitParticles(ofxNDParticleSystem & particles, float t, float perEmitterPerFrame, float life, float owed[4])
+{
+    for (unsigned int e=0; e<4; e++){
+        float phase = t*(2.0f + e*0.7f);
+        ofVec2f position(320.0f + e*160.0f + cosf(phase)*120.0f, 400.0f + sinf(phase)*120.0f);
+        ofVec2f velocity(-sinf(phase)*240.0f, cosf(phase)*240.0f);
+        owed[e] += perEmitterPerFrame;
+        unsigned int count = (unsigned int)owed[e];
+        owed[e] -= count;
+        particles.emit(count, position, velocity*0.3f, 4.0f, 120.0f, 12.0f, life);
+    }
+}
+
+}
+
+ofxHandPhysicsBenchmark::Result::Result()
+{
+    pattern = FRAMES_STEADY_60;
+    fixedStep = true;
+    numFrames = 0;
+    stable = false;
+    consistent = false;
+    numMatched = 0;
+    maxDivergence = 0.0f;
+    maxStretch = 0.0f;
+    rmsDeviation = 0.0f;
+    maxDeviation = 0.0f;
+    microsPerFrame = 0;
+}
+
+vector<ofxHandPhysicsBenchmark::PathSample> ofxHandPhysicsBenchmark::syntheticPath(float seconds)
+{
+    vector<PathSample> path;
+    ofPoint center(320, 240, 1500);
+
+    for (float t = 0.0f; t <= seconds; t += 1.0f/30.0f){
+        ofPoint p = center + ofPoint(sinf(t*2.1f)*220.0f, sinf(t*4.2f)*120.0f);
+        // a quick flick every 3 seconds
+        float flick = fmodf(t, 3.0f);
+        if (flick < 0.2f){
+            p.x += sinf(flick*M_PI/0.2f)*150.0f;
+        }
+        path.push_back(PathSample(t, p));
+    }
+    return path;
+}
+
+vector<ofxHandPhysicsBenchmark::PathSample> ofxHandPhysicsBenchmark::loadPath(const string &csvPath)
+{
+    vector<PathSample> path;
+    std::ifstream file(ofToDataPath(csvPath).c_str());
+    if (!file.is_open()){
+        ofLog(OF_LOG_ERROR, "ofxHandPhysicsBenchmark: could not open " + csvPath);
+        return path;
+    }
+
+    string line;
+    while (std::getline(file, line)){
+        PathSample sample;
+        int nParsed = sscanf(line.c_str(), "%f,%f,%f,%f", &sample.time, &sample.position.x, &sample.position.y, &sample.position.z);
+        if (nParsed >= 3){
+            path.push_back(sample);
+        }
+    }
+    return path;
+}
+
+void ofxHandPhysicsBenchmark::configure(ofxHandPhysicsManager &physics, bool fixedStep, bool smoothInput)
+{
+    // same as ofApplication::setup
+    physics.restDistance = 0.0f;
+    physics.springCoef = 100.0f;
+    physics.smoothCoef = 0.5f;
+    physics.friction = 0.08f;
+    physics.gravity = ofVec2f(0,7000.0f);
+    physics.physicsEnabled = true;
+    if (!fixedStep){
+        physics.fixedTimeStep = 0.0f;
+    }
+    if (!smoothInput){
+        physics.smoothCoef = 0.0f;
+    }
+}
+
+vector<float> ofxHandPhysicsBenchmark::frameTimes(FramePattern pattern, float seconds)
+{
+    vector<float> times;
+    ofSeedRandom(7);
+
+    float t = 0.0f;
+    float nextStall = 2.0f;
+    while (t <= seconds){
+        times.push_back(t);
+        switch (pattern){
+            case FRAMES_STEADY_30:
+                t += 1.0f/30.0f;
+                break;
+            case FRAMES_STEADY_144:
+                t += 1.0f/144.0f;
+                break;
+            case FRAMES_JITTER:
+                t += ofRandom(0.008f, 0.033f);
+                break;
+            case FRAMES_DROPPED:
+                if (t >= nextStall){
+                    t += 0.25f;
+                    nextStall += 2.0f;
+                }
+                else{
+                    t += 1.0f/60.0f;
+                }
+                break;
+            default:
+                t += 1.0f/60.0f;
+                break;
+        }
+    }
+    return times;
+}
+
+ofPoint ofxHandPhysicsBenchmark::pathPosition(const vector<PathSample> &path, float time)
+{
+    if (path.empty()) return ofPoint();
+    if (time <= path.front().time) return path.front().position;
+    if (time >= path.back().time) return path.back().position;
+
+    unsigned int lo = 0;
+    unsigned int hi = path.size() - 1;
+    while (hi - lo > 1){
+        unsigned int mid = (lo + hi)/2;
+        if (path[mid].time <= time) lo = mid; else hi = mid;
+    }
+    float span = path[hi].time - path[lo].time;
+    float frac = span > 0.0f ? (time - path[lo].time)/span : 0.0f;
+    return path[lo].position.getInterpolated(path[hi].position, frac);
+}
+
+ofxHandPhysicsBenchmark::Trace ofxHandPhysicsBenchmark::trace(const vector<PathSample> &path, const vector<float> &frameTimes, bool fixedStep, bool smoothInput)
+{
+    ofxSyntheticTrackingSource source(0);   // no users, only satisfies the manager's constructor
+    ofxHandPhysicsManager physics(source);
+    configure(physics, fixedStep, smoothInput);
+    ofxHandPhysicsManager::ofxHandPhysicsState state;
+
+    Trace result;
+    result.times.reserve(frameTimes.size());
+    result.sprites.reserve(frameTimes.size());
+    result.hands.reserve(frameTimes.size());
+    result.simTimes.reserve(frameTimes.size());
+    result.simPositions.reserve(frameTimes.size());
+
+    // fixed steps taken so far, from how much the accumulator drained; a stall's
+    // dropped time is never simulated, so it isn't counted
+    unsigned int steps = 0;
+    float accumulator = 0.0f;
+
+    unsigned long long startTime = ofGetElapsedTimeMicros();
+    for (unsigned int f=0; f<frameTimes.size(); f++){
+        float t = frameTimes[f];
+        physics.updatePhysState(state, pathPosition(path, t), t);
+        result.times.push_back(t);
+        result.sprites.push_back(state.spritePositions[0]);
+        result.hands.push_back(state.handPositions[0]);
+
+        if (fixedStep && f > 0){
+            float drained = accumulator + (t - frameTimes[f-1]) - state.timeAccumulator;
+            steps += MIN((unsigned int)roundf(drained/physics.fixedTimeStep), physics.maxSubSteps);
+        }
+        accumulator = state.timeAccumulator;
+        result.simTimes.push_back(fixedStep ? frameTimes[0] + steps*physics.fixedTimeStep : t);
+        result.simPositions.push_back(state.simPosition);
+    }
+    result.micros = ofGetElapsedTimeMicros() - startTime;
+
+    return result;
+}
+
+ofxHandPhysicsBenchmark::Result ofxHandPhysicsBenchmark::replay(const vector<PathSample> &path, FramePattern pattern, bool fixedStep)
+{
+    Result result;
+    result.pattern = pattern;
+    result.fixedStep = fixedStep;
+    if (path.empty()) return result;
+
+    float seconds = path.back().time;
+
+    // reference: 1kHz frames, fixed step
+    vector<float> referenceTimes;
+    for (float t = 0.0f; t <= seconds; t += 0.001f){
+        referenceTimes.push_back(t);
+    }
+    Trace reference = trace(path, referenceTimes, true, true);
+
+    float referenceStretch = 0.0f;
+    for (unsigned int f=0; f<reference.sprites.size(); f++){
+        referenceStretch = MAX(referenceStretch, ofVec2f(reference.sprites[f] - reference.hands[f]).length());
+    }
+
+    vector<float> times = frameTimes(pattern, seconds);
+    Trace first = trace(path, times, fixedStep, true);
+
+    result.numFrames = times.size();
+    result.microsPerFrame = first.micros/MAX(times.size(), 1);
+
+    // The simulation at the same sim time should not depend on how frames came. With a
+    // fixed step both replays stop on step boundaries, so many match (steps are 4ms apart);
+    // with variable steps only the frame times both patterns share do. Input smoothing is
+    // off here: it runs once per frame, so it does depend on the frame rate. Stalls drop
+    // sim time on purpose, so that pattern isn't compared.
+    result.consistent = true;
+    if (pattern != FRAMES_DROPPED){
+        Trace raw = trace(path, times, fixedStep, false);
+        Trace steady = trace(path, frameTimes(FRAMES_STEADY_60, seconds), fixedStep, false);
+        unsigned int other = 0;
+        for (unsigned int f=0; f<raw.simTimes.size(); f++){
+            while (other + 1 < steady.simTimes.size() && steady.simTimes[other] < raw.simTimes[f] - 0.0001f) other++;
+            if (fabsf(steady.simTimes[other] - raw.simTimes[f]) > 0.0001f) continue;
+            result.numMatched++;
+            float divergence = ofVec2f(raw.simPositions[f] - steady.simPositions[other]).length();
+            result.maxDivergence = MAX(result.maxDivergence, divergence);
+        }
+        // frames that miss the path's own samples see its corners cut a little, so the
+        // hand itself differs by up to a couple of px
+        result.consistent = result.numMatched > 0 && result.maxDivergence <= 2.0f;
+    }
+
+    bool finite = true;
+    double squaredSum = 0.0;
+    unsigned int ref = 0;
+
+    for (unsigned int f=0; f<times.size(); f++){
+        const ofPoint & sprite = first.sprites[f];
+        if (!(fabsf(sprite.x) < 1e9f && fabsf(sprite.y) < 1e9f)){
+            finite = false;
+            continue;
+        }
+
+        result.maxStretch = MAX(result.maxStretch, ofVec2f(sprite - first.hands[f]).length());
+
+        // reference sprite at this frame's time
+        while (ref + 1 < reference.times.size() && reference.times[ref + 1] <= times[f]) ref++;
+        float deviation = ofVec2f(sprite - reference.sprites[ref]).length();
+        squaredSum += deviation*deviation;
+        result.maxDeviation = MAX(result.maxDeviation, deviation);
+    }
+
+    result.rmsDeviation = sqrt(squaredSum/MAX(times.size(), 1));
+    result.stable = finite && result.maxStretch <= 2.0f*referenceStretch + 10.0f;
+
+    return result;
+}
+
+bool ofxHandPhysicsBenchmark::run(const vector<PathSample> &path)
+{
+    bool passed = true;
+    for (int fixedStep = 1; fixedStep >= 0; fixedStep--){
+        for (int p=0; p<NUM_FRAME_PATTERNS; p++){
+            Result result = replay(path, (FramePattern)p, fixedStep);
+            logResult(result);
+            if (fixedStep && (!result.stable || !result.consistent)){
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+void ofxHandPhysicsBenchmark::logResult(const Result &result)
+{
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: " << (result.fixedStep ? "fixed step, " : "variable step, ")
+       << patternNames[result.pattern] << ": " << result.numFrames << " frames, "
+       << (result.stable ? "stable" : "UNSTABLE") << ", ";
+    if (result.pattern == FRAMES_DROPPED){
+        ss << "not compared with steady 60Hz (stalls drop sim time)";
+    }
+    else{
+        ss << (result.consistent ? "consistent" : "NOT consistent") << " with steady 60Hz ("
+           << result.numMatched << " sim times matched, max divergence " << result.maxDivergence << "px)";
+    }
+    ss << ". Max stretch " << result.maxStretch << "px, deviation from reference rms "
+       << result.rmsDeviation << "px max " << result.maxDeviation << "px, "
+       << result.microsPerFrame << "us per frame";
+    ofLog(result.stable ? OF_LOG_NOTICE : OF_LOG_WARNING, ss.str());
+}
+
+ofxHandPhysicsBenchmark::PipelineResult::PipelineResult() :
+    numFrames(0),
+    maxTrackedHands(0),
+    handsAdded(0),
+    handsRemoved(0),
+    badPositions(0),
+    badHandles(0),
+    staleHandles(0),
+    microsPerFrame(0.0),
+    maxMicrosPerFrame(0.0)
+{
+}
+
+ofxHandPhysicsBenchmark::PipelineResult ofxHandPhysicsBenchmark::runPipeline(ofxHandTrackingSource &source, float seconds)
+{
+    ofxHandPhysicsManager physics(source);
+    configure(physics, true);
+
+    PipelineResult result;
+    unsigned int lastTracked = 0;
+    double totalMicros = 0.0;
+
+    typedef ofxHandPhysicsManager::HandHandle HandHandle;
+    vector<HandHandle> live;        // every tracked hand's handle after the last update
+    vector<HandHandle> departed;    // handles of hands that left, until their slot is reused
+
+    for (float t = 0.0f; t < seconds; t += 1.0f/60.0f){
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        physics.update(t);
+        unsigned int tracked = physics.getNumTrackedHands();
+        for (unsigned int i=0; i<tracked; i++){
+            ofPoint sprite = physics.getNormalizedSpritePositionForHand(i);
+            ofPoint hand = physics.getHandPositionForHand(i);
+            float speed = physics.getAbsSpriteVelocityForHand(i);
+            bool finite = fabsf(sprite.x) < 1e9f && fabsf(sprite.y) < 1e9f && fabsf(hand.x) < 1e9f && fabsf(hand.y) < 1e9f && speed < 1e9f;
+            if (!finite){
+                result.badPositions++;
+            }
+        }
+
+        double micros = ofGetElapsedTimeMicros() - startTime;
+        totalMicros += micros;
+        result.maxMicrosPerFrame = MAX(result.maxMicrosPerFrame, micros);
+
+        // Handles: a tracked hand's has to resolve to its own state, and one kept from
+        // before the hand left must never resolve again - in particular not once another
+        // hand has taken its slot (the low byte of a handle)
+        vector<HandHandle> current(tracked);
+        for (unsigned int i=0; i<tracked; i++){
+            current[i] = physics.getHandleForHand(i);
+            if (!physics.isHandleValid(current[i]) || &physics.getPhysicsStateForHandle(current[i]) != &physics.getPhysicsStateForHand(i)){
+                result.badHandles++;
+            }
+        }
+        for (unsigned int h=0; h<live.size(); h++){
+            if (std::find(current.begin(), current.end(), live[h]) == current.end()){
+                departed.push_back(live[h]);
+            }
+        }
+        for (int d = (int)departed.size() - 1; d >= 0; d--){
+            if (physics.isHandleValid(departed[d])){
+                result.badHandles++;
+            }
+            for (unsigned int i=0; i<tracked; i++){
+                if ((current[i] & 0xFF) == (departed[d] & 0xFF)){
+                    result.staleHandles++;
+                    departed.erase(departed.begin() + d);
+                    break;
+                }
+            }
+        }
+        live.swap(current);
+
+        if (tracked > lastTracked) result.handsAdded += tracked - lastTracked;
+        if (tracked < lastTracked) result.handsRemoved += lastTracked - tracked;
+        result.maxTrackedHands = MAX(result.maxTrackedHands, tracked);
+        lastTracked = tracked;
+        result.numFrames++;
+    }
+
+    result.microsPerFrame = totalMicros/MAX(result.numFrames, 1);
+    return result;
+}
+
+void ofxHandPhysicsBenchmark::logPipelineResult(const PipelineResult &result)
+{
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: pipeline, " << result.numFrames << " frames, up to "
+       << result.maxTrackedHands << " hands (" << result.handsAdded << " added, "
+       << result.handsRemoved << " removed), " << result.badPositions << " bad positions, "
+       << result.badHandles << " bad handles (" << result.staleHandles << " stale handles checked against a reused slot), "
+       << result.microsPerFrame << "us per frame (max " << result.maxMicrosPerFrame << "us)";
+    ofLog(result.badPositions == 0 && result.badHandles == 0 ? OF_LOG_NOTICE : OF_LOG_WARNING, ss.str());
+}
+
+ofxHandPhysicsBenchmark::FilterConditions::FilterConditions() :
+    sampleRate(30.0f),
+    sensorLatency(0.05f),
+    displayLatency(1.0f/60.0f),
+    noise(2.0f),
+    seed(1)
+{
+}
+
+ofxHandPhysicsBenchmark::FilterResult::FilterResult() :
+    type(HAND_FILTER_ONE_POLE),
+    predicted(false),
+    numFrames(0),
+    lagMillis(0.0f),
+    jitter(0.0f),
+    rmsError(0.0f),
+    maxError(0.0f)
+{
+}
+
+ofxHandPhysicsBenchmark::FilterResult ofxHandPhysicsBenchmark::evaluateFilter(const vector<PathSample> &path, ofxHandFilterType type, bool predict,
+                                                                             const FilterConditions &conditions, const ofxHandFilterSettings &settings)
+{
+    FilterResult result;
+    result.type = type;
+    result.predicted = predict && type != HAND_FILTER_ONE_POLE;
+    if (path.size() < 2 || conditions.sampleRate <= 0.0f) return result;
+
+    // the same run without noise tells how much of the noise makes it to the screen
+    FilterConditions noiseless = conditions;
+    noiseless.noise = 0.0f;
+    vector<float> seenTimes;
+    vector<ofPoint> drawn = filteredHand(path, type, result.predicted, conditions, settings, seenTimes);
+    vector<ofPoint> drawnNoiseless = filteredHand(path, type, result.predicted, noiseless, settings, seenTimes);
+    result.numFrames = drawn.size();
+    if (drawn.empty()) return result;
+
+    // lag: the shift of the real path that the noiseless hand follows most closely
+    float bestShift = 0.0f;
+    float bestSquared = -1.0f;
+    for (float shift = -0.1f; shift <= 0.3f; shift += 0.002f){
+        float squaredSum = 0.0f;
+        for (unsigned int f=0; f<drawn.size(); f++){
+            squaredSum += ofVec2f(drawnNoiseless[f] - pathPosition(path, seenTimes[f] - shift)).lengthSquared();
+        }
+        if (bestSquared < 0.0f || squaredSum < bestSquared){
+            bestSquared = squaredSum;
+            bestShift = shift;
+        }
+    }
+    result.lagMillis = bestShift*1000.0f;
+
+    double squaredError = 0.0;
+    double squaredJitter = 0.0;
+    for (unsigned int f=0; f<drawn.size(); f++){
+        float error = ofVec2f(drawn[f] - pathPosition(path, seenTimes[f])).length();
+        squaredError += error*error;
+        result.maxError = MAX(result.maxError, error);
+        squaredJitter += ofVec2f(drawn[f] - drawnNoiseless[f]).lengthSquared();
+    }
+    result.rmsError = sqrt(squaredError/drawn.size());
+    result.jitter = sqrt(squaredJitter/drawn.size());
+
+    return result;
+}
+
+vector<ofPoint> ofxHandPhysicsBenchmark::filteredHand(const vector<PathSample> &path, ofxHandFilterType type, bool predict,
+                                                     const FilterConditions &conditions, const ofxHandFilterSettings &settings,
+                                                     vector<float> &seenTimes)
+{
+    PathTrackingSource source(path, conditions, &ofxHandPhysicsBenchmark::pathPosition);
+    ofxHandPhysicsManager physics(source);
+    configure(physics, true);
+    physics.physicsEnabled = false;
+    physics.filterType = type;
+    physics.filterSettings = settings;
+    physics.predictionScale = predict ? 1.0f : 0.0f;
+    physics.sensorLatency = conditions.sensorLatency;
+
+    // what each frame showed and when it was seen, once the filter has settled
+    vector<ofPoint> drawn;
+    seenTimes.clear();
+    float settleTime = path.front().time + 1.0f;
+    for (float t = path.front().time; t <= path.back().time; t += 1.0f/60.0f){
+        physics.update(t);
+        physics.frameDisplayed(t + conditions.displayLatency);
+        if (t < settleTime || physics.getNumTrackedHands() == 0) continue;
+        seenTimes.push_back(t + conditions.displayLatency);
+        drawn.push_back(physics.getHandPositionForHand(0));
+    }
+    return drawn;
+}
+
+void ofxHandPhysicsBenchmark::runFilters(const vector<PathSample> &path, const FilterConditions &conditions)
+{
+    logFilterResult(evaluateFilter(path, HAND_FILTER_ONE_POLE, false, conditions));
+    for (int type = HAND_FILTER_ONE_EURO; type < NUM_HAND_FILTER_TYPES; type++){
+        logFilterResult(evaluateFilter(path, (ofxHandFilterType)type, false, conditions));
+        logFilterResult(evaluateFilter(path, (ofxHandFilterType)type, true, conditions));
+    }
+}
+
+void ofxHandPhysicsBenchmark::logFilterResult(const FilterResult &result)
+{
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: " << ofxHandFilterName(result.type)
+       << (result.predicted ? " + prediction" : "") << ": " << result.numFrames << " frames, lag "
+       << result.lagMillis << "ms, jitter " << result.jitter << "px, error rms "
+       << result.rmsError << "px max " << result.maxError << "px";
+    ofLog(OF_LOG_NOTICE, ss.str());
+}
+
+vector<ofxHandPhysicsBenchmark::PathSample> ofxHandPhysicsBenchmark::loadRecordedPath(const string &recordingPath)
+{
+    vector<PathSample> path;
+    ofxRecordedTrackingSource recording;
+    if (!recording.load(recordingPath)) return path;
+
+    ofxHandTrackingJoint joint = recording.tracksUsers() ? TRACKING_JOINT_RIGHT_HAND : TRACKING_JOINT_HAND;
+    unsigned int id = 0;
+    float lastSampleTime = -1.0f;
+
+    // step through at 1kHz so every frame record is seen on its own
+    for (float t = 0.0f; t <= recording.getDuration() + 0.001f; t += 0.001f){
+        recording.update(t);
+        ofxHandTrackingEvent event;
+        while (recording.getNextEvent(event)){
+            if (event.type == ofxHandTrackingEvent::LEFT && event.id == id) return path;
+        }
+        if (id == 0 && recording.getNumTracked() > 0){
+            id = recording.getTrackedID(0);
+        }
+
+        ofPoint position;
+        if (id == 0 || recording.getSampleTime() == lastSampleTime || !recording.getJointPosition(id, joint, position)) continue;
+        lastSampleTime = recording.getSampleTime();
+        path.push_back(PathSample(lastSampleTime, position));
+    }
+    return path;
+}
+
+ofxHandPhysicsBenchmark::RopeResult::RopeResult() :
+    numRopes(0),
+    links(0),
+    numFrames(0),
+    microsPerFrame(0.0),
+    scalarMicrosPerFrame(0.0),
+    maxDifference(0.0f),
+    finite(false)
+{
+}
+
+ofxHandPhysicsBenchmark::RopeResult ofxHandPhysicsBenchmark::benchmarkRopes(unsigned int numRopes, unsigned int links, float seconds)
+{
+    RopeResult result;
+    result.numRopes = numRopes = CLAMP(numRopes, 1, MAX_TRACKED_JOINTS);
+    result.links = links;
+
+    // ofApplication's parameters, stepped like ofxHandPhysicsManager does at 60fps
+    ofxHandRopes::Parameters parameters;
+    parameters.stiffness = 100.0f;
+    parameters.restLength = 0.0f;
+    parameters.gravity = ofVec2f(0, 7000.0f);
+    float dt = 1.0f/240.0f;
+    parameters.damping = powf(1.0f - 0.08f, dt*60.0f);
+
+    ofxHandRopes ropes[2];
+    for (int v=0; v<2; v++){
+        ropes[v].setup(MAX_TRACKED_JOINTS, links);
+        ropes[v].vectorized = v == 0;
+    }
+
+    double micros[2] = {0.0, 0.0};
+    ofVec2f anchors[MAX_TRACKED_JOINTS];
+    result.numFrames = seconds*60.0f;
+
+    for (unsigned int f=0; f<result.numFrames; f++){
+        for (int v=0; v<2; v++){
+            unsigned long long startTime = ofGetElapsedTimeMicros();
+            for (unsigned int s=0; s<4; s++){
+                float t = (f*4 + s + 1)*dt;
+                for (unsigned int r=0; r<numRopes; r++){
+                    // each hand swinging in its own circle
+                    float phase = t*(3.0f + r*0.37f);
+                    anchors[r] = ofVec2f(40.0f + r*35.0f + cosf(phase)*60.0f, 200.0f + sinf(phase)*60.0f);
+                    if (f == 0 && s == 0) ropes[v].resetRope(r, anchors[r]);
+                }
+                ropes[v].step(numRopes, anchors, dt, parameters);
+            }
+            ropes[v].updateVertices(numRopes, 1.0f);
+            micros[v] += ofGetElapsedTimeMicros() - startTime;
+        }
+    }
+
+    result.microsPerFrame = micros[0]/MAX(result.numFrames, 1);
+    result.scalarMicrosPerFrame = micros[1]/MAX(result.numFrames, 1);
+
+    result.finite = true;
+    const float *vertices = ropes[0].getVertices();
+    const float *scalarVertices = ropes[1].getVertices();
+    for (unsigned int i=0; i<numRopes*(links + 1)*2; i++){
+        if (!(fabsf(vertices[i]) < 1e9f)) result.finite = false;
+        result.maxDifference = MAX(result.maxDifference, fabsf(vertices[i] - scalarVertices[i]));
+    }
+
+    return result;
+}
+
+bool ofxHandPhysicsBenchmark::runRopes()
+{
+    unsigned int ropeCounts[] = {1, 2, 4, 8, 16};
+    unsigned int linkCounts[] = {64, 128, 256, 512};
+    bool finite = true;
+    for (unsigned int r=0; r<5; r++){
+        for (unsigned int l=0; l<4; l++){
+            RopeResult result = benchmarkRopes(ropeCounts[r], linkCounts[l]);
+            logRopeResult(result);
+            finite = finite && result.finite;
+        }
+    }
+    return finite;
+}
+
+void ofxHandPhysicsBenchmark::logRopeResult(const RopeResult &result)
+{
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: " << result.numRopes << " ropes x " << result.links << " links: "
+       << result.microsPerFrame << "us per frame (scalar " << result.scalarMicrosPerFrame << "us), "
+       << "max difference " << result.maxDifference << "px" << (result.finite ? "" : ", NOT FINITE");
+    ofLog(result.finite ? OF_LOG_NOTICE : OF_LOG_WARNING, ss.str());
+}
+
+ofxHandPhysicsBenchmark::ParticleResult::ParticleResult() :
+    numThreads(1),
+    vectorized(true),
+    numFrames(0),
+    meanParticles(0),
+    microsPerFrame(0.0),
+    maxMicrosPerFrame(0.0)
+{
+}
+
+ofxHandPhysicsBenchmark::ParticleResult ofxHandPhysicsBenchmark::benchmarkParticles(unsigned int numParticles, unsigned int numThreads,
+                                                                                     bool vectorized, float seconds)
+{
+    ParticleResult result;
+    result.vectorized = vectorized;
+
+    // lives are uniform in [life/2, life], so emitting numParticles every 0.75*life
+    // seconds holds the pool at about numParticles; the headroom absorbs the ripple
+    const float life = 2.0f;
+    const unsigned int numEmitters = 4;
+    float dt = 1.0f/60.0f;
+    float perEmitterPerFrame = numParticles/(0.75f*life)*dt/numEmitters;
+
+    ofxNDParticleSystem particles;
+    particles.setup(numParticles + numParticles/4);
+    particles.setNumThreads(numThreads);
+    particles.vectorized = vectorized;
+    result.numThreads = particles.getNumThreads();
+
+    ofxNDParticleSystem::Parameters parameters;
+    parameters.gravity = ofVec2f(0, 150.0f);
+    parameters.drag = 0.2f;
+
+    // fill to the steady state first, untimed
+    unsigned int warmupFrames = life*60.0f;
+    unsigned int totalFrames = warmupFrames + seconds*60.0f;
+    float owed[numEmitters] = {0.0f};
+    double totalMicros = 0.0;
+    double totalParticles = 0.0;
+
+    for (unsigned int f=0; f<totalFrames; f++){
+        float t = f*dt;
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        emitParticles(particles, t, perEmitterPerFrame, life, owed);
+        particles.update(dt, parameters);
+
+        double micros = ofGetElapsedTimeMicros() - startTime;
+        if (f >= warmupFrames){
+            totalMicros += micros;
+            totalParticles += particles.getNumParticles();
+            result.maxMicrosPerFrame = MAX(result.maxMicrosPerFrame, micros);
+            result.numFrames++;
+        }
+    }
+
+    result.microsPerFrame = totalMicros/MAX(result.numFrames, 1);
+    result.meanParticles = totalParticles/MAX(result.numFrames, 1);
+    return result;
+}
+
+bool ofxHandPhysicsBenchmark::checkParticles(unsigned int numParticles, float seconds)
+{
+    // the first is the reference
+    const unsigned int numPaths = 5;
+    unsigned int threadCounts[numPaths] = {1, 1, 2, 4, 4};
+    bool vectorizedPaths[numPaths] = {false, true, true, true, false};
+
+    const float life = 2.0f;
+    float dt = 1.0f/60.0f;
+    float perEmitterPerFrame = numParticles/(0.75f*life)*dt/4;
+
+    ofxNDParticleSystem::Parameters parameters;
+    parameters.gravity = ofVec2f(0, 150.0f);
+    parameters.drag = 0.2f;
+
+    vector<ofxNDParticleSystem*> systems(numPaths);
+    float owed[numPaths][4];
+    for (unsigned int p=0; p<numPaths; p++){
+        systems[p] = new ofxNDParticleSystem();
+        systems[p]->setup(numParticles + numParticles/4);
+        systems[p]->setNumThreads(threadCounts[p]);
+        systems[p]->vectorized = vectorizedPaths[p];
+        for (unsigned int e=0; e<4; e++) owed[p][e] = 0.0f;
+    }
+
+    unsigned int numFrames = seconds*60.0f;
+    unsigned int firstMismatch[numPaths];
+    for (unsigned int p=0; p<numPaths; p++) firstMismatch[p] = numFrames;
+    unsigned long long numCompared = 0;
+
+    for (unsigned int f=0; f<numFrames; f++){
+        for (unsigned int p=0; p<numPaths; p++){
+            emitParticles(*systems[p], f*dt, perEmitterPerFrame, life, owed[p]);
+            systems[p]->update(dt, parameters);
+        }
+
+        const ofxNDParticleSystem & reference = *systems[0];
+        size_t bytes = 2*reference.getNumParticles()*sizeof(float);
+        for (unsigned int p=1; p<numPaths; p++){
+            const ofxNDParticleSystem & other = *systems[p];
+            bool same = other.getNumParticles() == reference.getNumParticles() &&
+                        memcmp(other.getPositions(), reference.getPositions(), bytes) == 0 &&
+                        memcmp(other.getShapes(), reference.getShapes(), bytes) == 0 &&
+                        memcmp(other.getVelocities(), reference.getVelocities(), bytes) == 0 &&
+                        memcmp(other.getRates(), reference.getRates(), bytes) == 0;
+            if (!same && firstMismatch[p] == numFrames) firstMismatch[p] = f;
+        }
+        numCompared += reference.getNumParticles();
+    }
+
+    bool identical = true;
+    for (unsigned int p=1; p<numPaths; p++){
+        bool same = firstMismatch[p] == numFrames;
+        identical = identical && same;
+        stringstream ss;
+        ss << "ofxHandPhysicsBenchmark: particles " << (vectorizedPaths[p] ? "SIMD" : "scalar") << " on " << threadCounts[p]
+           << (threadCounts[p] > 1 ? " threads" : " thread") << " vs scalar on 1: " << numFrames << " frames, "
+           << numCompared << " particle states, ";
+        if (same) ss << "identical";
+        else ss << "DIFFERENT from frame " << firstMismatch[p];
+        ofLog(same ? OF_LOG_NOTICE : OF_LOG_ERROR, ss.str());
+    }
+
+    for (unsigned int p=0; p<numPaths; p++){
+        delete systems[p];
+    }
+    return identical;
+}
+
+void ofxHandPhysicsBenchmark::runParticles()
+{
+    logParticleResult(benchmarkParticles(100000, 1, false));
+    logParticleResult(benchmarkParticles(100000, 1, true));
+
+    unsigned int particleCounts[] = {100000, 200000, 400000};
+    unsigned int threadCounts[] = {1, 2, 4};
+    for (unsigned int p=0; p<3; p++){
+        for (unsigned int t=0; t<3; t++){
+            logParticleResult(benchmarkParticles(particleCounts[p], threadCounts[t]));
+        }
+    }
+}
+
+void ofxHandPhysicsBenchmark::logParticleResult(const ParticleResult &result)
+{
+    // a 60fps frame has 16.7ms for everything, so the particles get a third of it at most
+    bool inBudget = result.microsPerFrame < 1000000.0/60.0/3.0;
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: " << result.meanParticles << " particles, " << result.numThreads
+       << (result.numThreads > 1 ? " threads" : " thread") << (result.vectorized ? "" : " (scalar)") << ": "
+       << result.microsPerFrame << "us per frame (worst " << result.maxMicrosPerFrame << "us)"
+       << (inBudget ? "" : ", OVER BUDGET");
+    ofLog(inBudget ? OF_LOG_NOTICE : OF_LOG_WARNING, ss.str());
+}
+
+ofxHandPhysicsBenchmark::JointResult::JointResult() :
+    numUsers(0),
+    numSprites(0),
+    numFrames(0),
+    microsPerFrame(0.0),
+    perSpriteMicrosPerFrame(0.0),
+    queryMicrosPerFrame(0.0),
+    getterMicrosPerFrame(0.0),
+    maxDeviation(0.0f),
+    finite(true)
+{
+}
+
+ofxHandPhysicsBenchmark::JointResult ofxHandPhysicsBenchmark::benchmarkJoints(unsigned int numUsers, ofxHandTrackingJointSet joints, float seconds)
+{
+    JointResult result;
+    result.numUsers = numUsers;
+
+    ofxSyntheticTrackingSource source(numUsers, 1);
+    source.setSampling(30.0f, 0.0f);
+
+    // the manager carries every sprite's history, too big for the stack
+    ofxHandPhysicsManager *physics = new ofxHandPhysicsManager(source);
+    configure(*physics, true);
+    physics->setJointSet(joints);
+
+    vector<ofxHandPhysicsManager::SpriteSample> sprites(MAX_TRACKED_JOINTS);
+    vector<ofxHandPhysicsManager::ofxHandPhysicsState> reference;
+
+    double micros = 0.0, perSpriteMicros = 0.0, queryMicros = 0.0, getterMicros = 0.0;
+    float checksum = 0.0f;
+    result.numFrames = seconds*60.0f;
+
+    for (unsigned int f=0; f<result.numFrames; f++){
+        float t = f/60.0f;
+
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+        physics->update(t);
+        unsigned long long queryTime = ofGetElapsedTimeMicros();
+        unsigned int n = physics->getSprites(&sprites[0], sprites.size());
+        unsigned long long endTime = ofGetElapsedTimeMicros();
+        micros += endTime - startTime;
+        queryMicros += endTime - queryTime;
+
+        // what ofApplication used to do: one getter call per value per hand
+        startTime = ofGetElapsedTimeMicros();
+        for (unsigned int h=0; h<physics->getNumTrackedHands(); h++){
+            ofPoint position = physics->getNormalizedSpritePositionForHand(h);
+            ofVec2f velocity = physics->getPhysicsStateForHand(h).spriteVelocity;
+            checksum += position.x + velocity.y;
+        }
+        getterMicros += ofGetElapsedTimeMicros() - startTime;
+
+        // the same raw joints through the one-at-a-time path; ids never change here,
+        // so hand h is the same joint every frame
+        if (reference.size() != n){
+            reference.assign(n, ofxHandPhysicsManager::ofxHandPhysicsState());
+        }
+        startTime = ofGetElapsedTimeMicros();
+        for (unsigned int h=0; h<n; h++){
+            ofPoint raw;
+            if (source.getJointPosition(sprites[h].id, sprites[h].joint, raw)){
+                physics->updatePhysState(reference[h], raw, t, source.getSampleTime());
+            }
+        }
+        perSpriteMicros += ofGetElapsedTimeMicros() - startTime;
+
+        for (unsigned int h=0; h<n; h++){
+            ofVec2f batched = sprites[h].position*ofVec2f(source.getWidth(), source.getHeight());
+            ofVec2f single = reference[h].spritePositions[0];
+            if (!(fabsf(batched.x) < 1e6f && fabsf(batched.y) < 1e6f)) result.finite = false;
+            result.maxDeviation = MAX(result.maxDeviation, (batched - single).length());
+        }
+        result.numSprites = MAX(result.numSprites, n);
+    }
+    delete physics;
+
+    if (!(checksum == checksum)) result.finite = false;
+    result.microsPerFrame = micros/MAX(result.numFrames, 1);
+    result.perSpriteMicrosPerFrame = perSpriteMicros/MAX(result.numFrames, 1);
+    result.queryMicrosPerFrame = queryMicros/MAX(result.numFrames, 1);
+    result.getterMicrosPerFrame = getterMicros/MAX(result.numFrames, 1);
+    return result;
+}
+
+bool ofxHandPhysicsBenchmark::runJoints()
+{
+    unsigned int userCounts[] = {1, 2, 6};
+    ofxHandTrackingJointSet jointSets[] = {TRACKING_JOINTS_HANDS, TRACKING_JOINTS_USER};
+    bool finite = true;
+    for (unsigned int u=0; u<3; u++){
+        for (unsigned int j=0; j<2; j++){
+            JointResult result = benchmarkJoints(userCounts[u], jointSets[j]);
+            logJointResult(result);
+            finite = finite && result.finite;
+        }
+    }
+    return finite;
+}
+
+void ofxHandPhysicsBenchmark::logJointResult(const JointResult &result)
+{
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: " << result.numUsers << " users, " << result.numSprites << " joints: "
+       << result.microsPerFrame << "us per frame (one at a time " << result.perSpriteMicrosPerFrame << "us), query "
+       << result.queryMicrosPerFrame << "us (getters " << result.getterMicrosPerFrame << "us), max deviation "
+       << result.maxDeviation << "px" << (result.finite ? "" : ", NOT FINITE");
+    ofLog(result.finite ? OF_LOG_NOTICE : OF_LOG_WARNING, ss.str());
+}
+
+ofxHandPhysicsBenchmark::OverlapResult::OverlapResult() :
+    threaded(false),
+    numSprites(0),
+    numFrames(0),
+    renderMicros(0.0f),
+    frameMicros(0.0),
+    stepMicros(0.0),
+    waitMicros(0.0)
+{
+}
+
+ofxHandPhysicsBenchmark::OverlapResult ofxHandPhysicsBenchmark::benchmarkOverlap(bool threaded, unsigned int numUsers, unsigned int ropeLinks,
+                                                                                 float renderMicros, float seconds)
+{
+    OverlapResult result;
+    result.threaded = threaded;
+    result.renderMicros = renderMicros;
+
+    ofxSyntheticTrackingSource source(numUsers, 1);
+    source.setSampling(30.0f, 0.0f);
+
+    ofxHandPhysicsManager *physics = new ofxHandPhysicsManager(source);
+    configure(*physics, true);
+    physics->setJointSet(TRACKING_JOINTS_USER);
+    physics->setRopeLinks(ropeLinks);
+
+    ofxHandPhysicsThread *physicsThread = new ofxHandPhysicsThread(*physics);
+    physicsThread->setThreaded(threaded);
+
+    double frameMicros = 0.0, stepMicros = 0.0, waitMicros = 0.0;
+    float checksum = 0.0f;
+    result.numFrames = seconds*60.0f;
+
+    for (unsigned int f=0; f<result.numFrames; f++){
+        unsigned long long frameStart = ofGetElapsedTimeMicros();
+
+        // what ofApplication::update does with the device
+        physicsThread->finish();
+        physicsThread->start(f/60.0f);
+        unsigned long long renderStart = ofGetElapsedTimeMicros();
+
+        // "drawing": touch what was published, then burn the rest of the budget
+        const ofxHandPhysicsFrame & hands = physicsThread->front();
+        for (unsigned int h=0; h<hands.numHands; h++){
+            checksum += hands.sprites[h].position.x + hands.handPositions[h].y;
+        }
+        unsigned int nRopeFloats = hands.ropeLinks > 0 ? hands.numHands*(hands.ropeLinks + 1)*2 : 0;
+        for (unsigned int v=0; v<nRopeFloats; v++){
+            checksum += hands.ropeVertices[v];
+        }
+        while (ofGetElapsedTimeMicros() - renderStart < renderMicros){
+            checksum += 1e-9f;
+        }
+
+        frameMicros += ofGetElapsedTimeMicros() - frameStart;
+        stepMicros += physicsThread->getStepMicros();
+        waitMicros += physicsThread->getWaitMicros();
+        result.numSprites = MAX(result.numSprites, hands.numHands);
+        physicsThread->frameDisplayed(f/60.0f + renderMicros*1e-6f);
+    }
+
+    delete physicsThread;
+    delete physics;
+
+    if (checksum != checksum){
+        ofLog(OF_LOG_WARNING, "ofxHandPhysicsBenchmark: overlap run produced NaNs");
+    }
+    result.frameMicros = frameMicros/MAX(result.numFrames, 1);
+    result.stepMicros = stepMicros/MAX(result.numFrames, 1);
+    result.waitMicros = waitMicros/MAX(result.numFrames, 1);
+    return result;
+}
+
+void ofxHandPhysicsBenchmark::runOverlap()
+{
+    logOverlapResult(benchmarkOverlap(false));
+    logOverlapResult(benchmarkOverlap(true));
+}
+
+void ofxHandPhysicsBenchmark::logOverlapResult(const OverlapResult &result)
+{
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: " << (result.threaded ? "overlapped" : "serial") << ", " << result.numSprites
+       << " sprites, " << result.renderMicros << "us render: " << result.frameMicros << "us per frame, step "
+       << result.stepMicros << "us, " << result.waitMicros << "us of it on the render thread";
+    ofLog(OF_LOG_NOTICE, ss.str());
+}
+
+static const char * gestureNames[] = {
+    "circle cw", "circle ccw", "swipe right", "swipe left", "swipe up", "swipe down", "zigzag", "v"
+};
+
+vector<ofxHandPhysicsBenchmark::GestureCue> ofxHandPhysicsBenchmark::recordGestures(const string &recordingPath, unsigned int numUsers,
+                                                                                    float seconds, unsigned int seed)
+{
+    vector<GestureCue> script;
+    vector<GesturePerformanceSource::Cue> cues;
+
+    unsigned int random = seed*2246822519u + 3;
+    for (unsigned int k=0; ; k++){
+        float start = 1.0f + 2.5f*k;
+        if (start + 2.0f > seconds) break;
+
+        for (unsigned int u=0; u<numUsers; u++){
+            GesturePerformanceSource::Cue cue;
+            cue.user = u;
+            cue.start = start + 0.37f*u;
+
+            #define UNIFORM() (random = random*1664525u + 1013904223u, ((random >> 8) + 0.5f)/16777216.0f)
+            cue.duration = 0.9f + 0.4f*UNIFORM();
+            unsigned int kind = (k + u) % 8;
+
+            // each shape a little off the template: ellipses, bent swipes, uneven strokes
+            vector<ofPoint> shape;
+            if (kind < 2){
+                float aspect = 0.85f + 0.3f*UNIFORM();
+                float phase = TWO_PI*UNIFORM();
+                for (int i=0; i<=64; i++){
+                    float angle = phase + (kind == 0 ? 1.0f : -1.0f)*TWO_PI*i/64.0f;
+                    shape.push_back(ofPoint(cosf(angle), sinf(angle)*aspect));
+                }
+            }
+            else if (kind < 6){
+                float bend = 0.16f*(UNIFORM() - 0.5f);
+                for (int i=0; i<=8; i++){
+                    float along = i/8.0f, across = bend*sinf(PI*along);
+                    if (kind == 2) shape.push_back(ofPoint(along, across));
+                    if (kind == 3) shape.push_back(ofPoint(-along, across));
+                    if (kind == 4) shape.push_back(ofPoint(across, -along));
+                    if (kind == 5) shape.push_back(ofPoint(across, along));
+                }
+            }
+            else if (kind == 6){
+                for (int i=0; i<5; i++){
+                    shape.push_back(ofPoint(i, (i % 2)*(0.8f + 0.4f*UNIFORM())));
+                }
+            }
+            else{
+                float depth = 2.0f*(0.8f + 0.4f*UNIFORM());
+                shape.push_back(ofPoint(0, 0));
+                shape.push_back(ofPoint(1, depth));
+                shape.push_back(ofPoint(2, 0));
+            }
+
+            // about a middle-scale window of path (12px spacing), starting at 0, 0
+            float length = 0.0f;
+            for (unsigned int i=1; i<shape.size(); i++){
+                length += (shape[i] - shape[i-1]).length();
+            }
+            float scale = 12.0f*(GESTURE_WINDOW_POINTS - 1)*(0.9f + 0.2f*UNIFORM())/length;
+            #undef UNIFORM
+
+            float travelled = 0.0f;
+            for (unsigned int i=0; i<shape.size(); i++){
+                if (i > 0) travelled += (shape[i] - shape[i-1]).length();
+                cue.shape.push_back(PathSample(travelled/length, (shape[i] - shape[0])*scale));
+            }
+            cues.push_back(cue);
+
+            GestureCue gestureCue;
+            gestureCue.id = u + 1;
+            gestureCue.name = gestureNames[kind];
+            gestureCue.start = cue.start;
+            gestureCue.end = cue.start + cue.duration;
+            script.push_back(gestureCue);
+        }
+    }
+
+    // the synthetic users are ids 1..numUsers and never leave
+    GesturePerformanceSource performance(numUsers, seed, cues, pathPosition);
+    ofxTrackingRecorder recorder(performance);
+    if (!recorder.start(recordingPath)) return vector<GestureCue>();
+
+    ofxHandTrackingEvent event;
+    for (float t = 0.0f; t <= seconds; t += 1.0f/60.0f){
+        recorder.update(t);
+        while (recorder.getNextEvent(event)) {};
+    }
+    recorder.stop();
+    return script;
+}
+
+ofxHandPhysicsBenchmark::GestureResult::GestureResult() :
+    numTracks(0),
+    numTemplates(0),
+    numScales(0),
+    numFrames(0),
+    microsPerFrame(0.0),
+    maxMicrosPerFrame(0.0),
+    scalarMicrosPerFrame(0.0),
+    numCues(0),
+    hits(0),
+    wrong(0),
+    extra(0)
+{
+}
+
+ofxHandPhysicsBenchmark::GestureResult ofxHandPhysicsBenchmark::benchmarkGestures(const string &recordingPath, const vector<GestureCue> &cues)
+{
+    GestureResult result;
+    result.numCues = cues.size();
+
+    ofxRecordedTrackingSource recording;
+    if (!recording.load(recordingPath)) return result;
+
+    ofxHandPhysicsManager *physics = new ofxHandPhysicsManager(recording);
+    configure(*physics, true);
+    physics->filterType = HAND_FILTER_ONE_EURO;
+    physics->setJointSet(TRACKING_JOINTS_USER);
+
+    ofxHandGestureRecognizer recognizer, scalarRecognizer;
+    recognizer.addDefaultTemplates();
+    scalarRecognizer.addDefaultTemplates();
+    scalarRecognizer.vectorized = false;
+    result.numTemplates = recognizer.getNumTemplates();
+    result.numScales = recognizer.getNumScales();
+
+    vector<bool> cueHit(cues.size(), false);
+    double micros = 0.0, scalarMicros = 0.0;
+
+    for (float t = 0.0f; t <= recording.getDuration(); t += 1.0f/60.0f){
+        physics->update(t);
+        unsigned int n = physics->getNumTrackedHands();
+
+        // what ofApplication does each frame, the same positions through both
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+        recognizer.beginFrame(t);
+        for (unsigned int h=0; h<n; h++){
+            recognizer.addPosition(physics->getIDForHand(h)*NUM_TRACKING_JOINTS + physics->getJointForHand(h), physics->getHandPositionForHand(h));
+        }
+        recognizer.endFrame();
+        unsigned long long frameMicros = ofGetElapsedTimeMicros() - startTime;
+
+        startTime = ofGetElapsedTimeMicros();
+        scalarRecognizer.beginFrame(t);
+        for (unsigned int h=0; h<n; h++){
+            scalarRecognizer.addPosition(physics->getIDForHand(h)*NUM_TRACKING_JOINTS + physics->getJointForHand(h), physics->getHandPositionForHand(h));
+        }
+        scalarRecognizer.endFrame();
+        scalarMicros += ofGetElapsedTimeMicros() - startTime;
+
+        micros += frameMicros;
+        result.maxMicrosPerFrame = MAX(result.maxMicrosPerFrame, (double)frameMicros);
+        result.numTracks = MAX(result.numTracks, recognizer.getNumTracks());
+        result.numFrames++;
+
+        // a cue counts if its gesture is recognized on its hand by half a second after it ends
+        ofxHandGestureRecognizer::Gesture gesture;
+        while (recognizer.getNextGesture(gesture)){
+            bool cued = false;
+            for (unsigned int c=0; c<cues.size(); c++){
+                if (gesture.key != cues[c].id*NUM_TRACKING_JOINTS + TRACKING_JOINT_RIGHT_HAND) continue;
+                if (gesture.time < cues[c].start || gesture.time > cues[c].end + 0.5f) continue;
+                cued = true;
+                if (gesture.name == cues[c].name){
+                    if (!cueHit[c]) result.hits++;
+                    cueHit[c] = true;
+                }
+                else{
+                    result.wrong++;
+                }
+            }
+            if (!cued) result.extra++;
+        }
+        while (scalarRecognizer.getNextGesture(gesture)) {};
+    }
+    delete physics;
+
+    result.microsPerFrame = micros/MAX(result.numFrames, 1);
+    result.scalarMicrosPerFrame = scalarMicros/MAX(result.numFrames, 1);
+    return result;
+}
+
+bool ofxHandPhysicsBenchmark::runGestures(const string &recordingPath)
+{
+    vector<GestureCue> cues = recordGestures(recordingPath);
+    if (cues.empty()) return false;
+    logGestureResult(benchmarkGestures(recordingPath, cues));
+    return true;
+}
+
+void ofxHandPhysicsBenchmark::logGestureResult(const GestureResult &result)
+{
+    stringstream ss;
+    ss << "ofxHandPhysicsBenchmark: gestures, " << result.numTracks << " trajectories x " << result.numTemplates << " templates x "
+       << result.numScales << " scales: " << result.microsPerFrame << "us per frame (max " << result.maxMicrosPerFrame
+       << "us, scalar " << result.scalarMicrosPerFrame << "us), " << result.hits << "/" << result.numCues << " recognized, "
+       << result.wrong << " wrong, " << result.extra << " outside cues";
+    ofLog(OF_LOG_NOTICE, ss.str());
+}
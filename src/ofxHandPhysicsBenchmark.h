@@ -0,0 +1,285 @@
+//
+//  ofxHandPhysicsBenchmark.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/12/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxHandPhysics.h"
+#include "ofxHandPhysicsThread.h"
+#include "ofxHandGestureRecognizer.h"
+#include "ofxHandTrackingSource.h"
+#include "ofxHandRopes.h"
+#include "ofxNDParticleSystem.h"
+
+/// Replays a hand path through ofxHandPhysicsManager on a synthetic clock (no device,
+/// no window) under different frame-time patterns, and compares the drawn sprite
+/// against a 1kHz reference run of the same path, and the simulated one against the
+/// steady 60Hz replay wherever both have simulated up to the same time. Also measures the lag and jitter
+/// each hand filter adds when the path is seen through a noisy, late 30Hz camera.
+class ofxHandPhysicsBenchmark {
+
+public:
+
+    struct PathSample {
+        float   time;       // seconds
+        ofPoint position;   // projective (640x480) coordinates like ofxOpenNI hands
+        PathSample(float t = 0.0f, ofPoint p = ofPoint()) : time(t), position(p) {};
+    };
+
+    enum FramePattern {
+        FRAMES_STEADY_60 = 0,
+        FRAMES_STEADY_30,
+        FRAMES_STEADY_144,
+        FRAMES_JITTER,          // uniformly 8-33ms
+        FRAMES_DROPPED,         // 60Hz with a 250ms stall every 2 seconds
+        NUM_FRAME_PATTERNS
+    };
+
+    struct Result {
+
+        FramePattern    pattern;
+        bool            fixedStep;
+        unsigned int    numFrames;
+        bool            stable;             // finite and never stretched far beyond the reference
+        bool            consistent;         // simulated where the steady 60Hz replay was, within 2px
+                                            // (both with input smoothing off, it's per frame)
+        unsigned int    numMatched;         // sim times both replays stopped at
+        float           maxDivergence;      // from the steady 60Hz replay there, px
+        float           maxStretch;         // sprite to hand distance, px
+        float           rmsDeviation;       // drawn sprite vs reference at the same time, px
+        float           maxDeviation;
+        double          microsPerFrame;
+
+        Result();
+    };
+
+    // Figure-eight with sudden direction changes, sampled at 30Hz like the Kinect
+    static vector<PathSample> syntheticPath(float seconds = 20.0f);
+
+    // CSV lines of time,x,y[,z]; lines that don't parse are skipped
+    static vector<PathSample> loadPath(const string & csvPath);
+
+    // Physics parameters are the ones ofApplication::setup uses. fixedStep false runs
+    // the old one-step-per-frame integration for comparison.
+    static Result replay(const vector<PathSample> & path, FramePattern pattern, bool fixedStep = true);
+
+    // Every frame pattern with fixed and variable stepping, logged. Returns false if a
+    // fixed step replay was unstable or not consistent.
+    static bool run(const vector<PathSample> & path);
+    static void logResult(const Result & result);
+
+    struct PipelineResult {
+
+        unsigned int    numFrames;
+        unsigned int    maxTrackedHands;
+        unsigned int    handsAdded;         // frames where the tracked count went up, summed
+        unsigned int    handsRemoved;
+        unsigned int    badPositions;       // non-finite reads, should be 0
+        unsigned int    badHandles;         // a live handle not resolving to its hand, or a stale one resolving, should be 0
+        unsigned int    staleHandles;       // handles of departed hands checked after another hand took their slot
+        double          microsPerFrame;     // source + manager update + the getters ofApplication reads
+        double          maxMicrosPerFrame;
+
+        PipelineResult();
+    };
+
+    // Soak test of the whole hand pipeline: drives a manager from source for the given
+    // time at 60Hz on a synthetic clock, reading every hand the way ofApplication draws them.
+    static PipelineResult runPipeline(ofxHandTrackingSource & source, float seconds);
+    static void logPipelineResult(const PipelineResult & result);
+
+    // How the path is seen: sampled at sampleRate with noise, arriving sensorLatency
+    // after capture, drawn at 60Hz and on screen displayLatency after each update.
+    struct FilterConditions {
+
+        float           sampleRate;         // Hz
+        float           sensorLatency;      // s
+        float           displayLatency;     // s
+        float           noise;              // px std dev per axis, added to every sample
+        unsigned int    seed;
+
+        FilterConditions();
+    };
+
+    struct FilterResult {
+
+        ofxHandFilterType   type;
+        bool                predicted;
+        unsigned int        numFrames;
+        float               lagMillis;      // time shift that best lines the drawn hand up with the real one
+        float               jitter;         // rms of the drawn hand's response to the sample noise, px
+        float               rmsError;       // drawn hand vs where the hand really is when the frame is seen, px
+        float               maxError;
+
+        FilterResult();
+    };
+
+    // Hand output (physics off) through one filter, with or without latency prediction.
+    // The manager is told sensorLatency and measures displayLatency itself.
+    static FilterResult evaluateFilter(const vector<PathSample> & path, ofxHandFilterType type, bool predict,
+                                       const FilterConditions & conditions = FilterConditions(),
+                                       const ofxHandFilterSettings & settings = ofxHandFilterSettings());
+
+    // Every filter with and without prediction, logged
+    static void runFilters(const vector<PathSample> & path, const FilterConditions & conditions = FilterConditions());
+    static void logFilterResult(const FilterResult & result);
+
+    struct RopeResult {
+
+        unsigned int    numRopes;
+        unsigned int    links;
+        unsigned int    numFrames;
+        double          microsPerFrame;         // 4 rope steps at 240Hz + vertex stream per 60Hz frame
+        double          scalarMicrosPerFrame;   // same with the plain loops
+        float           maxDifference;          // between the two, px
+        bool            finite;
+
+        RopeResult();
+    };
+
+    // Swinging ropes with ofApplication's physics parameters, vectorized and scalar
+    static RopeResult benchmarkRopes(unsigned int numRopes, unsigned int links, float seconds = 2.0f);
+
+    // 1-16 ropes of 64-512 links, logged; false if any blew up
+    static bool runRopes();
+    static void logRopeResult(const RopeResult & result);
+
+    struct ParticleResult {
+
+        unsigned int    numThreads;
+        bool            vectorized;
+        unsigned int    numFrames;
+        unsigned int    meanParticles;          // live after each update, averaged
+        double          microsPerFrame;         // emit + update (with removal) per 60Hz frame
+        double          maxMicrosPerFrame;
+
+        ParticleResult();
+    };
+
+    // Hands-free particle soak: emits from a few moving points so about numParticles
+    // stay alive, updating at 60Hz on a synthetic clock; draw cost isn't included
+    static ParticleResult benchmarkParticles(unsigned int numParticles, unsigned int numThreads,
+                                             bool vectorized = true, float seconds = 4.0f);
+
+    // The same emission from the same seed through scalar and SIMD updates on 1-4 threads,
+    // every field of the pool compared bytewise against scalar on one thread each frame;
+    // logged, false on the first difference
+    static bool checkParticles(unsigned int numParticles = 100000, float seconds = 4.0f);
+
+    // 100k particles scalar and SIMD on one thread, then 100k-400k on 1-4 threads, logged
+    static void runParticles();
+    static void logParticleResult(const ParticleResult & result);
+
+    struct JointResult {
+
+        unsigned int    numUsers;
+        unsigned int    numSprites;
+        unsigned int    numFrames;
+        double          microsPerFrame;         // source + manager update (batched) + bulk sprite query
+        double          perSpriteMicrosPerFrame;    // the same joints through updatePhysState one at a time
+        double          queryMicrosPerFrame;    // getSprites alone
+        double          getterMicrosPerFrame;   // the same values from the per-index getters
+        float           maxDeviation;           // batched vs one at a time, px
+        bool            finite;
+
+        JointResult();
+    };
+
+    // Synthetic users (30Hz, no churn) with ofApplication's physics parameters, every
+    // joint in the set driving a sprite
+    static JointResult benchmarkJoints(unsigned int numUsers = 6, ofxHandTrackingJointSet joints = TRACKING_JOINTS_USER,
+                                       float seconds = 10.0f);
+
+    // 1, 2 and 6 users with hands only and with every joint, logged; false if any blew up
+    static bool runJoints();
+    static void logJointResult(const JointResult & result);
+
+    struct OverlapResult {
+
+        bool            threaded;
+        unsigned int    numSprites;
+        unsigned int    numFrames;
+        float           renderMicros;       // the stand-in for drawing, per frame
+        double          frameMicros;        // render thread, finish() to the end of "drawing"
+        double          stepMicros;         // physics step, on whichever thread ran it
+        double          waitMicros;         // physics on the render thread's frame
+
+        OverlapResult();
+    };
+
+    // Synthetic users through ofxHandPhysicsThread at 60Hz, with ofApplication's physics
+    // parameters and ropes, while the render thread spins for renderMicros reading front()
+    static OverlapResult benchmarkOverlap(bool threaded, unsigned int numUsers = 6, unsigned int ropeLinks = 128,
+                                          float renderMicros = 4000.0f, float seconds = 5.0f);
+
+    // serial vs overlapped, logged; overlapping only pays off with a core to spare
+    static void runOverlap();
+    static void logOverlapResult(const OverlapResult & result);
+
+    // a gesture one user's right hand performs in a recording
+    struct GestureCue {
+
+        unsigned int    id;
+        string          name;       // one of ofxHandGestureRecognizer's default templates
+        float           start;      // seconds into the recording
+        float           end;
+    };
+
+    // Records synthetic users whose right hands break off to trace the default gestures
+    // (perturbed, at sizes around the middle scale) every few seconds, and returns the script
+    static vector<GestureCue> recordGestures(const string & recordingPath, unsigned int numUsers = 6,
+                                             float seconds = 30.0f, unsigned int seed = 1);
+
+    struct GestureResult {
+
+        unsigned int    numTracks;          // trajectories followed at once
+        unsigned int    numTemplates;
+        unsigned int    numScales;
+        unsigned int    numFrames;
+        double          microsPerFrame;     // recognizer only, every tracked joint
+        double          maxMicrosPerFrame;
+        double          scalarMicrosPerFrame;
+        unsigned int    numCues;
+        unsigned int    hits;               // cued gesture recognized on the cued hand in time
+        unsigned int    wrong;              // something else recognized on the cued hand meanwhile
+        unsigned int    extra;              // recognized outside any cue, on any joint
+
+        GestureResult();
+    };
+
+    // Plays a recording through ofxHandPhysicsManager (every joint of every user, 60Hz)
+    // and the default templates; cues may be empty to time a recording of a real performance
+    static GestureResult benchmarkGestures(const string & recordingPath, const vector<GestureCue> & cues);
+
+    // records a performance with 6 users, plays it back, logged; false if it couldn't be recorded
+    static bool runGestures(const string & recordingPath = "gesture_benchmark.ndht");
+    static void logGestureResult(const GestureResult & result);
+
+    // First tracked hand of an ofxTrackingRecorder recording, one sample per recorded frame.
+    // It's taken as the true path, so jitter only covers FilterConditions::noise added on top.
+    static vector<PathSample> loadRecordedPath(const string & recordingPath);
+
+private:
+
+    struct Trace {
+        vector<float>   times;
+        vector<ofPoint> sprites;
+        vector<ofPoint> hands;
+        vector<float>   simTimes;       // time the simulation had reached at each frame
+        vector<ofPoint> simPositions;
+        double          micros;
+    };
+
+    static void configure(ofxHandPhysicsManager & physics, bool fixedStep, bool smoothInput = true);
+    static Trace trace(const vector<PathSample> & path, const vector<float> & frameTimes, bool fixedStep, bool smoothInput);
+    static vector<float> frameTimes(FramePattern pattern, float seconds);
+    static vector<ofPoint> filteredHand(const vector<PathSample> & path, ofxHandFilterType type, bool predict,
+                                        const FilterConditions & conditions, const ofxHandFilterSettings & settings,
+                                        vector<float> & seenTimes);
+    static ofPoint pathPosition(const vector<PathSample> & path, float time);
+};
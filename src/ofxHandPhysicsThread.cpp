@@ -0,0 +1,177 @@
+//
+//  ofxHandPhysicsThread.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/17/12.
+//
+//
+
+#include "ofxHandPhysicsThread.h"
+
+ofxHandPhysicsFrame::ofxHandPhysicsFrame() :
+    time(0.0f),
+    numHands(0),
+    displayLatency(0.0f),
+    ropeLinks(0),
+    ropeVertices(MAX_TRACKED_JOINTS*(MAX_ROPE_LINKS + 1)*2, 0.0f)
+{
+}
+
+ofxHandPhysicsThread::ofxHandPhysicsThread(ofxHandPhysicsManager &physics) :
+    _physics(physics),
+    _worker(NULL),
+    _running(false),
+    _displayedTime(-1.0f),
+    _stepMicros(0.0f),
+    _waitMicros(0.0f)
+{
+    _frames.allocate(ofxHandPhysicsFrame());
+}
+
+ofxHandPhysicsThread::~ofxHandPhysicsThread()
+{
+    setThreaded(false);
+}
+
+void ofxHandPhysicsThread::setThreaded(bool threaded)
+{
+    if (threaded == isThreaded()) return;
+
+    finish();
+    if (threaded){
+        _worker = new StepThread(this);
+        _worker->startThread(false, false);
+    }
+    else{
+        _worker->quit();
+        delete _worker;
+        _worker = NULL;
+    }
+}
+
+void ofxHandPhysicsThread::finish()
+{
+    if (!_running) return;
+    _running = false;
+
+    if (_worker){
+        unsigned long long waitStart = ofGetElapsedTimeMicros();
+        _worker->finish();
+        _waitMicros = ofGetElapsedTimeMicros() - waitStart;
+    }
+    _frames.update();
+}
+
+void ofxHandPhysicsThread::start(float time)
+{
+    finish();
+
+    if (_worker){
+        _worker->start(time, _displayedTime);
+        _running = true;
+    }
+    else{
+        // serial: the step is the whole critical path, nothing to wait for
+        step(time, _displayedTime);
+        _waitMicros = _stepMicros;
+        _frames.update();
+    }
+}
+
+void ofxHandPhysicsThread::step(float time, float displayedTime)
+{
+    unsigned long long stepStart = ofGetElapsedTimeMicros();
+
+    if (displayedTime >= 0.0f){
+        _physics.frameDisplayed(displayedTime);
+    }
+    _physics.update(time);
+    fillFrame(_frames.back(), time);
+    _frames.publish();
+
+    _stepMicros = ofGetElapsedTimeMicros() - stepStart;
+}
+
+void ofxHandPhysicsThread::fillFrame(ofxHandPhysicsFrame &frame, float time)
+{
+    frame.time = time;
+    frame.displayLatency = _physics.getDisplayLatency();
+    frame.numHands = _physics.getSprites(frame.sprites, MAX_TRACKED_JOINTS);
+    for (unsigned int h=0; h<frame.numHands; h++){
+        frame.previousPositions[h] = _physics.getNormalizedSpritePositionForHand(h, 1);
+        frame.handPositions[h] = _physics.getHandPositionForHand(h);
+    }
+
+    frame.ropeLinks = _physics.getRopeLinks();
+    unsigned int nFloats = frame.ropeLinks > 0 ? frame.numHands*(frame.ropeLinks + 1)*2 : 0;
+    if (nFloats > 0){
+        memcpy(&frame.ropeVertices[0], _physics.getRopeVertices(), nFloats*sizeof(float));
+    }
+}
+
+#pragma mark - Worker
+
+ofxHandPhysicsThread::StepThread::StepThread(ofxHandPhysicsThread *owner) :
+    _owner(owner),
+    _pending(false),
+    _quit(false),
+    _time(0.0f),
+    _displayedTime(-1.0f)
+{
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_condition, NULL);
+}
+
+ofxHandPhysicsThread::StepThread::~StepThread()
+{
+    pthread_cond_destroy(&_condition);
+    pthread_mutex_destroy(&_mutex);
+}
+
+void ofxHandPhysicsThread::StepThread::start(float time, float displayedTime)
+{
+    pthread_mutex_lock(&_mutex);
+    _time = time;
+    _displayedTime = displayedTime;
+    _pending = true;
+    pthread_cond_broadcast(&_condition);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ofxHandPhysicsThread::StepThread::finish()
+{
+    pthread_mutex_lock(&_mutex);
+    while (_pending){
+        pthread_cond_wait(&_condition, &_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ofxHandPhysicsThread::StepThread::quit()
+{
+    pthread_mutex_lock(&_mutex);
+    _quit = true;
+    pthread_cond_broadcast(&_condition);
+    pthread_mutex_unlock(&_mutex);
+    waitForThread(true);
+}
+
+void ofxHandPhysicsThread::StepThread::threadedFunction()
+{
+    // sleeps between frames like the particle workers; a step is one frame's work
+    pthread_mutex_lock(&_mutex);
+    while (true){
+        while (!_pending && !_quit){
+            pthread_cond_wait(&_condition, &_mutex);
+        }
+        if (_quit) break;
+
+        pthread_mutex_unlock(&_mutex);
+        _owner->step(_time, _displayedTime);
+        pthread_mutex_lock(&_mutex);
+
+        _pending = false;
+        pthread_cond_broadcast(&_condition);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
@@ -0,0 +1,110 @@
+//
+//  ofxHandPhysicsThread.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/17/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxHandPhysics.h"
+#include "ofxNDTripleBuffer.h"
+#include <pthread.h>
+
+/// Everything the renderer draws from one physics step, copied out of the manager
+struct ofxHandPhysicsFrame {
+
+    float           time;               // the update(time) this came from
+    unsigned int    numHands;
+    float           displayLatency;
+
+    ofxHandPhysicsManager::SpriteSample sprites[MAX_TRACKED_JOINTS];
+    ofVec2f         previousPositions[MAX_TRACKED_JOINTS];  // normalized, stepIndex 1
+    ofPoint         handPositions[MAX_TRACKED_JOINTS];      // projective, like getHandPositionForHand
+
+    unsigned int    ropeLinks;
+    vector<float>   ropeVertices;       // like getRopeVertices, numHands*(ropeLinks + 1)*2 valid; sized for MAX_ROPE_LINKS
+
+    ofxHandPhysicsFrame();
+};
+
+/// Steps an ofxHandPhysicsManager (and so its tracking source) on a worker thread
+/// while the render thread draws the step before.
+///
+/// Each frame the render thread calls finish(), which waits for the step started
+/// last frame and swaps its result into front(), then start(time) to begin the
+/// next one. Between the two the manager and its source belong to the render
+/// thread (settings, device updates); after start() only the worker touches them,
+/// so draw from front(), which the worker never writes. Results come back through
+/// a lock-free triple buffer; the only wait is finish() catching a step that
+/// overran a whole frame.
+///
+/// Overlapped, front() is one frame older than serial - the adaptive filters'
+/// prediction sees it through frameDisplayed(). setThreaded(false) runs each step
+/// inside start() instead, through the same buffers, for comparison.
+class ofxHandPhysicsThread {
+
+public:
+
+    // the manager must outlive this
+    ofxHandPhysicsThread(ofxHandPhysicsManager &physics);
+    ~ofxHandPhysicsThread();
+
+    void    setThreaded(bool threaded);
+    bool    isThreaded() const  { return _worker != NULL; };
+
+    // render thread only
+    void    finish();
+    void    start(float time);
+
+    const ofxHandPhysicsFrame & front() const { return _frames.front(); };
+
+    // passed on to the manager with the next step
+    void    frameDisplayed(float time)  { _displayedTime = time; };
+
+    // last step's duration on whichever thread ran it, and how much of the render
+    // thread's frame physics took: the whole step serial, finish()'s wait overlapped
+    float   getStepMicros() const       { return _stepMicros; };
+    float   getWaitMicros() const       { return _waitMicros; };
+
+private:
+
+    class StepThread;
+    friend class StepThread;
+
+    // Waits for a step to run, runs it, signals it's done, repeat
+    class StepThread : public ofThread {
+    public:
+        StepThread(ofxHandPhysicsThread *owner);
+        ~StepThread();
+        void start(float time, float displayedTime);
+        void finish();
+        void quit();
+    protected:
+        void threadedFunction();
+    private:
+        ofxHandPhysicsThread *_owner;
+        pthread_mutex_t     _mutex;
+        pthread_cond_t      _condition;
+        bool                _pending;
+        bool                _quit;
+        float               _time;
+        float               _displayedTime;
+    };
+
+    // one manager update, published to the back buffer
+    void    step(float time, float displayedTime);
+    void    fillFrame(ofxHandPhysicsFrame & frame, float time);
+
+    ofxHandPhysicsManager &     _physics;
+    StepThread *                _worker;
+    bool                        _running;       // a step was started and not finished yet
+
+    ofxNDTripleBuffer<ofxHandPhysicsFrame>  _frames;
+
+    float   _displayedTime;
+    float   _stepMicros;
+    float   _waitMicros;
+};
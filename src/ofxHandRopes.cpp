@@ -0,0 +1,287 @@
+//
+//  ofxHandRopes.cpp
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/15/12.
+//
+//
+
+#include "ofxHandRopes.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define HAND_ROPES_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAND_ROPES_NEON
+#endif
+
+// keeps the constraint direction defined when two masses coincide
+#define ROPE_MIN_DISTANCE_SQUARED   1e-8f
+
+ofxHandRopes::Parameters::Parameters() :
+    stiffness(100.0f),
+    restLength(100.0f),
+    mass(1.0f),
+    damping(1.0f),
+    gravity(0.0f, 1000.0f),
+    iterations(4)
+{
+}
+
+ofxHandRopes::ofxHandRopes() :
+    vectorized(true),
+    _maxRopes(0),
+    _links(0),
+    _laneStride(0)
+{
+}
+
+void ofxHandRopes::setup(unsigned int maxRopes, unsigned int links)
+{
+    links = MIN(links, MAX_ROPE_LINKS);
+    _maxRopes = links > 0 ? maxRopes : 0;
+    _links = _maxRopes > 0 ? links : 0;
+    _laneStride = (_maxRopes + 3) & ~3u;
+
+    unsigned int nMasses = (_links + 1)*_laneStride;
+    if (_links == 0) nMasses = 0;
+    _x.allocate(nMasses);
+    _y.allocate(nMasses);
+    _px.allocate(nMasses);
+    _py.allocate(nMasses);
+    _lambda.allocate(_links*_laneStride);
+    _vertices.allocate(_maxRopes*(_links + 1)*2);
+}
+
+void ofxHandRopes::resetRope(unsigned int rope, const ofVec2f &anchor)
+{
+    if (rope >= _maxRopes) return;
+    for (unsigned int i=0; i<=_links; i++){
+        unsigned int m = i*_laneStride + rope;
+        _x[m] = _px[m] = anchor.x;
+        _y[m] = _py[m] = anchor.y;
+    }
+}
+
+void ofxHandRopes::moveRope(unsigned int from, unsigned int to)
+{
+    if (from >= _maxRopes || to >= _maxRopes || from == to) return;
+    for (unsigned int i=0; i<=_links; i++){
+        unsigned int f = i*_laneStride + from;
+        unsigned int t = i*_laneStride + to;
+        _x[t] = _x[f];
+        _y[t] = _y[f];
+        _px[t] = _px[f];
+        _py[t] = _py[f];
+    }
+}
+
+void ofxHandRopes::step(unsigned int numRopes, const ofVec2f *anchors, float dt, const Parameters &parameters)
+{
+    numRopes = MIN(numRopes, _maxRopes);
+    if (numRopes == 0 || dt <= 0.0f) return;
+
+    // whole groups of four; lanes past numRopes are simulated but never read
+    unsigned int numLanes = (numRopes + 3) & ~3u;
+
+    for (unsigned int r=0; r<numLanes; r++){
+        _px[r] = _x[r];
+        _py[r] = _y[r];
+        if (r < numRopes){
+            _x[r] = anchors[r].x;
+            _y[r] = anchors[r].y;
+        }
+    }
+
+    integrate(numLanes, dt, parameters);
+    solve(numLanes, dt, parameters);
+}
+
+void ofxHandRopes::integrate(unsigned int numLanes, float dt, const Parameters &parameters)
+{
+    // Verlet on every free mass: x' = x + (x - x_prev)*damping + g*dt^2
+    float damping = parameters.damping;
+    float gx = parameters.gravity.x*dt*dt;
+    float gy = parameters.gravity.y*dt*dt;
+
+    unsigned int begin = _laneStride;
+    unsigned int end = (_links + 1)*_laneStride;
+    float *x = _x.data(), *y = _y.data(), *px = _px.data(), *py = _py.data();
+
+#if defined(HAND_ROPES_SSE)
+    if (vectorized){
+        __m128 d = _mm_set1_ps(damping);
+        __m128 ax = _mm_set1_ps(gx);
+        __m128 ay = _mm_set1_ps(gy);
+        for (unsigned int row = begin; row < end; row += _laneStride){
+            for (unsigned int m = row; m < row + numLanes; m += 4){
+                __m128 cx = _mm_load_ps(x + m);
+                __m128 cy = _mm_load_ps(y + m);
+                __m128 vx = _mm_mul_ps(_mm_sub_ps(cx, _mm_load_ps(px + m)), d);
+                __m128 vy = _mm_mul_ps(_mm_sub_ps(cy, _mm_load_ps(py + m)), d);
+                _mm_store_ps(px + m, cx);
+                _mm_store_ps(py + m, cy);
+                _mm_store_ps(x + m, _mm_add_ps(cx, _mm_add_ps(vx, ax)));
+                _mm_store_ps(y + m, _mm_add_ps(cy, _mm_add_ps(vy, ay)));
+            }
+        }
+        return;
+    }
+#elif defined(HAND_ROPES_NEON)
+    if (vectorized){
+        float32x4_t d = vdupq_n_f32(damping);
+        float32x4_t ax = vdupq_n_f32(gx);
+        float32x4_t ay = vdupq_n_f32(gy);
+        for (unsigned int row = begin; row < end; row += _laneStride){
+            for (unsigned int m = row; m < row + numLanes; m += 4){
+                float32x4_t cx = vld1q_f32(x + m);
+                float32x4_t cy = vld1q_f32(y + m);
+                float32x4_t vx = vmulq_f32(vsubq_f32(cx, vld1q_f32(px + m)), d);
+                float32x4_t vy = vmulq_f32(vsubq_f32(cy, vld1q_f32(py + m)), d);
+                vst1q_f32(px + m, cx);
+                vst1q_f32(py + m, cy);
+                vst1q_f32(x + m, vaddq_f32(cx, vaddq_f32(vx, ax)));
+                vst1q_f32(y + m, vaddq_f32(cy, vaddq_f32(vy, ay)));
+            }
+        }
+        return;
+    }
+#endif
+
+    for (unsigned int row = begin; row < end; row += _laneStride){
+        for (unsigned int m = row; m < row + numLanes; m++){
+            float cx = x[m];
+            float cy = y[m];
+            float vx = (cx - px[m])*damping;
+            float vy = (cy - py[m])*damping;
+            px[m] = cx;
+            py[m] = cy;
+            x[m] = cx + (vx + gx);
+            y[m] = cy + (vy + gy);
+        }
+    }
+}
+
+void ofxHandRopes::solve(unsigned int numLanes, float dt, const Parameters &parameters)
+{
+    // XPBD: each link is a spring of stiffness*links (springs in series add up to
+    // the rope's stiffness), each free mass carries mass/links
+    float restLength = parameters.restLength/_links;
+    float w = _links/MAX(parameters.mass, 1e-6f);
+    float compliance = 1.0f/(MAX(parameters.stiffness, 1e-6f)*_links*dt*dt);
+
+    // link 0 hangs from the pinned anchor (inverse mass 0)
+    float anchorWeight = 1.0f/(w + compliance);
+    float linkWeight = 1.0f/(2.0f*w + compliance);
+
+    float *x = _x.data(), *y = _y.data(), *lambda = _lambda.data();
+    memset(lambda, 0, _links*_laneStride*sizeof(float));
+
+    for (unsigned int it = 0; it < parameters.iterations; it++){
+        for (unsigned int i = 0; i < _links; i++){
+
+            float wa = i == 0 ? 0.0f : w;
+            float invDenominator = i == 0 ? anchorWeight : linkWeight;
+            unsigned int rowA = i*_laneStride;
+            unsigned int rowB = rowA + _laneStride;
+
+#if defined(HAND_ROPES_SSE)
+            if (vectorized){
+                __m128 vWa = _mm_set1_ps(wa);
+                __m128 vWb = _mm_set1_ps(w);
+                __m128 vInv = _mm_set1_ps(invDenominator);
+                __m128 vRest = _mm_set1_ps(restLength);
+                __m128 vCompliance = _mm_set1_ps(compliance);
+                __m128 vMin = _mm_set1_ps(ROPE_MIN_DISTANCE_SQUARED);
+                __m128 vOne = _mm_set1_ps(1.0f);
+                for (unsigned int l = 0; l < numLanes; l += 4){
+                    __m128 xa = _mm_load_ps(x + rowA + l);
+                    __m128 ya = _mm_load_ps(y + rowA + l);
+                    __m128 xb = _mm_load_ps(x + rowB + l);
+                    __m128 yb = _mm_load_ps(y + rowB + l);
+                    __m128 dx = _mm_sub_ps(xb, xa);
+                    __m128 dy = _mm_sub_ps(yb, ya);
+                    __m128 d = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), vMin));
+                    __m128 invD = _mm_div_ps(vOne, d);
+                    __m128 c = _mm_sub_ps(d, vRest);
+                    __m128 lam = _mm_load_ps(lambda + rowA + l);
+                    __m128 dl = _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(c, _mm_mul_ps(vCompliance, lam))), vInv);
+                    _mm_store_ps(lambda + rowA + l, _mm_add_ps(lam, dl));
+                    __m128 nx = _mm_mul_ps(_mm_mul_ps(dx, invD), dl);
+                    __m128 ny = _mm_mul_ps(_mm_mul_ps(dy, invD), dl);
+                    _mm_store_ps(x + rowA + l, _mm_sub_ps(xa, _mm_mul_ps(vWa, nx)));
+                    _mm_store_ps(y + rowA + l, _mm_sub_ps(ya, _mm_mul_ps(vWa, ny)));
+                    _mm_store_ps(x + rowB + l, _mm_add_ps(xb, _mm_mul_ps(vWb, nx)));
+                    _mm_store_ps(y + rowB + l, _mm_add_ps(yb, _mm_mul_ps(vWb, ny)));
+                }
+                continue;
+            }
+#elif defined(HAND_ROPES_NEON)
+            if (vectorized){
+                float32x4_t vWa = vdupq_n_f32(wa);
+                float32x4_t vWb = vdupq_n_f32(w);
+                float32x4_t vInv = vdupq_n_f32(invDenominator);
+                float32x4_t vRest = vdupq_n_f32(restLength);
+                float32x4_t vCompliance = vdupq_n_f32(compliance);
+                float32x4_t vMin = vdupq_n_f32(ROPE_MIN_DISTANCE_SQUARED);
+                for (unsigned int l = 0; l < numLanes; l += 4){
+                    float32x4_t xa = vld1q_f32(x + rowA + l);
+                    float32x4_t ya = vld1q_f32(y + rowA + l);
+                    float32x4_t xb = vld1q_f32(x + rowB + l);
+                    float32x4_t yb = vld1q_f32(y + rowB + l);
+                    float32x4_t dx = vsubq_f32(xb, xa);
+                    float32x4_t dy = vsubq_f32(yb, ya);
+                    float32x4_t d2 = vmaxq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vMin);
+                    // no sqrt/divide: reciprocal square root estimate + two Newton steps
+                    float32x4_t invD = vrsqrteq_f32(d2);
+                    invD = vmulq_f32(invD, vrsqrtsq_f32(vmulq_f32(d2, invD), invD));
+                    invD = vmulq_f32(invD, vrsqrtsq_f32(vmulq_f32(d2, invD), invD));
+                    float32x4_t c = vsubq_f32(vmulq_f32(d2, invD), vRest);
+                    float32x4_t lam = vld1q_f32(lambda + rowA + l);
+                    float32x4_t dl = vmulq_f32(vnegq_f32(vaddq_f32(c, vmulq_f32(vCompliance, lam))), vInv);
+                    vst1q_f32(lambda + rowA + l, vaddq_f32(lam, dl));
+                    float32x4_t nx = vmulq_f32(vmulq_f32(dx, invD), dl);
+                    float32x4_t ny = vmulq_f32(vmulq_f32(dy, invD), dl);
+                    vst1q_f32(x + rowA + l, vsubq_f32(xa, vmulq_f32(vWa, nx)));
+                    vst1q_f32(y + rowA + l, vsubq_f32(ya, vmulq_f32(vWa, ny)));
+                    vst1q_f32(x + rowB + l, vaddq_f32(xb, vmulq_f32(vWb, nx)));
+                    vst1q_f32(y + rowB + l, vaddq_f32(yb, vmulq_f32(vWb, ny)));
+                }
+                continue;
+            }
+#endif
+
+            for (unsigned int l = 0; l < numLanes; l++){
+                float dx = x[rowB + l] - x[rowA + l];
+                float dy = y[rowB + l] - y[rowA + l];
+                float d = sqrtf(MAX(dx*dx + dy*dy, ROPE_MIN_DISTANCE_SQUARED));
+                float invD = 1.0f/d;
+                float c = d - restLength;
+                float lam = lambda[rowA + l];
+                float dl = -(c + compliance*lam)*invDenominator;
+                lambda[rowA + l] = lam + dl;
+                float nx = dx*invD*dl;
+                float ny = dy*invD*dl;
+                x[rowA + l] -= wa*nx;
+                y[rowA + l] -= wa*ny;
+                x[rowB + l] += w*nx;
+                y[rowB + l] += w*ny;
+            }
+        }
+    }
+}
+
+void ofxHandRopes::updateVertices(unsigned int numRopes, float alpha)
+{
+    numRopes = MIN(numRopes, _maxRopes);
+    float *vertex = _vertices.data();
+
+    // rope-minor to one strip per rope
+    for (unsigned int r=0; r<numRopes; r++){
+        for (unsigned int m = r; m <= _links*_laneStride + r; m += _laneStride){
+            *vertex++ = _px[m] + (_x[m] - _px[m])*alpha;
+            *vertex++ = _py[m] + (_y[m] - _py[m])*alpha;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+//
+//  ofxHandRopes.h
+//  drawAndFade
+//
+//  Created by Nick Donaldson on 12/15/12.
+//
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxNDAlignedArray.h"
+
+#define MAX_ROPE_LINKS      512
+
+/// Batched rope (mass chain) simulation, one rope per tracked hand.
+///
+/// Each rope is links+1 masses; mass 0 is pinned to its anchor (the hand), the
+/// rest hang from it by XPBD distance constraints. All ropes are stepped together:
+/// positions are stored link-major, rope-minor (x[link*laneStride + rope]), so
+/// Verlet integration and each constraint along the chain run four ropes at a
+/// time with SSE/NEON, solved Gauss-Seidel down the chain.
+///
+/// Ropes are dense like the hand table: 0..numRopes-1 are live, and the owner
+/// calls moveRope() when it swap-removes a hand.
+class ofxHandRopes {
+
+public:
+
+    struct Parameters {
+
+        float           stiffness;      // of the whole rope, like a spring constant per unit mass
+        float           restLength;     // of the whole rope, px
+        float           mass;           // of the whole rope, spread evenly over the free masses
+        float           damping;        // velocity kept per step
+        ofVec2f         gravity;
+        unsigned int    iterations;     // constraint passes per step
+
+        Parameters();
+    };
+
+    ofxHandRopes();
+
+    // allocates for maxRopes ropes of links links (at most MAX_ROPE_LINKS); 0 links releases
+    void setup(unsigned int maxRopes, unsigned int links);
+
+    unsigned int getNumLinks() const    { return _links; };
+    unsigned int getMaxRopes() const    { return _maxRopes; };
+
+    // all masses of the rope collapsed onto anchor, at rest
+    void resetRope(unsigned int rope, const ofVec2f & anchor);
+    void moveRope(unsigned int from, unsigned int to);
+
+    // one step of dt seconds for ropes 0..numRopes-1, pinning rope r to anchors[r]
+    void step(unsigned int numRopes, const ofVec2f * anchors, float dt, const Parameters & parameters);
+
+    // Vertex stream: rope r is vertices r*(links+1) .. r*(links+1)+links, anchor first,
+    // two floats (x, y) each - ready for glVertexPointer(2, GL_FLOAT, 0, ...) and
+    // one GL_LINE_STRIP per rope. alpha blends from the previous step to the last.
+    void updateVertices(unsigned int numRopes, float alpha);
+    const float * getVertices() const   { return _vertices.data(); };
+
+    // false runs the plain scalar loops, for comparison
+    bool            vectorized;
+
+private:
+
+    void integrate(unsigned int numLanes, float dt, const Parameters & parameters);
+    void solve(unsigned int numLanes, float dt, const Parameters & parameters);
+
+    unsigned int    _maxRopes;
+    unsigned int    _links;
+    unsigned int    _laneStride;        // maxRopes rounded up to 4
+
+    ofxNDAlignedArray<float>    _x;
+    ofxNDAlignedArray<float>    _y;
+    ofxNDAlignedArray<float>    _px;        // previous step, for Verlet and render interpolation
+    ofxNDAlignedArray<float>    _py;
+    ofxNDAlignedArray<float>    _lambda;    // per link, accumulated over a step's iterations
+    ofxNDAlignedArray<float>    _vertices;
+};